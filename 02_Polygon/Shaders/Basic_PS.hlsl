@@ -1,7 +1,18 @@
 
 
+#ifndef COLOR_MODE
+#define COLOR_MODE 0
+#endif
+
 float4 main() : SV_TARGET
 {
+#if COLOR_MODE == 1
+	return float4(1.0f, 0.3f, 0.3f, 1.0f);
+#elif COLOR_MODE == 2
+	return float4(0.3f, 1.0f, 0.3f, 1.0f);
+#elif COLOR_MODE == 3
+	return float4(0.3f, 0.3f, 1.0f, 1.0f);
+#else
 	return float4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
 }
-
@@ -63,7 +63,84 @@ public:
 };
 
 
+// 起動モード
+enum APP_MODE
+{
+    APP_MODE_WINDOW
+
+    , APP_MODE_HEADLESS
+};
+
+
+// 起動設定
+struct AppStartupDesc
+{
+    APP_MODE mode;
+    Size2D   clientSize;
+
+    // ヘッドレス時に実行するフレーム数 (0 なら無制限)
+    u32 frameCount;
+
+    // ヘッドレス時の実行時間の上限 [秒] (0 なら無制限)
+    f64 frameBudget;
+
+    // 描画に使うバックエンド
+    GRAPHICS_BACKEND graphicsBackend;
+
+    // バックバッファの数 (同時に処理中にできるフレーム数)
+    u32 bufferCount;
+
+    // Null / ソフトウェアで 1 フレームにかかる疑似的な GPU 時間 [ミリ秒]
+    f64 emulatedGpuMilliseconds;
+
+    // 更新処理にかかる疑似的な CPU 時間 [ミリ秒] (描画スレッドの効果の計測用)
+    f64 emulatedUpdateMilliseconds;
+
+    // 描画スレッドに渡す描画の状態の数 (0 なら描画スレッドを使わない、2 か 3)
+    // 多いほど更新が描画を待たずに済むが、更新から画面に出るまでの遅延が増える
+    u32 renderSnapshotCount;
+
+    // 描画する四角形の数 (画面を格子に分けて並べる、コマンドの記録の負荷の計測用)
+    u32 quadCount;
+
+    // 四角形の描画をワーカーで分けて記録する単位 (0 なら分けずに 1 つのコマンドリストに記録する)
+    u32 recordChunkSize;
+
+    // 描画ごとの状態設定のうち、設定済みのものと同じものを記録しない
+    bool enableStateFilter;
+
+    // コンパイル済みシェーダーのアーカイブ (空ならソースからコンパイルする)
+    std::string shaderArchivePath;
+
+    // 空でなければアーカイブを作って終了する
+    std::string buildShaderArchivePath;
+
+    // 0 でなければこの数の描画のキーを並べる時間を計測して終了する
+    u32 sortBenchmarkCount;
+
+    // 初期化のタスクを実行するワーカーの数
+    u32 workerCount;
+
+    // シェーダーのソースを監視し、変更されたらパイプラインを作り直す
+    bool enableShaderHotReload;
+
+    // 四角形の色 (ピクセルシェーダーのバリアント、0 ～ 3)
+    u32 colorMode;
+
+    // 前回作ったパイプラインを初期化中に作っておく
+    bool enablePipelinePrewarm;
+
+    // ワーカーとメインスレッドを CPU の構成 (コアの種類、L3) に合わせた論理プロセッサに固定する
+    bool enableThreadAffinity;
+};
+
+
 bool CreateApp(const Size2D& clientSize, const std::string& title, IApp ** ppOut);
 
-void AppMain();
+bool CreateHeadlessApp(const Size2D& clientSize, u32 frameCount, f64 frameBudget, IApp ** ppOut);
+
+// コマンドライン引数から起動設定を作成
+void ParseAppStartupDesc(int argc, const char* const* argv, AppStartupDesc* pOut);
+
+void AppMain(int argc, const char* const* argv);
 
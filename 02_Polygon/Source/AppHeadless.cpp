@@ -0,0 +1,151 @@
+﻿
+
+AppHeadless::AppHeadless()
+    : m_ClientSize({ 0, 0 })
+    , m_Callbacks({})
+    , m_FrameCount(0)
+    , m_FrameBudget(0.0)
+    , m_IsQuitRequested(false)
+    , m_FrameIndex(0)
+    , m_IsStarted(false)
+    , m_IsReported(false)
+{
+
+}
+
+
+AppHeadless::~AppHeadless()
+{
+    Term();
+}
+
+
+bool AppHeadless::Init(const Size2D& clientSize, u32 frameCount, f64 frameBudget)
+{
+    if (clientSize.width == 0 || clientSize.height == 0)
+    {
+        return false;
+    }
+
+    m_ClientSize = clientSize;
+    m_FrameCount = frameCount;
+    m_FrameBudget = frameBudget;
+
+    return true;
+}
+
+
+void AppHeadless::Term()
+{
+    ReportFrameStatistics();
+}
+
+
+void AppHeadless::SetAppCallbacks(const AppCallbacks& callbacks)
+{
+    m_Callbacks = callbacks;
+}
+
+
+bool AppHeadless::IsLoop() const
+{
+    const Clock::time_point now = Clock::now();
+
+    // 最初のループ判定から計測を開始する (初期化時間は含めない)
+    if (!m_IsStarted)
+    {
+        m_IsStarted = true;
+        m_StartTime = now;
+    }
+
+    m_EndTime = now;
+
+    if (m_IsQuitRequested)
+    {
+        return false;
+    }
+
+    // フレーム数の上限
+    if (m_FrameCount > 0 && m_FrameIndex >= m_FrameCount)
+    {
+        return false;
+    }
+
+    // 実行時間の上限
+    if (m_FrameBudget > 0.0)
+    {
+        const std::chrono::duration<f64> elapsed = now - m_StartTime;
+        if (elapsed.count() >= m_FrameBudget)
+        {
+            return false;
+        }
+    }
+
+    m_FrameIndex++;
+    return true;
+}
+
+
+void AppHeadless::PostQuit()
+{
+    m_IsQuitRequested = true;
+}
+
+
+Size2D AppHeadless::GetClientSize() const
+{
+    return m_ClientSize;
+}
+
+
+void* AppHeadless::GetWindowHandle() const
+{
+    return nullptr;
+}
+
+
+void AppHeadless::ShowMessageBox(const std::string& message, const std::string& caption)
+{
+    std::fprintf(stderr, "[%s] %s\n", caption.c_str(), message.c_str());
+}
+
+
+void AppHeadless::ReportFrameStatistics() const
+{
+    if (!m_IsStarted || m_IsReported)
+    {
+        return;
+    }
+    m_IsReported = true;
+
+    // IsLoop が true を返した回数 = 実行したフレーム数
+    const std::chrono::duration<f64, std::milli> elapsed = m_EndTime - m_StartTime;
+    const f64 totalMilliseconds = elapsed.count();
+    const f64 averageMilliseconds = m_FrameIndex > 0 ? totalMilliseconds / m_FrameIndex : 0.0;
+    const f64 framesPerSecond = totalMilliseconds > 0.0 ? m_FrameIndex * 1000.0 / totalMilliseconds : 0.0;
+
+    std::fprintf(
+        stderr,
+        "[Headless] frames: %u, total: %.3f ms, average: %.4f ms/frame, %.1f fps\n",
+        m_FrameIndex,
+        totalMilliseconds,
+        averageMilliseconds,
+        framesPerSecond
+    );
+}
+
+
+bool CreateHeadlessApp(const Size2D& clientSize, u32 frameCount, f64 frameBudget, IApp ** ppOut)
+{
+    AppHeadless* pApp = new AppHeadless();
+    if (!pApp->Init(clientSize, frameCount, frameBudget))
+    {
+        delete pApp;
+        *ppOut = nullptr;
+        return false;
+    }
+
+    *ppOut = pApp;
+    return true;
+}
+
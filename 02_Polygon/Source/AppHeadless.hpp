@@ -0,0 +1,49 @@
+﻿
+#pragma once
+
+
+// ウィンドウを持たないアプリケーション
+// 指定フレーム数 (または指定時間) だけメインループを回して終了する
+class AppHeadless : public IApp
+{
+public:
+    AppHeadless();
+
+    ~AppHeadless();
+
+    bool Init(const Size2D& clientSize, u32 frameCount, f64 frameBudget);
+
+    void Term();
+
+    virtual void SetAppCallbacks(const AppCallbacks& callbacks) override;
+
+    virtual bool IsLoop() const override;
+
+    virtual void PostQuit() override;
+
+    virtual Size2D GetClientSize() const override;
+
+    virtual void* GetWindowHandle() const override;
+
+    virtual void ShowMessageBox(const std::string& message, const std::string& caption) override;
+
+private:
+    // 計測結果を出力
+    void ReportFrameStatistics() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Size2D       m_ClientSize;
+    AppCallbacks m_Callbacks;
+    u32          m_FrameCount;
+    f64          m_FrameBudget;
+    bool         m_IsQuitRequested;
+
+    mutable u32               m_FrameIndex;
+    mutable bool              m_IsStarted;
+    mutable bool              m_IsReported;
+    mutable Clock::time_point m_StartTime;
+    mutable Clock::time_point m_EndTime;
+};
+
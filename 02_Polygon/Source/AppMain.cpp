@@ -56,19 +56,224 @@ void OnMouseWheel(const Position2D& position, s32 wheelDelta, void* pUser)
 
 
 
+// コマンドライン引数から起動設定を作成
+//   -window / -headless        : 起動モード
+//   -frames=N                  : ヘッドレス時に実行するフレーム数
+//   -seconds=S                 : ヘッドレス時の実行時間の上限
+//   -width=W -height=H         : 描画領域のサイズ
+//   -d3d12 / -null / -software : 描画バックエンド (省略時はウィンドウなら D3D12、ヘッドレスなら Null)
+//   -buffers=N                 : バックバッファの数 = 同時に処理中にできるフレーム数 (2 ～ 16)
+//   -gpu-ms=T                  : Null / ソフトウェアで 1 フレームにかかる疑似的な GPU 時間
+//   -update-ms=T               : 更新処理にかかる疑似的な CPU 時間
+//   -render-thread[=N] / -no-render-thread : 描画スレッドで前のフレームを描画し、その間に次のフレームを更新する
+//                                (N は描画の状態の数 2 か 3、省略時は 2。既定は使わない)
+//   -quads=N                   : 描画する四角形の数 (画面を格子に分けて並べる、省略時は 1)
+//   -record-chunk=N            : 四角形 N 個ごとに別のコマンドリストへワーカーで記録する (0 なら分けない、省略時は 256)
+//   -state-filter / -no-state-filter : 設定済みの状態と同じ設定を記録しない (省略時は有効)
+//   -shader-archive=PATH       : コンパイル済みシェーダーのアーカイブを使う (無いシェーダーはコンパイルする)
+//   -build-shader-archive=PATH : バックエンドに合わせたアーカイブを作って終了する
+//   -sort-benchmark[=N]        : N 個 (省略時は 1000000) の描画のキーを基数ソートと std::sort で並べて比べ、終了する
+//   -workers=N                 : 初期化のタスクを実行するワーカーの数 (0 なら最初のフレームの後にまとめて実行する)
+//   -hot-reload / -no-hot-reload : シェーダーのホットリロード (省略時はウィンドウなら有効)
+//   -color-mode=N              : 四角形の色のバリアント (0 ～ 3、起動後にコンパイルする)
+//   -prewarm / -no-prewarm     : 前回使ったパイプラインを最初のフレームまでに作る (省略時は有効)
+//   -thread-affinity / -no-thread-affinity : スレッドを CPU の構成に合わせて固定する (省略時は有効)
+void ParseAppStartupDesc(int argc, const char* const* argv, AppStartupDesc* pOut)
+{
+    AppStartupDesc desc = {};
+#if defined(_WIN32)
+    desc.mode = APP_MODE_WINDOW;
+#else
+    desc.mode = APP_MODE_HEADLESS; // ウィンドウが無い環境ではヘッドレスのみ
+#endif
+    desc.clientSize = { 640, 480 };
+    desc.frameCount = 0;
+    desc.frameBudget = 0.0;
+    desc.bufferCount = 2;
+    desc.emulatedGpuMilliseconds = 0.0;
+    desc.emulatedUpdateMilliseconds = 0.0;
+    desc.renderSnapshotCount = 0;
+    desc.quadCount = 1;
+    desc.recordChunkSize = 256;
+    desc.enableStateFilter = true;
+    desc.sortBenchmarkCount = 0;
+    desc.workerCount = TaskScheduler::GetDefaultWorkerCount();
+    desc.enablePipelinePrewarm = true;
+    desc.enableThreadAffinity = true;
+
+    bool isBackendSpecified = false;
+    bool isHotReloadSpecified = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const std::string::size_type separator = arg.find('=');
+        const std::string key = arg.substr(0, separator);
+        const std::string value = separator != std::string::npos ? arg.substr(separator + 1) : "";
+
+        if (key == "-window")
+        {
+            desc.mode = APP_MODE_WINDOW;
+        }
+        else if (key == "-headless")
+        {
+            desc.mode = APP_MODE_HEADLESS;
+        }
+        else if (key == "-frames")
+        {
+            desc.frameCount = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-seconds")
+        {
+            desc.frameBudget = std::strtod(value.c_str(), nullptr);
+        }
+        else if (key == "-width")
+        {
+            desc.clientSize.width = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-height")
+        {
+            desc.clientSize.height = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-d3d12")
+        {
+            desc.graphicsBackend = GRAPHICS_BACKEND_D3D12;
+            isBackendSpecified = true;
+        }
+        else if (key == "-null")
+        {
+            desc.graphicsBackend = GRAPHICS_BACKEND_NULL;
+            isBackendSpecified = true;
+        }
+        else if (key == "-software")
+        {
+            desc.graphicsBackend = GRAPHICS_BACKEND_SOFTWARE;
+            isBackendSpecified = true;
+        }
+        else if (key == "-buffers")
+        {
+            // フリップモデルのスワップチェインは 2 ～ 16 枚
+            const u32 bufferCount = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+            desc.bufferCount = std::min(std::max(bufferCount, 2u), 16u);
+        }
+        else if (key == "-gpu-ms")
+        {
+            desc.emulatedGpuMilliseconds = std::max(std::strtod(value.c_str(), nullptr), 0.0);
+        }
+        else if (key == "-update-ms")
+        {
+            desc.emulatedUpdateMilliseconds = std::max(std::strtod(value.c_str(), nullptr), 0.0);
+        }
+        else if (key == "-render-thread")
+        {
+            const u32 snapshotCount = value.empty() ? 2 : static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+            desc.renderSnapshotCount = std::min(std::max(snapshotCount, 2u), 3u);
+        }
+        else if (key == "-no-render-thread")
+        {
+            desc.renderSnapshotCount = 0;
+        }
+        else if (key == "-quads")
+        {
+            desc.quadCount = std::max(static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10)), 1u);
+        }
+        else if (key == "-record-chunk")
+        {
+            desc.recordChunkSize = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-state-filter" || key == "-no-state-filter")
+        {
+            desc.enableStateFilter = (key == "-state-filter");
+        }
+        else if (key == "-shader-archive")
+        {
+            desc.shaderArchivePath = value;
+        }
+        else if (key == "-build-shader-archive")
+        {
+            desc.buildShaderArchivePath = value;
+        }
+        else if (key == "-sort-benchmark")
+        {
+            desc.sortBenchmarkCount = value.empty() ? 1000000 : static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-workers")
+        {
+            desc.workerCount = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-hot-reload" || key == "-no-hot-reload")
+        {
+            desc.enableShaderHotReload = (key == "-hot-reload");
+            isHotReloadSpecified = true;
+        }
+        else if (key == "-color-mode")
+        {
+            desc.colorMode = static_cast<u32>(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (key == "-prewarm" || key == "-no-prewarm")
+        {
+            desc.enablePipelinePrewarm = (key == "-prewarm");
+        }
+        else if (key == "-thread-affinity" || key == "-no-thread-affinity")
+        {
+            desc.enableThreadAffinity = (key == "-thread-affinity");
+        }
+    }
+
+    if (!isBackendSpecified)
+    {
+        desc.graphicsBackend = desc.mode == APP_MODE_HEADLESS ? GRAPHICS_BACKEND_NULL : GRAPHICS_BACKEND_D3D12;
+    }
+    if (!isHotReloadSpecified)
+    {
+        desc.enableShaderHotReload = desc.mode == APP_MODE_WINDOW;
+    }
+
+    *pOut = desc;
+}
+
+
 // エントリポイント
-void AppMain()
+void AppMain(int argc, const char* const* argv)
 {
+    AppStartupDesc startupDesc = {};
+    ParseAppStartupDesc(argc, argv, &startupDesc);
+
+    // オフラインの処理 (ウィンドウもデバイスも作らない)
+    if (!startupDesc.buildShaderArchivePath.empty())
+    {
+        SampleApp::BuildShaderArchive(startupDesc.graphicsBackend, startupDesc.buildShaderArchivePath);
+        return;
+    }
+    if (startupDesc.sortBenchmarkCount > 0)
+    {
+        SampleApp::RunSortBenchmark(startupDesc.workerCount, startupDesc.sortBenchmarkCount);
+        return;
+    }
+
     IApp* pApp = nullptr;
-    Size2D clientSize = { 640, 480 };
 
-    if (!CreateApp(clientSize, "Sample", &pApp))
+    if (startupDesc.mode == APP_MODE_HEADLESS)
+    {
+        if (!CreateHeadlessApp(startupDesc.clientSize, startupDesc.frameCount, startupDesc.frameBudget, &pApp))
+        {
+            return;
+        }
+    }
+    else
     {
+#if defined(_WIN32)
+        if (!CreateApp(startupDesc.clientSize, "Sample", &pApp))
+        {
+            return;
+        }
+#else
         return;
+#endif
     }
 
     // サンプルの作成
-    SampleApp * pSample = new SampleApp(pApp);
+    SampleApp * pSample = new SampleApp(pApp, startupDesc);
 
     // コールバックの設定
     {
@@ -102,7 +307,7 @@ void AppMain()
         pApp->PostQuit();
     }
 
-    // メインループ
+    // メインループ (描画スレッドを使う場合、Render は描画の状態を描画スレッドに渡すだけ)
     while (pApp->IsLoop())
     {
         pSample->Update();
@@ -1,4 +1,6 @@
 ﻿
+#if defined(_WIN32)
+
 
 #define WINDOW_CLASS_NAME "Sample"
 
@@ -406,3 +408,4 @@ bool CreateApp(const Size2D& clientSize, const std::string& title, IApp ** ppOut
     return true;
 }
 
+#endif
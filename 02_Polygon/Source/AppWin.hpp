@@ -1,6 +1,7 @@
 ﻿
 #pragma once
 
+#if defined(_WIN32)
 
 class AppWin : public IApp
 {
@@ -38,4 +39,4 @@ private:
     AppCallbacks m_Callbacks;
 };
 
-
+#endif
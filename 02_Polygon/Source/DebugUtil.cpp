@@ -0,0 +1,30 @@
+﻿
+
+void DebugOutputFormatString(const char* format, ...)
+{
+    char buff[1024];
+    va_list valist;
+    va_start(valist, format);
+    std::vsnprintf(buff, sizeof(buff), format, valist);
+    va_end(valist);
+
+#if defined(_WIN32)
+    size_t length = strnlen_s(buff, 1024);
+
+    if (length < 1023)
+    {
+        buff[length] = '\n';
+        buff[length + 1] = '\0';
+        OutputDebugStringA(buff);
+    }
+    else
+    {
+        OutputDebugStringA(buff);
+        OutputDebugStringA("\n");
+    }
+#else
+    // デバッガ出力が無いので標準エラーへ
+    std::fprintf(stderr, "%s\n", buff);
+#endif
+}
+
@@ -0,0 +1,6 @@
+﻿#pragma once
+
+
+// デバッグ出力 (書式指定付き、末尾に改行を付加)
+void DebugOutputFormatString(const char* format, ...);
+
@@ -0,0 +1,293 @@
+﻿
+
+// パスをディレクトリとファイル名に分ける (ディレクトリが無ければ ".")
+static void SplitPath(const std::string& path, std::string* pDirectory, std::string* pFileName)
+{
+    const std::string::size_type end = path.find_last_of("/\\");
+    if (end == std::string::npos)
+    {
+        *pDirectory = ".";
+        *pFileName = path;
+        return;
+    }
+    *pDirectory = (end > 0) ? path.substr(0, end) : path.substr(0, 1);
+    *pFileName = path.substr(end + 1);
+}
+
+
+static bool IsSameFileName(const std::string& a, const std::string& b)
+{
+#if defined(_WIN32)
+    return _stricmp(a.c_str(), b.c_str()) == 0; // 大文字小文字を区別しない
+#else
+    return a == b;
+#endif
+}
+
+
+FileWatcher::FileWatcher()
+#if !defined(_WIN32)
+    : m_Inotify(-1)
+    , m_IsInitialized(false)
+#else
+    : m_IsInitialized(false)
+#endif
+{
+
+}
+
+
+FileWatcher::~FileWatcher()
+{
+    Term();
+}
+
+
+bool FileWatcher::AddFile(const std::string& path)
+{
+    if (!m_IsInitialized)
+    {
+        return false;
+    }
+
+    std::string directoryPath;
+    std::string fileName;
+    SplitPath(path, &directoryPath, &fileName);
+
+    Directory* pDirectory = FindDirectory(directoryPath);
+    if (pDirectory == nullptr)
+    {
+        std::unique_ptr<Directory> directory(new Directory());
+        directory->path = directoryPath;
+#if defined(_WIN32)
+        directory->handle = CreateFileA(
+            directoryPath.c_str(),
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            nullptr
+        );
+        if (directory->handle == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        directory->buffer.resize(16 * 1024 / sizeof(DWORD));
+        directory->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        if (!BeginRead(directory.get()))
+        {
+            CloseHandle(directory->overlapped.hEvent);
+            CloseHandle(directory->handle);
+            return false;
+        }
+#else
+        // 書き込みの完了と、別の名前からの置き換えだけを見る
+        directory->watch = inotify_add_watch(m_Inotify, directoryPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (directory->watch < 0)
+        {
+            return false;
+        }
+#endif
+        pDirectory = directory.get();
+        m_Directories.push_back(std::move(directory));
+    }
+
+    for (const std::string& name : pDirectory->fileNames)
+    {
+        if (IsSameFileName(name, fileName))
+        {
+            return true;
+        }
+    }
+    pDirectory->fileNames.push_back(fileName);
+    pDirectory->filePaths.push_back(path);
+    return true;
+}
+
+
+FileWatcher::Directory* FileWatcher::FindDirectory(const std::string& path) const
+{
+    for (const std::unique_ptr<Directory>& directory : m_Directories)
+    {
+        if (IsSameFileName(directory->path, path))
+        {
+            return directory.get();
+        }
+    }
+    return nullptr;
+}
+
+
+void FileWatcher::AddChangedFile(const Directory& directory, const std::string& fileName, std::vector<std::string>* pOut)
+{
+    for (size_t i = 0; i < directory.fileNames.size(); i++)
+    {
+        if (IsSameFileName(directory.fileNames[i], fileName))
+        {
+            const std::string& path = directory.filePaths[i];
+            if (std::find(pOut->begin(), pOut->end(), path) == pOut->end())
+            {
+                pOut->push_back(path);
+            }
+            return;
+        }
+    }
+}
+
+
+#if defined(_WIN32)
+
+bool FileWatcher::Init()
+{
+    Term();
+    m_IsInitialized = true;
+    return true;
+}
+
+
+void FileWatcher::Term()
+{
+    for (const std::unique_ptr<Directory>& directory : m_Directories)
+    {
+        // 発行中の読み込みを取り消してから閉じる
+        CancelIoEx(directory->handle, &directory->overlapped);
+        DWORD transferredSize = 0;
+        GetOverlappedResult(directory->handle, &directory->overlapped, &transferredSize, TRUE);
+        CloseHandle(directory->overlapped.hEvent);
+        CloseHandle(directory->handle);
+    }
+    m_Directories.clear();
+    m_IsInitialized = false;
+}
+
+
+void FileWatcher::Poll(std::vector<std::string>* pOut)
+{
+    pOut->clear();
+
+    for (const std::unique_ptr<Directory>& directory : m_Directories)
+    {
+        DWORD transferredSize = 0;
+        if (!GetOverlappedResult(directory->handle, &directory->overlapped, &transferredSize, FALSE))
+        {
+            continue; // まだ変更が無い
+        }
+
+        if (transferredSize == 0)
+        {
+            // バッファが溢れたので、全て変わったものとする
+            for (const std::string& fileName : directory->fileNames)
+            {
+                AddChangedFile(*directory, fileName, pOut);
+            }
+        }
+        else
+        {
+            const u8* p = reinterpret_cast<const u8*>(directory->buffer.data());
+            for (;;)
+            {
+                const FILE_NOTIFY_INFORMATION* pInfo = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+                if (pInfo->Action == FILE_ACTION_ADDED || pInfo->Action == FILE_ACTION_MODIFIED || pInfo->Action == FILE_ACTION_RENAMED_NEW_NAME)
+                {
+                    char fileName[MAX_PATH] = {};
+                    const int length = WideCharToMultiByte(CP_ACP, 0, pInfo->FileName, static_cast<int>(pInfo->FileNameLength / sizeof(WCHAR)), fileName, MAX_PATH - 1, nullptr, nullptr);
+                    AddChangedFile(*directory, std::string(fileName, length), pOut);
+                }
+                if (pInfo->NextEntryOffset == 0)
+                {
+                    break;
+                }
+                p += pInfo->NextEntryOffset;
+            }
+        }
+
+        BeginRead(directory.get());
+    }
+}
+
+
+bool FileWatcher::BeginRead(Directory* pDirectory)
+{
+    ResetEvent(pDirectory->overlapped.hEvent);
+
+    return ReadDirectoryChangesW(
+        pDirectory->handle,
+        pDirectory->buffer.data(),
+        static_cast<DWORD>(pDirectory->buffer.size() * sizeof(DWORD)),
+        FALSE,
+        FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+        nullptr,
+        &pDirectory->overlapped,
+        nullptr
+    ) != FALSE;
+}
+
+#else
+
+bool FileWatcher::Init()
+{
+    Term();
+    m_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_IsInitialized = m_Inotify >= 0;
+    return m_IsInitialized;
+}
+
+
+void FileWatcher::Term()
+{
+    // 閉じれば監視も全て外れる
+    if (m_Inotify >= 0)
+    {
+        close(m_Inotify);
+        m_Inotify = -1;
+    }
+    m_Directories.clear();
+    m_IsInitialized = false;
+}
+
+
+void FileWatcher::Poll(std::vector<std::string>* pOut)
+{
+    pOut->clear();
+    if (m_Inotify < 0)
+    {
+        return;
+    }
+
+    // inotify_event は可変長なので境界を合わせたバッファに読む
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        const ssize_t readSize = read(m_Inotify, buffer, sizeof(buffer));
+        if (readSize <= 0)
+        {
+            break; // EAGAIN: もう無い
+        }
+
+        for (const char* p = buffer; p < buffer + readSize;)
+        {
+            const inotify_event* pEvent = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + pEvent->len;
+
+            // 溢れたときは全て変わったものとする
+            const bool isOverflow = (pEvent->mask & IN_Q_OVERFLOW) != 0;
+            for (const std::unique_ptr<Directory>& directory : m_Directories)
+            {
+                if (isOverflow)
+                {
+                    for (const std::string& fileName : directory->fileNames)
+                    {
+                        AddChangedFile(*directory, fileName, pOut);
+                    }
+                }
+                else if (directory->watch == pEvent->wd && pEvent->len > 0)
+                {
+                    AddChangedFile(*directory, pEvent->name, pOut);
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+
+// ファイルの変更の監視
+// ファイルのあるディレクトリを監視するので、まだ無いファイルや、置き換えて保存するエディタにも対応する
+// (Linux は inotify、Windows は ReadDirectoryChangesW)
+//
+// 変更は Poll で取り出す (待たない)。書き込みの途中で返ることがあるので、使う側で少し待つこと
+
+
+class FileWatcher
+{
+public:
+    FileWatcher();
+
+    ~FileWatcher();
+
+    // 監視できない環境では false
+    bool Init();
+
+    void Term();
+
+    // 同じファイルを何度追加してもよい
+    bool AddFile(const std::string& path);
+
+    // 前回から変更 (作成、置き換えを含む) されたファイルを AddFile に渡したパスで返す
+    void Poll(std::vector<std::string>* pOut);
+
+private:
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    struct Directory
+    {
+        std::string              path;
+        std::vector<std::string> fileNames; // 監視するファイル名
+        std::vector<std::string> filePaths; // AddFile に渡したパス (fileNames と同じ順)
+#if defined(_WIN32)
+        HANDLE                   handle;
+        OVERLAPPED               overlapped;
+        std::vector<DWORD>       buffer;    // DWORD 境界に置く必要がある
+#else
+        int                      watch;
+#endif
+    };
+
+private:
+    Directory* FindDirectory(const std::string& path) const;
+
+    static void AddChangedFile(const Directory& directory, const std::string& fileName, std::vector<std::string>* pOut);
+
+#if defined(_WIN32)
+    static bool BeginRead(Directory* pDirectory);
+#endif
+
+private:
+    std::vector<std::unique_ptr<Directory>> m_Directories; // OVERLAPPED の位置を変えない
+#if !defined(_WIN32)
+    int                                     m_Inotify;
+#endif
+    bool                                    m_IsInitialized;
+};
@@ -0,0 +1,272 @@
+﻿
+
+//-----------------------------------------------------------------
+// CommandListPool
+//-----------------------------------------------------------------
+CommandListPool::CommandListPool()
+    : m_pDevice(nullptr)
+    , m_Type(COMMAND_LIST_TYPE_DIRECT)
+    , m_CommandListCount(0)
+    , m_PeakInUseCount(0)
+    , m_AcquireCount(0)
+{
+
+}
+
+
+CommandListPool::~CommandListPool()
+{
+    Term();
+}
+
+
+void CommandListPool::Init(IGraphicsDevice* pDevice, COMMAND_LIST_TYPE type)
+{
+    m_pDevice = pDevice;
+    m_Type = type;
+}
+
+
+void CommandListPool::Term()
+{
+    // Entry はコマンドリストをアロケータより先に破棄する
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_FreeEntries.clear();
+    m_FrameEntries.clear();
+    m_RetiredEntries.clear();
+    m_CommandListCount = 0;
+    m_pDevice = nullptr;
+}
+
+
+HRESULT CommandListPool::Acquire(IGraphicsCommandList** ppOut)
+{
+    *ppOut = nullptr;
+
+    std::unique_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_FreeEntries.empty())
+        {
+            entry = std::move(m_FreeEntries.back());
+            m_FreeEntries.pop_back();
+        }
+    }
+
+    // 作成と Reset はロックの外で行う (このアロケータは他のスレッドから使われない)
+    HRESULT hr = S_OK;
+    const bool isCreated = !entry;
+    if (isCreated)
+    {
+        // 作ったコマンドリストは記録中の状態になっている
+        entry.reset(new Entry());
+        entry->fenceValue = 0;
+        hr = m_pDevice->CreateCommandAllocator(m_Type, &entry->commandAllocator);
+        if (SUCCEEDED(hr))
+        {
+            hr = m_pDevice->CreateCommandList(m_Type, entry->commandAllocator.get(), &entry->commandList);
+        }
+    }
+    else
+    {
+        hr = entry->commandAllocator->Reset();
+        if (SUCCEEDED(hr))
+        {
+            hr = entry->commandList->Reset(entry->commandAllocator.get(), nullptr);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (FAILED(hr))
+    {
+        // 記録できる状態か分からないので捨てる
+        m_CommandListCount -= isCreated ? 0 : 1;
+        return hr;
+    }
+    m_CommandListCount += isCreated ? 1 : 0;
+    m_AcquireCount++;
+
+    *ppOut = entry->commandList.get();
+    m_FrameEntries.push_back(std::move(entry));
+    m_PeakInUseCount = std::max(m_PeakInUseCount, static_cast<u32>(m_FrameEntries.size() + m_RetiredEntries.size()));
+    return S_OK;
+}
+
+
+void CommandListPool::FinishFrame(u64 fenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (std::unique_ptr<Entry>& entry : m_FrameEntries)
+    {
+        entry->fenceValue = fenceValue;
+        m_RetiredEntries.push_back(std::move(entry));
+    }
+    m_FrameEntries.clear();
+}
+
+
+void CommandListPool::Reclaim(u64 completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    while (!m_RetiredEntries.empty() && m_RetiredEntries.front()->fenceValue <= completedFenceValue)
+    {
+        m_FreeEntries.push_back(std::move(m_RetiredEntries.front()));
+        m_RetiredEntries.pop_front();
+    }
+}
+
+
+void CommandListPool::GetStatistics(CommandListPoolStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    pOut->commandListCount = m_CommandListCount;
+    pOut->inUseCount = static_cast<u32>(m_FrameEntries.size() + m_RetiredEntries.size());
+    pOut->peakInUseCount = m_PeakInUseCount;
+    pOut->acquireCount = m_AcquireCount;
+}
+
+
+//-----------------------------------------------------------------
+// ParallelCommandRecorder
+//-----------------------------------------------------------------
+ParallelCommandRecorder::ParallelCommandRecorder()
+    : m_pCommandListPool(nullptr)
+    , m_pTaskScheduler(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+    Term();
+}
+
+
+void ParallelCommandRecorder::Init(CommandListPool* pCommandListPool, TaskScheduler* pTaskScheduler)
+{
+    m_pCommandListPool = pCommandListPool;
+    m_pTaskScheduler = pTaskScheduler;
+}
+
+
+void ParallelCommandRecorder::Term()
+{
+    m_CommandLists.clear();
+    m_ChunkCommandLists.clear();
+    m_ChunkResults.clear();
+    m_pCommandListPool = nullptr;
+    m_pTaskScheduler = nullptr;
+}
+
+
+HRESULT ParallelCommandRecorder::Begin()
+{
+    m_CommandLists.clear();
+
+    IGraphicsCommandList* pCommandList = nullptr;
+    HRESULT hr = m_pCommandListPool->Acquire(&pCommandList);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_CommandLists.push_back(pCommandList);
+    return S_OK;
+}
+
+
+IGraphicsCommandList* ParallelCommandRecorder::GetCommandList() const
+{
+    return m_CommandLists.back();
+}
+
+
+HRESULT ParallelCommandRecorder::RecordParallel(const char* name, u32 itemCount, u32 grainSize, const CommandRecordFunction& record)
+{
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    m_Statistics.recordCount++;
+    m_Statistics.itemCount += itemCount;
+
+    // 分けても速くならないものは今のリストに記録する
+    const u32 chunkCount = (grainSize == 0) ? 1 : (itemCount + grainSize - 1) / grainSize;
+    if (chunkCount <= 1 || m_pTaskScheduler == nullptr || m_pTaskScheduler->GetWorkerCount() == 0)
+    {
+        if (itemCount > 0)
+        {
+            record(GetCommandList(), 0, itemCount);
+        }
+        m_Statistics.recordMilliseconds += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+        return S_OK;
+    }
+
+    // チャンクの番号の順に並べるので、どのワーカーが記録しても実行順は変わらない
+    m_ChunkCommandLists.assign(chunkCount, nullptr);
+    m_ChunkResults.assign(chunkCount, S_OK);
+    m_pTaskScheduler->ParallelFor(name, chunkCount, 1, [this, itemCount, grainSize, &record](u32 chunkBegin, u32 chunkEnd)
+    {
+        for (u32 chunk = chunkBegin; chunk < chunkEnd; chunk++)
+        {
+            IGraphicsCommandList* pCommandList = nullptr;
+            HRESULT hr = m_pCommandListPool->Acquire(&pCommandList);
+            if (SUCCEEDED(hr))
+            {
+                const u32 begin = chunk * grainSize;
+                record(pCommandList, begin, std::min(begin + grainSize, itemCount));
+                hr = pCommandList->Close();
+            }
+            m_ChunkCommandLists[chunk] = pCommandList;
+            m_ChunkResults[chunk] = hr;
+        }
+    });
+    for (HRESULT hr : m_ChunkResults)
+    {
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    // 前後のリストの間に入れる (後に続く記録は新しいリストへ)
+    HRESULT hr = GetCommandList()->Close();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_CommandLists.insert(m_CommandLists.end(), m_ChunkCommandLists.begin(), m_ChunkCommandLists.end());
+
+    IGraphicsCommandList* pCommandList = nullptr;
+    hr = m_pCommandListPool->Acquire(&pCommandList);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_CommandLists.push_back(pCommandList);
+
+    m_Statistics.parallelCount++;
+    m_Statistics.chunkCount += chunkCount;
+    m_Statistics.recordMilliseconds += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+    return S_OK;
+}
+
+
+HRESULT ParallelCommandRecorder::Submit(IGraphicsCommandQueue* pQueue)
+{
+    HRESULT hr = GetCommandList()->Close();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pQueue->ExecuteCommandLists(static_cast<u32>(m_CommandLists.size()), m_CommandLists.data());
+    m_Statistics.frameCount++;
+    m_Statistics.commandListCount += m_CommandLists.size();
+    m_CommandLists.clear();
+    return S_OK;
+}
+
+
+const ParallelCommandRecorderStatistics& ParallelCommandRecorder::GetStatistics() const
+{
+    return m_Statistics;
+}
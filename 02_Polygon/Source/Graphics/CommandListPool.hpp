@@ -0,0 +1,122 @@
+﻿#pragma once
+
+
+// コマンドリストの並列記録
+// CommandListPool         : アロケータとコマンドリストの組を貸し出し、GPU が使い終わったら (フェンスで) 回収する
+// ParallelCommandRecorder : 1 フレームのコマンドを順番の決まった複数のコマンドリストに記録し、1 回の ExecuteCommandLists で実行する
+//
+// 記録中のアロケータは 1 つのコマンドリストだけが使うので、ワーカーごとにロックせずに記録できる
+// 分けて記録したリストは状態を引き継がない (パイプラインやレンダーターゲットはリストごとに設定する)
+
+
+// 統計情報
+struct CommandListPoolStatistics
+{
+    u32 commandListCount; // 作った組の数
+    u32 inUseCount;       // 記録中か GPU の完了待ち
+    u32 peakInUseCount;
+    u64 acquireCount;     // 累計
+};
+
+
+class CommandListPool
+{
+public:
+    CommandListPool();
+
+    ~CommandListPool();
+
+    void Init(IGraphicsDevice* pDevice, COMMAND_LIST_TYPE type);
+
+    // GPU が使い終わっていること
+    void Term();
+
+    // 記録を始めたコマンドリストを返す (複数のスレッドから呼んでよい)
+    // アロケータはこのリスト専用で、FinishFrame のフェンス値が完了するまで他に貸さない
+    HRESULT Acquire(IGraphicsCommandList** ppOut);
+
+    // このフレームで貸したものをキューに積んだフェンス値に結び付ける
+    void FinishFrame(u64 fenceValue);
+
+    // GPU が完了したフレームのものを再利用可能にする
+    void Reclaim(u64 completedFenceValue);
+
+    void GetStatistics(CommandListPoolStatistics* pOut) const;
+
+private:
+    struct Entry
+    {
+        std::unique_ptr<IGraphicsCommandAllocator> commandAllocator;
+        std::unique_ptr<IGraphicsCommandList>      commandList;
+        u64                                        fenceValue;
+    };
+
+private:
+    IGraphicsDevice*   m_pDevice;
+    COMMAND_LIST_TYPE  m_Type;
+
+    mutable std::mutex                  m_Mutex;
+    std::vector<std::unique_ptr<Entry>> m_FreeEntries;
+    std::vector<std::unique_ptr<Entry>> m_FrameEntries;   // このフレームで貸したもの
+    std::deque<std::unique_ptr<Entry>>  m_RetiredEntries; // GPU の完了待ち (フェンス値の順)
+
+    u32 m_CommandListCount;
+    u32 m_PeakInUseCount;
+    u64 m_AcquireCount;
+};
+
+
+// 分けて記録する処理 ([begin, end) を pCommandList に記録する)
+typedef std::function<void(IGraphicsCommandList* pCommandList, u32 begin, u32 end)> CommandRecordFunction;
+
+
+// 統計情報 (累計)
+struct ParallelCommandRecorderStatistics
+{
+    u64 frameCount;
+    u64 commandListCount;   // 実行したコマンドリスト
+    u64 recordCount;        // RecordParallel の呼び出し
+    u64 parallelCount;      // そのうちワーカーで分けて記録したもの
+    u64 chunkCount;         // 分けた数
+    u64 itemCount;
+    f64 recordMilliseconds; // RecordParallel にかかった時間
+};
+
+
+class ParallelCommandRecorder
+{
+public:
+    ParallelCommandRecorder();
+
+    ~ParallelCommandRecorder();
+
+    // pTaskScheduler が nullptr かワーカーが無ければ分けずに記録する
+    void Init(CommandListPool* pCommandListPool, TaskScheduler* pTaskScheduler);
+
+    void Term();
+
+    // フレームの記録を始める
+    HRESULT Begin();
+
+    // 順番に記録するコマンドリスト (RecordParallel の後は別のリストになる)
+    IGraphicsCommandList* GetCommandList() const;
+
+    // [0, itemCount) を grainSize 個ずつ別のコマンドリストにワーカーで記録する
+    // 前後に GetCommandList へ記録したものとの順番は保つ
+    // 1 つに収まる数なら (grainSize が 0 でも) 今のリストにそのまま記録する
+    HRESULT RecordParallel(const char* name, u32 itemCount, u32 grainSize, const CommandRecordFunction& record);
+
+    // 全て閉じ、記録した順に 1 回の ExecuteCommandLists で実行する
+    HRESULT Submit(IGraphicsCommandQueue* pQueue);
+
+    const ParallelCommandRecorderStatistics& GetStatistics() const;
+
+private:
+    CommandListPool*                   m_pCommandListPool;
+    TaskScheduler*                     m_pTaskScheduler;
+    std::vector<IGraphicsCommandList*> m_CommandLists;      // 実行する順 (最後が記録中)
+    std::vector<IGraphicsCommandList*> m_ChunkCommandLists; // RecordParallel で分けたもの
+    std::vector<HRESULT>               m_ChunkResults;
+
+    ParallelCommandRecorderStatistics m_Statistics;
+};
@@ -0,0 +1,1610 @@
+﻿
+#if defined(_WIN32)
+
+// DXGI & D3D12 のライブラリをリンク
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d3d12.lib")
+
+
+//-----------------------------------------------------------------
+// 型変換
+//-----------------------------------------------------------------
+DXGI_FORMAT ToDXGIFormat(GRAPHICS_FORMAT format)
+{
+    switch (format)
+    {
+    case GRAPHICS_FORMAT_R8G8B8A8_UNORM:     return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case GRAPHICS_FORMAT_R32G32_FLOAT:       return DXGI_FORMAT_R32G32_FLOAT;
+    case GRAPHICS_FORMAT_R32G32B32_FLOAT:    return DXGI_FORMAT_R32G32B32_FLOAT;
+    case GRAPHICS_FORMAT_R32G32B32A32_FLOAT: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case GRAPHICS_FORMAT_R16_UINT:           return DXGI_FORMAT_R16_UINT;
+    case GRAPHICS_FORMAT_R32_UINT:           return DXGI_FORMAT_R32_UINT;
+    case GRAPHICS_FORMAT_D32_FLOAT:          return DXGI_FORMAT_D32_FLOAT;
+    default:                                 return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+
+D3D12_COMMAND_LIST_TYPE ToD3D12CommandListType(COMMAND_LIST_TYPE type)
+{
+    switch (type)
+    {
+    case COMMAND_LIST_TYPE_COMPUTE: return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    case COMMAND_LIST_TYPE_COPY:    return D3D12_COMMAND_LIST_TYPE_COPY;
+    default:                        return D3D12_COMMAND_LIST_TYPE_DIRECT;
+    }
+}
+
+
+D3D12_HEAP_TYPE ToD3D12HeapType(HEAP_TYPE type)
+{
+    switch (type)
+    {
+    case HEAP_TYPE_UPLOAD:   return D3D12_HEAP_TYPE_UPLOAD;
+    case HEAP_TYPE_READBACK: return D3D12_HEAP_TYPE_READBACK;
+    default:                 return D3D12_HEAP_TYPE_DEFAULT;
+    }
+}
+
+
+D3D12_HEAP_FLAGS ToD3D12HeapFlags(HEAP_FLAG flags)
+{
+    D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_NONE;
+    if (flags & HEAP_FLAG_ALLOW_ONLY_BUFFERS)
+    {
+        heapFlags |= D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+    }
+    if (flags & HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES)
+    {
+        heapFlags |= D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+    }
+    if (flags & HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES)
+    {
+        heapFlags |= D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    }
+    return heapFlags;
+}
+
+
+D3D12_RESOURCE_DESC ToD3D12ResourceDesc(const ResourceDesc& desc)
+{
+    D3D12_RESOURCE_DESC resourceDesc = {};
+    resourceDesc.Dimension = desc.dimension == RESOURCE_DIMENSION_BUFFER ? D3D12_RESOURCE_DIMENSION_BUFFER : D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.Alignment = desc.alignment;
+    resourceDesc.Width = desc.width;
+    resourceDesc.Height = desc.height;
+    resourceDesc.DepthOrArraySize = desc.depthOrArraySize;
+    resourceDesc.MipLevels = desc.mipLevels;
+    resourceDesc.Format = ToDXGIFormat(desc.format);
+    resourceDesc.SampleDesc.Count = desc.sampleCount;
+    resourceDesc.SampleDesc.Quality = 0;
+    resourceDesc.Layout = desc.dimension == RESOURCE_DIMENSION_BUFFER ? D3D12_TEXTURE_LAYOUT_ROW_MAJOR : D3D12_TEXTURE_LAYOUT_UNKNOWN;
+    resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+    if (desc.flags & RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+    {
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+    }
+    if (desc.flags & RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)
+    {
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+    }
+    if (desc.flags & RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)
+    {
+        resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+    }
+    return resourceDesc;
+}
+
+
+static D3D12_DESCRIPTOR_HEAP_TYPE ToD3D12DescriptorHeapType(DESCRIPTOR_HEAP_TYPE type)
+{
+    switch (type)
+    {
+    case DESCRIPTOR_HEAP_TYPE_SAMPLER: return D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+    case DESCRIPTOR_HEAP_TYPE_RTV:     return D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    case DESCRIPTOR_HEAP_TYPE_DSV:     return D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    default:                           return D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    }
+}
+
+
+static D3D12_PRIMITIVE_TOPOLOGY ToD3D12PrimitiveTopology(PRIMITIVE_TOPOLOGY topology)
+{
+    switch (topology)
+    {
+    case PRIMITIVE_TOPOLOGY_POINTLIST:     return D3D_PRIMITIVE_TOPOLOGY_POINTLIST;
+    case PRIMITIVE_TOPOLOGY_LINELIST:      return D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+    case PRIMITIVE_TOPOLOGY_LINESTRIP:     return D3D_PRIMITIVE_TOPOLOGY_LINESTRIP;
+    case PRIMITIVE_TOPOLOGY_TRIANGLELIST:  return D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    case PRIMITIVE_TOPOLOGY_TRIANGLESTRIP: return D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
+    default:                               return D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    }
+}
+
+
+static D3D12_PRIMITIVE_TOPOLOGY_TYPE ToD3D12PrimitiveTopologyType(PRIMITIVE_TOPOLOGY_TYPE type)
+{
+    switch (type)
+    {
+    case PRIMITIVE_TOPOLOGY_TYPE_POINT:    return D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+    case PRIMITIVE_TOPOLOGY_TYPE_LINE:     return D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+    case PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE: return D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    default:                               return D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED;
+    }
+}
+
+
+static D3D12_BLEND ToD3D12Blend(BLEND blend)
+{
+    switch (blend)
+    {
+    case BLEND_ONE:           return D3D12_BLEND_ONE;
+    case BLEND_SRC_ALPHA:     return D3D12_BLEND_SRC_ALPHA;
+    case BLEND_INV_SRC_ALPHA: return D3D12_BLEND_INV_SRC_ALPHA;
+    default:                  return D3D12_BLEND_ZERO;
+    }
+}
+
+
+static D3D12_SHADER_VISIBILITY ToD3D12ShaderVisibility(SHADER_VISIBILITY visibility)
+{
+    switch (visibility)
+    {
+    case SHADER_VISIBILITY_VERTEX: return D3D12_SHADER_VISIBILITY_VERTEX;
+    case SHADER_VISIBILITY_PIXEL:  return D3D12_SHADER_VISIBILITY_PIXEL;
+    default:                       return D3D12_SHADER_VISIBILITY_ALL;
+    }
+}
+
+
+static D3D12_DESCRIPTOR_RANGE_TYPE ToD3D12DescriptorRangeType(DESCRIPTOR_RANGE_TYPE type)
+{
+    switch (type)
+    {
+    case DESCRIPTOR_RANGE_TYPE_UAV:     return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+    case DESCRIPTOR_RANGE_TYPE_CBV:     return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+    case DESCRIPTOR_RANGE_TYPE_SAMPLER: return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+    default:                            return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+    }
+}
+
+
+static D3D12_RESOURCE_BARRIER ToD3D12ResourceBarrier(const ResourceBarrierDesc& barrier)
+{
+    D3D12_RESOURCE_BARRIER resourceBarrier = {};
+
+    switch (barrier.flags)
+    {
+    case RESOURCE_BARRIER_FLAG_BEGIN_ONLY: resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY; break;
+    case RESOURCE_BARRIER_FLAG_END_ONLY:   resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY; break;
+    default:                               resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE; break;
+    }
+
+    ID3D12Resource* pResource = barrier.pResource != nullptr ? static_cast<GraphicsResourceD3D12*>(barrier.pResource)->GetD3D12Resource() : nullptr;
+
+    switch (barrier.type)
+    {
+    case RESOURCE_BARRIER_TYPE_ALIASING:
+        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        resourceBarrier.Aliasing.pResourceBefore = pResource;
+        resourceBarrier.Aliasing.pResourceAfter = barrier.pResourceAfter != nullptr ? static_cast<GraphicsResourceD3D12*>(barrier.pResourceAfter)->GetD3D12Resource() : nullptr;
+        break;
+
+    case RESOURCE_BARRIER_TYPE_UAV:
+        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        resourceBarrier.UAV.pResource = pResource;
+        break;
+
+    default:
+        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        resourceBarrier.Transition.pResource = pResource;
+        resourceBarrier.Transition.Subresource = barrier.subresource;
+        resourceBarrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(barrier.stateBefore); // 値は同じ
+        resourceBarrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(barrier.stateAfter);
+        break;
+    }
+
+    return resourceBarrier;
+}
+
+
+// パイプラインステートの設定の変換 (入力レイアウトは pInputElements を指す)
+static void ToD3D12GraphicsPipelineStateDesc(const GraphicsPipelineStateDesc& desc, std::vector<D3D12_INPUT_ELEMENT_DESC>* pInputElements, D3D12_GRAPHICS_PIPELINE_STATE_DESC* pOut)
+{
+    // 入力レイアウト
+    std::vector<D3D12_INPUT_ELEMENT_DESC>& inputElements = *pInputElements;
+    inputElements.resize(desc.inputLayout.numElements);
+    for (u32 i = 0; i < desc.inputLayout.numElements; i++)
+    {
+        const InputElementDesc& source = desc.inputLayout.pInputElementDescs[i];
+        D3D12_INPUT_ELEMENT_DESC& element = inputElements[i];
+        element.SemanticName = source.semanticName;
+        element.SemanticIndex = source.semanticIndex;
+        element.Format = ToDXGIFormat(source.format);
+        element.InputSlot = source.inputSlot;
+        element.AlignedByteOffset = source.alignedByteOffset == APPEND_ALIGNED_ELEMENT ? D3D12_APPEND_ALIGNED_ELEMENT : source.alignedByteOffset;
+        element.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+        element.InstanceDataStepRate = 0;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC& pipelineStateDesc = *pOut;
+    pipelineStateDesc = D3D12_GRAPHICS_PIPELINE_STATE_DESC();
+
+    // ルートシグネチャ
+    pipelineStateDesc.pRootSignature = static_cast<GraphicsRootSignatureD3D12*>(desc.pRootSignature)->GetD3D12RootSignature();
+
+    // シェーダー
+    pipelineStateDesc.VS.BytecodeLength = desc.VS.bytecodeLength;
+    pipelineStateDesc.VS.pShaderBytecode = desc.VS.pShaderBytecode;
+    pipelineStateDesc.PS.BytecodeLength = desc.PS.bytecodeLength;
+    pipelineStateDesc.PS.pShaderBytecode = desc.PS.pShaderBytecode;
+
+    // ラスタライザステート
+    pipelineStateDesc.SampleMask = desc.sampleMask;
+    pipelineStateDesc.RasterizerState.MultisampleEnable = desc.rasterizerState.multisampleEnable ? TRUE : FALSE;
+    pipelineStateDesc.RasterizerState.CullMode =
+        desc.rasterizerState.cullMode == CULL_MODE_FRONT ? D3D12_CULL_MODE_FRONT :
+        desc.rasterizerState.cullMode == CULL_MODE_BACK ? D3D12_CULL_MODE_BACK :
+        D3D12_CULL_MODE_NONE;
+    pipelineStateDesc.RasterizerState.FillMode = desc.rasterizerState.fillMode == FILL_MODE_WIREFRAME ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+    pipelineStateDesc.RasterizerState.DepthClipEnable = desc.rasterizerState.depthClipEnable ? TRUE : FALSE;
+
+    // ブレンドステート
+    pipelineStateDesc.BlendState.AlphaToCoverageEnable = FALSE;
+    pipelineStateDesc.BlendState.IndependentBlendEnable = FALSE;
+    pipelineStateDesc.BlendState.RenderTarget[0].BlendEnable = desc.blendState.blendEnable ? TRUE : FALSE;
+    pipelineStateDesc.BlendState.RenderTarget[0].LogicOpEnable = FALSE;
+    pipelineStateDesc.BlendState.RenderTarget[0].SrcBlend = ToD3D12Blend(desc.blendState.srcBlend);
+    pipelineStateDesc.BlendState.RenderTarget[0].DestBlend = ToD3D12Blend(desc.blendState.destBlend);
+    pipelineStateDesc.BlendState.RenderTarget[0].BlendOp = desc.blendState.blendOp == BLEND_OP_SUBTRACT ? D3D12_BLEND_OP_SUBTRACT : D3D12_BLEND_OP_ADD;
+    pipelineStateDesc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+    pipelineStateDesc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
+    pipelineStateDesc.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+    pipelineStateDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = desc.blendState.renderTargetWriteMask;
+
+    // デプスステート
+    pipelineStateDesc.DepthStencilState.DepthEnable = desc.depthEnable ? TRUE : FALSE;
+    pipelineStateDesc.DepthStencilState.DepthWriteMask = desc.depthEnable ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    pipelineStateDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+
+    // 入力レイアウト
+    pipelineStateDesc.InputLayout.NumElements = desc.inputLayout.numElements;
+    pipelineStateDesc.InputLayout.pInputElementDescs = inputElements.data();
+
+    // プリミティブトポロジータイプ
+    pipelineStateDesc.PrimitiveTopologyType = ToD3D12PrimitiveTopologyType(desc.primitiveTopologyType);
+
+    // レンダーターゲット
+    pipelineStateDesc.NumRenderTargets = desc.numRenderTargets;
+    for (u32 i = 0; i < desc.numRenderTargets && i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+    {
+        pipelineStateDesc.RTVFormats[i] = ToDXGIFormat(desc.rtvFormats[i]);
+    }
+    pipelineStateDesc.DSVFormat = ToDXGIFormat(desc.dsvFormat);
+
+    // アンチエイリアス マルチサンプル
+    pipelineStateDesc.SampleDesc.Count = desc.sampleCount;
+    pipelineStateDesc.SampleDesc.Quality = 0;
+}
+
+
+static std::string ToString(ID3DBlob* pBlob)
+{
+    std::string text;
+    if (pBlob != nullptr)
+    {
+        text.resize(pBlob->GetBufferSize());
+        std::copy_n(
+            (char*)pBlob->GetBufferPointer(),
+            pBlob->GetBufferSize(),
+            text.begin()
+        );
+    }
+    return text;
+}
+
+
+static void EnableDebugLayer()
+{
+    ComPtr<ID3D12Debug> debugLayer;
+    HRESULT hr = D3D12GetDebugInterface(IID_PPV_ARGS(&debugLayer));
+    if (SUCCEEDED(hr))
+    {
+        debugLayer->EnableDebugLayer();
+    }
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsResourceD3D12
+//-----------------------------------------------------------------
+GraphicsResourceD3D12::GraphicsResourceD3D12(const ComPtr<ID3D12Resource>& resource, const ResourceDesc& desc)
+    : m_Resource(resource)
+    , m_Desc(desc)
+{
+
+}
+
+
+GraphicsResourceD3D12::~GraphicsResourceD3D12()
+{
+
+}
+
+
+const ResourceDesc& GraphicsResourceD3D12::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+HRESULT GraphicsResourceD3D12::Map(u32 subresource, void** ppData)
+{
+    return m_Resource->Map(
+        subresource,
+        nullptr,   // 範囲指定。全範囲なので nullptr でよい
+        ppData
+    );
+}
+
+
+void GraphicsResourceD3D12::Unmap(u32 subresource)
+{
+    m_Resource->Unmap(subresource, nullptr);
+}
+
+
+u64 GraphicsResourceD3D12::GetGPUVirtualAddress() const
+{
+    return m_Resource->GetGPUVirtualAddress();
+}
+
+
+ID3D12Resource* GraphicsResourceD3D12::GetD3D12Resource() const
+{
+    return m_Resource.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsHeapD3D12
+//-----------------------------------------------------------------
+GraphicsHeapD3D12::GraphicsHeapD3D12(const ComPtr<ID3D12Heap>& heap, const HeapDesc& desc)
+    : m_Heap(heap)
+    , m_Desc(desc)
+{
+
+}
+
+
+GraphicsHeapD3D12::~GraphicsHeapD3D12()
+{
+
+}
+
+
+const HeapDesc& GraphicsHeapD3D12::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+ID3D12Heap* GraphicsHeapD3D12::GetD3D12Heap() const
+{
+    return m_Heap.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsRootSignatureD3D12
+//-----------------------------------------------------------------
+GraphicsRootSignatureD3D12::GraphicsRootSignatureD3D12(const ComPtr<ID3D12RootSignature>& rootSignature)
+    : m_RootSignature(rootSignature)
+{
+
+}
+
+
+GraphicsRootSignatureD3D12::~GraphicsRootSignatureD3D12()
+{
+
+}
+
+
+ID3D12RootSignature* GraphicsRootSignatureD3D12::GetD3D12RootSignature() const
+{
+    return m_RootSignature.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsPipelineStateD3D12
+//-----------------------------------------------------------------
+GraphicsPipelineStateD3D12::GraphicsPipelineStateD3D12(const ComPtr<ID3D12PipelineState>& pipelineState)
+    : m_PipelineState(pipelineState)
+{
+
+}
+
+
+GraphicsPipelineStateD3D12::~GraphicsPipelineStateD3D12()
+{
+
+}
+
+
+ID3D12PipelineState* GraphicsPipelineStateD3D12::GetD3D12PipelineState() const
+{
+    return m_PipelineState.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsPipelineLibraryD3D12
+//-----------------------------------------------------------------
+GraphicsPipelineLibraryD3D12::GraphicsPipelineLibraryD3D12()
+{
+
+}
+
+
+GraphicsPipelineLibraryD3D12::~GraphicsPipelineLibraryD3D12()
+{
+
+}
+
+
+HRESULT GraphicsPipelineLibraryD3D12::Init(ID3D12Device1* pDevice, const void* pData, size_t dataSize)
+{
+    if (dataSize > 0)
+    {
+        const u8* pBegin = static_cast<const u8*>(pData);
+        m_Data.assign(pBegin, pBegin + dataSize);
+    }
+    return pDevice->CreatePipelineLibrary(m_Data.data(), m_Data.size(), IID_PPV_ARGS(&m_Library));
+}
+
+
+HRESULT GraphicsPipelineLibraryD3D12::LoadGraphicsPipeline(const char* name, const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut)
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc = {};
+    ToD3D12GraphicsPipelineStateDesc(desc, &inputElements, &pipelineStateDesc);
+
+    // 名前は ASCII のみ
+    const std::wstring wideName(name, name + std::strlen(name));
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    HRESULT hr = m_Library->LoadGraphicsPipeline(wideName.c_str(), &pipelineStateDesc, IID_PPV_ARGS(&pipelineState));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsPipelineStateD3D12(pipelineState));
+    return S_OK;
+}
+
+
+HRESULT GraphicsPipelineLibraryD3D12::StorePipeline(const char* name, IGraphicsPipelineState* pPipelineState)
+{
+    const std::wstring wideName(name, name + std::strlen(name));
+    return m_Library->StorePipeline(wideName.c_str(), static_cast<GraphicsPipelineStateD3D12*>(pPipelineState)->GetD3D12PipelineState());
+}
+
+
+size_t GraphicsPipelineLibraryD3D12::GetSerializedSize() const
+{
+    return m_Library->GetSerializedSize();
+}
+
+
+HRESULT GraphicsPipelineLibraryD3D12::Serialize(void* pData, size_t dataSize)
+{
+    return m_Library->Serialize(pData, dataSize);
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsDescriptorHeapD3D12
+//-----------------------------------------------------------------
+GraphicsDescriptorHeapD3D12::GraphicsDescriptorHeapD3D12(const ComPtr<ID3D12DescriptorHeap>& descriptorHeap, const DescriptorHeapDesc& desc)
+    : m_DescriptorHeap(descriptorHeap)
+    , m_Desc(desc)
+{
+
+}
+
+
+GraphicsDescriptorHeapD3D12::~GraphicsDescriptorHeapD3D12()
+{
+
+}
+
+
+const DescriptorHeapDesc& GraphicsDescriptorHeapD3D12::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+CpuDescriptorHandle GraphicsDescriptorHeapD3D12::GetCPUDescriptorHandleForHeapStart() const
+{
+    CpuDescriptorHandle handle = { m_DescriptorHeap->GetCPUDescriptorHandleForHeapStart().ptr };
+    return handle;
+}
+
+
+GpuDescriptorHandle GraphicsDescriptorHeapD3D12::GetGPUDescriptorHandleForHeapStart() const
+{
+    GpuDescriptorHandle handle = { 0 };
+    if (m_Desc.shaderVisible)
+    {
+        handle.ptr = m_DescriptorHeap->GetGPUDescriptorHandleForHeapStart().ptr;
+    }
+    return handle;
+}
+
+
+ID3D12DescriptorHeap* GraphicsDescriptorHeapD3D12::GetD3D12DescriptorHeap() const
+{
+    return m_DescriptorHeap.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsFenceD3D12
+//-----------------------------------------------------------------
+GraphicsFenceD3D12::GraphicsFenceD3D12(const ComPtr<ID3D12Fence>& fence)
+    : m_Fence(fence)
+    , m_Event(nullptr)
+{
+
+}
+
+
+GraphicsFenceD3D12::~GraphicsFenceD3D12()
+{
+    if (m_Event != nullptr)
+    {
+        CloseHandle(m_Event);
+    }
+}
+
+
+HRESULT GraphicsFenceD3D12::Init()
+{
+    // 自動リセットのイベント
+    m_Event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (m_Event == nullptr)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    return S_OK;
+}
+
+
+u64 GraphicsFenceD3D12::GetCompletedValue() const
+{
+    return m_Fence->GetCompletedValue();
+}
+
+
+HRESULT GraphicsFenceD3D12::Wait(u64 value)
+{
+    if (m_Fence->GetCompletedValue() >= value)
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = m_Fence->SetEventOnCompletion(value, m_Event);
+    if (SUCCEEDED(hr))
+    {
+        WaitForSingleObject(m_Event, INFINITE);
+    }
+    return hr;
+}
+
+
+ID3D12Fence* GraphicsFenceD3D12::GetD3D12Fence() const
+{
+    return m_Fence.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandAllocatorD3D12
+//-----------------------------------------------------------------
+GraphicsCommandAllocatorD3D12::GraphicsCommandAllocatorD3D12(const ComPtr<ID3D12CommandAllocator>& commandAllocator)
+    : m_CommandAllocator(commandAllocator)
+{
+
+}
+
+
+GraphicsCommandAllocatorD3D12::~GraphicsCommandAllocatorD3D12()
+{
+
+}
+
+
+HRESULT GraphicsCommandAllocatorD3D12::Reset()
+{
+    return m_CommandAllocator->Reset();
+}
+
+
+ID3D12CommandAllocator* GraphicsCommandAllocatorD3D12::GetD3D12CommandAllocator() const
+{
+    return m_CommandAllocator.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandListD3D12
+//-----------------------------------------------------------------
+GraphicsCommandListD3D12::GraphicsCommandListD3D12(const ComPtr<ID3D12GraphicsCommandList>& commandList, COMMAND_LIST_TYPE type)
+    : m_CommandList(commandList)
+    , m_Type(type)
+    , m_DrawCount(0)
+    , m_ResourceBarrierCallCount(0)
+    , m_ResourceBarrierCount(0)
+{
+
+}
+
+
+GraphicsCommandListD3D12::~GraphicsCommandListD3D12()
+{
+
+}
+
+
+COMMAND_LIST_TYPE GraphicsCommandListD3D12::GetType() const
+{
+    return m_Type;
+}
+
+
+HRESULT GraphicsCommandListD3D12::Close()
+{
+    return m_CommandList->Close();
+}
+
+
+HRESULT GraphicsCommandListD3D12::Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState)
+{
+    m_DrawCount = 0;
+    m_ResourceBarrierCallCount = 0;
+    m_ResourceBarrierCount = 0;
+    return m_CommandList->Reset(
+        static_cast<GraphicsCommandAllocatorD3D12*>(pAllocator)->GetD3D12CommandAllocator(),
+        pInitialState != nullptr ? static_cast<GraphicsPipelineStateD3D12*>(pInitialState)->GetD3D12PipelineState() : nullptr
+    );
+}
+
+
+void GraphicsCommandListD3D12::ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers)
+{
+    m_ResourceBarrierCallCount++;
+    m_ResourceBarrierCount += numBarriers;
+
+    // 一定数ずつまとめて発行
+    const u32 BatchSize = 16;
+    D3D12_RESOURCE_BARRIER resourceBarriers[BatchSize];
+
+    for (u32 i = 0; i < numBarriers; i += BatchSize)
+    {
+        const u32 count = std::min(BatchSize, numBarriers - i);
+        for (u32 j = 0; j < count; j++)
+        {
+            resourceBarriers[j] = ToD3D12ResourceBarrier(pBarriers[i + j]);
+        }
+        m_CommandList->ResourceBarrier(count, resourceBarriers);
+    }
+}
+
+
+void GraphicsCommandListD3D12::OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE renderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    for (u32 i = 0; i < numRenderTargets && i < D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+    {
+        renderTargets[i].ptr = pRenderTargets[i].ptr;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE depthStencil = {};
+    if (pDepthStencil != nullptr)
+    {
+        depthStencil.ptr = pDepthStencil->ptr;
+    }
+
+    m_CommandList->OMSetRenderTargets(
+        numRenderTargets,
+        renderTargets,
+        FALSE,
+        pDepthStencil != nullptr ? &depthStencil : nullptr
+    );
+}
+
+
+void GraphicsCommandListD3D12::ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4])
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = { renderTarget.ptr };
+    m_CommandList->ClearRenderTargetView(handle, color, 0, nullptr);
+}
+
+
+void GraphicsCommandListD3D12::SetPipelineState(IGraphicsPipelineState* pPipelineState)
+{
+    m_CommandList->SetPipelineState(static_cast<GraphicsPipelineStateD3D12*>(pPipelineState)->GetD3D12PipelineState());
+}
+
+
+void GraphicsCommandListD3D12::SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature)
+{
+    m_CommandList->SetGraphicsRootSignature(static_cast<GraphicsRootSignatureD3D12*>(pRootSignature)->GetD3D12RootSignature());
+}
+
+
+void GraphicsCommandListD3D12::SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps)
+{
+    // CBV_SRV_UAV と SAMPLER の 2 つまで
+    ID3D12DescriptorHeap* descriptorHeaps[2] = {};
+    for (u32 i = 0; i < numHeaps && i < _countof(descriptorHeaps); i++)
+    {
+        descriptorHeaps[i] = static_cast<GraphicsDescriptorHeapD3D12*>(ppHeaps[i])->GetD3D12DescriptorHeap();
+    }
+    m_CommandList->SetDescriptorHeaps(std::min<u32>(numHeaps, _countof(descriptorHeaps)), descriptorHeaps);
+}
+
+
+void GraphicsCommandListD3D12::SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor)
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = { baseDescriptor.ptr };
+    m_CommandList->SetGraphicsRootDescriptorTable(rootParameterIndex, handle);
+}
+
+
+void GraphicsCommandListD3D12::SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues)
+{
+    m_CommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, pData, destOffsetIn32BitValues);
+}
+
+
+void GraphicsCommandListD3D12::SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation)
+{
+    m_CommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
+
+void GraphicsCommandListD3D12::RSSetViewports(u32 numViewports, const Viewport* pViewports)
+{
+    D3D12_VIEWPORT viewports[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
+    const u32 count = std::min<u32>(numViewports, _countof(viewports));
+    for (u32 i = 0; i < count; i++)
+    {
+        viewports[i].TopLeftX = pViewports[i].topLeftX;
+        viewports[i].TopLeftY = pViewports[i].topLeftY;
+        viewports[i].Width = pViewports[i].width;
+        viewports[i].Height = pViewports[i].height;
+        viewports[i].MinDepth = pViewports[i].minDepth;
+        viewports[i].MaxDepth = pViewports[i].maxDepth;
+    }
+    m_CommandList->RSSetViewports(count, viewports);
+}
+
+
+void GraphicsCommandListD3D12::RSSetScissorRects(u32 numRects, const Rect* pRects)
+{
+    D3D12_RECT rects[D3D12_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE] = {};
+    const u32 count = std::min<u32>(numRects, _countof(rects));
+    for (u32 i = 0; i < count; i++)
+    {
+        rects[i].left = pRects[i].left;
+        rects[i].top = pRects[i].top;
+        rects[i].right = pRects[i].right;
+        rects[i].bottom = pRects[i].bottom;
+    }
+    m_CommandList->RSSetScissorRects(count, rects);
+}
+
+
+void GraphicsCommandListD3D12::IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+    m_CommandList->IASetPrimitiveTopology(ToD3D12PrimitiveTopology(primitiveTopology));
+}
+
+
+void GraphicsCommandListD3D12::IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews)
+{
+    D3D12_VERTEX_BUFFER_VIEW views[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+    const u32 count = std::min<u32>(numViews, _countof(views));
+    for (u32 i = 0; i < count; i++)
+    {
+        views[i].BufferLocation = pViews[i].bufferLocation;
+        views[i].SizeInBytes = pViews[i].sizeInBytes;
+        views[i].StrideInBytes = pViews[i].strideInBytes;
+    }
+    m_CommandList->IASetVertexBuffers(startSlot, count, views);
+}
+
+
+void GraphicsCommandListD3D12::IASetIndexBuffer(const IndexBufferView* pView)
+{
+    if (pView == nullptr)
+    {
+        m_CommandList->IASetIndexBuffer(nullptr);
+        return;
+    }
+
+    D3D12_INDEX_BUFFER_VIEW view = {};
+    view.BufferLocation = pView->bufferLocation;
+    view.SizeInBytes = pView->sizeInBytes;
+    view.Format = ToDXGIFormat(pView->format);
+    m_CommandList->IASetIndexBuffer(&view);
+}
+
+
+void GraphicsCommandListD3D12::DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation)
+{
+    m_DrawCount++;
+    m_CommandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+
+void GraphicsCommandListD3D12::DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation)
+{
+    m_DrawCount++;
+    m_CommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+
+void GraphicsCommandListD3D12::CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes)
+{
+    m_CommandList->CopyBufferRegion(
+        static_cast<GraphicsResourceD3D12*>(pDstBuffer)->GetD3D12Resource(),
+        dstOffset,
+        static_cast<GraphicsResourceD3D12*>(pSrcBuffer)->GetD3D12Resource(),
+        srcOffset,
+        numBytes
+    );
+}
+
+
+ID3D12GraphicsCommandList* GraphicsCommandListD3D12::GetD3D12CommandList() const
+{
+    return m_CommandList.Get();
+}
+
+
+u32 GraphicsCommandListD3D12::GetDrawCount() const
+{
+    return m_DrawCount;
+}
+
+
+u32 GraphicsCommandListD3D12::GetResourceBarrierCallCount() const
+{
+    return m_ResourceBarrierCallCount;
+}
+
+
+u32 GraphicsCommandListD3D12::GetResourceBarrierCount() const
+{
+    return m_ResourceBarrierCount;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandQueueD3D12
+//-----------------------------------------------------------------
+GraphicsCommandQueueD3D12::GraphicsCommandQueueD3D12(const ComPtr<ID3D12CommandQueue>& commandQueue, COMMAND_LIST_TYPE type, GraphicsStatistics* pStatistics)
+    : m_CommandQueue(commandQueue)
+    , m_Type(type)
+    , m_pStatistics(pStatistics)
+{
+
+}
+
+
+GraphicsCommandQueueD3D12::~GraphicsCommandQueueD3D12()
+{
+
+}
+
+
+COMMAND_LIST_TYPE GraphicsCommandQueueD3D12::GetType() const
+{
+    return m_Type;
+}
+
+
+void GraphicsCommandQueueD3D12::ExecuteCommandLists(u32 numCommandLists, IGraphicsCommandList* const* ppCommandLists)
+{
+    std::vector<ID3D12CommandList*> commandLists(numCommandLists);
+    for (u32 i = 0; i < numCommandLists; i++)
+    {
+        GraphicsCommandListD3D12* pCommandList = static_cast<GraphicsCommandListD3D12*>(ppCommandLists[i]);
+        commandLists[i] = pCommandList->GetD3D12CommandList();
+        m_pStatistics->drawCount += pCommandList->GetDrawCount();
+        m_pStatistics->resourceBarrierCalls += pCommandList->GetResourceBarrierCallCount();
+        m_pStatistics->resourceBarriers += pCommandList->GetResourceBarrierCount();
+    }
+
+    m_CommandQueue->ExecuteCommandLists(
+        numCommandLists,
+        commandLists.data()
+    );
+
+    m_pStatistics->executedCommandLists += numCommandLists;
+}
+
+
+HRESULT GraphicsCommandQueueD3D12::Signal(IGraphicsFence* pFence, u64 value)
+{
+    return m_CommandQueue->Signal(static_cast<GraphicsFenceD3D12*>(pFence)->GetD3D12Fence(), value);
+}
+
+
+HRESULT GraphicsCommandQueueD3D12::Wait(IGraphicsFence* pFence, u64 value)
+{
+    return m_CommandQueue->Wait(static_cast<GraphicsFenceD3D12*>(pFence)->GetD3D12Fence(), value);
+}
+
+
+ID3D12CommandQueue* GraphicsCommandQueueD3D12::GetD3D12CommandQueue() const
+{
+    return m_CommandQueue.Get();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsSwapChainD3D12
+//-----------------------------------------------------------------
+GraphicsSwapChainD3D12::GraphicsSwapChainD3D12(GraphicsStatistics* pStatistics)
+    : m_Desc({})
+    , m_pStatistics(pStatistics)
+{
+
+}
+
+
+GraphicsSwapChainD3D12::~GraphicsSwapChainD3D12()
+{
+
+}
+
+
+HRESULT GraphicsSwapChainD3D12::Init(const ComPtr<IDXGISwapChain4>& swapChain, const SwapChainDesc& desc)
+{
+    m_SwapChain = swapChain;
+    m_Desc = desc;
+
+    ResourceDesc resourceDesc = {};
+    resourceDesc.dimension = RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.width = desc.width;
+    resourceDesc.height = desc.height;
+    resourceDesc.depthOrArraySize = 1;
+    resourceDesc.mipLevels = 1;
+    resourceDesc.format = desc.format;
+    resourceDesc.sampleCount = 1;
+    resourceDesc.flags = RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+    for (UINT i = 0; i < desc.bufferCount; i++)
+    {
+        ComPtr<ID3D12Resource> backBuffer;
+        HRESULT hr = m_SwapChain->GetBuffer(i, IID_PPV_ARGS(&backBuffer));
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_Buffers.emplace_back(new GraphicsResourceD3D12(backBuffer, resourceDesc));
+    }
+
+    return S_OK;
+}
+
+
+u32 GraphicsSwapChainD3D12::GetBufferCount() const
+{
+    return m_Desc.bufferCount;
+}
+
+
+u32 GraphicsSwapChainD3D12::GetCurrentBackBufferIndex() const
+{
+    return m_SwapChain->GetCurrentBackBufferIndex();
+}
+
+
+IGraphicsResource* GraphicsSwapChainD3D12::GetBuffer(u32 index) const
+{
+    if (index >= m_Buffers.size())
+    {
+        return nullptr;
+    }
+    return m_Buffers[index].get();
+}
+
+
+HRESULT GraphicsSwapChainD3D12::Present(u32 syncInterval)
+{
+    m_pStatistics->presentCount++;
+    return m_SwapChain->Present(syncInterval, 0);
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsDeviceD3D12
+//-----------------------------------------------------------------
+GraphicsDeviceD3D12::GraphicsDeviceD3D12()
+    : m_Statistics({})
+{
+
+}
+
+
+GraphicsDeviceD3D12::~GraphicsDeviceD3D12()
+{
+
+}
+
+
+HRESULT GraphicsDeviceD3D12::Init(bool enableDebugLayer)
+{
+    HRESULT hr = S_OK;
+
+    if (enableDebugLayer)
+    {
+        EnableDebugLayer();
+    }
+
+    // ファクトリーを生成
+    if (enableDebugLayer)
+    {
+        hr = CreateDXGIFactory2(DXGI_CREATE_FACTORY_DEBUG, IID_PPV_ARGS(&m_Factory));
+    }
+    else
+    {
+        hr = CreateDXGIFactory1(IID_PPV_ARGS(&m_Factory));
+    }
+    if (FAILED(hr))
+    {
+        DebugOutputFormatString("CreateDXGIFactory failed.");
+        return hr;
+    }
+
+    // アダプターを列挙
+    {
+        std::vector<ComPtr<IDXGIAdapter>> adapters;
+        for (UINT i = 0; ; i++)
+        {
+            ComPtr<IDXGIAdapter> adapter;
+
+            if (m_Factory->EnumAdapters(i, &adapter) == DXGI_ERROR_NOT_FOUND)
+            {
+                break;
+            }
+
+            adapters.push_back(adapter);
+        }
+
+        SIZE_T largestVideoMemory = 0;
+        for (auto& adapter : adapters)
+        {
+            DXGI_ADAPTER_DESC adapterDesc = {};
+
+            hr = adapter->GetDesc(&adapterDesc);
+
+            if (FAILED(hr)) { continue; }
+
+            // とりあえず一番大きいビデオメモリを持つものを選択
+            if (largestVideoMemory > adapterDesc.DedicatedVideoMemory)
+            {
+                largestVideoMemory = adapterDesc.DedicatedVideoMemory;
+                m_Adapter = adapter;
+            }
+        }
+    }
+
+    // D3D12デバイスを生成
+    {
+        struct {
+            D3D_FEATURE_LEVEL featureLevel;
+            char featureName[16];
+        }
+        featureLevels[] = {
+            { D3D_FEATURE_LEVEL_12_1, "12.1" },
+            { D3D_FEATURE_LEVEL_12_0, "12.0" },
+            { D3D_FEATURE_LEVEL_11_1, "11.1" },
+            { D3D_FEATURE_LEVEL_11_0, "11.0" },
+        };
+
+        for (int i = 0; i < _countof(featureLevels); i++)
+        {
+            hr = D3D12CreateDevice(
+                m_Adapter.Get(),
+                featureLevels[i].featureLevel,
+                IID_PPV_ARGS(&m_Device)
+            );
+            if (SUCCEEDED(hr))
+            {
+                DebugOutputFormatString("FeatureLevel[%s] is selected.", featureLevels[i].featureName);
+                break;
+            }
+        }
+
+        if (FAILED(hr))
+        {
+            DebugOutputFormatString("D3D12CreateDevice failed.");
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+
+GRAPHICS_BACKEND GraphicsDeviceD3D12::GetBackend() const
+{
+    return GRAPHICS_BACKEND_D3D12;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateCommandQueue(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandQueue>* pOut)
+{
+    D3D12_COMMAND_QUEUE_DESC commandQueueDesc = {};
+
+    // タイムアウトなし
+    commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+
+    // アダプターを一つしか使わない時は「0」で良い
+    commandQueueDesc.NodeMask = 0;
+
+    // プライオリティは特に指定なし
+    commandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+
+    // コマンドリストと合わせる
+    commandQueueDesc.Type = ToD3D12CommandListType(type);
+
+    ComPtr<ID3D12CommandQueue> commandQueue;
+    HRESULT hr = m_Device->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&commandQueue));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsCommandQueueD3D12(commandQueue, type, &m_Statistics));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateCommandAllocator(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandAllocator>* pOut)
+{
+    ComPtr<ID3D12CommandAllocator> commandAllocator;
+    HRESULT hr = m_Device->CreateCommandAllocator(
+        ToD3D12CommandListType(type),
+        IID_PPV_ARGS(&commandAllocator)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsCommandAllocatorD3D12(commandAllocator));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateCommandList(COMMAND_LIST_TYPE type, IGraphicsCommandAllocator* pAllocator, std::unique_ptr<IGraphicsCommandList>* pOut)
+{
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    HRESULT hr = m_Device->CreateCommandList(
+        0,
+        ToD3D12CommandListType(type),
+        static_cast<GraphicsCommandAllocatorD3D12*>(pAllocator)->GetD3D12CommandAllocator(),
+        nullptr,
+        IID_PPV_ARGS(&commandList)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsCommandListD3D12(commandList, type));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateSwapChain(IGraphicsCommandQueue* pQueue, void* windowHandle, const SwapChainDesc& desc, std::unique_ptr<IGraphicsSwapChain>* pOut)
+{
+    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+
+    swapChainDesc.Width = static_cast<UINT>(desc.width);
+    swapChainDesc.Height = static_cast<UINT>(desc.height);
+    swapChainDesc.Format = ToDXGIFormat(desc.format);
+    swapChainDesc.Stereo = FALSE;
+    swapChainDesc.SampleDesc.Count = 1;
+    swapChainDesc.SampleDesc.Quality = 0;
+    swapChainDesc.BufferUsage = DXGI_USAGE_BACK_BUFFER;
+    swapChainDesc.BufferCount = desc.bufferCount;
+
+    // バックバッファは伸び縮み可能
+    swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+
+    // フリップ後は速やかに破棄
+    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+
+    // 特に指定なし
+    swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+
+    // ウィンドウ ⇔ フルスクリーン切り替え可能
+    swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+
+    ComPtr<IDXGISwapChain1> swapChain1;
+    HRESULT hr = m_Factory->CreateSwapChainForHwnd(
+        static_cast<GraphicsCommandQueueD3D12*>(pQueue)->GetD3D12CommandQueue(),
+        reinterpret_cast<HWND>(windowHandle),
+        &swapChainDesc,
+        nullptr,
+        nullptr,
+        &swapChain1
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ComPtr<IDXGISwapChain4> swapChain;
+    hr = swapChain1.As(&swapChain);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<GraphicsSwapChainD3D12> graphicsSwapChain(new GraphicsSwapChainD3D12(&m_Statistics));
+    hr = graphicsSwapChain->Init(swapChain, desc);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(graphicsSwapChain.release());
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateDescriptorHeap(const DescriptorHeapDesc& desc, std::unique_ptr<IGraphicsDescriptorHeap>* pOut)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
+
+    // アダプターを一つしか使わない時は「0」で良い
+    descriptorHeapDesc.NodeMask = 0;
+
+    descriptorHeapDesc.Flags = desc.shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    descriptorHeapDesc.Type = ToD3D12DescriptorHeapType(desc.type);
+    descriptorHeapDesc.NumDescriptors = desc.numDescriptors;
+
+    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    HRESULT hr = m_Device->CreateDescriptorHeap(
+        &descriptorHeapDesc,
+        IID_PPV_ARGS(&descriptorHeap)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsDescriptorHeapD3D12(descriptorHeap, desc));
+    return S_OK;
+}
+
+
+u32 GraphicsDeviceD3D12::GetDescriptorHandleIncrementSize(DESCRIPTOR_HEAP_TYPE type) const
+{
+    return m_Device->GetDescriptorHandleIncrementSize(ToD3D12DescriptorHeapType(type));
+}
+
+
+void GraphicsDeviceD3D12::CreateRenderTargetView(IGraphicsResource* pResource, CpuDescriptorHandle destDescriptor)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = { destDescriptor.ptr };
+    m_Device->CreateRenderTargetView(
+        static_cast<GraphicsResourceD3D12*>(pResource)->GetD3D12Resource(),
+        nullptr,
+        handle
+    );
+}
+
+
+void GraphicsDeviceD3D12::CopyDescriptorsSimple(u32 numDescriptors, CpuDescriptorHandle destDescriptorRangeStart, CpuDescriptorHandle srcDescriptorRangeStart, DESCRIPTOR_HEAP_TYPE type)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE destHandle = { destDescriptorRangeStart.ptr };
+    D3D12_CPU_DESCRIPTOR_HANDLE srcHandle = { srcDescriptorRangeStart.ptr };
+    m_Device->CopyDescriptorsSimple(numDescriptors, destHandle, srcHandle, ToD3D12DescriptorHeapType(type));
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateFence(u64 initialValue, std::unique_ptr<IGraphicsFence>* pOut)
+{
+    ComPtr<ID3D12Fence> fence;
+    HRESULT hr = m_Device->CreateFence(
+        initialValue,
+        D3D12_FENCE_FLAG_NONE,
+        IID_PPV_ARGS(&fence)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<GraphicsFenceD3D12> graphicsFence(new GraphicsFenceD3D12(fence));
+    hr = graphicsFence->Init();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(graphicsFence.release());
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateCommittedResource(HEAP_TYPE heapType, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut)
+{
+    D3D12_HEAP_PROPERTIES heapProperties = {};
+    heapProperties.Type = ToD3D12HeapType(heapType);
+    heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN; // Type が D3D12_HEAP_TYPE_CUSTOM でないなら UNKNOWN でよい
+    heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN; // Type が D3D12_HEAP_TYPE_CUSTOM でないなら UNKNOWN でよい
+    heapProperties.CreationNodeMask = 0; // 単一アダプターの場合 0 でよい
+    heapProperties.VisibleNodeMask = 0; // 単一アダプターの場合 0 でよい
+
+    D3D12_RESOURCE_DESC resourceDesc = ToD3D12ResourceDesc(desc);
+
+    ComPtr<ID3D12Resource> resource;
+    HRESULT hr = m_Device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        static_cast<D3D12_RESOURCE_STATES>(initialState),
+        nullptr,
+        IID_PPV_ARGS(&resource)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsResourceD3D12(resource, desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateHeap(const HeapDesc& desc, std::unique_ptr<IGraphicsHeap>* pOut)
+{
+    D3D12_HEAP_DESC heapDesc = {};
+    heapDesc.SizeInBytes = desc.sizeInBytes;
+    heapDesc.Properties.Type = ToD3D12HeapType(desc.type);
+    heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+    heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+    heapDesc.Properties.CreationNodeMask = 0;
+    heapDesc.Properties.VisibleNodeMask = 0;
+    heapDesc.Alignment = desc.alignment;
+    heapDesc.Flags = ToD3D12HeapFlags(desc.flags);
+
+    ComPtr<ID3D12Heap> heap;
+    HRESULT hr = m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsHeapD3D12(heap, desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreatePlacedResource(IGraphicsHeap* pHeap, u64 heapOffset, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut)
+{
+    D3D12_RESOURCE_DESC resourceDesc = ToD3D12ResourceDesc(desc);
+
+    ComPtr<ID3D12Resource> resource;
+    HRESULT hr = m_Device->CreatePlacedResource(
+        static_cast<GraphicsHeapD3D12*>(pHeap)->GetD3D12Heap(),
+        heapOffset,
+        &resourceDesc,
+        static_cast<D3D12_RESOURCE_STATES>(initialState),
+        nullptr,
+        IID_PPV_ARGS(&resource)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsResourceD3D12(resource, desc));
+    return S_OK;
+}
+
+
+ResourceAllocationInfo GraphicsDeviceD3D12::GetResourceAllocationInfo(const ResourceDesc& desc) const
+{
+    D3D12_RESOURCE_DESC resourceDesc = ToD3D12ResourceDesc(desc);
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = m_Device->GetResourceAllocationInfo(0, 1, &resourceDesc);
+
+    ResourceAllocationInfo info = {};
+    info.sizeInBytes = allocationInfo.SizeInBytes;
+    info.alignment = allocationInfo.Alignment;
+    return info;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateRootSignature(const RootSignatureDesc& desc, std::unique_ptr<IGraphicsRootSignature>* pOut, std::string* pErrorText)
+{
+    // 変換後のディスクリプタレンジは先にまとめて確保しておく
+    size_t numRanges = 0;
+    for (u32 i = 0; i < desc.numParameters; i++)
+    {
+        numRanges += desc.pParameters[i].numDescriptorRanges;
+    }
+
+    std::vector<D3D12_DESCRIPTOR_RANGE> ranges;
+    ranges.reserve(numRanges);
+
+    std::vector<D3D12_ROOT_PARAMETER> parameters(desc.numParameters);
+    for (u32 i = 0; i < desc.numParameters; i++)
+    {
+        const RootParameter& source = desc.pParameters[i];
+        D3D12_ROOT_PARAMETER& parameter = parameters[i];
+
+        parameter.ShaderVisibility = ToD3D12ShaderVisibility(source.shaderVisibility);
+
+        switch (source.parameterType)
+        {
+        case ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+            parameter.DescriptorTable.NumDescriptorRanges = source.numDescriptorRanges;
+            parameter.DescriptorTable.pDescriptorRanges = ranges.data() + ranges.size();
+            for (u32 j = 0; j < source.numDescriptorRanges; j++)
+            {
+                const DescriptorRange& sourceRange = source.pDescriptorRanges[j];
+                D3D12_DESCRIPTOR_RANGE range = {};
+                range.RangeType = ToD3D12DescriptorRangeType(sourceRange.rangeType);
+                range.NumDescriptors = sourceRange.numDescriptors;
+                range.BaseShaderRegister = sourceRange.baseShaderRegister;
+                range.RegisterSpace = sourceRange.registerSpace;
+                range.OffsetInDescriptorsFromTableStart = sourceRange.offsetInDescriptorsFromTableStart;
+                ranges.push_back(range);
+            }
+            break;
+
+        case ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            parameter.Constants.ShaderRegister = source.shaderRegister;
+            parameter.Constants.RegisterSpace = source.registerSpace;
+            parameter.Constants.Num32BitValues = source.num32BitValues;
+            break;
+
+        default:
+            parameter.ParameterType =
+                source.parameterType == ROOT_PARAMETER_TYPE_CBV ? D3D12_ROOT_PARAMETER_TYPE_CBV :
+                source.parameterType == ROOT_PARAMETER_TYPE_SRV ? D3D12_ROOT_PARAMETER_TYPE_SRV :
+                D3D12_ROOT_PARAMETER_TYPE_UAV;
+            parameter.Descriptor.ShaderRegister = source.shaderRegister;
+            parameter.Descriptor.RegisterSpace = source.registerSpace;
+            break;
+        }
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
+    rootSignatureDesc.NumParameters = desc.numParameters;
+    rootSignatureDesc.pParameters = parameters.data();
+    rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+    if (desc.flags & ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT)
+    {
+        rootSignatureDesc.Flags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT; // 入力レイアウト有り
+    }
+    if (desc.flags & ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS)
+    {
+        rootSignatureDesc.Flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
+    }
+    if (desc.flags & ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS)
+    {
+        rootSignatureDesc.Flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
+    }
+
+    // ハル / ドメイン / ジオメトリシェーダーは使わない
+    rootSignatureDesc.Flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS
+        | D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS
+        | D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
+
+    ComPtr<ID3DBlob> rootSignatureBlob;
+    ComPtr<ID3DBlob> errorBlob;
+
+    HRESULT hr = D3D12SerializeRootSignature(
+        &rootSignatureDesc,
+        D3D_ROOT_SIGNATURE_VERSION_1_0,
+        &rootSignatureBlob,
+        &errorBlob
+    );
+    if (FAILED(hr))
+    {
+        *pErrorText = ToString(errorBlob.Get());
+        return hr;
+    }
+
+    ComPtr<ID3D12RootSignature> rootSignature;
+    hr = m_Device->CreateRootSignature(
+        0,
+        rootSignatureBlob->GetBufferPointer(),
+        rootSignatureBlob->GetBufferSize(),
+        IID_PPV_ARGS(&rootSignature)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsRootSignatureD3D12(rootSignature));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut)
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc = {};
+    ToD3D12GraphicsPipelineStateDesc(desc, &inputElements, &pipelineStateDesc);
+
+    ComPtr<ID3D12PipelineState> pipelineState;
+    HRESULT hr = m_Device->CreateGraphicsPipelineState(
+        &pipelineStateDesc,
+        IID_PPV_ARGS(&pipelineState)
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    pOut->reset(new GraphicsPipelineStateD3D12(pipelineState));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceD3D12::CreatePipelineLibrary(const void* pData, size_t dataSize, std::unique_ptr<IGraphicsPipelineLibrary>* pOut)
+{
+    ComPtr<ID3D12Device1> device1;
+    HRESULT hr = m_Device.As(&device1);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<GraphicsPipelineLibraryD3D12> library(new GraphicsPipelineLibraryD3D12());
+    hr = library->Init(device1.Get(), pData, dataSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    *pOut = std::move(library);
+    return S_OK;
+}
+
+
+void GraphicsDeviceD3D12::GetStatistics(GraphicsStatistics* pOut) const
+{
+    *pOut = m_Statistics;
+}
+
+
+ID3D12Device* GraphicsDeviceD3D12::GetD3D12Device() const
+{
+    return m_Device.Get();
+}
+
+#endif // defined(_WIN32)
+
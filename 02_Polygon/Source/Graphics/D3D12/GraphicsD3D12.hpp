@@ -0,0 +1,340 @@
+﻿#pragma once
+
+#if defined(_WIN32)
+
+
+// D3D12 バックエンド
+
+
+class GraphicsResourceD3D12 : public IGraphicsResource
+{
+public:
+    GraphicsResourceD3D12(const ComPtr<ID3D12Resource>& resource, const ResourceDesc& desc);
+
+    ~GraphicsResourceD3D12();
+
+    virtual const ResourceDesc& GetDesc() const override;
+
+    virtual HRESULT Map(u32 subresource, void** ppData) override;
+
+    virtual void Unmap(u32 subresource) override;
+
+    virtual u64 GetGPUVirtualAddress() const override;
+
+    ID3D12Resource* GetD3D12Resource() const;
+
+private:
+    ComPtr<ID3D12Resource> m_Resource;
+    ResourceDesc           m_Desc;
+};
+
+
+class GraphicsHeapD3D12 : public IGraphicsHeap
+{
+public:
+    GraphicsHeapD3D12(const ComPtr<ID3D12Heap>& heap, const HeapDesc& desc);
+
+    ~GraphicsHeapD3D12();
+
+    virtual const HeapDesc& GetDesc() const override;
+
+    ID3D12Heap* GetD3D12Heap() const;
+
+private:
+    ComPtr<ID3D12Heap> m_Heap;
+    HeapDesc           m_Desc;
+};
+
+
+class GraphicsRootSignatureD3D12 : public IGraphicsRootSignature
+{
+public:
+    GraphicsRootSignatureD3D12(const ComPtr<ID3D12RootSignature>& rootSignature);
+
+    ~GraphicsRootSignatureD3D12();
+
+    ID3D12RootSignature* GetD3D12RootSignature() const;
+
+private:
+    ComPtr<ID3D12RootSignature> m_RootSignature;
+};
+
+
+class GraphicsPipelineStateD3D12 : public IGraphicsPipelineState
+{
+public:
+    GraphicsPipelineStateD3D12(const ComPtr<ID3D12PipelineState>& pipelineState);
+
+    ~GraphicsPipelineStateD3D12();
+
+    ID3D12PipelineState* GetD3D12PipelineState() const;
+
+private:
+    ComPtr<ID3D12PipelineState> m_PipelineState;
+};
+
+
+class GraphicsPipelineLibraryD3D12 : public IGraphicsPipelineLibrary
+{
+public:
+    GraphicsPipelineLibraryD3D12();
+
+    ~GraphicsPipelineLibraryD3D12();
+
+    HRESULT Init(ID3D12Device1* pDevice, const void* pData, size_t dataSize);
+
+    virtual HRESULT LoadGraphicsPipeline(const char* name, const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) override;
+
+    virtual HRESULT StorePipeline(const char* name, IGraphicsPipelineState* pPipelineState) override;
+
+    virtual size_t GetSerializedSize() const override;
+
+    virtual HRESULT Serialize(void* pData, size_t dataSize) override;
+
+private:
+    std::vector<u8>               m_Data; // ライブラリが参照し続けるのでコピーを持つ
+    ComPtr<ID3D12PipelineLibrary> m_Library;
+};
+
+
+class GraphicsDescriptorHeapD3D12 : public IGraphicsDescriptorHeap
+{
+public:
+    GraphicsDescriptorHeapD3D12(const ComPtr<ID3D12DescriptorHeap>& descriptorHeap, const DescriptorHeapDesc& desc);
+
+    ~GraphicsDescriptorHeapD3D12();
+
+    virtual const DescriptorHeapDesc& GetDesc() const override;
+
+    virtual CpuDescriptorHandle GetCPUDescriptorHandleForHeapStart() const override;
+
+    virtual GpuDescriptorHandle GetGPUDescriptorHandleForHeapStart() const override;
+
+    ID3D12DescriptorHeap* GetD3D12DescriptorHeap() const;
+
+private:
+    ComPtr<ID3D12DescriptorHeap> m_DescriptorHeap;
+    DescriptorHeapDesc           m_Desc;
+};
+
+
+class GraphicsFenceD3D12 : public IGraphicsFence
+{
+public:
+    GraphicsFenceD3D12(const ComPtr<ID3D12Fence>& fence);
+
+    ~GraphicsFenceD3D12();
+
+    HRESULT Init();
+
+    virtual u64 GetCompletedValue() const override;
+
+    virtual HRESULT Wait(u64 value) override;
+
+    ID3D12Fence* GetD3D12Fence() const;
+
+private:
+    ComPtr<ID3D12Fence> m_Fence;
+    HANDLE              m_Event; // 待ち用 (毎回作らずに使い回す)
+};
+
+
+class GraphicsCommandAllocatorD3D12 : public IGraphicsCommandAllocator
+{
+public:
+    GraphicsCommandAllocatorD3D12(const ComPtr<ID3D12CommandAllocator>& commandAllocator);
+
+    ~GraphicsCommandAllocatorD3D12();
+
+    virtual HRESULT Reset() override;
+
+    ID3D12CommandAllocator* GetD3D12CommandAllocator() const;
+
+private:
+    ComPtr<ID3D12CommandAllocator> m_CommandAllocator;
+};
+
+
+class GraphicsCommandListD3D12 : public IGraphicsCommandList
+{
+public:
+    GraphicsCommandListD3D12(const ComPtr<ID3D12GraphicsCommandList>& commandList, COMMAND_LIST_TYPE type);
+
+    ~GraphicsCommandListD3D12();
+
+    virtual COMMAND_LIST_TYPE GetType() const override;
+
+    virtual HRESULT Close() override;
+
+    virtual HRESULT Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState) override;
+
+    virtual void ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers) override;
+
+    virtual void OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil) override;
+
+    virtual void ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4]) override;
+
+    virtual void SetPipelineState(IGraphicsPipelineState* pPipelineState) override;
+
+    virtual void SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature) override;
+
+    virtual void SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps) override;
+
+    virtual void SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor) override;
+
+    virtual void SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues) override;
+
+    virtual void SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation) override;
+
+    virtual void RSSetViewports(u32 numViewports, const Viewport* pViewports) override;
+
+    virtual void RSSetScissorRects(u32 numRects, const Rect* pRects) override;
+
+    virtual void IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+    virtual void IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews) override;
+
+    virtual void IASetIndexBuffer(const IndexBufferView* pView) override;
+
+    virtual void DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes) override;
+
+    ID3D12GraphicsCommandList* GetD3D12CommandList() const;
+
+    // 記録された描画命令の数 (統計用)
+    u32 GetDrawCount() const;
+
+    // 記録された ResourceBarrier の呼び出しとバリアの数 (統計用)
+    u32 GetResourceBarrierCallCount() const;
+
+    u32 GetResourceBarrierCount() const;
+
+private:
+    ComPtr<ID3D12GraphicsCommandList> m_CommandList;
+    COMMAND_LIST_TYPE                 m_Type;
+    u32                               m_DrawCount;
+    u32                               m_ResourceBarrierCallCount;
+    u32                               m_ResourceBarrierCount;
+};
+
+
+class GraphicsCommandQueueD3D12 : public IGraphicsCommandQueue
+{
+public:
+    GraphicsCommandQueueD3D12(const ComPtr<ID3D12CommandQueue>& commandQueue, COMMAND_LIST_TYPE type, GraphicsStatistics* pStatistics);
+
+    ~GraphicsCommandQueueD3D12();
+
+    virtual COMMAND_LIST_TYPE GetType() const override;
+
+    virtual void ExecuteCommandLists(u32 numCommandLists, IGraphicsCommandList* const* ppCommandLists) override;
+
+    virtual HRESULT Signal(IGraphicsFence* pFence, u64 value) override;
+
+    virtual HRESULT Wait(IGraphicsFence* pFence, u64 value) override;
+
+    ID3D12CommandQueue* GetD3D12CommandQueue() const;
+
+private:
+    ComPtr<ID3D12CommandQueue> m_CommandQueue;
+    COMMAND_LIST_TYPE          m_Type;
+    GraphicsStatistics*        m_pStatistics;
+};
+
+
+class GraphicsSwapChainD3D12 : public IGraphicsSwapChain
+{
+public:
+    GraphicsSwapChainD3D12(GraphicsStatistics* pStatistics);
+
+    ~GraphicsSwapChainD3D12();
+
+    HRESULT Init(const ComPtr<IDXGISwapChain4>& swapChain, const SwapChainDesc& desc);
+
+    virtual u32 GetBufferCount() const override;
+
+    virtual u32 GetCurrentBackBufferIndex() const override;
+
+    virtual IGraphicsResource* GetBuffer(u32 index) const override;
+
+    virtual HRESULT Present(u32 syncInterval) override;
+
+private:
+    ComPtr<IDXGISwapChain4>                             m_SwapChain;
+    SwapChainDesc                                       m_Desc;
+    std::vector<std::unique_ptr<GraphicsResourceD3D12>> m_Buffers;
+    GraphicsStatistics*                                 m_pStatistics;
+};
+
+
+class GraphicsDeviceD3D12 : public IGraphicsDevice
+{
+public:
+    GraphicsDeviceD3D12();
+
+    ~GraphicsDeviceD3D12();
+
+    HRESULT Init(bool enableDebugLayer);
+
+    virtual GRAPHICS_BACKEND GetBackend() const override;
+
+    virtual HRESULT CreateCommandQueue(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandQueue>* pOut) override;
+
+    virtual HRESULT CreateCommandAllocator(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandAllocator>* pOut) override;
+
+    virtual HRESULT CreateCommandList(COMMAND_LIST_TYPE type, IGraphicsCommandAllocator* pAllocator, std::unique_ptr<IGraphicsCommandList>* pOut) override;
+
+    virtual HRESULT CreateSwapChain(IGraphicsCommandQueue* pQueue, void* windowHandle, const SwapChainDesc& desc, std::unique_ptr<IGraphicsSwapChain>* pOut) override;
+
+    virtual HRESULT CreateDescriptorHeap(const DescriptorHeapDesc& desc, std::unique_ptr<IGraphicsDescriptorHeap>* pOut) override;
+
+    virtual u32 GetDescriptorHandleIncrementSize(DESCRIPTOR_HEAP_TYPE type) const override;
+
+    virtual void CreateRenderTargetView(IGraphicsResource* pResource, CpuDescriptorHandle destDescriptor) override;
+
+    virtual void CopyDescriptorsSimple(u32 numDescriptors, CpuDescriptorHandle destDescriptorRangeStart, CpuDescriptorHandle srcDescriptorRangeStart, DESCRIPTOR_HEAP_TYPE type) override;
+
+    virtual HRESULT CreateFence(u64 initialValue, std::unique_ptr<IGraphicsFence>* pOut) override;
+
+    virtual HRESULT CreateCommittedResource(HEAP_TYPE heapType, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) override;
+
+    virtual HRESULT CreateHeap(const HeapDesc& desc, std::unique_ptr<IGraphicsHeap>* pOut) override;
+
+    virtual HRESULT CreatePlacedResource(IGraphicsHeap* pHeap, u64 heapOffset, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) override;
+
+    virtual ResourceAllocationInfo GetResourceAllocationInfo(const ResourceDesc& desc) const override;
+
+    virtual HRESULT CreateRootSignature(const RootSignatureDesc& desc, std::unique_ptr<IGraphicsRootSignature>* pOut, std::string* pErrorText) override;
+
+    virtual HRESULT CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) override;
+
+    virtual HRESULT CreatePipelineLibrary(const void* pData, size_t dataSize, std::unique_ptr<IGraphicsPipelineLibrary>* pOut) override;
+
+    virtual void GetStatistics(GraphicsStatistics* pOut) const override;
+
+    ID3D12Device* GetD3D12Device() const;
+
+private:
+    ComPtr<IDXGIFactory6> m_Factory;
+    ComPtr<IDXGIAdapter>  m_Adapter;
+    ComPtr<ID3D12Device>  m_Device;
+    GraphicsStatistics    m_Statistics;
+};
+
+
+// 型変換
+DXGI_FORMAT ToDXGIFormat(GRAPHICS_FORMAT format);
+
+D3D12_COMMAND_LIST_TYPE ToD3D12CommandListType(COMMAND_LIST_TYPE type);
+
+D3D12_HEAP_TYPE ToD3D12HeapType(HEAP_TYPE type);
+
+D3D12_HEAP_FLAGS ToD3D12HeapFlags(HEAP_FLAG flags);
+
+D3D12_RESOURCE_DESC ToD3D12ResourceDesc(const ResourceDesc& desc);
+
+#endif // defined(_WIN32)
+
@@ -0,0 +1,94 @@
+﻿
+#if defined(_WIN32)
+
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "delayimp.lib") // d3dcompiler_47.dll は遅延読み込み (アーカイブだけで足りれば読み込まない)
+
+
+ShaderCompilerD3D12::ShaderCompilerD3D12()
+{
+
+}
+
+
+ShaderCompilerD3D12::~ShaderCompilerD3D12()
+{
+
+}
+
+
+HRESULT ShaderCompilerD3D12::CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText)
+{
+    // ファイルパスはワイド文字列
+    std::wstring filePath;
+    {
+        int length = MultiByteToWideChar(CP_UTF8, 0, desc.filePath.c_str(), -1, nullptr, 0);
+        if (length > 0)
+        {
+            filePath.resize(length - 1);
+            MultiByteToWideChar(CP_UTF8, 0, desc.filePath.c_str(), -1, &filePath[0], length);
+        }
+    }
+
+    // マクロは終端を nullptr で埋める
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (const ShaderMacro& define : desc.defines)
+    {
+        D3D_SHADER_MACRO macro = { define.name.c_str(), define.definition.c_str() };
+        macros.push_back(macro);
+    }
+    {
+        D3D_SHADER_MACRO macro = { nullptr, nullptr };
+        macros.push_back(macro);
+    }
+
+    UINT flags = 0;
+    if (desc.flags & SHADER_COMPILE_FLAG_DEBUG)
+    {
+        flags |= D3DCOMPILE_DEBUG; // デバッグ用
+    }
+    if (desc.flags & SHADER_COMPILE_FLAG_SKIP_OPTIMIZATION)
+    {
+        flags |= D3DCOMPILE_SKIP_OPTIMIZATION; // 最適化なし
+    }
+
+    ComPtr<ID3DBlob> bytecodeBlob;
+    ComPtr<ID3DBlob> errorBlob;
+    HRESULT hr = D3DCompileFromFile(
+        filePath.c_str(),
+        macros.data(),
+        D3D_COMPILE_STANDARD_FILE_INCLUDE,
+        desc.entryPoint.c_str(),
+        desc.target.c_str(),
+        flags,
+        0,
+        &bytecodeBlob,
+        &errorBlob
+    );
+    if (FAILED(hr))
+    {
+        if (errorBlob != nullptr)
+        {
+            pErrorText->resize(errorBlob->GetBufferSize());
+            std::copy_n(
+                (char*)errorBlob->GetBufferPointer(),
+                errorBlob->GetBufferSize(),
+                pErrorText->begin()
+            );
+        }
+        return hr;
+    }
+
+    const u8* pBegin = static_cast<const u8*>(bytecodeBlob->GetBufferPointer());
+    pBytecode->assign(pBegin, pBegin + bytecodeBlob->GetBufferSize());
+    return S_OK;
+}
+
+
+const char* ShaderCompilerD3D12::GetIdentifier() const
+{
+    return GetShaderCompilerIdentifier(GRAPHICS_BACKEND_D3D12);
+}
+
+#endif // defined(_WIN32)
+
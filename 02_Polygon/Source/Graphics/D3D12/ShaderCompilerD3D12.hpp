@@ -0,0 +1,20 @@
+﻿#pragma once
+
+#if defined(_WIN32)
+
+
+// D3DCompileFromFile によるシェーダーコンパイラ
+class ShaderCompilerD3D12 : public IShaderCompiler
+{
+public:
+    ShaderCompilerD3D12();
+
+    ~ShaderCompilerD3D12();
+
+    virtual HRESULT CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText) override;
+
+    virtual const char* GetIdentifier() const override;
+};
+
+#endif // defined(_WIN32)
+
@@ -0,0 +1,260 @@
+﻿
+
+//-----------------------------------------------------------------
+// DescriptorHeapAllocator
+//-----------------------------------------------------------------
+DescriptorHeapAllocator::DescriptorHeapAllocator()
+    : m_pDevice(nullptr)
+    , m_Type(DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+    , m_DescriptorsPerHeap(0)
+    , m_IncrementSize(0)
+    , m_AllocatedCount(0)
+    , m_PeakAllocatedCount(0)
+    , m_AllocateCount(0)
+    , m_FreeCount(0)
+{
+
+}
+
+
+DescriptorHeapAllocator::~DescriptorHeapAllocator()
+{
+    Term();
+}
+
+
+HRESULT DescriptorHeapAllocator::Init(IGraphicsDevice* pDevice, DESCRIPTOR_HEAP_TYPE type, u32 descriptorsPerHeap)
+{
+    m_pDevice = pDevice;
+    m_Type = type;
+    m_DescriptorsPerHeap = (descriptorsPerHeap > 0) ? descriptorsPerHeap : DefaultDescriptorsPerHeap;
+    m_IncrementSize = m_pDevice->GetDescriptorHandleIncrementSize(type);
+    m_AllocatedCount = 0;
+    m_PeakAllocatedCount = 0;
+    m_AllocateCount = 0;
+    m_FreeCount = 0;
+    return CreateHeap();
+}
+
+
+void DescriptorHeapAllocator::Term()
+{
+    m_Heaps.clear();
+    m_AvailableHeaps.clear();
+    m_pDevice = nullptr;
+}
+
+
+HRESULT DescriptorHeapAllocator::Allocate(DescriptorAllocation* pOut)
+{
+    if (m_AvailableHeaps.empty())
+    {
+        HRESULT hr = CreateHeap();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    const u32 heapIndex = m_AvailableHeaps.back();
+    Heap& heap = m_Heaps[heapIndex];
+    const u32 index = heap.freeIndices.back();
+    heap.freeIndices.pop_back();
+    if (heap.freeIndices.empty())
+    {
+        m_AvailableHeaps.pop_back();
+    }
+
+    pOut->cpuHandle.ptr = heap.cpuStart.ptr + static_cast<size_t>(index) * m_IncrementSize;
+    pOut->gpuHandle.ptr = 0;
+    pOut->heapIndex = heapIndex;
+    pOut->index = index;
+
+    m_AllocatedCount++;
+    m_PeakAllocatedCount = std::max(m_PeakAllocatedCount, m_AllocatedCount);
+    m_AllocateCount++;
+    return S_OK;
+}
+
+
+void DescriptorHeapAllocator::Free(const DescriptorAllocation& allocation)
+{
+    Heap& heap = m_Heaps[allocation.heapIndex];
+
+    // 満杯だったヒープは再び空きのあるヒープになる
+    if (heap.freeIndices.empty())
+    {
+        m_AvailableHeaps.push_back(allocation.heapIndex);
+    }
+    heap.freeIndices.push_back(allocation.index);
+
+    m_AllocatedCount--;
+    m_FreeCount++;
+}
+
+
+DESCRIPTOR_HEAP_TYPE DescriptorHeapAllocator::GetType() const
+{
+    return m_Type;
+}
+
+
+u32 DescriptorHeapAllocator::GetIncrementSize() const
+{
+    return m_IncrementSize;
+}
+
+
+void DescriptorHeapAllocator::GetStatistics(DescriptorHeapAllocatorStatistics* pOut) const
+{
+    pOut->heapCount = static_cast<u32>(m_Heaps.size());
+    pOut->allocatedCount = m_AllocatedCount;
+    pOut->peakAllocatedCount = m_PeakAllocatedCount;
+    pOut->allocateCount = m_AllocateCount;
+    pOut->freeCount = m_FreeCount;
+}
+
+
+HRESULT DescriptorHeapAllocator::CreateHeap()
+{
+    DescriptorHeapDesc desc = {};
+    desc.type = m_Type;
+    desc.numDescriptors = m_DescriptorsPerHeap;
+    desc.shaderVisible = false;
+
+    Heap heap;
+    HRESULT hr = m_pDevice->CreateDescriptorHeap(desc, &heap.heap);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    heap.cpuStart = heap.heap->GetCPUDescriptorHandleForHeapStart();
+
+    // 先頭から順に使われるように逆順に積む
+    heap.freeIndices.resize(m_DescriptorsPerHeap);
+    for (u32 i = 0; i < m_DescriptorsPerHeap; i++)
+    {
+        heap.freeIndices[i] = m_DescriptorsPerHeap - 1 - i;
+    }
+
+    m_AvailableHeaps.push_back(static_cast<u32>(m_Heaps.size()));
+    m_Heaps.push_back(std::move(heap));
+    return S_OK;
+}
+
+
+//-----------------------------------------------------------------
+// DescriptorRing
+//-----------------------------------------------------------------
+DescriptorRing::DescriptorRing()
+    : m_pDevice(nullptr)
+    , m_Type(DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
+    , m_IncrementSize(0)
+    , m_CpuStart()
+    , m_GpuStart()
+{
+
+}
+
+
+DescriptorRing::~DescriptorRing()
+{
+    Term();
+}
+
+
+HRESULT DescriptorRing::Init(IGraphicsDevice* pDevice, DESCRIPTOR_HEAP_TYPE type, u32 numDescriptors)
+{
+    m_pDevice = pDevice;
+    m_Type = type;
+    m_IncrementSize = m_pDevice->GetDescriptorHandleIncrementSize(type);
+
+    DescriptorHeapDesc desc = {};
+    desc.type = type;
+    desc.numDescriptors = numDescriptors;
+    desc.shaderVisible = true;
+
+    HRESULT hr = m_pDevice->CreateDescriptorHeap(desc, &m_Heap);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_CpuStart = m_Heap->GetCPUDescriptorHandleForHeapStart();
+    m_GpuStart = m_Heap->GetGPUDescriptorHandleForHeapStart();
+    m_Allocator.Init(numDescriptors);
+    return S_OK;
+}
+
+
+void DescriptorRing::Term()
+{
+    m_Heap.reset();
+    m_pDevice = nullptr;
+}
+
+
+bool DescriptorRing::Allocate(u32 count, DescriptorAllocation* pOut)
+{
+    const u64 index = m_Allocator.Allocate(count, 1);
+    if (index == LinearRingAllocator::InvalidOffset)
+    {
+        return false;
+    }
+
+    pOut->cpuHandle.ptr = m_CpuStart.ptr + static_cast<size_t>(index) * m_IncrementSize;
+    pOut->gpuHandle.ptr = m_GpuStart.ptr + index * m_IncrementSize;
+    pOut->heapIndex = 0;
+    pOut->index = static_cast<u32>(index);
+    return true;
+}
+
+
+bool DescriptorRing::CopyTable(const CpuDescriptorHandle* pSrcDescriptors, u32 count, GpuDescriptorHandle* pOut)
+{
+    DescriptorAllocation allocation = {};
+    if (!Allocate(count, &allocation))
+    {
+        return false;
+    }
+
+    // 元は別々のヒープにあり得るので 1 個ずつコピーする
+    for (u32 i = 0; i < count; i++)
+    {
+        CpuDescriptorHandle destHandle = { allocation.cpuHandle.ptr + static_cast<size_t>(i) * m_IncrementSize };
+        m_pDevice->CopyDescriptorsSimple(1, destHandle, pSrcDescriptors[i], m_Type);
+    }
+
+    *pOut = allocation.gpuHandle;
+    return true;
+}
+
+
+void DescriptorRing::FinishFrame(u64 fenceValue)
+{
+    m_Allocator.FinishFrame(fenceValue);
+}
+
+
+void DescriptorRing::Reclaim(u64 completedFenceValue)
+{
+    m_Allocator.Reclaim(completedFenceValue);
+}
+
+
+IGraphicsDescriptorHeap* DescriptorRing::GetHeap() const
+{
+    return m_Heap.get();
+}
+
+
+u32 DescriptorRing::GetIncrementSize() const
+{
+    return m_IncrementSize;
+}
+
+
+const LinearRingAllocator& DescriptorRing::GetAllocator() const
+{
+    return m_Allocator;
+}
@@ -0,0 +1,121 @@
+﻿#pragma once
+
+
+// ディスクリプタの管理
+// DescriptorHeapAllocator : ビューを置いておく CPU 専用ヒープ (種類ごとに 1 つ、フリーリストで 1 個ずつ確保)
+// DescriptorRing          : フレームごとのテーブルを置くシェーダーから見えるヒープ (フェンスで回収するリング)
+// ハンドルの増分はどちらも Init で取得しておき、毎回デバイスに問い合わせない
+
+
+// 確保したディスクリプタ
+struct DescriptorAllocation
+{
+    CpuDescriptorHandle cpuHandle;
+    GpuDescriptorHandle gpuHandle; // シェーダーから見えるヒープのみ
+    u32                 heapIndex; // DescriptorHeapAllocator のヒープの番号
+    u32                 index;     // ヒープ内の位置
+};
+
+
+// 統計情報
+struct DescriptorHeapAllocatorStatistics
+{
+    u32 heapCount;
+    u32 allocatedCount;
+    u32 peakAllocatedCount;
+    u64 allocateCount; // 累計
+    u64 freeCount;     // 累計
+};
+
+
+class DescriptorHeapAllocator
+{
+public:
+    static const u32 DefaultDescriptorsPerHeap = 256;
+
+    DescriptorHeapAllocator();
+
+    ~DescriptorHeapAllocator();
+
+    // descriptorsPerHeap が 0 なら DefaultDescriptorsPerHeap
+    HRESULT Init(IGraphicsDevice* pDevice, DESCRIPTOR_HEAP_TYPE type, u32 descriptorsPerHeap);
+
+    void Term();
+
+    // 空きが無ければヒープを足す
+    HRESULT Allocate(DescriptorAllocation* pOut);
+
+    // GPU が使い終わってから呼ぶこと
+    void Free(const DescriptorAllocation& allocation);
+
+    DESCRIPTOR_HEAP_TYPE GetType() const;
+
+    u32 GetIncrementSize() const;
+
+    void GetStatistics(DescriptorHeapAllocatorStatistics* pOut) const;
+
+private:
+    struct Heap
+    {
+        std::unique_ptr<IGraphicsDescriptorHeap> heap;
+        CpuDescriptorHandle                      cpuStart;
+        std::vector<u32>                         freeIndices; // 空いている位置 (後ろから使う)
+    };
+
+private:
+    HRESULT CreateHeap();
+
+private:
+    IGraphicsDevice*     m_pDevice;
+    DESCRIPTOR_HEAP_TYPE m_Type;
+    u32                  m_DescriptorsPerHeap;
+    u32                  m_IncrementSize;
+    std::vector<Heap>    m_Heaps;
+    std::vector<u32>     m_AvailableHeaps; // 空きのあるヒープの番号
+
+    u32 m_AllocatedCount;
+    u32 m_PeakAllocatedCount;
+    u64 m_AllocateCount;
+    u64 m_FreeCount;
+};
+
+
+class DescriptorRing
+{
+public:
+    DescriptorRing();
+
+    ~DescriptorRing();
+
+    // type は CBV_SRV_UAV か SAMPLER (シェーダーから見えるヒープを作る)
+    HRESULT Init(IGraphicsDevice* pDevice, DESCRIPTOR_HEAP_TYPE type, u32 numDescriptors);
+
+    void Term();
+
+    // 連続した count 個を確保する (空きが無ければ false)
+    bool Allocate(u32 count, DescriptorAllocation* pOut);
+
+    // CPU 専用ヒープのディスクリプタを連続した領域へコピーし、テーブルの先頭を返す
+    bool CopyTable(const CpuDescriptorHandle* pSrcDescriptors, u32 count, GpuDescriptorHandle* pOut);
+
+    // このフレームの確保をキューに積んだフェンス値に結び付ける
+    void FinishFrame(u64 fenceValue);
+
+    // GPU が完了したフレームの領域を再利用可能にする
+    void Reclaim(u64 completedFenceValue);
+
+    IGraphicsDescriptorHeap* GetHeap() const;
+
+    u32 GetIncrementSize() const;
+
+    const LinearRingAllocator& GetAllocator() const;
+
+private:
+    IGraphicsDevice*                         m_pDevice;
+    DESCRIPTOR_HEAP_TYPE                     m_Type;
+    u32                                      m_IncrementSize;
+    std::unique_ptr<IGraphicsDescriptorHeap> m_Heap;
+    CpuDescriptorHandle                      m_CpuStart;
+    GpuDescriptorHandle                      m_GpuStart;
+    LinearRingAllocator                      m_Allocator; // ディスクリプタの個数単位
+};
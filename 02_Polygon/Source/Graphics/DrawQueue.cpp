@@ -0,0 +1,87 @@
+﻿
+
+DrawQueue::DrawQueue()
+{
+
+}
+
+
+DrawQueue::~DrawQueue()
+{
+    Term();
+}
+
+
+void DrawQueue::Init(TaskScheduler* pTaskScheduler)
+{
+    m_Sorter.Init(pTaskScheduler);
+}
+
+
+void DrawQueue::Term()
+{
+    m_Keys.clear();
+    m_Payloads.clear();
+    m_Sorter.Term();
+}
+
+
+void DrawQueue::Reset()
+{
+    m_Keys.clear();
+    m_Payloads.clear();
+}
+
+
+u64 DrawQueue::MakeKey(u32 pass, u32 pipeline, u32 material, u32 depth)
+{
+    u64 key = pass & ((1u << PassBits) - 1);
+    key = (key << PipelineBits) | (pipeline & ((1u << PipelineBits) - 1));
+    key = (key << MaterialBits) | (material & ((1u << MaterialBits) - 1));
+    key = (key << DepthBits) | (depth & ((1u << DepthBits) - 1));
+    return key;
+}
+
+
+u32 DrawQueue::QuantizeDepth(f32 depth)
+{
+    const f32 maxValue = static_cast<f32>((1u << DepthBits) - 1);
+    return static_cast<u32>(std::min(std::max(depth, 0.0f), 1.0f) * maxValue + 0.5f);
+}
+
+
+void DrawQueue::Push(u64 key, u32 payload)
+{
+    m_Keys.push_back(key);
+    m_Payloads.push_back(payload);
+}
+
+
+void DrawQueue::Sort()
+{
+    m_Sorter.Sort(m_Keys.data(), m_Payloads.data(), static_cast<u32>(m_Keys.size()));
+}
+
+
+u32 DrawQueue::GetCount() const
+{
+    return static_cast<u32>(m_Keys.size());
+}
+
+
+const u64* DrawQueue::GetKeys() const
+{
+    return m_Keys.data();
+}
+
+
+const u32* DrawQueue::GetPayloads() const
+{
+    return m_Payloads.data();
+}
+
+
+const RadixSorterStatistics& DrawQueue::GetSortStatistics() const
+{
+    return m_Sorter.GetStatistics();
+}
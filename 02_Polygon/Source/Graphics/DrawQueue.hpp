@@ -0,0 +1,60 @@
+﻿#pragma once
+
+
+// 描画の発行キュー
+// 描画ごとに 64 ビットのキーと項目の番号 (payload) を積み、キーで並べてから記録する
+// キーの上位ほど切り替えが高いもの (パス、パイプライン、マテリアル) にして、同じ状態の描画を続ける
+//
+// キー (上位から)
+//   pass     :  8 ビット (記録する順)
+//   pipeline : 16 ビット
+//   material : 16 ビット
+//   depth    : 24 ビット (小さいものが先。奥から描くものは呼ぶ側で反転する)
+
+
+class DrawQueue
+{
+public:
+    static const u32 PassBits = 8;
+    static const u32 PipelineBits = 16;
+    static const u32 MaterialBits = 16;
+    static const u32 DepthBits = 24;
+
+    DrawQueue();
+
+    ~DrawQueue();
+
+    // 並べるときに pTaskScheduler のワーカーを使う (nullptr 可)
+    void Init(TaskScheduler* pTaskScheduler);
+
+    void Term();
+
+    // 積んだものを捨てる (メモリは残す)
+    void Reset();
+
+    // 範囲外のビットは捨てる
+    static u64 MakeKey(u32 pass, u32 pipeline, u32 material, u32 depth);
+
+    // [0, 1] の深度を DepthBits に合わせる (範囲外は丸める)
+    static u32 QuantizeDepth(f32 depth);
+
+    // 1 つのスレッドから積むこと
+    void Push(u64 key, u32 payload);
+
+    // キーの昇順に並べる (同じキーは積んだ順)
+    void Sort();
+
+    u32 GetCount() const;
+
+    // Sort の後は並べた順
+    const u64* GetKeys() const;
+
+    const u32* GetPayloads() const;
+
+    const RadixSorterStatistics& GetSortStatistics() const;
+
+private:
+    std::vector<u64> m_Keys;
+    std::vector<u32> m_Payloads;
+    RadixSorter      m_Sorter;
+};
@@ -0,0 +1,262 @@
+﻿
+
+// 配置リソースのオフセットの単位 (D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+static const u64 PlacementAlignment = 64 * 1024;
+
+
+GpuHeapAllocator::GpuHeapAllocator()
+    : m_pDevice(nullptr)
+    , m_Desc()
+    , m_IsDefragmenting(false)
+    , m_CreateHeapCount(0)
+    , m_AllocateCount(0)
+    , m_FreeCount(0)
+{
+
+}
+
+
+GpuHeapAllocator::~GpuHeapAllocator()
+{
+    Term();
+}
+
+
+HRESULT GpuHeapAllocator::Init(IGraphicsDevice* pDevice, const GpuHeapAllocatorDesc& desc)
+{
+    m_pDevice = pDevice;
+    m_Desc = desc;
+    if (m_Desc.blockSize == 0)
+    {
+        m_Desc.blockSize = DefaultBlockSize;
+    }
+    m_Desc.blockSize = AlignUp(m_Desc.blockSize, PlacementAlignment);
+
+    // 最初のブロックは作っておく (初回の確保でヒープを作る時間を取られないように)
+    u32 index = 0;
+    return CreateBlock(m_Desc.blockSize, false, &index);
+}
+
+
+void GpuHeapAllocator::Term()
+{
+    m_Blocks.clear();
+    m_IsDefragmenting = false;
+    m_pDevice = nullptr;
+}
+
+
+HRESULT GpuHeapAllocator::CreateResource(const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut, GpuHeapAllocation* pAllocation)
+{
+    const ResourceAllocationInfo info = m_pDevice->GetResourceAllocationInfo(desc);
+    const u64 alignment = std::max(info.alignment, PlacementAlignment);
+
+    // 既存のブロックから探す
+    u32 blockIndex = 0;
+    TlsfAllocation allocation = {};
+    bool found = false;
+    if (info.sizeInBytes <= m_Desc.blockSize)
+    {
+        for (u32 i = 0; i < m_Blocks.size(); i++)
+        {
+            Block* pBlock = m_Blocks[i].get();
+            if (!pBlock || pBlock->isDedicated || pBlock->isEvacuating)
+            {
+                continue;
+            }
+            if (pBlock->allocator.Allocate(info.sizeInBytes, alignment, &allocation))
+            {
+                blockIndex = i;
+                found = true;
+                break;
+            }
+        }
+    }
+
+    // 無ければブロックを足す
+    if (!found)
+    {
+        const bool isDedicated = (info.sizeInBytes > m_Desc.blockSize);
+        HRESULT hr = CreateBlock(isDedicated ? AlignUp(info.sizeInBytes, alignment) : m_Desc.blockSize, isDedicated, &blockIndex);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        if (!m_Blocks[blockIndex]->allocator.Allocate(info.sizeInBytes, alignment, &allocation))
+        {
+            return E_OUTOFMEMORY;
+        }
+    }
+
+    Block* pBlock = m_Blocks[blockIndex].get();
+    HRESULT hr = m_pDevice->CreatePlacedResource(pBlock->heap.get(), allocation.offset, desc, initialState, pOut);
+    if (FAILED(hr))
+    {
+        pBlock->allocator.Free(allocation.handle);
+        if (pBlock->isDedicated)
+        {
+            DestroyBlock(blockIndex);
+        }
+        return hr;
+    }
+
+    pAllocation->blockIndex = blockIndex;
+    pAllocation->handle = allocation.handle;
+    pAllocation->offset = allocation.offset;
+    pAllocation->size = allocation.size;
+    m_AllocateCount++;
+    return S_OK;
+}
+
+
+void GpuHeapAllocator::Free(const GpuHeapAllocation& allocation)
+{
+    Block* pBlock = m_Blocks[allocation.blockIndex].get();
+    pBlock->allocator.Free(allocation.handle);
+    m_FreeCount++;
+
+    // 専用ブロックはすぐ返す (通常のブロックは再利用するため残す)
+    if (pBlock->isDedicated)
+    {
+        DestroyBlock(allocation.blockIndex);
+    }
+}
+
+
+void GpuHeapAllocator::GetStatistics(GpuHeapAllocatorStatistics* pOut) const
+{
+    *pOut = GpuHeapAllocatorStatistics();
+
+    u64 freeBytes = 0;
+    for (const auto& block : m_Blocks)
+    {
+        if (!block)
+        {
+            continue;
+        }
+
+        TlsfAllocatorStatistics statistics;
+        block->allocator.GetStatistics(&statistics);
+        pOut->blockCount++;
+        pOut->allocationCount += statistics.allocationCount;
+        pOut->reservedBytes += statistics.capacity;
+        pOut->usedBytes += statistics.usedBytes;
+        if (!block->isDedicated && !block->isEvacuating)
+        {
+            pOut->largestFreeBytes = std::max(pOut->largestFreeBytes, statistics.largestFreeBytes);
+            freeBytes += statistics.freeBytes;
+        }
+    }
+    pOut->fragmentation = (freeBytes > 0) ? 1.0 - static_cast<f64>(pOut->largestFreeBytes) / static_cast<f64>(freeBytes) : 0.0;
+    pOut->createHeapCount = m_CreateHeapCount;
+    pOut->allocateCount = m_AllocateCount;
+    pOut->freeCount = m_FreeCount;
+}
+
+
+void GpuHeapAllocator::BeginDefragmentation(f64 maxUsage, std::vector<GpuHeapAllocation>* pCandidates)
+{
+    pCandidates->clear();
+    m_IsDefragmenting = true;
+
+    std::vector<TlsfAllocation> allocations;
+    for (u32 i = 0; i < m_Blocks.size(); i++)
+    {
+        Block* pBlock = m_Blocks[i].get();
+        if (!pBlock || pBlock->isDedicated || pBlock->allocator.IsEmpty())
+        {
+            continue;
+        }
+
+        TlsfAllocatorStatistics statistics;
+        pBlock->allocator.GetStatistics(&statistics);
+        const f64 usage = static_cast<f64>(statistics.usedBytes) / static_cast<f64>(statistics.capacity);
+        if (usage > maxUsage)
+        {
+            continue;
+        }
+
+        pBlock->isEvacuating = true;
+        pBlock->allocator.GetAllocations(&allocations);
+        for (const TlsfAllocation& allocation : allocations)
+        {
+            GpuHeapAllocation candidate = {};
+            candidate.blockIndex = i;
+            candidate.handle = allocation.handle;
+            candidate.offset = allocation.offset;
+            candidate.size = allocation.size;
+            pCandidates->push_back(candidate);
+        }
+    }
+}
+
+
+void GpuHeapAllocator::EndDefragmentation()
+{
+    // 退避しきれなかったブロックは元に戻す
+    for (u32 i = 0; i < m_Blocks.size(); i++)
+    {
+        Block* pBlock = m_Blocks[i].get();
+        if (!pBlock || !pBlock->isEvacuating)
+        {
+            continue;
+        }
+
+        if (pBlock->allocator.IsEmpty())
+        {
+            DestroyBlock(i);
+        }
+        else
+        {
+            pBlock->isEvacuating = false;
+        }
+    }
+    m_IsDefragmenting = false;
+}
+
+
+bool GpuHeapAllocator::IsDefragmenting() const
+{
+    return m_IsDefragmenting;
+}
+
+
+HRESULT GpuHeapAllocator::CreateBlock(u64 size, bool isDedicated, u32* pIndex)
+{
+    HeapDesc heapDesc = {};
+    heapDesc.sizeInBytes = size;
+    heapDesc.type = m_Desc.heapType;
+    heapDesc.alignment = PlacementAlignment;
+    heapDesc.flags = m_Desc.heapFlags;
+
+    std::unique_ptr<Block> block(new Block());
+    HRESULT hr = m_pDevice->CreateHeap(heapDesc, &block->heap);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    block->allocator.Init(size, PlacementAlignment);
+    block->isDedicated = isDedicated;
+    block->isEvacuating = false;
+    m_CreateHeapCount++;
+
+    // 破棄したブロックの番号を再利用する
+    for (u32 i = 0; i < m_Blocks.size(); i++)
+    {
+        if (!m_Blocks[i])
+        {
+            m_Blocks[i] = std::move(block);
+            *pIndex = i;
+            return S_OK;
+        }
+    }
+    *pIndex = static_cast<u32>(m_Blocks.size());
+    m_Blocks.push_back(std::move(block));
+    return S_OK;
+}
+
+
+void GpuHeapAllocator::DestroyBlock(u32 index)
+{
+    m_Blocks[index].reset();
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+
+
+// 配置リソース用のヒープアロケータ
+// 大きなヒープ (ブロック) をまとめて作り、TlsfAllocator で切り出して CreatePlacedResource する
+// リソースごとにコミットドリソースを作るより、ドライバの呼び出しとアライメントの無駄が少ない
+// ブロックに収まらない大きさのリソースは専用のブロックを作る
+
+
+struct GpuHeapAllocatorDesc
+{
+    HEAP_TYPE heapType;
+    HEAP_FLAG heapFlags; // リソース ヒープ ティア 1 ではバッファ / テクスチャで分ける
+    u64       blockSize; // 0 なら DefaultBlockSize
+};
+
+
+// 確保した領域 (解放に使う)
+struct GpuHeapAllocation
+{
+    u32 blockIndex;
+    u32 handle;
+    u64 offset;
+    u64 size;
+};
+
+
+// 統計情報
+struct GpuHeapAllocatorStatistics
+{
+    u32 blockCount;
+    u32 allocationCount;
+    u64 reservedBytes;     // 作ったヒープの合計
+    u64 usedBytes;
+    u64 largestFreeBytes;  // 1 回で確保できる最大サイズ
+    f64 fragmentation;     // 空き領域全体の断片化の度合い (0 ～ 1)
+    u64 createHeapCount;   // 累計
+    u64 allocateCount;     // 累計
+    u64 freeCount;         // 累計
+};
+
+
+class GpuHeapAllocator
+{
+public:
+    static const u64 DefaultBlockSize = 64 * 1024 * 1024;
+
+    GpuHeapAllocator();
+
+    ~GpuHeapAllocator();
+
+    HRESULT Init(IGraphicsDevice* pDevice, const GpuHeapAllocatorDesc& desc);
+
+    // 全て解放済みであること
+    void Term();
+
+    // ヒープから切り出した領域にリソースを作る
+    HRESULT CreateResource(const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut, GpuHeapAllocation* pAllocation);
+
+    // リソースを破棄してから呼ぶこと (GPU が使い終わっていること)
+    void Free(const GpuHeapAllocation& allocation);
+
+    void GetStatistics(GpuHeapAllocatorStatistics* pOut) const;
+
+    // デフラグ
+    // 使用率が maxUsage 以下のブロックを退避対象にし、そこにある確保を pCandidates に返す
+    // 退避対象のブロックからは新たに確保しないので、呼び出し側は候補を CreateResource で作り直して
+    // データをコピーし、GPU が終わってから元を Free する
+    // EndDefragmentation で空になったブロックのヒープを破棄する
+    void BeginDefragmentation(f64 maxUsage, std::vector<GpuHeapAllocation>* pCandidates);
+
+    void EndDefragmentation();
+
+    bool IsDefragmenting() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<IGraphicsHeap> heap;
+        TlsfAllocator                  allocator;
+        bool                           isDedicated;  // 大きなリソース 1 つ用
+        bool                           isEvacuating; // デフラグで退避中
+    };
+
+private:
+    // size を確保できるブロックを作る (空いている番号を再利用する)
+    HRESULT CreateBlock(u64 size, bool isDedicated, u32* pIndex);
+
+    void DestroyBlock(u32 index);
+
+private:
+    IGraphicsDevice*                    m_pDevice;
+    GpuHeapAllocatorDesc                m_Desc;
+    std::vector<std::unique_ptr<Block>> m_Blocks; // 破棄したブロックは nullptr
+    bool                                m_IsDefragmenting;
+
+    u64 m_CreateHeapCount;
+    u64 m_AllocateCount;
+    u64 m_FreeCount;
+};
@@ -0,0 +1,63 @@
+﻿
+
+HRESULT CreateGraphicsDevice(const GraphicsDeviceDesc& desc, std::unique_ptr<IGraphicsDevice>* pOut)
+{
+    switch (desc.backend)
+    {
+#if defined(_WIN32)
+    case GRAPHICS_BACKEND_D3D12:
+        {
+            std::unique_ptr<GraphicsDeviceD3D12> device(new GraphicsDeviceD3D12());
+            HRESULT hr = device->Init(desc.enableDebugLayer);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            pOut->reset(device.release());
+            return S_OK;
+        }
+#endif
+
+    case GRAPHICS_BACKEND_NULL:
+        {
+            std::unique_ptr<GraphicsDeviceNull> device(new GraphicsDeviceNull());
+            if (!device->Init(nullptr, desc.emulatedGpuMilliseconds))
+            {
+                return E_FAIL;
+            }
+            pOut->reset(device.release());
+            return S_OK;
+        }
+
+    case GRAPHICS_BACKEND_SOFTWARE:
+        {
+            std::unique_ptr<GraphicsDeviceSoftware> device(new GraphicsDeviceSoftware());
+            if (!device->Init(0, desc.emulatedGpuMilliseconds))
+            {
+                return E_FAIL;
+            }
+            pOut->reset(device.release());
+            return S_OK;
+        }
+
+    default:
+        return E_NOTIMPL;
+    }
+}
+
+
+ResourceDesc MakeBufferResourceDesc(u64 size)
+{
+    ResourceDesc resourceDesc = {};
+    resourceDesc.dimension = RESOURCE_DIMENSION_BUFFER; // バッファ
+    resourceDesc.alignment = 0;
+    resourceDesc.width = size; // 幅でバッファ全体のサイズを表現
+    resourceDesc.height = 1; // 幅で表現しているので 1 とする
+    resourceDesc.depthOrArraySize = 1; // 1 でよい
+    resourceDesc.mipLevels = 1; // 1 でよい
+    resourceDesc.format = GRAPHICS_FORMAT_UNKNOWN; // 画像ではないので UNKNOWN でよい
+    resourceDesc.sampleCount = 1;
+    resourceDesc.flags = RESOURCE_FLAG_NONE;
+    return resourceDesc;
+}
+
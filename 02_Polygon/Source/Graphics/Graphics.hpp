@@ -0,0 +1,272 @@
+﻿#pragma once
+
+
+// グラフィックス API の薄い抽象化
+// SampleApp はこのインターフェース越しにデバイス・コマンドリスト・キュー・スワップチェインを扱う
+
+
+// リソース
+class IGraphicsResource
+{
+public:
+    virtual ~IGraphicsResource() = default;
+
+    virtual const ResourceDesc& GetDesc() const = 0;
+
+    virtual HRESULT Map(u32 subresource, void** ppData) = 0;
+
+    virtual void Unmap(u32 subresource) = 0;
+
+    virtual u64 GetGPUVirtualAddress() const = 0;
+};
+
+
+// ヒープ (配置リソースの置き場所)
+class IGraphicsHeap
+{
+public:
+    virtual ~IGraphicsHeap() = default;
+
+    virtual const HeapDesc& GetDesc() const = 0;
+};
+
+
+// ルートシグネチャ
+class IGraphicsRootSignature
+{
+public:
+    virtual ~IGraphicsRootSignature() = default;
+};
+
+
+// パイプラインステート
+class IGraphicsPipelineState
+{
+public:
+    virtual ~IGraphicsPipelineState() = default;
+};
+
+
+// パイプラインライブラリ
+// 作成済みのパイプラインを名前を付けて保存し、次回の起動ではコンパイルせずに作る
+class IGraphicsPipelineLibrary
+{
+public:
+    virtual ~IGraphicsPipelineLibrary() = default;
+
+    // 無ければ E_INVALIDARG (desc は保存したときと同じであること)
+    virtual HRESULT LoadGraphicsPipeline(const char* name, const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) = 0;
+
+    // 同じ名前が既にあれば E_INVALIDARG
+    virtual HRESULT StorePipeline(const char* name, IGraphicsPipelineState* pPipelineState) = 0;
+
+    virtual size_t GetSerializedSize() const = 0;
+
+    virtual HRESULT Serialize(void* pData, size_t dataSize) = 0;
+};
+
+
+// ディスクリプタヒープ
+class IGraphicsDescriptorHeap
+{
+public:
+    virtual ~IGraphicsDescriptorHeap() = default;
+
+    virtual const DescriptorHeapDesc& GetDesc() const = 0;
+
+    virtual CpuDescriptorHandle GetCPUDescriptorHandleForHeapStart() const = 0;
+
+    virtual GpuDescriptorHandle GetGPUDescriptorHandleForHeapStart() const = 0;
+};
+
+
+// フェンス
+class IGraphicsFence
+{
+public:
+    virtual ~IGraphicsFence() = default;
+
+    virtual u64 GetCompletedValue() const = 0;
+
+    // 指定値に到達するまで CPU を待機させる
+    virtual HRESULT Wait(u64 value) = 0;
+};
+
+
+// コマンドアロケータ
+class IGraphicsCommandAllocator
+{
+public:
+    virtual ~IGraphicsCommandAllocator() = default;
+
+    virtual HRESULT Reset() = 0;
+};
+
+
+// コマンドリスト
+class IGraphicsCommandList
+{
+public:
+    virtual ~IGraphicsCommandList() = default;
+
+    virtual COMMAND_LIST_TYPE GetType() const = 0;
+
+    virtual HRESULT Close() = 0;
+
+    virtual HRESULT Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState) = 0;
+
+    virtual void ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers) = 0;
+
+    virtual void OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil) = 0;
+
+    virtual void ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4]) = 0;
+
+    virtual void SetPipelineState(IGraphicsPipelineState* pPipelineState) = 0;
+
+    virtual void SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature) = 0;
+
+    virtual void SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps) = 0;
+
+    virtual void SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor) = 0;
+
+    virtual void SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues) = 0;
+
+    virtual void SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation) = 0;
+
+    virtual void RSSetViewports(u32 numViewports, const Viewport* pViewports) = 0;
+
+    virtual void RSSetScissorRects(u32 numRects, const Rect* pRects) = 0;
+
+    virtual void IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology) = 0;
+
+    virtual void IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews) = 0;
+
+    virtual void IASetIndexBuffer(const IndexBufferView* pView) = 0;
+
+    virtual void DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation) = 0;
+
+    virtual void DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation) = 0;
+
+    virtual void CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes) = 0;
+};
+
+
+// コマンドキュー
+class IGraphicsCommandQueue
+{
+public:
+    virtual ~IGraphicsCommandQueue() = default;
+
+    virtual COMMAND_LIST_TYPE GetType() const = 0;
+
+    virtual void ExecuteCommandLists(u32 numCommandLists, IGraphicsCommandList* const* ppCommandLists) = 0;
+
+    // キューの処理がここまで進んだらフェンスに値を設定する
+    virtual HRESULT Signal(IGraphicsFence* pFence, u64 value) = 0;
+
+    // フェンスが指定値に到達するまでキューの処理を待機させる
+    virtual HRESULT Wait(IGraphicsFence* pFence, u64 value) = 0;
+};
+
+
+// スワップチェイン
+class IGraphicsSwapChain
+{
+public:
+    virtual ~IGraphicsSwapChain() = default;
+
+    virtual u32 GetBufferCount() const = 0;
+
+    virtual u32 GetCurrentBackBufferIndex() const = 0;
+
+    // バックバッファ (所有権はスワップチェインが持つ)
+    virtual IGraphicsResource* GetBuffer(u32 index) const = 0;
+
+    virtual HRESULT Present(u32 syncInterval) = 0;
+};
+
+
+// 統計情報
+struct GraphicsStatistics
+{
+    u64 executedCommandLists;
+    u64 recordedCommands;
+    u64 recordedBytes;
+    u64 presentCount;
+    u64 drawCount;
+    u64 resourceBarrierCalls;
+    u64 resourceBarriers;
+
+    // ソフトウェアラスタライザのみ
+    u64 triangleCount;
+    u64 pixelCount;
+    f64 rasterizeMilliseconds;
+};
+
+
+// デバイス
+class IGraphicsDevice
+{
+public:
+    virtual ~IGraphicsDevice() = default;
+
+    virtual GRAPHICS_BACKEND GetBackend() const = 0;
+
+    virtual HRESULT CreateCommandQueue(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandQueue>* pOut) = 0;
+
+    virtual HRESULT CreateCommandAllocator(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandAllocator>* pOut) = 0;
+
+    virtual HRESULT CreateCommandList(COMMAND_LIST_TYPE type, IGraphicsCommandAllocator* pAllocator, std::unique_ptr<IGraphicsCommandList>* pOut) = 0;
+
+    virtual HRESULT CreateSwapChain(IGraphicsCommandQueue* pQueue, void* windowHandle, const SwapChainDesc& desc, std::unique_ptr<IGraphicsSwapChain>* pOut) = 0;
+
+    virtual HRESULT CreateDescriptorHeap(const DescriptorHeapDesc& desc, std::unique_ptr<IGraphicsDescriptorHeap>* pOut) = 0;
+
+    virtual u32 GetDescriptorHandleIncrementSize(DESCRIPTOR_HEAP_TYPE type) const = 0;
+
+    virtual void CreateRenderTargetView(IGraphicsResource* pResource, CpuDescriptorHandle destDescriptor) = 0;
+
+    // CPU 専用ヒープのディスクリプタを連続した領域へコピーする
+    virtual void CopyDescriptorsSimple(u32 numDescriptors, CpuDescriptorHandle destDescriptorRangeStart, CpuDescriptorHandle srcDescriptorRangeStart, DESCRIPTOR_HEAP_TYPE type) = 0;
+
+    virtual HRESULT CreateFence(u64 initialValue, std::unique_ptr<IGraphicsFence>* pOut) = 0;
+
+    virtual HRESULT CreateCommittedResource(HEAP_TYPE heapType, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) = 0;
+
+    virtual HRESULT CreateHeap(const HeapDesc& desc, std::unique_ptr<IGraphicsHeap>* pOut) = 0;
+
+    // ヒープ内の heapOffset にリソースを配置する (メモリはヒープが持つ)
+    virtual HRESULT CreatePlacedResource(IGraphicsHeap* pHeap, u64 heapOffset, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) = 0;
+
+    virtual ResourceAllocationInfo GetResourceAllocationInfo(const ResourceDesc& desc) const = 0;
+
+    // 失敗時は pErrorText にシリアライズのエラー内容を格納する
+    virtual HRESULT CreateRootSignature(const RootSignatureDesc& desc, std::unique_ptr<IGraphicsRootSignature>* pOut, std::string* pErrorText) = 0;
+
+    virtual HRESULT CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) = 0;
+
+    // pData は Serialize した内容 (空なら新しいライブラリ、内容はコピーする)
+    // ドライバーやアダプタが変わった、または壊れていれば失敗するので、空で作り直すこと
+    virtual HRESULT CreatePipelineLibrary(const void* pData, size_t dataSize, std::unique_ptr<IGraphicsPipelineLibrary>* pOut) = 0;
+
+    virtual void GetStatistics(GraphicsStatistics* pOut) const = 0;
+};
+
+
+// デバイスの設定
+struct GraphicsDeviceDesc
+{
+    GRAPHICS_BACKEND backend;
+    bool             enableDebugLayer; // D3D12 のみ
+
+    // Null / ソフトウェアのみ: 1 回の ExecuteCommandLists にかかる疑似的な GPU 時間 [ミリ秒]
+    f64 emulatedGpuMilliseconds;
+};
+
+
+// デバイスの作成
+HRESULT CreateGraphicsDevice(const GraphicsDeviceDesc& desc, std::unique_ptr<IGraphicsDevice>* pOut);
+
+// バッファ用のリソース設定
+ResourceDesc MakeBufferResourceDesc(u64 size);
+
@@ -0,0 +1,17 @@
+﻿
+
+u32 GetFormatByteSize(GRAPHICS_FORMAT format)
+{
+    switch (format)
+    {
+    case GRAPHICS_FORMAT_R8G8B8A8_UNORM:     return 4;
+    case GRAPHICS_FORMAT_R32G32_FLOAT:       return 8;
+    case GRAPHICS_FORMAT_R32G32B32_FLOAT:    return 12;
+    case GRAPHICS_FORMAT_R32G32B32A32_FLOAT: return 16;
+    case GRAPHICS_FORMAT_R16_UINT:           return 2;
+    case GRAPHICS_FORMAT_R32_UINT:           return 4;
+    case GRAPHICS_FORMAT_D32_FLOAT:          return 4;
+    default:                                 return 0;
+    }
+}
+
@@ -0,0 +1,513 @@
+﻿#pragma once
+
+
+// グラフィックス API に依存しない型定義
+
+
+class IGraphicsResource;
+class IGraphicsRootSignature;
+
+
+struct Float3
+{
+    f32 x;
+    f32 y;
+    f32 z;
+};
+
+struct Float4
+{
+    f32 x;
+    f32 y;
+    f32 z;
+    f32 w;
+};
+
+
+// バックエンド
+enum GRAPHICS_BACKEND
+{
+    GRAPHICS_BACKEND_D3D12
+
+    , GRAPHICS_BACKEND_NULL
+    , GRAPHICS_BACKEND_SOFTWARE
+};
+
+
+// フォーマット
+enum GRAPHICS_FORMAT
+{
+    GRAPHICS_FORMAT_UNKNOWN
+
+    , GRAPHICS_FORMAT_R8G8B8A8_UNORM
+    , GRAPHICS_FORMAT_R32G32_FLOAT
+    , GRAPHICS_FORMAT_R32G32B32_FLOAT
+    , GRAPHICS_FORMAT_R32G32B32A32_FLOAT
+    , GRAPHICS_FORMAT_R16_UINT
+    , GRAPHICS_FORMAT_R32_UINT
+    , GRAPHICS_FORMAT_D32_FLOAT
+};
+
+
+// コマンドリストの種類
+enum COMMAND_LIST_TYPE
+{
+    COMMAND_LIST_TYPE_DIRECT
+
+    , COMMAND_LIST_TYPE_COMPUTE
+    , COMMAND_LIST_TYPE_COPY
+};
+
+
+// ヒープの種類
+enum HEAP_TYPE
+{
+    HEAP_TYPE_DEFAULT
+
+    , HEAP_TYPE_UPLOAD
+    , HEAP_TYPE_READBACK
+};
+
+
+// ヒープフラグ (リソース ヒープ ティア 1 では種類を 1 つに限定する)
+enum HEAP_FLAG
+{
+    HEAP_FLAG_NONE                              = 0x0
+
+    , HEAP_FLAG_ALLOW_ONLY_BUFFERS              = 0x1
+    , HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES   = 0x2
+    , HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES       = 0x4
+};
+
+
+// リソースの次元
+enum RESOURCE_DIMENSION
+{
+    RESOURCE_DIMENSION_BUFFER
+
+    , RESOURCE_DIMENSION_TEXTURE2D
+};
+
+
+// リソースフラグ
+enum RESOURCE_FLAG
+{
+    RESOURCE_FLAG_NONE                     = 0x0
+
+    , RESOURCE_FLAG_ALLOW_RENDER_TARGET    = 0x1
+    , RESOURCE_FLAG_ALLOW_DEPTH_STENCIL    = 0x2
+    , RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4
+};
+
+
+// リソースの状態 (ビットの組み合わせ、値は D3D12_RESOURCE_STATES と同じ)
+enum RESOURCE_STATE
+{
+    RESOURCE_STATE_COMMON                       = 0x0
+
+    , RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1
+    , RESOURCE_STATE_INDEX_BUFFER               = 0x2
+    , RESOURCE_STATE_RENDER_TARGET              = 0x4
+    , RESOURCE_STATE_UNORDERED_ACCESS           = 0x8
+    , RESOURCE_STATE_DEPTH_WRITE                = 0x10
+    , RESOURCE_STATE_DEPTH_READ                 = 0x20
+    , RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE  = 0x40
+    , RESOURCE_STATE_PIXEL_SHADER_RESOURCE      = 0x80
+    , RESOURCE_STATE_INDIRECT_ARGUMENT          = 0x200
+    , RESOURCE_STATE_COPY_DEST                  = 0x400
+    , RESOURCE_STATE_COPY_SOURCE                = 0x800
+    , RESOURCE_STATE_GENERIC_READ               = 0x1 | 0x2 | 0x40 | 0x80 | 0x200 | 0x800
+    , RESOURCE_STATE_PRESENT                    = 0x0
+};
+
+
+// ディスクリプタヒープの種類
+enum DESCRIPTOR_HEAP_TYPE
+{
+    DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
+
+    , DESCRIPTOR_HEAP_TYPE_SAMPLER
+    , DESCRIPTOR_HEAP_TYPE_RTV
+    , DESCRIPTOR_HEAP_TYPE_DSV
+    , DESCRIPTOR_HEAP_TYPE_NUM_TYPES
+};
+
+
+// プリミティブトポロジーの種類 (パイプラインステート用)
+enum PRIMITIVE_TOPOLOGY_TYPE
+{
+    PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED
+
+    , PRIMITIVE_TOPOLOGY_TYPE_POINT
+    , PRIMITIVE_TOPOLOGY_TYPE_LINE
+    , PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE
+};
+
+
+// プリミティブトポロジー
+enum PRIMITIVE_TOPOLOGY
+{
+    PRIMITIVE_TOPOLOGY_UNDEFINED
+
+    , PRIMITIVE_TOPOLOGY_POINTLIST
+    , PRIMITIVE_TOPOLOGY_LINELIST
+    , PRIMITIVE_TOPOLOGY_LINESTRIP
+    , PRIMITIVE_TOPOLOGY_TRIANGLELIST
+    , PRIMITIVE_TOPOLOGY_TRIANGLESTRIP
+};
+
+
+// カリングモード
+enum CULL_MODE
+{
+    CULL_MODE_NONE
+
+    , CULL_MODE_FRONT
+    , CULL_MODE_BACK
+};
+
+
+// フィルモード
+enum FILL_MODE
+{
+    FILL_MODE_SOLID
+
+    , FILL_MODE_WIREFRAME
+};
+
+
+// ブレンド係数
+enum BLEND
+{
+    BLEND_ZERO
+
+    , BLEND_ONE
+    , BLEND_SRC_ALPHA
+    , BLEND_INV_SRC_ALPHA
+};
+
+
+// ブレンド演算
+enum BLEND_OP
+{
+    BLEND_OP_ADD
+
+    , BLEND_OP_SUBTRACT
+};
+
+
+// カラー書き込みマスク
+enum COLOR_WRITE_ENABLE
+{
+    COLOR_WRITE_ENABLE_RED     = 0x1
+
+    , COLOR_WRITE_ENABLE_GREEN = 0x2
+    , COLOR_WRITE_ENABLE_BLUE  = 0x4
+    , COLOR_WRITE_ENABLE_ALPHA = 0x8
+    , COLOR_WRITE_ENABLE_ALL   = 0xF
+};
+
+
+// ルートパラメータの種類
+enum ROOT_PARAMETER_TYPE
+{
+    ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE
+
+    , ROOT_PARAMETER_TYPE_32BIT_CONSTANTS
+    , ROOT_PARAMETER_TYPE_CBV
+    , ROOT_PARAMETER_TYPE_SRV
+    , ROOT_PARAMETER_TYPE_UAV
+};
+
+
+// ディスクリプタレンジの種類
+enum DESCRIPTOR_RANGE_TYPE
+{
+    DESCRIPTOR_RANGE_TYPE_SRV
+
+    , DESCRIPTOR_RANGE_TYPE_UAV
+    , DESCRIPTOR_RANGE_TYPE_CBV
+    , DESCRIPTOR_RANGE_TYPE_SAMPLER
+};
+
+
+// シェーダーの可視性
+enum SHADER_VISIBILITY
+{
+    SHADER_VISIBILITY_ALL
+
+    , SHADER_VISIBILITY_VERTEX
+    , SHADER_VISIBILITY_PIXEL
+};
+
+
+// ルートシグネチャフラグ
+enum ROOT_SIGNATURE_FLAG
+{
+    ROOT_SIGNATURE_FLAG_NONE                                 = 0x0
+
+    , ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1
+    , ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS     = 0x2 // ルート引数を使わない段階
+    , ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS      = 0x4
+};
+
+
+// リソースバリアの種類
+enum RESOURCE_BARRIER_TYPE
+{
+    RESOURCE_BARRIER_TYPE_TRANSITION
+
+    , RESOURCE_BARRIER_TYPE_ALIASING
+    , RESOURCE_BARRIER_TYPE_UAV
+};
+
+
+// リソースバリアフラグ
+enum RESOURCE_BARRIER_FLAG
+{
+    RESOURCE_BARRIER_FLAG_NONE
+
+    , RESOURCE_BARRIER_FLAG_BEGIN_ONLY
+    , RESOURCE_BARRIER_FLAG_END_ONLY
+};
+
+
+// 全サブリソース指定
+static const u32 RESOURCE_BARRIER_ALL_SUBRESOURCES = 0xFFFFFFFF;
+
+// 直前の要素に続けて配置
+static const u32 APPEND_ALIGNED_ELEMENT = 0xFFFFFFFF;
+
+
+// ディスクリプタハンドル
+struct CpuDescriptorHandle
+{
+    size_t ptr;
+};
+
+struct GpuDescriptorHandle
+{
+    u64 ptr;
+};
+
+
+// ビューポート
+struct Viewport
+{
+    f32 topLeftX;
+    f32 topLeftY;
+    f32 width;
+    f32 height;
+    f32 minDepth;
+    f32 maxDepth;
+};
+
+
+// 矩形
+struct Rect
+{
+    s32 left;
+    s32 top;
+    s32 right;
+    s32 bottom;
+};
+
+
+// 頂点バッファビュー
+struct VertexBufferView
+{
+    u64 bufferLocation;
+    u32 sizeInBytes;
+    u32 strideInBytes;
+};
+
+
+// インデックスバッファビュー
+struct IndexBufferView
+{
+    u64             bufferLocation;
+    u32             sizeInBytes;
+    GRAPHICS_FORMAT format;
+};
+
+
+// リソースの設定
+struct ResourceDesc
+{
+    RESOURCE_DIMENSION dimension;
+    u64                alignment;
+    u64                width;
+    u32                height;
+    u16                depthOrArraySize;
+    u16                mipLevels;
+    GRAPHICS_FORMAT    format;
+    u32                sampleCount;
+    RESOURCE_FLAG      flags;
+};
+
+
+// ヒープの設定
+struct HeapDesc
+{
+    u64       sizeInBytes;
+    HEAP_TYPE type;
+    u64       alignment; // 0 なら 64KB
+    HEAP_FLAG flags;
+};
+
+
+// リソースを配置するのに必要なサイズとアライメント
+struct ResourceAllocationInfo
+{
+    u64 sizeInBytes;
+    u64 alignment;
+};
+
+
+// スワップチェインの設定
+struct SwapChainDesc
+{
+    u32             width;
+    u32             height;
+    GRAPHICS_FORMAT format;
+    u32             bufferCount;
+};
+
+
+// ディスクリプタヒープの設定
+struct DescriptorHeapDesc
+{
+    DESCRIPTOR_HEAP_TYPE type;
+    u32                  numDescriptors;
+    bool                 shaderVisible;
+};
+
+
+// 入力要素
+struct InputElementDesc
+{
+    const char*     semanticName;
+    u32             semanticIndex;
+    GRAPHICS_FORMAT format;
+    u32             inputSlot;
+    u32             alignedByteOffset;
+};
+
+
+// 入力レイアウト
+struct InputLayoutDesc
+{
+    const InputElementDesc* pInputElementDescs;
+    u32                     numElements;
+};
+
+
+// シェーダーバイトコード
+struct ShaderBytecode
+{
+    const void* pShaderBytecode;
+    size_t      bytecodeLength;
+};
+
+
+// ディスクリプタレンジ
+struct DescriptorRange
+{
+    DESCRIPTOR_RANGE_TYPE rangeType;
+    u32                   numDescriptors;
+    u32                   baseShaderRegister;
+    u32                   registerSpace;
+    u32                   offsetInDescriptorsFromTableStart;
+};
+
+
+// ルートパラメータ
+struct RootParameter
+{
+    ROOT_PARAMETER_TYPE parameterType;
+    SHADER_VISIBILITY   shaderVisibility;
+
+    // ディスクリプタテーブル
+    u32                    numDescriptorRanges;
+    const DescriptorRange* pDescriptorRanges;
+
+    // ルート定数 / ルートディスクリプタ
+    u32 shaderRegister;
+    u32 registerSpace;
+    u32 num32BitValues;
+};
+
+
+// ルートシグネチャの設定
+struct RootSignatureDesc
+{
+    u32                  numParameters;
+    const RootParameter* pParameters;
+    ROOT_SIGNATURE_FLAG  flags;
+};
+
+
+// ラスタライザステート
+struct RasterizerDesc
+{
+    FILL_MODE fillMode;
+    CULL_MODE cullMode;
+    bool      depthClipEnable;
+    bool      multisampleEnable;
+};
+
+
+// ブレンドステート (全レンダーターゲット共通)
+struct BlendDesc
+{
+    bool     blendEnable;
+    BLEND    srcBlend;
+    BLEND    destBlend;
+    BLEND_OP blendOp;
+    u8       renderTargetWriteMask;
+};
+
+
+// グラフィックスパイプラインステートの設定
+struct GraphicsPipelineStateDesc
+{
+    IGraphicsRootSignature* pRootSignature;
+
+    ShaderBytecode VS;
+    ShaderBytecode PS;
+
+    BlendDesc      blendState;
+    u32            sampleMask;
+    RasterizerDesc rasterizerState;
+    bool           depthEnable;
+
+    InputLayoutDesc         inputLayout;
+    PRIMITIVE_TOPOLOGY_TYPE primitiveTopologyType;
+
+    u32             numRenderTargets;
+    GRAPHICS_FORMAT rtvFormats[8];
+    GRAPHICS_FORMAT dsvFormat;
+    u32             sampleCount;
+};
+
+
+// リソースバリア
+struct ResourceBarrierDesc
+{
+    RESOURCE_BARRIER_TYPE type;
+    RESOURCE_BARRIER_FLAG flags;
+
+    // 遷移 / UAV / エイリアシング前
+    IGraphicsResource* pResource;
+    u32                subresource;
+    RESOURCE_STATE     stateBefore;
+    RESOURCE_STATE     stateAfter;
+
+    // エイリアシング後
+    IGraphicsResource* pResourceAfter;
+};
+
+
+// フォーマット 1 要素あたりのバイト数
+u32 GetFormatByteSize(GRAPHICS_FORMAT format);
+
@@ -0,0 +1,1113 @@
+﻿
+
+//-----------------------------------------------------------------
+// GraphicsResourceNull
+//-----------------------------------------------------------------
+GraphicsResourceNull::GraphicsResourceNull(const ResourceDesc& desc)
+    : m_Desc(desc)
+    , m_pData(nullptr)
+    , m_DataSize(CalcDataSize(desc))
+{
+    m_Memory.resize((m_DataSize + sizeof(u64) - 1) / sizeof(u64));
+    m_pData = reinterpret_cast<u8*>(m_Memory.data());
+}
+
+
+GraphicsResourceNull::GraphicsResourceNull(const ResourceDesc& desc, u8* pPlacedData)
+    : m_Desc(desc)
+    , m_pData(pPlacedData)
+    , m_DataSize(CalcDataSize(desc))
+{
+
+}
+
+
+GraphicsResourceNull::~GraphicsResourceNull()
+{
+
+}
+
+
+const ResourceDesc& GraphicsResourceNull::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+HRESULT GraphicsResourceNull::Map(u32 subresource, void** ppData)
+{
+    subresource;
+
+    *ppData = GetData();
+    return S_OK;
+}
+
+
+void GraphicsResourceNull::Unmap(u32 subresource)
+{
+    subresource;
+}
+
+
+u64 GraphicsResourceNull::GetGPUVirtualAddress() const
+{
+    return reinterpret_cast<u64>(m_pData);
+}
+
+
+u8* GraphicsResourceNull::GetData()
+{
+    return m_pData;
+}
+
+
+size_t GraphicsResourceNull::GetDataSize() const
+{
+    return m_DataSize;
+}
+
+
+u32 GraphicsResourceNull::GetRowPitch() const
+{
+    if (m_Desc.dimension == RESOURCE_DIMENSION_BUFFER)
+    {
+        return static_cast<u32>(m_Desc.width);
+    }
+    return static_cast<u32>(m_Desc.width) * GetFormatByteSize(m_Desc.format);
+}
+
+
+size_t GraphicsResourceNull::CalcDataSize(const ResourceDesc& desc)
+{
+    if (desc.dimension == RESOURCE_DIMENSION_BUFFER)
+    {
+        return static_cast<size_t>(desc.width);
+    }
+    return static_cast<size_t>(desc.width) * GetFormatByteSize(desc.format) * desc.height * desc.depthOrArraySize;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsHeapNull
+//-----------------------------------------------------------------
+GraphicsHeapNull::GraphicsHeapNull(const HeapDesc& desc)
+    : m_Desc(desc)
+    , m_Memory(static_cast<size_t>((desc.sizeInBytes + sizeof(u64) - 1) / sizeof(u64)))
+{
+
+}
+
+
+GraphicsHeapNull::~GraphicsHeapNull()
+{
+
+}
+
+
+const HeapDesc& GraphicsHeapNull::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+u8* GraphicsHeapNull::GetData()
+{
+    return reinterpret_cast<u8*>(m_Memory.data());
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsRootSignatureNull
+//-----------------------------------------------------------------
+GraphicsRootSignatureNull::GraphicsRootSignatureNull(const RootSignatureDesc& desc)
+    : m_Parameters(desc.pParameters, desc.pParameters + desc.numParameters)
+    , m_DescriptorRanges(desc.numParameters)
+    , m_Flags(desc.flags)
+{
+    for (size_t i = 0; i < m_Parameters.size(); i++)
+    {
+        RootParameter& parameter = m_Parameters[i];
+        if (parameter.parameterType != ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+        {
+            continue;
+        }
+
+        m_DescriptorRanges[i].assign(
+            parameter.pDescriptorRanges,
+            parameter.pDescriptorRanges + parameter.numDescriptorRanges
+        );
+        parameter.pDescriptorRanges = m_DescriptorRanges[i].data();
+    }
+}
+
+
+GraphicsRootSignatureNull::~GraphicsRootSignatureNull()
+{
+
+}
+
+
+u32 GraphicsRootSignatureNull::GetNumParameters() const
+{
+    return static_cast<u32>(m_Parameters.size());
+}
+
+
+const RootParameter& GraphicsRootSignatureNull::GetParameter(u32 index) const
+{
+    return m_Parameters[index];
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsPipelineStateNull
+//-----------------------------------------------------------------
+GraphicsPipelineStateNull::GraphicsPipelineStateNull(const GraphicsPipelineStateDesc& desc)
+    : m_Desc(desc)
+{
+    // シェーダーのコピー
+    const u8* pVS = reinterpret_cast<const u8*>(desc.VS.pShaderBytecode);
+    const u8* pPS = reinterpret_cast<const u8*>(desc.PS.pShaderBytecode);
+
+    if (pVS != nullptr)
+    {
+        m_VS.assign(pVS, pVS + desc.VS.bytecodeLength);
+    }
+    if (pPS != nullptr)
+    {
+        m_PS.assign(pPS, pPS + desc.PS.bytecodeLength);
+    }
+
+    m_Desc.VS.pShaderBytecode = m_VS.data();
+    m_Desc.PS.pShaderBytecode = m_PS.data();
+
+    // 入力レイアウトのコピー
+    m_InputElements.assign(
+        desc.inputLayout.pInputElementDescs,
+        desc.inputLayout.pInputElementDescs + desc.inputLayout.numElements
+    );
+
+    m_SemanticNames.resize(m_InputElements.size());
+    for (size_t i = 0; i < m_InputElements.size(); i++)
+    {
+        m_SemanticNames[i] = m_InputElements[i].semanticName;
+        m_InputElements[i].semanticName = m_SemanticNames[i].c_str();
+    }
+
+    m_Desc.inputLayout.pInputElementDescs = m_InputElements.data();
+}
+
+
+GraphicsPipelineStateNull::~GraphicsPipelineStateNull()
+{
+
+}
+
+
+const GraphicsPipelineStateDesc& GraphicsPipelineStateNull::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsPipelineLibraryNull
+//-----------------------------------------------------------------
+GraphicsPipelineLibraryNull::GraphicsPipelineLibraryNull()
+{
+
+}
+
+
+GraphicsPipelineLibraryNull::~GraphicsPipelineLibraryNull()
+{
+
+}
+
+
+HRESULT GraphicsPipelineLibraryNull::Init(const void* pData, size_t dataSize)
+{
+    const u8* p = static_cast<const u8*>(pData);
+    const u8* pEnd = p + dataSize;
+    while (p < pEnd)
+    {
+        u32 length = 0;
+        if (static_cast<size_t>(pEnd - p) < sizeof(length))
+        {
+            return E_INVALIDARG;
+        }
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+
+        if (static_cast<size_t>(pEnd - p) < length)
+        {
+            return E_INVALIDARG;
+        }
+        m_Names.push_back(std::string(reinterpret_cast<const char*>(p), length));
+        p += length;
+    }
+
+    if (!std::is_sorted(m_Names.begin(), m_Names.end()))
+    {
+        m_Names.clear();
+        return E_INVALIDARG;
+    }
+    return S_OK;
+}
+
+
+HRESULT GraphicsPipelineLibraryNull::LoadGraphicsPipeline(const char* name, const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut)
+{
+    if (desc.pRootSignature == nullptr || !std::binary_search(m_Names.begin(), m_Names.end(), std::string(name)))
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsPipelineStateNull(desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsPipelineLibraryNull::StorePipeline(const char* name, IGraphicsPipelineState* pPipelineState)
+{
+    const std::string key = name;
+    const std::vector<std::string>::iterator it = std::lower_bound(m_Names.begin(), m_Names.end(), key);
+    if (pPipelineState == nullptr || (it != m_Names.end() && *it == key))
+    {
+        return E_INVALIDARG;
+    }
+
+    m_Names.insert(it, key);
+    return S_OK;
+}
+
+
+size_t GraphicsPipelineLibraryNull::GetSerializedSize() const
+{
+    size_t size = 0;
+    for (const std::string& name : m_Names)
+    {
+        size += sizeof(u32) + name.size();
+    }
+    return size;
+}
+
+
+HRESULT GraphicsPipelineLibraryNull::Serialize(void* pData, size_t dataSize)
+{
+    if (dataSize < GetSerializedSize())
+    {
+        return E_INVALIDARG;
+    }
+
+    u8* p = static_cast<u8*>(pData);
+    for (const std::string& name : m_Names)
+    {
+        const u32 length = static_cast<u32>(name.size());
+        std::memcpy(p, &length, sizeof(length));
+        p += sizeof(length);
+        std::memcpy(p, name.data(), name.size());
+        p += name.size();
+    }
+    return S_OK;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsDescriptorHeapNull
+//-----------------------------------------------------------------
+GraphicsDescriptorHeapNull::GraphicsDescriptorHeapNull(const DescriptorHeapDesc& desc)
+    : m_Desc(desc)
+    , m_Descriptors(desc.numDescriptors, NullDescriptor{ nullptr })
+{
+
+}
+
+
+GraphicsDescriptorHeapNull::~GraphicsDescriptorHeapNull()
+{
+
+}
+
+
+const DescriptorHeapDesc& GraphicsDescriptorHeapNull::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+CpuDescriptorHandle GraphicsDescriptorHeapNull::GetCPUDescriptorHandleForHeapStart() const
+{
+    CpuDescriptorHandle handle = { reinterpret_cast<size_t>(m_Descriptors.data()) };
+    return handle;
+}
+
+
+GpuDescriptorHandle GraphicsDescriptorHeapNull::GetGPUDescriptorHandleForHeapStart() const
+{
+    GpuDescriptorHandle handle = { 0 };
+    if (m_Desc.shaderVisible)
+    {
+        handle.ptr = reinterpret_cast<u64>(m_Descriptors.data());
+    }
+    return handle;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsFenceNull
+//-----------------------------------------------------------------
+GraphicsFenceNull::GraphicsFenceNull(u64 initialValue)
+    : m_CompletedValue(initialValue)
+{
+
+}
+
+
+GraphicsFenceNull::~GraphicsFenceNull()
+{
+
+}
+
+
+u64 GraphicsFenceNull::GetCompletedValue() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_CompletedValue;
+}
+
+
+HRESULT GraphicsFenceNull::Wait(u64 value)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Condition.wait(lock, [&]() { return m_CompletedValue >= value; });
+    return S_OK;
+}
+
+
+void GraphicsFenceNull::SetCompletedValue(u64 value)
+{
+    // 待っていた側がすぐにフェンスを破棄してもよいように、ロック中に通知する
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_CompletedValue = value;
+    m_Condition.notify_all();
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandAllocatorNull
+//-----------------------------------------------------------------
+GraphicsCommandAllocatorNull::GraphicsCommandAllocatorNull(COMMAND_LIST_TYPE type)
+    : m_Type(type)
+    , m_UsedCommandStreamCount(0)
+{
+
+}
+
+
+GraphicsCommandAllocatorNull::~GraphicsCommandAllocatorNull()
+{
+
+}
+
+
+HRESULT GraphicsCommandAllocatorNull::Reset()
+{
+    // 記録先はメモリを残したまま再利用する
+    m_UsedCommandStreamCount = 0;
+    return S_OK;
+}
+
+
+COMMAND_LIST_TYPE GraphicsCommandAllocatorNull::GetType() const
+{
+    return m_Type;
+}
+
+
+NullCommandStream* GraphicsCommandAllocatorNull::AcquireCommandStream()
+{
+    if (m_UsedCommandStreamCount == m_CommandStreams.size())
+    {
+        m_CommandStreams.emplace_back(new NullCommandStream());
+    }
+
+    NullCommandStream* pCommandStream = m_CommandStreams[m_UsedCommandStreamCount++].get();
+    pCommandStream->Reset();
+    return pCommandStream;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandListNull
+//-----------------------------------------------------------------
+GraphicsCommandListNull::GraphicsCommandListNull(COMMAND_LIST_TYPE type, GraphicsCommandAllocatorNull* pAllocator)
+    : m_Type(type)
+    , m_pCommandStream(pAllocator->AcquireCommandStream())
+    , m_IsClosed(false)
+{
+
+}
+
+
+GraphicsCommandListNull::~GraphicsCommandListNull()
+{
+
+}
+
+
+COMMAND_LIST_TYPE GraphicsCommandListNull::GetType() const
+{
+    return m_Type;
+}
+
+
+HRESULT GraphicsCommandListNull::Close()
+{
+    if (m_IsClosed)
+    {
+        return E_FAIL;
+    }
+    m_IsClosed = true;
+    return S_OK;
+}
+
+
+HRESULT GraphicsCommandListNull::Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState)
+{
+    if (!m_IsClosed || pAllocator == nullptr)
+    {
+        return E_FAIL;
+    }
+
+    m_pCommandStream = static_cast<GraphicsCommandAllocatorNull*>(pAllocator)->AcquireCommandStream();
+    m_IsClosed = false;
+
+    if (pInitialState != nullptr)
+    {
+        SetPipelineState(pInitialState);
+    }
+    return S_OK;
+}
+
+
+void GraphicsCommandListNull::ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers)
+{
+    NullCommand_ResourceBarrier* pCommand = m_pCommandStream->Allocate<NullCommand_ResourceBarrier>(sizeof(ResourceBarrierDesc) * numBarriers);
+    pCommand->numBarriers = numBarriers;
+    std::copy_n(pBarriers, numBarriers, NullCommandStream::GetArray<NullCommand_ResourceBarrier, ResourceBarrierDesc>(pCommand));
+}
+
+
+void GraphicsCommandListNull::OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil)
+{
+    NullCommand_OMSetRenderTargets* pCommand = m_pCommandStream->Allocate<NullCommand_OMSetRenderTargets>(sizeof(CpuDescriptorHandle) * numRenderTargets);
+    pCommand->numRenderTargets = numRenderTargets;
+    pCommand->hasDepthStencil = pDepthStencil != nullptr;
+    pCommand->depthStencil = pDepthStencil != nullptr ? *pDepthStencil : CpuDescriptorHandle{ 0 };
+    std::copy_n(pRenderTargets, numRenderTargets, NullCommandStream::GetArray<NullCommand_OMSetRenderTargets, CpuDescriptorHandle>(pCommand));
+}
+
+
+void GraphicsCommandListNull::ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4])
+{
+    NullCommand_ClearRenderTargetView* pCommand = m_pCommandStream->Allocate<NullCommand_ClearRenderTargetView>();
+    pCommand->renderTarget = renderTarget;
+    std::copy_n(color, 4, pCommand->color);
+}
+
+
+void GraphicsCommandListNull::SetPipelineState(IGraphicsPipelineState* pPipelineState)
+{
+    NullCommand_SetPipelineState* pCommand = m_pCommandStream->Allocate<NullCommand_SetPipelineState>();
+    pCommand->pPipelineState = pPipelineState;
+}
+
+
+void GraphicsCommandListNull::SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature)
+{
+    NullCommand_SetGraphicsRootSignature* pCommand = m_pCommandStream->Allocate<NullCommand_SetGraphicsRootSignature>();
+    pCommand->pRootSignature = pRootSignature;
+}
+
+
+void GraphicsCommandListNull::SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps)
+{
+    NullCommand_SetDescriptorHeaps* pCommand = m_pCommandStream->Allocate<NullCommand_SetDescriptorHeaps>(sizeof(IGraphicsDescriptorHeap*) * numHeaps);
+    pCommand->numHeaps = numHeaps;
+    std::copy_n(ppHeaps, numHeaps, NullCommandStream::GetArray<NullCommand_SetDescriptorHeaps, IGraphicsDescriptorHeap*>(pCommand));
+}
+
+
+void GraphicsCommandListNull::SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor)
+{
+    NullCommand_SetGraphicsRootDescriptorTable* pCommand = m_pCommandStream->Allocate<NullCommand_SetGraphicsRootDescriptorTable>();
+    pCommand->rootParameterIndex = rootParameterIndex;
+    pCommand->baseDescriptor = baseDescriptor;
+}
+
+
+void GraphicsCommandListNull::SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues)
+{
+    NullCommand_SetGraphicsRoot32BitConstants* pCommand = m_pCommandStream->Allocate<NullCommand_SetGraphicsRoot32BitConstants>(sizeof(u32) * num32BitValues);
+    pCommand->rootParameterIndex = rootParameterIndex;
+    pCommand->num32BitValues = num32BitValues;
+    pCommand->destOffsetIn32BitValues = destOffsetIn32BitValues;
+    std::copy_n(
+        reinterpret_cast<const u32*>(pData),
+        num32BitValues,
+        NullCommandStream::GetArray<NullCommand_SetGraphicsRoot32BitConstants, u32>(pCommand)
+    );
+}
+
+
+void GraphicsCommandListNull::SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation)
+{
+    NullCommand_SetGraphicsRootConstantBufferView* pCommand = m_pCommandStream->Allocate<NullCommand_SetGraphicsRootConstantBufferView>();
+    pCommand->rootParameterIndex = rootParameterIndex;
+    pCommand->bufferLocation = bufferLocation;
+}
+
+
+void GraphicsCommandListNull::RSSetViewports(u32 numViewports, const Viewport* pViewports)
+{
+    NullCommand_RSSetViewports* pCommand = m_pCommandStream->Allocate<NullCommand_RSSetViewports>(sizeof(Viewport) * numViewports);
+    pCommand->numViewports = numViewports;
+    std::copy_n(pViewports, numViewports, NullCommandStream::GetArray<NullCommand_RSSetViewports, Viewport>(pCommand));
+}
+
+
+void GraphicsCommandListNull::RSSetScissorRects(u32 numRects, const Rect* pRects)
+{
+    NullCommand_RSSetScissorRects* pCommand = m_pCommandStream->Allocate<NullCommand_RSSetScissorRects>(sizeof(Rect) * numRects);
+    pCommand->numRects = numRects;
+    std::copy_n(pRects, numRects, NullCommandStream::GetArray<NullCommand_RSSetScissorRects, Rect>(pCommand));
+}
+
+
+void GraphicsCommandListNull::IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+    NullCommand_IASetPrimitiveTopology* pCommand = m_pCommandStream->Allocate<NullCommand_IASetPrimitiveTopology>();
+    pCommand->primitiveTopology = primitiveTopology;
+}
+
+
+void GraphicsCommandListNull::IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews)
+{
+    NullCommand_IASetVertexBuffers* pCommand = m_pCommandStream->Allocate<NullCommand_IASetVertexBuffers>(sizeof(VertexBufferView) * numViews);
+    pCommand->startSlot = startSlot;
+    pCommand->numViews = numViews;
+    std::copy_n(pViews, numViews, NullCommandStream::GetArray<NullCommand_IASetVertexBuffers, VertexBufferView>(pCommand));
+}
+
+
+void GraphicsCommandListNull::IASetIndexBuffer(const IndexBufferView* pView)
+{
+    NullCommand_IASetIndexBuffer* pCommand = m_pCommandStream->Allocate<NullCommand_IASetIndexBuffer>();
+    pCommand->hasView = pView != nullptr;
+    pCommand->view = pView != nullptr ? *pView : IndexBufferView{};
+}
+
+
+void GraphicsCommandListNull::DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation)
+{
+    NullCommand_DrawInstanced* pCommand = m_pCommandStream->Allocate<NullCommand_DrawInstanced>();
+    pCommand->vertexCountPerInstance = vertexCountPerInstance;
+    pCommand->instanceCount = instanceCount;
+    pCommand->startVertexLocation = startVertexLocation;
+    pCommand->startInstanceLocation = startInstanceLocation;
+}
+
+
+void GraphicsCommandListNull::DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation)
+{
+    NullCommand_DrawIndexedInstanced* pCommand = m_pCommandStream->Allocate<NullCommand_DrawIndexedInstanced>();
+    pCommand->indexCountPerInstance = indexCountPerInstance;
+    pCommand->instanceCount = instanceCount;
+    pCommand->startIndexLocation = startIndexLocation;
+    pCommand->baseVertexLocation = baseVertexLocation;
+    pCommand->startInstanceLocation = startInstanceLocation;
+}
+
+
+void GraphicsCommandListNull::CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes)
+{
+    NullCommand_CopyBufferRegion* pCommand = m_pCommandStream->Allocate<NullCommand_CopyBufferRegion>();
+    pCommand->pDstBuffer = pDstBuffer;
+    pCommand->dstOffset = dstOffset;
+    pCommand->pSrcBuffer = pSrcBuffer;
+    pCommand->srcOffset = srcOffset;
+    pCommand->numBytes = numBytes;
+}
+
+
+const NullCommandStream& GraphicsCommandListNull::GetCommandStream() const
+{
+    return *m_pCommandStream;
+}
+
+
+bool GraphicsCommandListNull::IsClosed() const
+{
+    return m_IsClosed;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsCommandQueueNull
+//-----------------------------------------------------------------
+// 記録されたバリアの数 (統計用)
+static u64 CountResourceBarriers(const NullCommandStream& commandStream)
+{
+    u64 count = 0;
+    for (const NullCommandHeader* pHeader = commandStream.GetFirst(); pHeader != nullptr; pHeader = commandStream.GetNext(pHeader))
+    {
+        if (pHeader->type == NULL_COMMAND_TYPE_RESOURCE_BARRIER)
+        {
+            count += reinterpret_cast<const NullCommand_ResourceBarrier*>(pHeader)->numBarriers;
+        }
+    }
+    return count;
+}
+
+
+// コピーコマンドだけを実行する (COPY キュー用)
+static void ExecuteCopyCommands(const NullCommandStream& commandStream)
+{
+    for (const NullCommandHeader* pHeader = commandStream.GetFirst(); pHeader != nullptr; pHeader = commandStream.GetNext(pHeader))
+    {
+        if (pHeader->type != NULL_COMMAND_TYPE_COPY_BUFFER_REGION)
+        {
+            continue;
+        }
+
+        const NullCommand_CopyBufferRegion* pCommand = reinterpret_cast<const NullCommand_CopyBufferRegion*>(pHeader);
+        GraphicsResourceNull* pDst = static_cast<GraphicsResourceNull*>(pCommand->pDstBuffer);
+        GraphicsResourceNull* pSrc = static_cast<GraphicsResourceNull*>(pCommand->pSrcBuffer);
+        if (pCommand->dstOffset + pCommand->numBytes <= pDst->GetDataSize() && pCommand->srcOffset + pCommand->numBytes <= pSrc->GetDataSize())
+        {
+            std::memmove(pDst->GetData() + pCommand->dstOffset, pSrc->GetData() + pCommand->srcOffset, static_cast<size_t>(pCommand->numBytes));
+        }
+    }
+}
+
+
+
+GraphicsCommandQueueNull::GraphicsCommandQueueNull(COMMAND_LIST_TYPE type, INullCommandExecutor* pExecutor, f64 emulatedMilliseconds, GraphicsStatistics* pStatistics)
+    : m_Type(type)
+    , m_pExecutor(pExecutor)
+    , m_EmulatedMilliseconds(emulatedMilliseconds)
+    , m_pStatistics(pStatistics)
+    , m_IsTerminating(false)
+{
+    m_Thread = std::thread(&GraphicsCommandQueueNull::WorkerMain, this);
+}
+
+
+GraphicsCommandQueueNull::~GraphicsCommandQueueNull()
+{
+    // 積まれた処理を全て終えてから止める
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_IsTerminating = true;
+    }
+    m_Condition.notify_one();
+    m_Thread.join();
+}
+
+
+COMMAND_LIST_TYPE GraphicsCommandQueueNull::GetType() const
+{
+    return m_Type;
+}
+
+
+void GraphicsCommandQueueNull::ExecuteCommandLists(u32 numCommandLists, IGraphicsCommandList* const* ppCommandLists)
+{
+    for (u32 i = 0; i < numCommandLists; i++)
+    {
+        const GraphicsCommandListNull* pCommandList = static_cast<const GraphicsCommandListNull*>(ppCommandLists[i]);
+        const NullCommandStream& commandStream = pCommandList->GetCommandStream();
+
+        m_pStatistics->executedCommandLists++;
+        m_pStatistics->recordedCommands += commandStream.GetCommandCount();
+        m_pStatistics->recordedBytes += commandStream.GetSize();
+        m_pStatistics->drawCount += commandStream.GetCommandCount(NULL_COMMAND_TYPE_DRAW_INSTANCED);
+        m_pStatistics->drawCount += commandStream.GetCommandCount(NULL_COMMAND_TYPE_DRAW_INDEXED_INSTANCED);
+        m_pStatistics->resourceBarrierCalls += commandStream.GetCommandCount(NULL_COMMAND_TYPE_RESOURCE_BARRIER);
+        m_pStatistics->resourceBarriers += CountResourceBarriers(commandStream);
+    }
+
+    // 記録内容はアロケータが持つので、コマンドリストはこの直後に Reset してよい
+    Item item = {};
+    item.type = ITEM_TYPE_EXECUTE;
+    for (u32 i = 0; i < numCommandLists; i++)
+    {
+        item.commandStreams.push_back(&static_cast<const GraphicsCommandListNull*>(ppCommandLists[i])->GetCommandStream());
+    }
+    Push(std::move(item));
+}
+
+
+HRESULT GraphicsCommandQueueNull::Signal(IGraphicsFence* pFence, u64 value)
+{
+    // 先に積まれた処理が終わったら完了値を設定する
+    Item item = {};
+    item.type = ITEM_TYPE_SIGNAL;
+    item.pFence = static_cast<GraphicsFenceNull*>(pFence);
+    item.value = value;
+    Push(std::move(item));
+    return S_OK;
+}
+
+
+HRESULT GraphicsCommandQueueNull::Wait(IGraphicsFence* pFence, u64 value)
+{
+    // 完了値に到達するまで、以降に積まれた処理を始めない
+    Item item = {};
+    item.type = ITEM_TYPE_WAIT;
+    item.pFence = static_cast<GraphicsFenceNull*>(pFence);
+    item.value = value;
+    Push(std::move(item));
+    return S_OK;
+}
+
+
+void GraphicsCommandQueueNull::Push(Item&& item)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Items.push_back(std::move(item));
+    }
+    m_Condition.notify_one();
+}
+
+
+void GraphicsCommandQueueNull::WorkerMain()
+{
+    for (;;)
+    {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]() { return m_IsTerminating || !m_Items.empty(); });
+            if (m_Items.empty())
+            {
+                return; // 終了要求かつ処理が残っていない
+            }
+            item = std::move(m_Items.front());
+            m_Items.pop_front();
+        }
+
+        switch (item.type)
+        {
+        case ITEM_TYPE_EXECUTE:
+            {
+                const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+                if (m_Type == COMMAND_LIST_TYPE_COPY)
+                {
+                    // コピーエンジンはコピーだけなので、実行側に関係なくここで行う
+                    for (const NullCommandStream* pCommandStream : item.commandStreams)
+                    {
+                        ExecuteCopyCommands(*pCommandStream);
+                    }
+                }
+                else if (m_pExecutor != nullptr)
+                {
+                    for (const NullCommandStream* pCommandStream : item.commandStreams)
+                    {
+                        m_pExecutor->Execute(*pCommandStream);
+                    }
+                }
+
+                // 疑似的な GPU 時間に満たなければ、その分だけ待つ
+                if (m_EmulatedMilliseconds > 0.0)
+                {
+                    std::this_thread::sleep_until(beginTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<f64, std::milli>(m_EmulatedMilliseconds)));
+                }
+            }
+            break;
+
+        case ITEM_TYPE_SIGNAL:
+            item.pFence->SetCompletedValue(item.value);
+            break;
+
+        case ITEM_TYPE_WAIT:
+            item.pFence->Wait(item.value);
+            break;
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsSwapChainNull
+//-----------------------------------------------------------------
+GraphicsSwapChainNull::GraphicsSwapChainNull(const SwapChainDesc& desc, GraphicsStatistics* pStatistics)
+    : m_Desc(desc)
+    , m_CurrentBackBufferIndex(0)
+    , m_pStatistics(pStatistics)
+{
+    ResourceDesc resourceDesc = {};
+    resourceDesc.dimension = RESOURCE_DIMENSION_TEXTURE2D;
+    resourceDesc.width = desc.width;
+    resourceDesc.height = desc.height;
+    resourceDesc.depthOrArraySize = 1;
+    resourceDesc.mipLevels = 1;
+    resourceDesc.format = desc.format;
+    resourceDesc.sampleCount = 1;
+    resourceDesc.flags = RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+    for (u32 i = 0; i < desc.bufferCount; i++)
+    {
+        m_Buffers.emplace_back(new GraphicsResourceNull(resourceDesc));
+    }
+}
+
+
+GraphicsSwapChainNull::~GraphicsSwapChainNull()
+{
+
+}
+
+
+u32 GraphicsSwapChainNull::GetBufferCount() const
+{
+    return m_Desc.bufferCount;
+}
+
+
+u32 GraphicsSwapChainNull::GetCurrentBackBufferIndex() const
+{
+    return m_CurrentBackBufferIndex;
+}
+
+
+IGraphicsResource* GraphicsSwapChainNull::GetBuffer(u32 index) const
+{
+    if (index >= m_Buffers.size())
+    {
+        return nullptr;
+    }
+    return m_Buffers[index].get();
+}
+
+
+HRESULT GraphicsSwapChainNull::Present(u32 syncInterval)
+{
+    syncInterval;
+
+    m_CurrentBackBufferIndex = (m_CurrentBackBufferIndex + 1) % m_Desc.bufferCount;
+    m_pStatistics->presentCount++;
+    return S_OK;
+}
+
+
+//-----------------------------------------------------------------
+// GraphicsDeviceNull
+//-----------------------------------------------------------------
+GraphicsDeviceNull::GraphicsDeviceNull()
+    : m_pExecutor(nullptr)
+    , m_EmulatedGpuMilliseconds(0.0)
+    , m_Statistics({})
+{
+
+}
+
+
+GraphicsDeviceNull::~GraphicsDeviceNull()
+{
+
+}
+
+
+bool GraphicsDeviceNull::Init(INullCommandExecutor* pExecutor, f64 emulatedGpuMilliseconds)
+{
+    m_pExecutor = pExecutor;
+    m_EmulatedGpuMilliseconds = emulatedGpuMilliseconds;
+    return true;
+}
+
+
+GRAPHICS_BACKEND GraphicsDeviceNull::GetBackend() const
+{
+    return GRAPHICS_BACKEND_NULL;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateCommandQueue(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandQueue>* pOut)
+{
+    // 疑似的な GPU 時間はフレームの描画の分なので、COPY キューにはかけない
+    const f64 emulatedMilliseconds = (type == COMMAND_LIST_TYPE_COPY) ? 0.0 : m_EmulatedGpuMilliseconds;
+    pOut->reset(new GraphicsCommandQueueNull(type, m_pExecutor, emulatedMilliseconds, &m_Statistics));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateCommandAllocator(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandAllocator>* pOut)
+{
+    pOut->reset(new GraphicsCommandAllocatorNull(type));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateCommandList(COMMAND_LIST_TYPE type, IGraphicsCommandAllocator* pAllocator, std::unique_ptr<IGraphicsCommandList>* pOut)
+{
+    if (pAllocator == nullptr || static_cast<GraphicsCommandAllocatorNull*>(pAllocator)->GetType() != type)
+    {
+        return E_INVALIDARG;
+    }
+
+    // D3D12 と同じく記録中の状態で作成される
+    pOut->reset(new GraphicsCommandListNull(type, static_cast<GraphicsCommandAllocatorNull*>(pAllocator)));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateSwapChain(IGraphicsCommandQueue* pQueue, void* windowHandle, const SwapChainDesc& desc, std::unique_ptr<IGraphicsSwapChain>* pOut)
+{
+    windowHandle;
+
+    if (pQueue == nullptr || desc.bufferCount == 0 || desc.width == 0 || desc.height == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsSwapChainNull(desc, &m_Statistics));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateDescriptorHeap(const DescriptorHeapDesc& desc, std::unique_ptr<IGraphicsDescriptorHeap>* pOut)
+{
+    pOut->reset(new GraphicsDescriptorHeapNull(desc));
+    return S_OK;
+}
+
+
+u32 GraphicsDeviceNull::GetDescriptorHandleIncrementSize(DESCRIPTOR_HEAP_TYPE type) const
+{
+    type;
+    return static_cast<u32>(sizeof(NullDescriptor));
+}
+
+
+void GraphicsDeviceNull::CreateRenderTargetView(IGraphicsResource* pResource, CpuDescriptorHandle destDescriptor)
+{
+    NullDescriptor* pDescriptor = reinterpret_cast<NullDescriptor*>(destDescriptor.ptr);
+    pDescriptor->pResource = pResource;
+}
+
+
+void GraphicsDeviceNull::CopyDescriptorsSimple(u32 numDescriptors, CpuDescriptorHandle destDescriptorRangeStart, CpuDescriptorHandle srcDescriptorRangeStart, DESCRIPTOR_HEAP_TYPE type)
+{
+    type;
+
+    std::memcpy(
+        reinterpret_cast<NullDescriptor*>(destDescriptorRangeStart.ptr),
+        reinterpret_cast<const NullDescriptor*>(srcDescriptorRangeStart.ptr),
+        sizeof(NullDescriptor) * numDescriptors
+    );
+}
+
+
+HRESULT GraphicsDeviceNull::CreateFence(u64 initialValue, std::unique_ptr<IGraphicsFence>* pOut)
+{
+    pOut->reset(new GraphicsFenceNull(initialValue));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateCommittedResource(HEAP_TYPE heapType, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut)
+{
+    heapType; initialState;
+
+    if (desc.width == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsResourceNull(desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateHeap(const HeapDesc& desc, std::unique_ptr<IGraphicsHeap>* pOut)
+{
+    if (desc.sizeInBytes == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsHeapNull(desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreatePlacedResource(IGraphicsHeap* pHeap, u64 heapOffset, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut)
+{
+    initialState;
+
+    GraphicsHeapNull* pHeapNull = static_cast<GraphicsHeapNull*>(pHeap);
+    if (desc.width == 0 || heapOffset + GraphicsResourceNull::CalcDataSize(desc) > pHeapNull->GetDesc().sizeInBytes)
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsResourceNull(desc, pHeapNull->GetData() + heapOffset));
+    return S_OK;
+}
+
+
+ResourceAllocationInfo GraphicsDeviceNull::GetResourceAllocationInfo(const ResourceDesc& desc) const
+{
+    // D3D12 の既定に合わせて 64KB 単位とする
+    const u64 alignment = 64 * 1024;
+
+    ResourceAllocationInfo info = {};
+    info.sizeInBytes = AlignUp(GraphicsResourceNull::CalcDataSize(desc), alignment);
+    info.alignment = alignment;
+    return info;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateRootSignature(const RootSignatureDesc& desc, std::unique_ptr<IGraphicsRootSignature>* pOut, std::string* pErrorText)
+{
+    pErrorText;
+
+    pOut->reset(new GraphicsRootSignatureNull(desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut)
+{
+    if (desc.pRootSignature == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    pOut->reset(new GraphicsPipelineStateNull(desc));
+    return S_OK;
+}
+
+
+HRESULT GraphicsDeviceNull::CreatePipelineLibrary(const void* pData, size_t dataSize, std::unique_ptr<IGraphicsPipelineLibrary>* pOut)
+{
+    std::unique_ptr<GraphicsPipelineLibraryNull> library(new GraphicsPipelineLibraryNull());
+    HRESULT hr = library->Init(pData, dataSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    *pOut = std::move(library);
+    return S_OK;
+}
+
+
+void GraphicsDeviceNull::GetStatistics(GraphicsStatistics* pOut) const
+{
+    *pOut = m_Statistics;
+}
+
@@ -0,0 +1,392 @@
+﻿#pragma once
+
+
+// Null バックエンド
+// GPU を使わず、コマンドをメモリ上に記録するだけのバックエンド
+// リソースは CPU メモリ上に確保し、GPU 仮想アドレスはそのメモリのアドレスとする
+// キューはそれぞれ専用のスレッドで GPU のタイムラインを模倣し、フェンスは実際に待つ
+// COPY キューはコピーを自分で実行するので、キュー間の同期もこのバックエンドで確かめられる
+
+
+// ディスクリプタ (ディスクリプタハンドルはこの構造体のアドレス)
+struct NullDescriptor
+{
+    IGraphicsResource* pResource;
+};
+
+
+class GraphicsResourceNull : public IGraphicsResource
+{
+public:
+    GraphicsResourceNull(const ResourceDesc& desc);
+
+    // 配置リソース (メモリはヒープが持つ)
+    GraphicsResourceNull(const ResourceDesc& desc, u8* pPlacedData);
+
+    ~GraphicsResourceNull();
+
+    virtual const ResourceDesc& GetDesc() const override;
+
+    virtual HRESULT Map(u32 subresource, void** ppData) override;
+
+    virtual void Unmap(u32 subresource) override;
+
+    virtual u64 GetGPUVirtualAddress() const override;
+
+    u8* GetData();
+
+    size_t GetDataSize() const;
+
+    // テクスチャの 1 行あたりのバイト数
+    u32 GetRowPitch() const;
+
+    // desc のリソースに必要なバイト数
+    static size_t CalcDataSize(const ResourceDesc& desc);
+
+private:
+    ResourceDesc     m_Desc;
+    std::vector<u64> m_Memory; // 8 バイト境界を保証するため u64 で確保
+    u8*              m_pData;  // m_Memory かヒープのメモリを指す
+    size_t           m_DataSize;
+};
+
+
+class GraphicsHeapNull : public IGraphicsHeap
+{
+public:
+    GraphicsHeapNull(const HeapDesc& desc);
+
+    ~GraphicsHeapNull();
+
+    virtual const HeapDesc& GetDesc() const override;
+
+    u8* GetData();
+
+private:
+    HeapDesc         m_Desc;
+    std::vector<u64> m_Memory;
+};
+
+
+class GraphicsRootSignatureNull : public IGraphicsRootSignature
+{
+public:
+    GraphicsRootSignatureNull(const RootSignatureDesc& desc);
+
+    ~GraphicsRootSignatureNull();
+
+    u32 GetNumParameters() const;
+
+    // ディスクリプタレンジはこのオブジェクトが持つコピーを指す
+    const RootParameter& GetParameter(u32 index) const;
+
+private:
+    std::vector<RootParameter>                m_Parameters;
+    std::vector<std::vector<DescriptorRange>> m_DescriptorRanges;
+    ROOT_SIGNATURE_FLAG                       m_Flags;
+};
+
+
+class GraphicsPipelineStateNull : public IGraphicsPipelineState
+{
+public:
+    GraphicsPipelineStateNull(const GraphicsPipelineStateDesc& desc);
+
+    ~GraphicsPipelineStateNull();
+
+    // ポインタは全てこのオブジェクトが持つコピーを指す
+    const GraphicsPipelineStateDesc& GetDesc() const;
+
+private:
+    GraphicsPipelineStateDesc     m_Desc;
+    std::vector<u8>               m_VS;
+    std::vector<u8>               m_PS;
+    std::vector<InputElementDesc> m_InputElements;
+    std::vector<std::string>      m_SemanticNames;
+};
+
+
+// 保存するのは名前だけで、読み込みは desc から作り直す (呼び出し側のキャッシュの動作確認用)
+class GraphicsPipelineLibraryNull : public IGraphicsPipelineLibrary
+{
+public:
+    GraphicsPipelineLibraryNull();
+
+    ~GraphicsPipelineLibraryNull();
+
+    // 形式が違えば E_INVALIDARG
+    HRESULT Init(const void* pData, size_t dataSize);
+
+    virtual HRESULT LoadGraphicsPipeline(const char* name, const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) override;
+
+    virtual HRESULT StorePipeline(const char* name, IGraphicsPipelineState* pPipelineState) override;
+
+    virtual size_t GetSerializedSize() const override;
+
+    virtual HRESULT Serialize(void* pData, size_t dataSize) override;
+
+private:
+    std::vector<std::string> m_Names; // 名前の順 (形式: (u32 長さ, 文字列) の並び)
+};
+
+
+class GraphicsDescriptorHeapNull : public IGraphicsDescriptorHeap
+{
+public:
+    GraphicsDescriptorHeapNull(const DescriptorHeapDesc& desc);
+
+    ~GraphicsDescriptorHeapNull();
+
+    virtual const DescriptorHeapDesc& GetDesc() const override;
+
+    virtual CpuDescriptorHandle GetCPUDescriptorHandleForHeapStart() const override;
+
+    virtual GpuDescriptorHandle GetGPUDescriptorHandleForHeapStart() const override;
+
+private:
+    DescriptorHeapDesc          m_Desc;
+    std::vector<NullDescriptor> m_Descriptors;
+};
+
+
+class GraphicsFenceNull : public IGraphicsFence
+{
+public:
+    GraphicsFenceNull(u64 initialValue);
+
+    ~GraphicsFenceNull();
+
+    virtual u64 GetCompletedValue() const override;
+
+    virtual HRESULT Wait(u64 value) override;
+
+    // キューのスレッドから完了値を設定
+    void SetCompletedValue(u64 value);
+
+private:
+    mutable std::mutex      m_Mutex;
+    std::condition_variable m_Condition;
+    u64                     m_CompletedValue;
+};
+
+
+class GraphicsCommandAllocatorNull : public IGraphicsCommandAllocator
+{
+public:
+    GraphicsCommandAllocatorNull(COMMAND_LIST_TYPE type);
+
+    ~GraphicsCommandAllocatorNull();
+
+    virtual HRESULT Reset() override;
+
+    COMMAND_LIST_TYPE GetType() const;
+
+    // コマンドリストの記録先を割り当てる (次の Reset まで有効)
+    // D3D12 と同じく、記録内容はコマンドリストではなくアロケータが持つ
+    NullCommandStream* AcquireCommandStream();
+
+private:
+    COMMAND_LIST_TYPE                               m_Type;
+    std::vector<std::unique_ptr<NullCommandStream>> m_CommandStreams;
+    size_t                                          m_UsedCommandStreamCount;
+};
+
+
+class GraphicsCommandListNull : public IGraphicsCommandList
+{
+public:
+    GraphicsCommandListNull(COMMAND_LIST_TYPE type, GraphicsCommandAllocatorNull* pAllocator);
+
+    ~GraphicsCommandListNull();
+
+    virtual COMMAND_LIST_TYPE GetType() const override;
+
+    virtual HRESULT Close() override;
+
+    virtual HRESULT Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState) override;
+
+    virtual void ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers) override;
+
+    virtual void OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil) override;
+
+    virtual void ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4]) override;
+
+    virtual void SetPipelineState(IGraphicsPipelineState* pPipelineState) override;
+
+    virtual void SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature) override;
+
+    virtual void SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps) override;
+
+    virtual void SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor) override;
+
+    virtual void SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues) override;
+
+    virtual void SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation) override;
+
+    virtual void RSSetViewports(u32 numViewports, const Viewport* pViewports) override;
+
+    virtual void RSSetScissorRects(u32 numRects, const Rect* pRects) override;
+
+    virtual void IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+    virtual void IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews) override;
+
+    virtual void IASetIndexBuffer(const IndexBufferView* pView) override;
+
+    virtual void DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes) override;
+
+    const NullCommandStream& GetCommandStream() const;
+
+    bool IsClosed() const;
+
+private:
+    COMMAND_LIST_TYPE  m_Type;
+    NullCommandStream* m_pCommandStream; // アロケータが所有
+    bool               m_IsClosed;
+};
+
+
+// 実行されたコマンドリストを処理する (ソフトウェア描画などで差し替える)
+class INullCommandExecutor
+{
+public:
+    virtual ~INullCommandExecutor() = default;
+
+    // キューのスレッドから呼ばれる
+    virtual void Execute(const NullCommandStream& commandStream) = 0;
+};
+
+
+class GraphicsCommandQueueNull : public IGraphicsCommandQueue
+{
+public:
+    // emulatedMilliseconds は 1 回の ExecuteCommandLists にかかる疑似的な GPU 時間
+    GraphicsCommandQueueNull(COMMAND_LIST_TYPE type, INullCommandExecutor* pExecutor, f64 emulatedMilliseconds, GraphicsStatistics* pStatistics);
+
+    ~GraphicsCommandQueueNull();
+
+    virtual COMMAND_LIST_TYPE GetType() const override;
+
+    virtual void ExecuteCommandLists(u32 numCommandLists, IGraphicsCommandList* const* ppCommandLists) override;
+
+    virtual HRESULT Signal(IGraphicsFence* pFence, u64 value) override;
+
+    virtual HRESULT Wait(IGraphicsFence* pFence, u64 value) override;
+
+private:
+    // キューに積まれた処理
+    enum ITEM_TYPE
+    {
+        ITEM_TYPE_EXECUTE
+
+        , ITEM_TYPE_SIGNAL
+        , ITEM_TYPE_WAIT
+    };
+
+    struct Item
+    {
+        ITEM_TYPE                             type;
+        std::vector<const NullCommandStream*> commandStreams; // EXECUTE
+        GraphicsFenceNull*                    pFence;         // SIGNAL / WAIT
+        u64                                   value;          // SIGNAL / WAIT
+    };
+
+    void Push(Item&& item);
+
+    // GPU のタイムラインを模倣するスレッド
+    void WorkerMain();
+
+private:
+    COMMAND_LIST_TYPE       m_Type;
+    INullCommandExecutor*   m_pExecutor;
+    f64                     m_EmulatedMilliseconds;
+    GraphicsStatistics*     m_pStatistics;
+
+    std::thread             m_Thread;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<Item>        m_Items;
+    bool                    m_IsTerminating;
+};
+
+
+class GraphicsSwapChainNull : public IGraphicsSwapChain
+{
+public:
+    GraphicsSwapChainNull(const SwapChainDesc& desc, GraphicsStatistics* pStatistics);
+
+    ~GraphicsSwapChainNull();
+
+    virtual u32 GetBufferCount() const override;
+
+    virtual u32 GetCurrentBackBufferIndex() const override;
+
+    virtual IGraphicsResource* GetBuffer(u32 index) const override;
+
+    virtual HRESULT Present(u32 syncInterval) override;
+
+private:
+    SwapChainDesc                                      m_Desc;
+    std::vector<std::unique_ptr<GraphicsResourceNull>> m_Buffers;
+    u32                                                m_CurrentBackBufferIndex;
+    GraphicsStatistics*                                m_pStatistics;
+};
+
+
+class GraphicsDeviceNull : public IGraphicsDevice
+{
+public:
+    GraphicsDeviceNull();
+
+    ~GraphicsDeviceNull();
+
+    // pExecutor はデバイスより長く生存すること (nullptr なら実行しない)
+    // emulatedGpuMilliseconds は 1 回の ExecuteCommandLists にかかる疑似的な GPU 時間
+    bool Init(INullCommandExecutor* pExecutor, f64 emulatedGpuMilliseconds);
+
+    virtual GRAPHICS_BACKEND GetBackend() const override;
+
+    virtual HRESULT CreateCommandQueue(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandQueue>* pOut) override;
+
+    virtual HRESULT CreateCommandAllocator(COMMAND_LIST_TYPE type, std::unique_ptr<IGraphicsCommandAllocator>* pOut) override;
+
+    virtual HRESULT CreateCommandList(COMMAND_LIST_TYPE type, IGraphicsCommandAllocator* pAllocator, std::unique_ptr<IGraphicsCommandList>* pOut) override;
+
+    virtual HRESULT CreateSwapChain(IGraphicsCommandQueue* pQueue, void* windowHandle, const SwapChainDesc& desc, std::unique_ptr<IGraphicsSwapChain>* pOut) override;
+
+    virtual HRESULT CreateDescriptorHeap(const DescriptorHeapDesc& desc, std::unique_ptr<IGraphicsDescriptorHeap>* pOut) override;
+
+    virtual u32 GetDescriptorHandleIncrementSize(DESCRIPTOR_HEAP_TYPE type) const override;
+
+    virtual void CreateRenderTargetView(IGraphicsResource* pResource, CpuDescriptorHandle destDescriptor) override;
+
+    virtual void CopyDescriptorsSimple(u32 numDescriptors, CpuDescriptorHandle destDescriptorRangeStart, CpuDescriptorHandle srcDescriptorRangeStart, DESCRIPTOR_HEAP_TYPE type) override;
+
+    virtual HRESULT CreateFence(u64 initialValue, std::unique_ptr<IGraphicsFence>* pOut) override;
+
+    virtual HRESULT CreateCommittedResource(HEAP_TYPE heapType, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) override;
+
+    virtual HRESULT CreateHeap(const HeapDesc& desc, std::unique_ptr<IGraphicsHeap>* pOut) override;
+
+    virtual HRESULT CreatePlacedResource(IGraphicsHeap* pHeap, u64 heapOffset, const ResourceDesc& desc, RESOURCE_STATE initialState, std::unique_ptr<IGraphicsResource>* pOut) override;
+
+    virtual ResourceAllocationInfo GetResourceAllocationInfo(const ResourceDesc& desc) const override;
+
+    virtual HRESULT CreateRootSignature(const RootSignatureDesc& desc, std::unique_ptr<IGraphicsRootSignature>* pOut, std::string* pErrorText) override;
+
+    virtual HRESULT CreateGraphicsPipelineState(const GraphicsPipelineStateDesc& desc, std::unique_ptr<IGraphicsPipelineState>* pOut) override;
+
+    virtual HRESULT CreatePipelineLibrary(const void* pData, size_t dataSize, std::unique_ptr<IGraphicsPipelineLibrary>* pOut) override;
+
+    virtual void GetStatistics(GraphicsStatistics* pOut) const override;
+
+private:
+    INullCommandExecutor* m_pExecutor;
+    f64                   m_EmulatedGpuMilliseconds;
+    GraphicsStatistics    m_Statistics;
+};
+
@@ -0,0 +1,100 @@
+﻿
+
+NullCommandStream::NullCommandStream()
+    : m_Size(0)
+    , m_CommandCount(0)
+{
+    std::fill(std::begin(m_CommandCountPerType), std::end(m_CommandCountPerType), 0u);
+}
+
+
+NullCommandStream::~NullCommandStream()
+{
+
+}
+
+
+void NullCommandStream::Reset()
+{
+    m_Size = 0;
+    m_CommandCount = 0;
+    std::fill(std::begin(m_CommandCountPerType), std::end(m_CommandCountPerType), 0u);
+}
+
+
+const NullCommandHeader* NullCommandStream::GetFirst() const
+{
+    if (m_Size == 0)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<const NullCommandHeader*>(m_Buffer.data());
+}
+
+
+const NullCommandHeader* NullCommandStream::GetNext(const NullCommandHeader* pCommand) const
+{
+    const u8* pNext = reinterpret_cast<const u8*>(pCommand) + pCommand->size;
+    const u8* pEnd = reinterpret_cast<const u8*>(m_Buffer.data()) + m_Size;
+
+    if (pNext >= pEnd)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<const NullCommandHeader*>(pNext);
+}
+
+
+u32 NullCommandStream::GetCommandCount() const
+{
+    return m_CommandCount;
+}
+
+
+u32 NullCommandStream::GetCommandCount(NULL_COMMAND_TYPE type) const
+{
+    return m_CommandCountPerType[type];
+}
+
+
+size_t NullCommandStream::GetSize() const
+{
+    return m_Size;
+}
+
+
+void* NullCommandStream::AllocateRaw(NULL_COMMAND_TYPE type, size_t commandBytes, size_t arrayBytes)
+{
+    const size_t size = AlignCommandSize(commandBytes) + AlignCommandSize(arrayBytes);
+    const size_t requiredSize = m_Size + size;
+
+    // 足りなければ倍々で拡張
+    const size_t capacity = m_Buffer.size() * sizeof(u64);
+    if (requiredSize > capacity)
+    {
+        size_t newCapacity = std::max<size_t>(capacity * 2, 4096);
+        while (newCapacity < requiredSize)
+        {
+            newCapacity *= 2;
+        }
+        m_Buffer.resize(newCapacity / sizeof(u64));
+    }
+
+    u8* pCommand = reinterpret_cast<u8*>(m_Buffer.data()) + m_Size;
+    m_Size = requiredSize;
+    m_CommandCount++;
+    m_CommandCountPerType[type]++;
+
+    NullCommandHeader* pHeader = reinterpret_cast<NullCommandHeader*>(pCommand);
+    pHeader->type = type;
+    pHeader->size = static_cast<u32>(size);
+
+    return pCommand;
+}
+
+
+size_t NullCommandStream::AlignCommandSize(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
@@ -0,0 +1,242 @@
+﻿#pragma once
+
+
+// Null バックエンドのコマンド記録
+// コマンドは [ヘッダー][固定長の引数][可変長の配列] の順に連続したメモリへ詰める
+
+
+enum NULL_COMMAND_TYPE
+{
+    NULL_COMMAND_TYPE_RESOURCE_BARRIER
+
+    , NULL_COMMAND_TYPE_OM_SET_RENDER_TARGETS
+    , NULL_COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW
+    , NULL_COMMAND_TYPE_SET_PIPELINE_STATE
+    , NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE
+    , NULL_COMMAND_TYPE_SET_DESCRIPTOR_HEAPS
+    , NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE
+    , NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS
+    , NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW
+    , NULL_COMMAND_TYPE_RS_SET_VIEWPORTS
+    , NULL_COMMAND_TYPE_RS_SET_SCISSOR_RECTS
+    , NULL_COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY
+    , NULL_COMMAND_TYPE_IA_SET_VERTEX_BUFFERS
+    , NULL_COMMAND_TYPE_IA_SET_INDEX_BUFFER
+    , NULL_COMMAND_TYPE_DRAW_INSTANCED
+    , NULL_COMMAND_TYPE_DRAW_INDEXED_INSTANCED
+    , NULL_COMMAND_TYPE_COPY_BUFFER_REGION
+
+    , NULL_COMMAND_TYPE_NUM
+};
+
+
+struct NullCommandHeader
+{
+    NULL_COMMAND_TYPE type;
+    u32               size; // ヘッダーを含むコマンド全体のサイズ
+};
+
+
+struct NullCommand_ResourceBarrier
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_RESOURCE_BARRIER;
+    NullCommandHeader header;
+    u32 numBarriers;
+    // ResourceBarrierDesc[numBarriers] が続く
+};
+
+struct NullCommand_OMSetRenderTargets
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_OM_SET_RENDER_TARGETS;
+    NullCommandHeader header;
+    u32 numRenderTargets;
+    bool hasDepthStencil;
+    CpuDescriptorHandle depthStencil;
+    // CpuDescriptorHandle[numRenderTargets] が続く
+};
+
+struct NullCommand_ClearRenderTargetView
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW;
+    NullCommandHeader header;
+    CpuDescriptorHandle renderTarget;
+    f32 color[4];
+};
+
+struct NullCommand_SetPipelineState
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_PIPELINE_STATE;
+    NullCommandHeader header;
+    IGraphicsPipelineState* pPipelineState;
+};
+
+struct NullCommand_SetGraphicsRootSignature
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_SIGNATURE;
+    NullCommandHeader header;
+    IGraphicsRootSignature* pRootSignature;
+};
+
+struct NullCommand_SetDescriptorHeaps
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_DESCRIPTOR_HEAPS;
+    NullCommandHeader header;
+    u32 numHeaps;
+    // IGraphicsDescriptorHeap*[numHeaps] が続く
+};
+
+struct NullCommand_SetGraphicsRootDescriptorTable
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_DESCRIPTOR_TABLE;
+    NullCommandHeader header;
+    u32 rootParameterIndex;
+    GpuDescriptorHandle baseDescriptor;
+};
+
+struct NullCommand_SetGraphicsRoot32BitConstants
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_32BIT_CONSTANTS;
+    NullCommandHeader header;
+    u32 rootParameterIndex;
+    u32 num32BitValues;
+    u32 destOffsetIn32BitValues;
+    // u32[num32BitValues] が続く
+};
+
+struct NullCommand_SetGraphicsRootConstantBufferView
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_SET_GRAPHICS_ROOT_CONSTANT_BUFFER_VIEW;
+    NullCommandHeader header;
+    u32 rootParameterIndex;
+    u64 bufferLocation;
+};
+
+struct NullCommand_RSSetViewports
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_RS_SET_VIEWPORTS;
+    NullCommandHeader header;
+    u32 numViewports;
+    // Viewport[numViewports] が続く
+};
+
+struct NullCommand_RSSetScissorRects
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_RS_SET_SCISSOR_RECTS;
+    NullCommandHeader header;
+    u32 numRects;
+    // Rect[numRects] が続く
+};
+
+struct NullCommand_IASetPrimitiveTopology
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY;
+    NullCommandHeader header;
+    PRIMITIVE_TOPOLOGY primitiveTopology;
+};
+
+struct NullCommand_IASetVertexBuffers
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_IA_SET_VERTEX_BUFFERS;
+    NullCommandHeader header;
+    u32 startSlot;
+    u32 numViews;
+    // VertexBufferView[numViews] が続く
+};
+
+struct NullCommand_IASetIndexBuffer
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_IA_SET_INDEX_BUFFER;
+    NullCommandHeader header;
+    bool hasView;
+    IndexBufferView view;
+};
+
+struct NullCommand_DrawInstanced
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_DRAW_INSTANCED;
+    NullCommandHeader header;
+    u32 vertexCountPerInstance;
+    u32 instanceCount;
+    u32 startVertexLocation;
+    u32 startInstanceLocation;
+};
+
+struct NullCommand_DrawIndexedInstanced
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_DRAW_INDEXED_INSTANCED;
+    NullCommandHeader header;
+    u32 indexCountPerInstance;
+    u32 instanceCount;
+    u32 startIndexLocation;
+    s32 baseVertexLocation;
+    u32 startInstanceLocation;
+};
+
+struct NullCommand_CopyBufferRegion
+{
+    static const NULL_COMMAND_TYPE Type = NULL_COMMAND_TYPE_COPY_BUFFER_REGION;
+    NullCommandHeader header;
+    IGraphicsResource* pDstBuffer;
+    u64 dstOffset;
+    IGraphicsResource* pSrcBuffer;
+    u64 srcOffset;
+    u64 numBytes;
+};
+
+
+class NullCommandStream
+{
+public:
+    NullCommandStream();
+
+    ~NullCommandStream();
+
+    // 記録内容を破棄 (メモリは再利用する)
+    void Reset();
+
+    // コマンドを確保 (arrayBytes は後ろに続く配列のサイズ)
+    // 戻り値は次の Allocate 呼び出しまで有効
+    template<class T>
+    T* Allocate(size_t arrayBytes = 0)
+    {
+        T* pCommand = reinterpret_cast<T*>(AllocateRaw(T::Type, sizeof(T), arrayBytes));
+        return pCommand;
+    }
+
+    // コマンドの後ろに続く配列を取得
+    template<class T, class E>
+    static E* GetArray(T* pCommand)
+    {
+        return reinterpret_cast<E*>(reinterpret_cast<u8*>(pCommand) + AlignCommandSize(sizeof(T)));
+    }
+
+    template<class T, class E>
+    static const E* GetArray(const T* pCommand)
+    {
+        return reinterpret_cast<const E*>(reinterpret_cast<const u8*>(pCommand) + AlignCommandSize(sizeof(T)));
+    }
+
+    // 先頭コマンド (無ければ nullptr)
+    const NullCommandHeader* GetFirst() const;
+
+    // 次のコマンド (終端なら nullptr)
+    const NullCommandHeader* GetNext(const NullCommandHeader* pCommand) const;
+
+    u32 GetCommandCount() const;
+
+    u32 GetCommandCount(NULL_COMMAND_TYPE type) const;
+
+    size_t GetSize() const;
+
+private:
+    void* AllocateRaw(NULL_COMMAND_TYPE type, size_t commandBytes, size_t arrayBytes);
+
+    static size_t AlignCommandSize(size_t size);
+
+private:
+    std::vector<u64> m_Buffer; // 8 バイト境界を保証するため u64 で確保
+    size_t           m_Size;
+    u32              m_CommandCount;
+    u32              m_CommandCountPerType[NULL_COMMAND_TYPE_NUM];
+};
+
@@ -0,0 +1,41 @@
+﻿
+
+ShaderCompilerNull::ShaderCompilerNull()
+{
+
+}
+
+
+ShaderCompilerNull::~ShaderCompilerNull()
+{
+
+}
+
+
+HRESULT ShaderCompilerNull::CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText)
+{
+    std::FILE* pFile = std::fopen(desc.filePath.c_str(), "rb");
+    if (pFile == nullptr)
+    {
+        *pErrorText = desc.filePath;
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+
+    pBytecode->clear();
+
+    u8 buffer[4096];
+    size_t readSize = 0;
+    while ((readSize = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        pBytecode->insert(pBytecode->end(), buffer, buffer + readSize);
+    }
+
+    std::fclose(pFile);
+    return S_OK;
+}
+
+
+const char* ShaderCompilerNull::GetIdentifier() const
+{
+    return GetShaderCompilerIdentifier(GRAPHICS_BACKEND_NULL);
+}
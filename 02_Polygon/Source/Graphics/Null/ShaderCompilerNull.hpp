@@ -0,0 +1,17 @@
+﻿#pragma once
+
+
+// Null バックエンド用のシェーダーコンパイラ
+// コンパイラを使わず、ソースファイルの内容をそのままバイトコードとして返す
+class ShaderCompilerNull : public IShaderCompiler
+{
+public:
+    ShaderCompilerNull();
+
+    ~ShaderCompilerNull();
+
+    virtual HRESULT CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText) override;
+
+    virtual const char* GetIdentifier() const override;
+};
+
@@ -0,0 +1,431 @@
+﻿
+
+// ファイル形式 (ヘッダーの後にライブラリの内容が続く)
+struct PipelineStateCacheHeader
+{
+    u32     magic;
+    u32     version;
+    u32     backend;
+    u32     reserved;
+    u64     dataSize;
+    Hash128 checksum;
+};
+
+static const u32 PipelineStateCacheMagic = 0x4C4F5350; // 'PSOL'
+static const u32 PipelineStateCacheVersion = 1;
+
+
+static f64 GetElapsedMilliseconds(std::chrono::steady_clock::time_point beginTime)
+{
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+}
+
+
+static void HashBytecode(const ShaderBytecode& bytecode, Hasher128* pHasher)
+{
+    const size_t size = (bytecode.pShaderBytecode != nullptr) ? bytecode.bytecodeLength : 0;
+    pHasher->UpdateValue(static_cast<u64>(size));
+    pHasher->Update(bytecode.pShaderBytecode, size);
+}
+
+
+PipelineStateCache::PipelineStateCache()
+    : m_pDevice(nullptr)
+    , m_IsDirty(false)
+    , m_Statistics()
+{
+
+}
+
+
+PipelineStateCache::~PipelineStateCache()
+{
+    Term();
+}
+
+
+HRESULT PipelineStateCache::Init(IGraphicsDevice* pDevice, const std::string& path)
+{
+    m_pDevice = pDevice;
+    m_Path = path;
+    m_IsDirty = false;
+    m_Statistics = PipelineStateCacheStatistics();
+
+    // ヘッダーが合っているものだけをデバイスに渡す
+    std::vector<u8> data;
+    std::FILE* pFile = std::fopen(m_Path.c_str(), "rb");
+    if (pFile != nullptr)
+    {
+        PipelineStateCacheHeader header = {};
+        bool isValid = std::fread(&header, sizeof(header), 1, pFile) == 1
+            && header.magic == PipelineStateCacheMagic
+            && header.version == PipelineStateCacheVersion
+            && header.backend == static_cast<u32>(m_pDevice->GetBackend());
+        if (isValid)
+        {
+            data.resize(static_cast<size_t>(header.dataSize));
+            isValid = data.empty() || std::fread(data.data(), data.size(), 1, pFile) == 1;
+        }
+        if (isValid)
+        {
+            Hasher128 hasher;
+            hasher.Update(data.data(), data.size());
+            isValid = hasher.Finish() == header.checksum;
+        }
+        std::fclose(pFile);
+
+        if (!isValid)
+        {
+            data.clear();
+            m_Statistics.isLibraryRecreated = true;
+        }
+        m_Statistics.loadedBytes = data.size();
+    }
+
+    m_Library = CreateLibrary(data);
+    return S_OK;
+}
+
+
+void PipelineStateCache::Term()
+{
+    m_PipelineStates.clear();
+    m_RootSignatures.clear();
+    m_RootSignatureKeys.clear();
+    m_Library.reset();
+    m_pDevice = nullptr;
+}
+
+
+HRESULT PipelineStateCache::Save()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::lock_guard<std::mutex> libraryLock(m_LibraryMutex);
+    if (!m_Library || !m_IsDirty)
+    {
+        return S_OK;
+    }
+
+    std::vector<u8> data(m_Library->GetSerializedSize());
+    HRESULT hr = m_Library->Serialize(data.data(), data.size());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    PipelineStateCacheHeader header = {};
+    header.magic = PipelineStateCacheMagic;
+    header.version = PipelineStateCacheVersion;
+    header.backend = static_cast<u32>(m_pDevice->GetBackend());
+    header.dataSize = data.size();
+    {
+        Hasher128 hasher;
+        hasher.Update(data.data(), data.size());
+        header.checksum = hasher.Finish();
+    }
+
+    // 別の名前に書いてから置き換える
+    const std::string temporaryPath = m_Path + ".tmp";
+    std::FILE* pFile = std::fopen(temporaryPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+    bool isWritten = std::fwrite(&header, sizeof(header), 1, pFile) == 1;
+    if (isWritten && !data.empty())
+    {
+        isWritten = std::fwrite(data.data(), data.size(), 1, pFile) == 1;
+    }
+    isWritten = (std::fclose(pFile) == 0) && isWritten;
+
+    // rename は置き換え先があると失敗する環境があるので先に消す
+    std::remove(m_Path.c_str());
+    if (!isWritten || std::rename(temporaryPath.c_str(), m_Path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return E_FAIL;
+    }
+
+    m_IsDirty = false;
+    m_Statistics.savedBytes = sizeof(header) + data.size();
+    return S_OK;
+}
+
+
+void PipelineStateCache::RegisterRootSignature(IGraphicsRootSignature* pRootSignature, const RootSignatureDesc& desc)
+{
+    const Hash128 key = ComputeRootSignatureKey(desc);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_RootSignatureKeys[pRootSignature] = key;
+}
+
+
+void PipelineStateCache::UnregisterRootSignature(IGraphicsRootSignature* pRootSignature)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_RootSignatureKeys.erase(pRootSignature);
+}
+
+
+HRESULT PipelineStateCache::GetOrCreateRootSignature(const RootSignatureDesc& desc, IGraphicsRootSignature** ppOut, std::string* pErrorText)
+{
+    const Hash128 key = ComputeRootSignatureKey(desc);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Statistics.rootSignatureRequestCount++;
+
+        const auto it = m_RootSignatures.find(key);
+        if (it != m_RootSignatures.end())
+        {
+            m_Statistics.rootSignatureSharedCount++;
+            *ppOut = it->second.get();
+            return S_OK;
+        }
+    }
+
+    // 作成はロックの外で行い、同時に作られていたら先に入った方を使う
+    std::unique_ptr<IGraphicsRootSignature> rootSignature;
+    HRESULT hr = m_pDevice->CreateRootSignature(desc, &rootSignature, pErrorText);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_RootSignatures.find(key);
+    if (it == m_RootSignatures.end())
+    {
+        m_RootSignatureKeys[rootSignature.get()] = key;
+        it = m_RootSignatures.emplace(key, std::move(rootSignature)).first;
+    }
+    else
+    {
+        m_Statistics.rootSignatureSharedCount++;
+    }
+    m_Statistics.rootSignatureCount = static_cast<u32>(m_RootSignatures.size());
+    *ppOut = it->second.get();
+    return S_OK;
+}
+
+
+HRESULT PipelineStateCache::GetOrCreate(const GraphicsPipelineStateDesc& desc, IGraphicsPipelineState** ppOut)
+{
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    Hash128 rootSignatureKey = {};
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Statistics.requestCount++;
+
+        const auto it = m_RootSignatureKeys.find(desc.pRootSignature);
+        if (it == m_RootSignatureKeys.end())
+        {
+            return E_INVALIDARG;
+        }
+        rootSignatureKey = it->second;
+    }
+
+    const Hash128 key = ComputeKey(desc, rootSignatureKey);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Statistics.hashMilliseconds += GetElapsedMilliseconds(beginTime);
+
+        const auto it = m_PipelineStates.find(key);
+        if (it != m_PipelineStates.end())
+        {
+            m_Statistics.sharedCount++;
+            *ppOut = it->second.get();
+            return S_OK;
+        }
+    }
+
+    // ライブラリにあればコンパイルせずに作る
+    const std::string name = ToHexString(key);
+    std::unique_ptr<IGraphicsPipelineState> pipelineState;
+    f64 libraryMilliseconds = 0.0;
+    if (m_Library)
+    {
+        beginTime = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> libraryLock(m_LibraryMutex);
+        m_Library->LoadGraphicsPipeline(name.c_str(), desc, &pipelineState);
+        libraryMilliseconds = GetElapsedMilliseconds(beginTime);
+    }
+    const bool isLibraryHit = static_cast<bool>(pipelineState);
+
+    f64 createMilliseconds = 0.0;
+    bool isStored = true;
+    if (!isLibraryHit)
+    {
+        beginTime = std::chrono::steady_clock::now();
+        HRESULT hr = m_pDevice->CreateGraphicsPipelineState(desc, &pipelineState);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        createMilliseconds = GetElapsedMilliseconds(beginTime);
+
+        if (m_Library)
+        {
+            std::lock_guard<std::mutex> libraryLock(m_LibraryMutex);
+            isStored = SUCCEEDED(m_Library->StorePipeline(name.c_str(), pipelineState.get()));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Statistics.libraryMilliseconds += libraryMilliseconds;
+    m_Statistics.createMilliseconds += createMilliseconds;
+    if (isLibraryHit)
+    {
+        m_Statistics.libraryHitCount++;
+    }
+    else
+    {
+        m_Statistics.createCount++;
+        if (isStored)
+        {
+            m_IsDirty = true;
+        }
+        else
+        {
+            m_Statistics.storeErrorCount++;
+        }
+    }
+
+    // 別のスレッドが先に作っていればそちらを使う
+    std::unique_ptr<IGraphicsPipelineState>& entry = m_PipelineStates[key];
+    if (entry)
+    {
+        m_Statistics.sharedCount++;
+    }
+    else
+    {
+        entry = std::move(pipelineState);
+    }
+    m_Statistics.pipelineCount = static_cast<u32>(m_PipelineStates.size());
+    *ppOut = entry.get();
+    return S_OK;
+}
+
+
+void PipelineStateCache::GetStatistics(PipelineStateCacheStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    *pOut = m_Statistics;
+}
+
+
+Hash128 PipelineStateCache::ComputeRootSignatureKey(const RootSignatureDesc& desc)
+{
+    // 種類ごとに意味のあるものだけを含める
+    Hasher128 hasher;
+    hasher.UpdateValue(static_cast<u32>(desc.flags));
+    hasher.UpdateValue(desc.numParameters);
+    for (u32 i = 0; i < desc.numParameters; i++)
+    {
+        const RootParameter& parameter = desc.pParameters[i];
+        hasher.UpdateValue(static_cast<u32>(parameter.parameterType));
+        hasher.UpdateValue(static_cast<u32>(parameter.shaderVisibility));
+
+        switch (parameter.parameterType)
+        {
+        case ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            hasher.UpdateValue(parameter.numDescriptorRanges);
+            for (u32 j = 0; j < parameter.numDescriptorRanges; j++)
+            {
+                const DescriptorRange& range = parameter.pDescriptorRanges[j];
+                hasher.UpdateValue(static_cast<u32>(range.rangeType));
+                hasher.UpdateValue(range.numDescriptors);
+                hasher.UpdateValue(range.baseShaderRegister);
+                hasher.UpdateValue(range.registerSpace);
+                hasher.UpdateValue(range.offsetInDescriptorsFromTableStart);
+            }
+            break;
+
+        case ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            hasher.UpdateValue(parameter.shaderRegister);
+            hasher.UpdateValue(parameter.registerSpace);
+            hasher.UpdateValue(parameter.num32BitValues);
+            break;
+
+        default:
+            hasher.UpdateValue(parameter.shaderRegister);
+            hasher.UpdateValue(parameter.registerSpace);
+            break;
+        }
+    }
+    return hasher.Finish();
+}
+
+
+Hash128 PipelineStateCache::ComputeKey(const GraphicsPipelineStateDesc& desc, const Hash128& rootSignatureKey)
+{
+    // 結果に影響しない値 (無効なブレンドの係数、使わないレンダーターゲットの形式など) は含めない
+    // 構造体をそのまま渡すと詰め物の値で変わるので、値を 1 つずつ加える
+    Hasher128 hasher;
+    hasher.UpdateValue(rootSignatureKey);
+
+    HashBytecode(desc.VS, &hasher);
+    HashBytecode(desc.PS, &hasher);
+
+    hasher.UpdateValue(static_cast<u8>(desc.blendState.blendEnable));
+    if (desc.blendState.blendEnable)
+    {
+        hasher.UpdateValue(static_cast<u32>(desc.blendState.srcBlend));
+        hasher.UpdateValue(static_cast<u32>(desc.blendState.destBlend));
+        hasher.UpdateValue(static_cast<u32>(desc.blendState.blendOp));
+    }
+    hasher.UpdateValue(desc.blendState.renderTargetWriteMask);
+    hasher.UpdateValue(desc.sampleMask);
+
+    hasher.UpdateValue(static_cast<u32>(desc.rasterizerState.fillMode));
+    hasher.UpdateValue(static_cast<u32>(desc.rasterizerState.cullMode));
+    hasher.UpdateValue(static_cast<u8>(desc.rasterizerState.depthClipEnable));
+    hasher.UpdateValue(static_cast<u8>(desc.rasterizerState.multisampleEnable));
+    hasher.UpdateValue(static_cast<u8>(desc.depthEnable));
+
+    // セマンティクス名は大文字小文字を区別しない
+    hasher.UpdateValue(desc.inputLayout.numElements);
+    for (u32 i = 0; i < desc.inputLayout.numElements; i++)
+    {
+        const InputElementDesc& element = desc.inputLayout.pInputElementDescs[i];
+        std::string semanticName = element.semanticName;
+        std::transform(semanticName.begin(), semanticName.end(), semanticName.begin(), [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+        hasher.UpdateString(semanticName);
+        hasher.UpdateValue(element.semanticIndex);
+        hasher.UpdateValue(static_cast<u32>(element.format));
+        hasher.UpdateValue(element.inputSlot);
+        hasher.UpdateValue(element.alignedByteOffset);
+    }
+    hasher.UpdateValue(static_cast<u32>(desc.primitiveTopologyType));
+
+    const u32 numRenderTargets = std::min(desc.numRenderTargets, static_cast<u32>(_countof(desc.rtvFormats)));
+    hasher.UpdateValue(numRenderTargets);
+    for (u32 i = 0; i < numRenderTargets; i++)
+    {
+        hasher.UpdateValue(static_cast<u32>(desc.rtvFormats[i]));
+    }
+    hasher.UpdateValue(static_cast<u32>(desc.dsvFormat));
+    hasher.UpdateValue(std::max(desc.sampleCount, 1u));
+    return hasher.Finish();
+}
+
+
+std::unique_ptr<IGraphicsPipelineLibrary> PipelineStateCache::CreateLibrary(const std::vector<u8>& data)
+{
+    // ドライバーが変わったなどで使えなければ空で作り直す
+    std::unique_ptr<IGraphicsPipelineLibrary> library;
+    if (!data.empty() && SUCCEEDED(m_pDevice->CreatePipelineLibrary(data.data(), data.size(), &library)))
+    {
+        return library;
+    }
+    if (!data.empty())
+    {
+        m_Statistics.isLibraryRecreated = true;
+    }
+    if (FAILED(m_pDevice->CreatePipelineLibrary(nullptr, 0, &library)))
+    {
+        library.reset();
+    }
+    return library;
+}
@@ -0,0 +1,87 @@
+﻿#pragma once
+
+
+// パイプラインステートのキャッシュ
+// 設定を正規化してハッシュし、同じ設定の要求には作成済みのものを返す
+// 作成したものはパイプラインライブラリに保存してファイルに書き出し、次回の起動ではそこから作る
+//
+// ルートシグネチャはポインタではなく設定で区別するので、RegisterRootSignature で登録しておくこと
+// (GetOrCreateRootSignature で作ったものは登録済みで、同じ設定なら同じものを返す)
+// シェーダーはバイトコードの内容で区別する (ポインタが違っても内容が同じなら同じパイプライン)
+//
+// GetOrCreate は複数のスレッドから呼んでよい (コンパイルはロックの外で行う)
+// 同じ設定を同時に要求すると両方でコンパイルし、後から終わった方を捨てる
+
+
+// 統計情報
+struct PipelineStateCacheStatistics
+{
+    u64  requestCount;
+    u64  rootSignatureRequestCount;
+    u64  rootSignatureSharedCount;
+    u32  rootSignatureCount;
+    u64  sharedCount;       // 作成済みのものを返した (同時に作って捨てたものを含む)
+    u64  libraryHitCount;   // ライブラリから作った
+    u64  createCount;       // コンパイルした
+    u64  storeErrorCount;
+    u32  pipelineCount;
+    bool isLibraryRecreated; // ファイルが使えず空のライブラリで始めた
+    u64  loadedBytes;
+    u64  savedBytes;
+    f64  hashMilliseconds;
+    f64  libraryMilliseconds;
+    f64  createMilliseconds;
+};
+
+
+class PipelineStateCache
+{
+public:
+    PipelineStateCache();
+
+    ~PipelineStateCache();
+
+    // path のファイルがあれば読み込む (無い、または使えなければ空から始める)
+    // ライブラリに対応していないデバイスでは保存しない
+    HRESULT Init(IGraphicsDevice* pDevice, const std::string& path);
+
+    void Term();
+
+    // 新しく作ったものがあれば書き出す
+    HRESULT Save();
+
+    void RegisterRootSignature(IGraphicsRootSignature* pRootSignature, const RootSignatureDesc& desc);
+
+    void UnregisterRootSignature(IGraphicsRootSignature* pRootSignature);
+
+    // 戻り値のルートシグネチャはキャッシュが持つ (Term まで有効)
+    HRESULT GetOrCreateRootSignature(const RootSignatureDesc& desc, IGraphicsRootSignature** ppOut, std::string* pErrorText);
+
+    // 戻り値のパイプラインはキャッシュが持つ (Term まで有効)
+    HRESULT GetOrCreate(const GraphicsPipelineStateDesc& desc, IGraphicsPipelineState** ppOut);
+
+    void GetStatistics(PipelineStateCacheStatistics* pOut) const;
+
+    static Hash128 ComputeRootSignatureKey(const RootSignatureDesc& desc);
+
+    static Hash128 ComputeKey(const GraphicsPipelineStateDesc& desc, const Hash128& rootSignatureKey);
+
+private:
+    std::unique_ptr<IGraphicsPipelineLibrary> CreateLibrary(const std::vector<u8>& data);
+
+private:
+    IGraphicsDevice*                          m_pDevice;
+    std::string                               m_Path;
+    std::unique_ptr<IGraphicsPipelineLibrary> m_Library;
+    bool                                      m_IsDirty;
+
+    // ライブラリはスレッドセーフとは限らないので別にロックする
+    mutable std::mutex m_Mutex;
+    std::mutex         m_LibraryMutex;
+
+    std::unordered_map<IGraphicsRootSignature*, Hash128>                                m_RootSignatureKeys;
+    std::unordered_map<Hash128, std::unique_ptr<IGraphicsRootSignature>, Hash128Hasher> m_RootSignatures;
+    std::unordered_map<Hash128, std::unique_ptr<IGraphicsPipelineState>, Hash128Hasher> m_PipelineStates;
+
+    PipelineStateCacheStatistics m_Statistics;
+};
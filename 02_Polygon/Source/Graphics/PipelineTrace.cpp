@@ -0,0 +1,499 @@
+﻿
+
+// ファイル形式 (ヘッダーの後に項目が続く)
+struct PipelineTraceHeader
+{
+    u32     magic;
+    u32     version;
+    u32     entryCount;
+    u32     reserved;
+    u64     dataSize;
+    Hash128 checksum;
+};
+
+static const u32 PipelineTraceMagic = 0x544F5350; // 'PSOT'
+static const u32 PipelineTraceVersion = 1;
+
+// 入力レイアウトの要素数の上限 (壊れたファイルで大きく確保しない)
+static const u32 MaxTraceInputElements = 32;
+
+
+// 範囲を超えて読まないための位置
+struct PipelineTraceReader
+{
+    const u8* pData;
+    size_t    size;
+    size_t    position;
+};
+
+
+static f64 GetElapsedMilliseconds(std::chrono::steady_clock::time_point beginTime)
+{
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+}
+
+
+template<class T>
+static void WriteValue(std::vector<u8>* pData, const T& value)
+{
+    const u8* pBytes = reinterpret_cast<const u8*>(&value);
+    pData->insert(pData->end(), pBytes, pBytes + sizeof(value));
+}
+
+
+static void WriteString(std::vector<u8>* pData, const std::string& text)
+{
+    WriteValue(pData, static_cast<u32>(text.size()));
+    pData->insert(pData->end(), text.begin(), text.end());
+}
+
+
+static void WriteUsage(std::vector<u8>* pData, const ShaderVariantUsage& usage)
+{
+    WriteString(pData, usage.shaderName);
+    WriteValue(pData, usage.featureHash);
+    WriteValue(pData, usage.key);
+}
+
+
+// 列挙型は u32、bool は u8 で書く (構造体をそのまま書くと詰め物の値が入る)
+static void WriteEntry(std::vector<u8>* pData, const ShaderVariantUsage& vertexShader, const ShaderVariantUsage& pixelShader, const GraphicsPipelineStateDesc& desc)
+{
+    WriteUsage(pData, vertexShader);
+    WriteUsage(pData, pixelShader);
+
+    WriteValue(pData, static_cast<u8>(desc.blendState.blendEnable));
+    WriteValue(pData, static_cast<u32>(desc.blendState.srcBlend));
+    WriteValue(pData, static_cast<u32>(desc.blendState.destBlend));
+    WriteValue(pData, static_cast<u32>(desc.blendState.blendOp));
+    WriteValue(pData, desc.blendState.renderTargetWriteMask);
+    WriteValue(pData, desc.sampleMask);
+
+    WriteValue(pData, static_cast<u32>(desc.rasterizerState.fillMode));
+    WriteValue(pData, static_cast<u32>(desc.rasterizerState.cullMode));
+    WriteValue(pData, static_cast<u8>(desc.rasterizerState.depthClipEnable));
+    WriteValue(pData, static_cast<u8>(desc.rasterizerState.multisampleEnable));
+    WriteValue(pData, static_cast<u8>(desc.depthEnable));
+
+    WriteValue(pData, desc.inputLayout.numElements);
+    for (u32 i = 0; i < desc.inputLayout.numElements; i++)
+    {
+        const InputElementDesc& element = desc.inputLayout.pInputElementDescs[i];
+        WriteString(pData, element.semanticName);
+        WriteValue(pData, element.semanticIndex);
+        WriteValue(pData, static_cast<u32>(element.format));
+        WriteValue(pData, element.inputSlot);
+        WriteValue(pData, element.alignedByteOffset);
+    }
+    WriteValue(pData, static_cast<u32>(desc.primitiveTopologyType));
+
+    const u32 numRenderTargets = std::min(desc.numRenderTargets, static_cast<u32>(_countof(desc.rtvFormats)));
+    WriteValue(pData, numRenderTargets);
+    for (u32 i = 0; i < numRenderTargets; i++)
+    {
+        WriteValue(pData, static_cast<u32>(desc.rtvFormats[i]));
+    }
+    WriteValue(pData, static_cast<u32>(desc.dsvFormat));
+    WriteValue(pData, desc.sampleCount);
+}
+
+
+template<class T>
+static bool ReadValue(PipelineTraceReader* pReader, T* pOut)
+{
+    if (pReader->size - pReader->position < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(pOut, pReader->pData + pReader->position, sizeof(T));
+    pReader->position += sizeof(T);
+    return true;
+}
+
+
+template<class T>
+static bool ReadEnum(PipelineTraceReader* pReader, T* pOut)
+{
+    u32 value = 0;
+    if (!ReadValue(pReader, &value))
+    {
+        return false;
+    }
+    *pOut = static_cast<T>(value);
+    return true;
+}
+
+
+static bool ReadBool(PipelineTraceReader* pReader, bool* pOut)
+{
+    u8 value = 0;
+    if (!ReadValue(pReader, &value))
+    {
+        return false;
+    }
+    *pOut = (value != 0);
+    return true;
+}
+
+
+static bool ReadString(PipelineTraceReader* pReader, std::string* pOut)
+{
+    u32 length = 0;
+    if (!ReadValue(pReader, &length) || pReader->size - pReader->position < length)
+    {
+        return false;
+    }
+    pOut->assign(reinterpret_cast<const char*>(pReader->pData + pReader->position), length);
+    pReader->position += length;
+    return true;
+}
+
+
+static bool ReadUsage(PipelineTraceReader* pReader, ShaderVariantUsage* pOut)
+{
+    return ReadString(pReader, &pOut->shaderName)
+        && ReadValue(pReader, &pOut->featureHash)
+        && ReadValue(pReader, &pOut->key);
+}
+
+
+static bool ReadEntry(PipelineTraceReader* pReader, PipelineTraceEntry* pOut)
+{
+    GraphicsPipelineStateDesc& desc = pOut->desc;
+    desc = GraphicsPipelineStateDesc();
+
+    bool isValid = ReadUsage(pReader, &pOut->vertexShader)
+        && ReadUsage(pReader, &pOut->pixelShader)
+        && ReadBool(pReader, &desc.blendState.blendEnable)
+        && ReadEnum(pReader, &desc.blendState.srcBlend)
+        && ReadEnum(pReader, &desc.blendState.destBlend)
+        && ReadEnum(pReader, &desc.blendState.blendOp)
+        && ReadValue(pReader, &desc.blendState.renderTargetWriteMask)
+        && ReadValue(pReader, &desc.sampleMask)
+        && ReadEnum(pReader, &desc.rasterizerState.fillMode)
+        && ReadEnum(pReader, &desc.rasterizerState.cullMode)
+        && ReadBool(pReader, &desc.rasterizerState.depthClipEnable)
+        && ReadBool(pReader, &desc.rasterizerState.multisampleEnable)
+        && ReadBool(pReader, &desc.depthEnable);
+
+    u32 numElements = 0;
+    isValid = isValid && ReadValue(pReader, &numElements) && numElements <= MaxTraceInputElements;
+    if (!isValid)
+    {
+        return false;
+    }
+    pOut->inputElements.resize(numElements);
+    pOut->semanticNames.resize(numElements);
+    for (u32 i = 0; i < numElements; i++)
+    {
+        InputElementDesc& element = pOut->inputElements[i];
+        element.semanticName = nullptr;
+        isValid = ReadString(pReader, &pOut->semanticNames[i])
+            && ReadValue(pReader, &element.semanticIndex)
+            && ReadEnum(pReader, &element.format)
+            && ReadValue(pReader, &element.inputSlot)
+            && ReadValue(pReader, &element.alignedByteOffset);
+        if (!isValid)
+        {
+            return false;
+        }
+    }
+
+    isValid = ReadEnum(pReader, &desc.primitiveTopologyType)
+        && ReadValue(pReader, &desc.numRenderTargets)
+        && desc.numRenderTargets <= _countof(desc.rtvFormats);
+    for (u32 i = 0; isValid && i < desc.numRenderTargets; i++)
+    {
+        isValid = ReadEnum(pReader, &desc.rtvFormats[i]);
+    }
+    return isValid
+        && ReadEnum(pReader, &desc.dsvFormat)
+        && ReadValue(pReader, &desc.sampleCount);
+}
+
+
+//-----------------------------------------------------------------
+// PipelineTrace
+//-----------------------------------------------------------------
+PipelineTrace::PipelineTrace()
+    : m_EntryCount(0)
+{
+
+}
+
+
+PipelineTrace::~PipelineTrace()
+{
+
+}
+
+
+void PipelineTrace::Record(const ShaderVariantUsage& vertexShader, const ShaderVariantUsage& pixelShader, const GraphicsPipelineStateDesc& desc)
+{
+    // 書き出す内容で比べるので、ポインタが違っても同じ設定なら 1 つにまとまる
+    std::vector<u8> data;
+    WriteEntry(&data, vertexShader, pixelShader, desc);
+
+    Hasher128 hasher;
+    hasher.Update(data.data(), data.size());
+    const Hash128 key = hasher.Finish();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_EntryKeys.insert(key).second)
+    {
+        return;
+    }
+    m_Data.insert(m_Data.end(), data.begin(), data.end());
+    m_EntryCount++;
+}
+
+
+u32 PipelineTrace::GetEntryCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_EntryCount;
+}
+
+
+HRESULT PipelineTrace::Save(const std::string& path) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    PipelineTraceHeader header = {};
+    header.magic = PipelineTraceMagic;
+    header.version = PipelineTraceVersion;
+    header.entryCount = m_EntryCount;
+    header.dataSize = m_Data.size();
+    {
+        Hasher128 hasher;
+        hasher.Update(m_Data.data(), m_Data.size());
+        header.checksum = hasher.Finish();
+    }
+
+    // 別の名前に書いてから置き換える
+    const std::string temporaryPath = path + ".tmp";
+    std::FILE* pFile = std::fopen(temporaryPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+    bool isWritten = std::fwrite(&header, sizeof(header), 1, pFile) == 1;
+    if (isWritten && !m_Data.empty())
+    {
+        isWritten = std::fwrite(m_Data.data(), m_Data.size(), 1, pFile) == 1;
+    }
+    isWritten = (std::fclose(pFile) == 0) && isWritten;
+
+    // rename は置き換え先があると失敗する環境があるので先に消す
+    std::remove(path.c_str());
+    if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+
+HRESULT PipelineTrace::Load(const std::string& path, std::vector<PipelineTraceEntry>* pOut)
+{
+    pOut->clear();
+
+    std::FILE* pFile = std::fopen(path.c_str(), "rb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+
+    PipelineTraceHeader header = {};
+    std::vector<u8> data;
+    bool isValid = std::fread(&header, sizeof(header), 1, pFile) == 1
+        && header.magic == PipelineTraceMagic
+        && header.version == PipelineTraceVersion;
+    if (isValid)
+    {
+        // 大きさはファイルの残りと比べてから確保する
+        const long dataOffset = std::ftell(pFile);
+        std::fseek(pFile, 0, SEEK_END);
+        isValid = dataOffset >= 0 && header.dataSize == static_cast<u64>(std::ftell(pFile) - dataOffset);
+        std::fseek(pFile, dataOffset, SEEK_SET);
+    }
+    if (isValid)
+    {
+        data.resize(static_cast<size_t>(header.dataSize));
+        isValid = data.empty() || std::fread(data.data(), data.size(), 1, pFile) == 1;
+    }
+    std::fclose(pFile);
+    if (isValid)
+    {
+        Hasher128 hasher;
+        hasher.Update(data.data(), data.size());
+        isValid = hasher.Finish() == header.checksum;
+    }
+
+    // 項目の区切りが合わなければ全体を使わない
+    PipelineTraceReader reader = { data.data(), data.size(), 0 };
+    for (u32 i = 0; isValid && i < header.entryCount; i++)
+    {
+        PipelineTraceEntry entry;
+        isValid = ReadEntry(&reader, &entry);
+        if (isValid)
+        {
+            pOut->push_back(std::move(entry));
+        }
+    }
+    if (!isValid || reader.position != reader.size)
+    {
+        pOut->clear();
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+
+GraphicsPipelineStateDesc PipelineTrace::MakeDesc(const PipelineTraceEntry& entry, std::vector<InputElementDesc>* pInputElements)
+{
+    *pInputElements = entry.inputElements;
+    for (size_t i = 0; i < pInputElements->size(); i++)
+    {
+        (*pInputElements)[i].semanticName = entry.semanticNames[i].c_str();
+    }
+
+    GraphicsPipelineStateDesc desc = entry.desc;
+    desc.inputLayout.pInputElementDescs = pInputElements->data();
+    desc.inputLayout.numElements = static_cast<u32>(pInputElements->size());
+    return desc;
+}
+
+
+//-----------------------------------------------------------------
+// PipelinePrewarmer
+//-----------------------------------------------------------------
+PipelinePrewarmer::PipelinePrewarmer()
+    : m_pTaskScheduler(nullptr)
+    , m_pShaderPermutations(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+PipelinePrewarmer::~PipelinePrewarmer()
+{
+    Term();
+}
+
+
+void PipelinePrewarmer::Init(TaskScheduler* pTaskScheduler, ShaderPermutationManager* pShaderPermutations, const CreateFunction& create)
+{
+    m_pTaskScheduler = pTaskScheduler;
+    m_pShaderPermutations = pShaderPermutations;
+    m_Create = create;
+    m_BeginTime = std::chrono::steady_clock::now();
+    m_Statistics = PipelinePrewarmerStatistics();
+}
+
+
+void PipelinePrewarmer::Term()
+{
+    // タスクは m_Create とシェーダーの管理を使うので、先に終わらせる
+    for (const TaskHandle& task : m_Tasks)
+    {
+        m_pTaskScheduler->Wait(task);
+    }
+    m_Tasks.clear();
+    m_Create = CreateFunction();
+    m_pShaderPermutations = nullptr;
+    m_pTaskScheduler = nullptr;
+}
+
+
+u32 PipelinePrewarmer::Begin(const std::vector<PipelineTraceEntry>& entries, const TaskHandle* pDependencies, u32 dependencyCount)
+{
+    m_BeginTime = std::chrono::steady_clock::now();
+
+    u32 count = 0;
+    u32 skippedCount = 0;
+    for (const PipelineTraceEntry& entry : entries)
+    {
+        // シェーダーの読み込みは他の項目と共有する (同じバリアントは 1 回だけ読み込む)
+        const u32 vertexShaderIndex = m_pShaderPermutations->FindShader(entry.vertexShader.shaderName, entry.vertexShader.featureHash);
+        const u32 pixelShaderIndex = m_pShaderPermutations->FindShader(entry.pixelShader.shaderName, entry.pixelShader.featureHash);
+        if (vertexShaderIndex == ShaderPermutationManager::InvalidIndex || pixelShaderIndex == ShaderPermutationManager::InvalidIndex)
+        {
+            skippedCount++;
+            continue;
+        }
+
+        std::vector<TaskHandle> dependencies(pDependencies, pDependencies + dependencyCount);
+        dependencies.push_back(m_pShaderPermutations->Prepare(vertexShaderIndex, entry.vertexShader.key));
+        dependencies.push_back(m_pShaderPermutations->Prepare(pixelShaderIndex, entry.pixelShader.key));
+        if (!dependencies[dependencyCount].pState || !dependencies[dependencyCount + 1].pState)
+        {
+            skippedCount++;
+            continue;
+        }
+
+        const TaskHandle task = m_pTaskScheduler->Submit("PrewarmPipelineState", [this, entry, vertexShaderIndex, pixelShaderIndex]()
+        {
+            const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+            // 読み込みは終わっているので待たない (失敗していればそのエラーが返る)
+            std::vector<InputElementDesc> inputElements;
+            GraphicsPipelineStateDesc desc = PipelineTrace::MakeDesc(entry, &inputElements);
+            std::string errorText;
+            HRESULT hr = m_pShaderPermutations->Wait(vertexShaderIndex, entry.vertexShader.key, &desc.VS, &errorText);
+            if (SUCCEEDED(hr))
+            {
+                hr = m_pShaderPermutations->Wait(pixelShaderIndex, entry.pixelShader.key, &desc.PS, &errorText);
+            }
+            if (SUCCEEDED(hr))
+            {
+                hr = m_Create(vertexShaderIndex, entry.vertexShader.key, pixelShaderIndex, entry.pixelShader.key, desc, &errorText);
+            }
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Statistics.completedCount++;
+            if (FAILED(hr))
+            {
+                m_Statistics.failedCount++;
+            }
+            m_Statistics.taskMilliseconds += GetElapsedMilliseconds(beginTime);
+            m_Statistics.readyMilliseconds = std::max(m_Statistics.readyMilliseconds, GetElapsedMilliseconds(m_BeginTime));
+        }, dependencies.data(), static_cast<u32>(dependencies.size()));
+        m_Tasks.push_back(task);
+        count++;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Statistics.entryCount += static_cast<u32>(entries.size());
+    m_Statistics.skippedCount += skippedCount;
+    m_Statistics.submittedCount += count;
+    return count;
+}
+
+
+bool PipelinePrewarmer::IsCompleted() const
+{
+    return std::all_of(m_Tasks.begin(), m_Tasks.end(), [this](const TaskHandle& task) { return m_pTaskScheduler->IsCompleted(task); });
+}
+
+
+void PipelinePrewarmer::Wait()
+{
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    for (const TaskHandle& task : m_Tasks)
+    {
+        m_pTaskScheduler->Wait(task);
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Statistics.waitMilliseconds += GetElapsedMilliseconds(beginTime);
+}
+
+
+void PipelinePrewarmer::GetStatistics(PipelinePrewarmerStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    *pOut = m_Statistics;
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+
+
+// パイプラインの使用記録と起動時の事前作成
+// PipelineTrace     : 作ったパイプラインの設定を、シェーダーをバリアント (名前と機能のキー) で表して記録し、ファイルに書き出す
+// PipelinePrewarmer : 前回の記録をワーカーで再生し、描画で要求される前にパイプラインを作っておく
+//
+// 記録はポインタもバイトコードも含まないので、シェーダーを直しても同じ設定として扱える
+// ルートシグネチャはシェーダーのリフレクションから作り直せるので記録しない
+// 同じ設定は 1 回だけ記録する (再生して作ったものも記録すれば、今回使わなかった設定も次回に残る)
+
+
+// 記録の 1 項目
+struct PipelineTraceEntry
+{
+    ShaderVariantUsage            vertexShader;
+    ShaderVariantUsage            pixelShader;
+    GraphicsPipelineStateDesc     desc;          // ルートシグネチャ、シェーダー、入力レイアウトのポインタは空
+    std::vector<InputElementDesc> inputElements; // semanticName は空 (semanticNames を使う)
+    std::vector<std::string>      semanticNames;
+};
+
+
+class PipelineTrace
+{
+public:
+    PipelineTrace();
+
+    ~PipelineTrace();
+
+    // 複数のスレッドから呼んでよい (desc のルートシグネチャとシェーダーは使わない)
+    void Record(const ShaderVariantUsage& vertexShader, const ShaderVariantUsage& pixelShader, const GraphicsPipelineStateDesc& desc);
+
+    u32 GetEntryCount() const;
+
+    HRESULT Save(const std::string& path) const;
+
+    // 無ければ ERROR_FILE_NOT_FOUND、形式が違えば E_FAIL
+    static HRESULT Load(const std::string& path, std::vector<PipelineTraceEntry>* pOut);
+
+    // entry の設定を指すパイプラインの設定を作る (pInputElements は戻り値を使い終わるまで持つこと)
+    static GraphicsPipelineStateDesc MakeDesc(const PipelineTraceEntry& entry, std::vector<InputElementDesc>* pInputElements);
+
+private:
+    mutable std::mutex                         m_Mutex;
+    std::vector<u8>                            m_Data;      // ファイルに書く形式で並べたもの
+    std::unordered_set<Hash128, Hash128Hasher> m_EntryKeys; // 記録した項目の内容のハッシュ
+    u32                                        m_EntryCount;
+};
+
+
+// 統計情報
+struct PipelinePrewarmerStatistics
+{
+    u32 entryCount;          // Begin に渡された項目
+    u32 skippedCount;        // 登録されていないシェーダー、範囲外のキー
+    u32 submittedCount;
+    u32 completedCount;      // 進み具合 (submittedCount になれば完了)
+    u32 failedCount;
+    f64 readyMilliseconds;   // Begin から最後のパイプラインができるまで
+    f64 waitMilliseconds;    // Wait で待った時間
+    f64 taskMilliseconds;    // ワーカーでの作成時間の合計 (シェーダーの読み込みは含まない)
+};
+
+
+class PipelinePrewarmer
+{
+public:
+    // バリアントのバイトコードを入れた設定からパイプラインを作る (ルートシグネチャも作ること、複数のスレッドから呼ばれる)
+    typedef std::function<HRESULT(u32 vertexShaderIndex, ShaderVariantKey vertexShaderKey, u32 pixelShaderIndex, ShaderVariantKey pixelShaderKey, const GraphicsPipelineStateDesc& desc, std::string* pErrorText)> CreateFunction;
+
+    PipelinePrewarmer();
+
+    ~PipelinePrewarmer();
+
+    void Init(TaskScheduler* pTaskScheduler, ShaderPermutationManager* pShaderPermutations, const CreateFunction& create);
+
+    // 作成中のものは終わるのを待つ
+    void Term();
+
+    // シェーダーを読み込み始め、それぞれ読み込めたらパイプラインを作る (pDependencies が終わるまでは作らない)
+    // 始めた数を返す
+    u32 Begin(const std::vector<PipelineTraceEntry>& entries, const TaskHandle* pDependencies, u32 dependencyCount);
+
+    bool IsCompleted() const;
+
+    // 全て終わるまで待つ (ワーカーが無ければここで作る)
+    void Wait();
+
+    void GetStatistics(PipelinePrewarmerStatistics* pOut) const;
+
+private:
+    TaskScheduler*            m_pTaskScheduler;
+    ShaderPermutationManager* m_pShaderPermutations;
+    CreateFunction            m_Create;
+    std::vector<TaskHandle>   m_Tasks;
+
+    std::chrono::steady_clock::time_point m_BeginTime;
+    mutable std::mutex                    m_Mutex;
+    PipelinePrewarmerStatistics           m_Statistics;
+};
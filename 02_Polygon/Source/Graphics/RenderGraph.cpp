@@ -0,0 +1,554 @@
+﻿
+
+// 一時リソースのヒープを作り直すときの単位
+static const u64 TransientHeapGranularity = 1024 * 1024;
+
+
+RenderGraph::RenderGraph()
+    : m_pDevice(nullptr)
+    , m_RequiredHeapSizes()
+    , m_Statistics()
+{
+
+}
+
+
+RenderGraph::~RenderGraph()
+{
+    Term();
+}
+
+
+void RenderGraph::Init(IGraphicsDevice* pDevice)
+{
+    m_pDevice = pDevice;
+}
+
+
+void RenderGraph::Term()
+{
+    Reset();
+
+    // リソースを先に、ヒープを後に破棄する
+    m_FrameResources.clear();
+    m_FrameRetiredHeaps.clear();
+    m_RetiredObjects.clear();
+    for (std::unique_ptr<IGraphicsHeap>& heap : m_Heaps)
+    {
+        heap.reset();
+    }
+    m_pDevice = nullptr;
+}
+
+
+void RenderGraph::Reset()
+{
+    m_Resources.clear();
+    m_Passes.clear();
+    m_ExecutionOrder.clear();
+    std::fill_n(m_RequiredHeapSizes, static_cast<u32>(HEAP_CATEGORY_COUNT), 0ull);
+}
+
+
+RenderGraphResource RenderGraph::ImportResource(const char* name, IGraphicsResource* pResource, RESOURCE_STATE currentState, bool isOutput)
+{
+    Resource resource = {};
+    resource.name = name;
+    resource.pResource = pResource;
+    resource.desc = pResource->GetDesc();
+    resource.importedState = currentState;
+    resource.initialState = currentState;
+    resource.isTransient = false;
+    resource.isOutput = isOutput;
+    resource.firstPass = InvalidIndex;
+    resource.lastPass = InvalidIndex;
+    m_Resources.push_back(resource);
+
+    RenderGraphResource handle = { static_cast<u32>(m_Resources.size() - 1) };
+    return handle;
+}
+
+
+RenderGraphResource RenderGraph::CreateTransient(const char* name, const ResourceDesc& desc)
+{
+    const ResourceAllocationInfo info = m_pDevice->GetResourceAllocationInfo(desc);
+
+    Resource resource = {};
+    resource.name = name;
+    resource.pResource = nullptr;
+    resource.desc = desc;
+    resource.importedState = RESOURCE_STATE_COMMON;
+    resource.initialState = RESOURCE_STATE_COMMON;
+    resource.isTransient = true;
+    resource.isOutput = false;
+    resource.size = info.sizeInBytes;
+    resource.alignment = info.alignment;
+    resource.firstPass = InvalidIndex;
+    resource.lastPass = InvalidIndex;
+    if (desc.dimension == RESOURCE_DIMENSION_BUFFER)
+    {
+        resource.heapCategory = HEAP_CATEGORY_BUFFER;
+    }
+    else if (desc.flags & (RESOURCE_FLAG_ALLOW_RENDER_TARGET | RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+    {
+        resource.heapCategory = HEAP_CATEGORY_RT_DS_TEXTURE;
+    }
+    else
+    {
+        resource.heapCategory = HEAP_CATEGORY_TEXTURE;
+    }
+    m_Resources.push_back(resource);
+
+    RenderGraphResource handle = { static_cast<u32>(m_Resources.size() - 1) };
+    return handle;
+}
+
+
+u32 RenderGraph::AddPass(const char* name, const RenderGraphExecuteFunction& execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    pass.itemCount = 0;
+    pass.grainSize = 0;
+    pass.hasSideEffect = false;
+    pass.isCulled = false;
+    m_Passes.push_back(std::move(pass));
+    return static_cast<u32>(m_Passes.size() - 1);
+}
+
+
+u32 RenderGraph::AddParallelPass(const char* name, u32 itemCount, u32 grainSize, const CommandRecordFunction& execute)
+{
+    Pass pass;
+    pass.name = name;
+    pass.parallelExecute = execute;
+    pass.itemCount = itemCount;
+    pass.grainSize = grainSize;
+    pass.hasSideEffect = false;
+    pass.isCulled = false;
+    m_Passes.push_back(std::move(pass));
+    return static_cast<u32>(m_Passes.size() - 1);
+}
+
+
+void RenderGraph::Read(u32 pass, RenderGraphResource resource, RESOURCE_STATE state)
+{
+    AddAccess(pass, resource, state, false);
+}
+
+
+void RenderGraph::Write(u32 pass, RenderGraphResource resource, RESOURCE_STATE state)
+{
+    AddAccess(pass, resource, state, true);
+}
+
+
+void RenderGraph::SetSideEffect(u32 pass)
+{
+    m_Passes[pass].hasSideEffect = true;
+}
+
+
+void RenderGraph::Compile()
+{
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    m_Statistics = RenderGraphStatistics();
+    m_Statistics.passCount = static_cast<u32>(m_Passes.size());
+    m_Statistics.resourceCount = static_cast<u32>(m_Resources.size());
+
+    CullPasses();
+    ComputeLifetimes();
+    AssignHeapOffsets();
+    PlanBarriers();
+
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    m_Statistics.compileMilliseconds = std::chrono::duration<f64, std::milli>(endTime - beginTime).count();
+}
+
+
+HRESULT RenderGraph::Execute(IGraphicsCommandList* pCommandList, ResourceStateTracker* pTracker)
+{
+    return ExecutePasses(pCommandList, nullptr, pTracker);
+}
+
+
+HRESULT RenderGraph::Execute(ParallelCommandRecorder* pRecorder, ResourceStateTracker* pTracker)
+{
+    return ExecutePasses(nullptr, pRecorder, pTracker);
+}
+
+
+HRESULT RenderGraph::ExecutePasses(IGraphicsCommandList* pCommandList, ParallelCommandRecorder* pRecorder, ResourceStateTracker* pTracker)
+{
+    ResourceStateTable* pTable = pTracker->GetTable();
+
+    // 一時リソースを計算した位置に作る
+    for (u32 i = 0; i < HEAP_CATEGORY_COUNT; i++)
+    {
+        HRESULT hr = PrepareHeap(static_cast<HEAP_CATEGORY>(i));
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+    for (Resource& resource : m_Resources)
+    {
+        if (!resource.isTransient || resource.firstPass == InvalidIndex)
+        {
+            continue;
+        }
+
+        std::unique_ptr<IGraphicsResource> placedResource;
+        HRESULT hr = m_pDevice->CreatePlacedResource(m_Heaps[resource.heapCategory].get(), resource.heapOffset, resource.desc, resource.initialState, &placedResource);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        resource.pResource = placedResource.get();
+        pTable->Register(resource.pResource, resource.initialState);
+        m_FrameResources.push_back(std::move(placedResource));
+    }
+
+    // パスごとに遷移をまとめて発行してから記録する
+    for (u32 order = 0; order < m_ExecutionOrder.size(); order++)
+    {
+        Pass& pass = m_Passes[m_ExecutionOrder[order]];
+        for (const Access& access : pass.accesses)
+        {
+            const Resource& resource = m_Resources[access.resource];
+            if (resource.needsAliasingBarrier && resource.firstPass == order)
+            {
+                pTracker->AliasingBarrier(nullptr, resource.pResource);
+            }
+            pTracker->Transition(resource.pResource, access.state);
+        }
+        if (pRecorder != nullptr)
+        {
+            pCommandList = pRecorder->GetCommandList();
+        }
+        pTracker->FlushBarriers(pCommandList);
+
+        if (!pass.parallelExecute)
+        {
+            pass.execute(pCommandList);
+        }
+        else if (pRecorder != nullptr)
+        {
+            HRESULT hr = pRecorder->RecordParallel(pass.name, pass.itemCount, pass.grainSize, pass.parallelExecute);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+        else if (pass.itemCount > 0)
+        {
+            pass.parallelExecute(pCommandList, 0, pass.itemCount);
+        }
+    }
+
+    // 一時リソースの状態はフレームをまたがない
+    for (Resource& resource : m_Resources)
+    {
+        if (resource.isTransient && resource.pResource != nullptr)
+        {
+            pTable->Unregister(resource.pResource);
+        }
+    }
+    return S_OK;
+}
+
+
+IGraphicsResource* RenderGraph::GetResource(RenderGraphResource resource) const
+{
+    return m_Resources[resource.index].pResource;
+}
+
+
+bool RenderGraph::IsPassCulled(u32 pass) const
+{
+    return m_Passes[pass].isCulled;
+}
+
+
+void RenderGraph::FinishFrame(u64 fenceValue)
+{
+    // リソースを先に積み、ヒープより先に破棄されるようにする
+    for (std::unique_ptr<IGraphicsResource>& resource : m_FrameResources)
+    {
+        RetiredObject object;
+        object.fenceValue = fenceValue;
+        object.resource = std::move(resource);
+        m_RetiredObjects.push_back(std::move(object));
+    }
+    m_FrameResources.clear();
+
+    for (std::unique_ptr<IGraphicsHeap>& heap : m_FrameRetiredHeaps)
+    {
+        RetiredObject object;
+        object.fenceValue = fenceValue;
+        object.heap = std::move(heap);
+        m_RetiredObjects.push_back(std::move(object));
+    }
+    m_FrameRetiredHeaps.clear();
+}
+
+
+void RenderGraph::Reclaim(u64 completedFenceValue)
+{
+    while (!m_RetiredObjects.empty() && m_RetiredObjects.front().fenceValue <= completedFenceValue)
+    {
+        m_RetiredObjects.pop_front();
+    }
+}
+
+
+const RenderGraphStatistics& RenderGraph::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+
+void RenderGraph::AddAccess(u32 pass, RenderGraphResource resource, RESOURCE_STATE state, bool isWrite)
+{
+    // 同じパスで同じリソースを複数回宣言したら 1 つにまとめる
+    std::vector<Access>& accesses = m_Passes[pass].accesses;
+    for (Access& access : accesses)
+    {
+        if (access.resource != resource.index)
+        {
+            continue;
+        }
+
+        if (isWrite)
+        {
+            access.state = state; // 書き込みの状態を優先する
+        }
+        else if (!access.isWrite)
+        {
+            access.state = static_cast<RESOURCE_STATE>(access.state | state); // 読み込み同士は組み合わせられる
+        }
+        access.isRead |= !isWrite;
+        access.isWrite |= isWrite;
+        return;
+    }
+
+    Access access = { resource.index, state, !isWrite, isWrite };
+    accesses.push_back(access);
+}
+
+
+void RenderGraph::CullPasses()
+{
+    // 出力から逆にたどり、必要なリソースを書くパスだけを残す
+    std::vector<u8> isNeeded(m_Resources.size(), 0);
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        isNeeded[i] = m_Resources[i].isOutput ? 1 : 0;
+    }
+
+    for (size_t i = m_Passes.size(); i-- > 0;)
+    {
+        Pass& pass = m_Passes[i];
+        bool isAlive = pass.hasSideEffect;
+        for (size_t j = 0; j < pass.accesses.size() && !isAlive; j++)
+        {
+            isAlive = pass.accesses[j].isWrite && isNeeded[pass.accesses[j].resource];
+        }
+
+        pass.isCulled = !isAlive;
+        if (!isAlive)
+        {
+            m_Statistics.culledPassCount++;
+            continue;
+        }
+
+        for (const Access& access : pass.accesses)
+        {
+            if (access.isRead)
+            {
+                isNeeded[access.resource] = 1;
+            }
+        }
+    }
+
+    m_ExecutionOrder.clear();
+    for (u32 i = 0; i < m_Passes.size(); i++)
+    {
+        if (!m_Passes[i].isCulled)
+        {
+            m_ExecutionOrder.push_back(i);
+        }
+    }
+}
+
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (Resource& resource : m_Resources)
+    {
+        resource.firstPass = InvalidIndex;
+        resource.lastPass = InvalidIndex;
+    }
+
+    for (u32 order = 0; order < m_ExecutionOrder.size(); order++)
+    {
+        for (const Access& access : m_Passes[m_ExecutionOrder[order]].accesses)
+        {
+            Resource& resource = m_Resources[access.resource];
+            if (resource.firstPass == InvalidIndex)
+            {
+                resource.firstPass = order;
+                resource.initialState = resource.isTransient ? access.state : resource.importedState;
+            }
+            resource.lastPass = order;
+        }
+    }
+}
+
+
+void RenderGraph::AssignHeapOffsets()
+{
+    // 大きいものから、生存期間が重なるものと重ならない最も低い位置に置く
+    std::vector<u32> transients;
+    for (u32 i = 0; i < m_Resources.size(); i++)
+    {
+        const Resource& resource = m_Resources[i];
+        if (resource.isTransient && resource.firstPass != InvalidIndex)
+        {
+            transients.push_back(i);
+            m_Statistics.transientBytes += resource.size;
+        }
+    }
+    m_Statistics.transientCount = static_cast<u32>(transients.size());
+
+    std::sort(transients.begin(), transients.end(), [this](u32 a, u32 b)
+    {
+        const Resource& resourceA = m_Resources[a];
+        const Resource& resourceB = m_Resources[b];
+        if (resourceA.heapCategory != resourceB.heapCategory)
+        {
+            return resourceA.heapCategory < resourceB.heapCategory;
+        }
+        if (resourceA.size != resourceB.size)
+        {
+            return resourceA.size > resourceB.size;
+        }
+        return a < b;
+    });
+
+    std::vector<u32> placed;
+    std::vector<std::pair<u64, u64>> occupied; // 生存期間が重なるものの [offset, end)
+    for (size_t i = 0; i < transients.size(); i++)
+    {
+        Resource& resource = m_Resources[transients[i]];
+        if (i > 0 && m_Resources[transients[i - 1]].heapCategory != resource.heapCategory)
+        {
+            placed.clear();
+        }
+
+        occupied.clear();
+        for (u32 index : placed)
+        {
+            const Resource& other = m_Resources[index];
+            if (other.lastPass >= resource.firstPass && resource.lastPass >= other.firstPass)
+            {
+                occupied.push_back(std::make_pair(other.heapOffset, other.heapOffset + other.size));
+            }
+        }
+        std::sort(occupied.begin(), occupied.end());
+
+        u64 offset = 0;
+        for (const std::pair<u64, u64>& range : occupied)
+        {
+            if (AlignUp(offset, resource.alignment) + resource.size <= range.first)
+            {
+                break;
+            }
+            offset = std::max(offset, range.second);
+        }
+        resource.heapOffset = AlignUp(offset, resource.alignment);
+        resource.needsAliasingBarrier = false;
+
+        u64& requiredSize = m_RequiredHeapSizes[resource.heapCategory];
+        requiredSize = std::max(requiredSize, resource.heapOffset + resource.size);
+        placed.push_back(transients[i]);
+    }
+
+    // 先に使い終わったリソースとメモリが重なるなら、最初の使用の前にエイリアシングバリアが要る
+    for (size_t i = 0; i < transients.size(); i++)
+    {
+        Resource& resource = m_Resources[transients[i]];
+        for (size_t j = 0; j < transients.size(); j++)
+        {
+            const Resource& other = m_Resources[transients[j]];
+            if (other.heapCategory == resource.heapCategory
+                && other.lastPass < resource.firstPass
+                && other.heapOffset < resource.heapOffset + resource.size
+                && resource.heapOffset < other.heapOffset + other.size)
+            {
+                resource.needsAliasingBarrier = true;
+                m_Statistics.aliasingBarriers++;
+                break;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < HEAP_CATEGORY_COUNT; i++)
+    {
+        m_Statistics.transientHeapBytes += m_RequiredHeapSizes[i];
+    }
+}
+
+
+void RenderGraph::PlanBarriers()
+{
+    // 実行順に状態をたどり、変わる回数を数える (Execute では ResourceStateTracker が同じ判断をする)
+    std::vector<RESOURCE_STATE> states(m_Resources.size());
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        states[i] = m_Resources[i].initialState;
+    }
+
+    for (u32 passIndex : m_ExecutionOrder)
+    {
+        for (const Access& access : m_Passes[passIndex].accesses)
+        {
+            if (states[access.resource] != access.state)
+            {
+                states[access.resource] = access.state;
+                m_Statistics.plannedBarriers++;
+            }
+        }
+    }
+}
+
+
+HRESULT RenderGraph::PrepareHeap(HEAP_CATEGORY category)
+{
+    const u64 requiredSize = m_RequiredHeapSizes[category];
+    if (requiredSize == 0 || (m_Heaps[category] && m_Heaps[category]->GetDesc().sizeInBytes >= requiredSize))
+    {
+        return S_OK;
+    }
+
+    // 足りなければ作り直す (古いものは GPU が使い終わってから破棄する)
+    if (m_Heaps[category])
+    {
+        m_FrameRetiredHeaps.push_back(std::move(m_Heaps[category]));
+    }
+
+    static const HEAP_FLAG HeapFlags[HEAP_CATEGORY_COUNT] = {
+        HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+        HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+        HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES,
+    };
+
+    HeapDesc heapDesc = {};
+    heapDesc.sizeInBytes = AlignUp(requiredSize, TransientHeapGranularity);
+    heapDesc.type = HEAP_TYPE_DEFAULT;
+    heapDesc.alignment = 0;
+    heapDesc.flags = HeapFlags[category];
+    return m_pDevice->CreateHeap(heapDesc, &m_Heaps[category]);
+}
@@ -0,0 +1,191 @@
+﻿#pragma once
+
+
+// レンダーグラフ
+// パスごとに読み書きするリソースを宣言し、Compile で実行順、不要なパスの除外、
+// 状態遷移、一時リソースのメモリの割り当てを決め、Execute でその通りに記録する
+// Compile は GPU を使わない (リソースのサイズはデバイスに問い合わせるだけ)
+//
+// 使い方 (毎フレーム)
+//   Reclaim -> Reset -> ImportResource / CreateTransient / AddPass / Read / Write -> Compile -> Execute -> FinishFrame
+//
+// 実行順はパスを追加した順 (読むリソースは先に追加したパスが書いたもの)
+// 出力 (isOutput の外部リソース) にも副作用にもつながらないパスは実行しない
+// 一時リソースは生存期間が重ならないもの同士で同じヒープのメモリを共有する
+// 共有したメモリは前の内容が不定なので、最初に書くパスでクリアするか全体を上書きすること
+// 並列のパスは ParallelCommandRecorder で Execute したときだけワーカーで分けて記録する
+
+
+// グラフ内のリソース
+struct RenderGraphResource
+{
+    u32 index;
+};
+
+
+// パスの処理
+typedef std::function<void(IGraphicsCommandList* pCommandList)> RenderGraphExecuteFunction;
+
+
+// 統計情報 (最後の Compile / Execute)
+struct RenderGraphStatistics
+{
+    u32 passCount;
+    u32 culledPassCount;
+    u32 resourceCount;
+    u32 transientCount;      // 実行するパスが使う一時リソース
+    u64 transientBytes;      // 共有しない場合に必要なメモリ
+    u64 transientHeapBytes;  // 共有した結果のメモリ
+    u32 plannedBarriers;     // 状態遷移の数 (外部リソースは宣言時の状態から数える)
+    u32 aliasingBarriers;
+    f64 compileMilliseconds;
+};
+
+
+class RenderGraph
+{
+public:
+    static const u32 InvalidIndex = 0xFFFFFFFF;
+
+    RenderGraph();
+
+    ~RenderGraph();
+
+    void Init(IGraphicsDevice* pDevice);
+
+    // GPU が使い終わっていること
+    void Term();
+
+    // グラフの内容を破棄する (ヒープは残す)
+    void Reset();
+
+    // 外部のリソース (currentState は統計用、isOutput ならこれを書くパスは除外しない)
+    RenderGraphResource ImportResource(const char* name, IGraphicsResource* pResource, RESOURCE_STATE currentState, bool isOutput);
+
+    // グラフの中だけで使うリソース (name は Reset まで有効な文字列)
+    RenderGraphResource CreateTransient(const char* name, const ResourceDesc& desc);
+
+    u32 AddPass(const char* name, const RenderGraphExecuteFunction& execute);
+
+    // [0, itemCount) を grainSize 個ずつ別のコマンドリストに記録できるパス
+    // (リストごとにレンダーターゲットやパイプラインを設定すること、遷移はパスの前に済んでいる)
+    u32 AddParallelPass(const char* name, u32 itemCount, u32 grainSize, const CommandRecordFunction& execute);
+
+    void Read(u32 pass, RenderGraphResource resource, RESOURCE_STATE state);
+
+    void Write(u32 pass, RenderGraphResource resource, RESOURCE_STATE state);
+
+    // 出力につながらなくても実行する
+    void SetSideEffect(u32 pass);
+
+    void Compile();
+
+    // 一時リソースを作り、各パスの前に遷移をまとめて発行してから処理を呼ぶ
+    // pTracker は Begin 済みであること
+    HRESULT Execute(IGraphicsCommandList* pCommandList, ResourceStateTracker* pTracker);
+
+    // 遷移と通常のパスは pRecorder の今のリストに、並列のパスは分けて記録する
+    HRESULT Execute(ParallelCommandRecorder* pRecorder, ResourceStateTracker* pTracker);
+
+    // Execute 中のみ有効
+    IGraphicsResource* GetResource(RenderGraphResource resource) const;
+
+    bool IsPassCulled(u32 pass) const;
+
+    // このフレームで作った一時リソースをキューに積んだフェンス値に結び付ける
+    void FinishFrame(u64 fenceValue);
+
+    // GPU が完了したフレームの一時リソースと古いヒープを破棄する
+    void Reclaim(u64 completedFenceValue);
+
+    const RenderGraphStatistics& GetStatistics() const;
+
+private:
+    // ヒープの種類 (リソース ヒープ ティア 1 では混ぜられない)
+    enum HEAP_CATEGORY
+    {
+        HEAP_CATEGORY_BUFFER
+
+        , HEAP_CATEGORY_TEXTURE
+        , HEAP_CATEGORY_RT_DS_TEXTURE
+        , HEAP_CATEGORY_COUNT
+    };
+
+    struct Resource
+    {
+        const char*        name;
+        IGraphicsResource* pResource;      // 外部のリソース、または Execute で作ったもの
+        ResourceDesc       desc;
+        RESOURCE_STATE     importedState;
+        RESOURCE_STATE     initialState;   // 一時リソースの作成時の状態 (最初の使用)
+        bool               isTransient;
+        bool               isOutput;
+        bool               needsAliasingBarrier;
+        HEAP_CATEGORY      heapCategory;
+        u64                size;
+        u64                alignment;
+        u64                heapOffset;
+        u32                firstPass;      // 実行順での最初と最後の使用 (使われなければ InvalidIndex)
+        u32                lastPass;
+    };
+
+    struct Access
+    {
+        u32            resource;
+        RESOURCE_STATE state;
+        bool           isRead;
+        bool           isWrite;
+    };
+
+    struct Pass
+    {
+        const char*                name;
+        RenderGraphExecuteFunction execute;
+        CommandRecordFunction      parallelExecute; // 並列のパス
+        u32                        itemCount;
+        u32                        grainSize;
+        std::vector<Access>        accesses;
+        bool                       hasSideEffect;
+        bool                       isCulled;
+    };
+
+    // GPU が使い終わるまで破棄できないもの
+    struct RetiredObject
+    {
+        u64                                fenceValue;
+        std::unique_ptr<IGraphicsResource> resource;
+        std::unique_ptr<IGraphicsHeap>     heap;
+    };
+
+private:
+    void AddAccess(u32 pass, RenderGraphResource resource, RESOURCE_STATE state, bool isWrite);
+
+    void CullPasses();
+
+    void ComputeLifetimes();
+
+    // 一時リソースのヒープ内の位置を決める
+    void AssignHeapOffsets();
+
+    void PlanBarriers();
+
+    // pRecorder が無ければ全て pCommandList に記録する
+    HRESULT ExecutePasses(IGraphicsCommandList* pCommandList, ParallelCommandRecorder* pRecorder, ResourceStateTracker* pTracker);
+
+    HRESULT PrepareHeap(HEAP_CATEGORY category);
+
+private:
+    IGraphicsDevice*       m_pDevice;
+    std::vector<Resource>  m_Resources;
+    std::vector<Pass>      m_Passes;
+    std::vector<u32>       m_ExecutionOrder;
+
+    u64                            m_RequiredHeapSizes[HEAP_CATEGORY_COUNT];
+    std::unique_ptr<IGraphicsHeap> m_Heaps[HEAP_CATEGORY_COUNT];
+
+    std::vector<std::unique_ptr<IGraphicsResource>> m_FrameResources;    // このフレームで作った一時リソース
+    std::vector<std::unique_ptr<IGraphicsHeap>>     m_FrameRetiredHeaps; // このフレームで入れ替えたヒープ
+    std::deque<RetiredObject>                       m_RetiredObjects;
+
+    RenderGraphStatistics m_Statistics;
+};
@@ -0,0 +1,335 @@
+﻿
+
+//-----------------------------------------------------------------
+// ResourceStateTable
+//-----------------------------------------------------------------
+ResourceStateTable::ResourceStateTable()
+{
+
+}
+
+
+ResourceStateTable::~ResourceStateTable()
+{
+
+}
+
+
+void ResourceStateTable::Register(IGraphicsResource* pResource, RESOURCE_STATE initialState)
+{
+    const ResourceDesc& desc = pResource->GetDesc();
+
+    Entry entry;
+    entry.state = initialState;
+    entry.subresourceCount = (desc.dimension == RESOURCE_DIMENSION_BUFFER) ? 1 : static_cast<u32>(desc.mipLevels) * desc.depthOrArraySize;
+    entry.subresourceCount = std::max(entry.subresourceCount, 1u);
+    m_Entries[pResource] = std::move(entry);
+}
+
+
+void ResourceStateTable::Unregister(IGraphicsResource* pResource)
+{
+    m_Entries.erase(pResource);
+}
+
+
+bool ResourceStateTable::GetState(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE* pOut) const
+{
+    const auto it = m_Entries.find(pResource);
+    if (it == m_Entries.end())
+    {
+        *pOut = RESOURCE_STATE_COMMON;
+        return true;
+    }
+
+    const Entry& entry = it->second;
+    if (entry.subresourceStates.empty())
+    {
+        *pOut = entry.state;
+        return true;
+    }
+    if (subresource == RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        return false;
+    }
+    *pOut = entry.subresourceStates[subresource];
+    return true;
+}
+
+
+void ResourceStateTable::SetState(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE state)
+{
+    Entry& entry = FindOrRegister(pResource);
+    if (subresource == RESOURCE_BARRIER_ALL_SUBRESOURCES || entry.subresourceCount == 1)
+    {
+        entry.state = state;
+        entry.subresourceStates.clear();
+        return;
+    }
+
+    if (entry.subresourceStates.empty())
+    {
+        entry.subresourceStates.assign(entry.subresourceCount, entry.state);
+    }
+    entry.subresourceStates[subresource] = state;
+
+    // 全て同じ状態に戻ったらまとめる
+    if (std::all_of(entry.subresourceStates.begin(), entry.subresourceStates.end(), [state](RESOURCE_STATE s) { return s == state; }))
+    {
+        entry.state = state;
+        entry.subresourceStates.clear();
+    }
+}
+
+
+u32 ResourceStateTable::GetSubresourceCount(IGraphicsResource* pResource) const
+{
+    const auto it = m_Entries.find(pResource);
+    return (it != m_Entries.end()) ? it->second.subresourceCount : 1;
+}
+
+
+ResourceStateTable::Entry& ResourceStateTable::FindOrRegister(IGraphicsResource* pResource)
+{
+    auto it = m_Entries.find(pResource);
+    if (it == m_Entries.end())
+    {
+        Register(pResource, RESOURCE_STATE_COMMON);
+        it = m_Entries.find(pResource);
+    }
+    return it->second;
+}
+
+
+//-----------------------------------------------------------------
+// ResourceStateTracker
+//-----------------------------------------------------------------
+ResourceStateTracker::ResourceStateTracker()
+    : m_pTable(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+ResourceStateTracker::~ResourceStateTracker()
+{
+
+}
+
+
+void ResourceStateTracker::Begin(ResourceStateTable* pTable)
+{
+    m_pTable = pTable;
+    m_PendingBarriers.clear();
+    m_SplitTransitions.clear();
+}
+
+
+void ResourceStateTracker::Transition(IGraphicsResource* pResource, RESOURCE_STATE stateAfter, u32 subresource)
+{
+    m_Statistics.requestedTransitions++;
+
+    // 同じ遷移の分割バリアが始まっていれば、終わらせるだけでよい
+    for (const SplitTransition& split : m_SplitTransitions)
+    {
+        if (split.pResource == pResource && split.subresource == subresource && split.stateAfter == stateAfter)
+        {
+            EndSplitTransition(pResource);
+            return;
+        }
+    }
+    EndSplitTransition(pResource);
+
+    if (subresource != RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        TransitionSubresource(pResource, subresource, stateAfter);
+        return;
+    }
+
+    RESOURCE_STATE stateBefore = RESOURCE_STATE_COMMON;
+    if (m_pTable->GetState(pResource, RESOURCE_BARRIER_ALL_SUBRESOURCES, &stateBefore))
+    {
+        if (stateBefore == stateAfter)
+        {
+            m_Statistics.skippedTransitions++;
+            return;
+        }
+        AddTransition(pResource, RESOURCE_BARRIER_ALL_SUBRESOURCES, stateBefore, stateAfter, RESOURCE_BARRIER_FLAG_NONE);
+    }
+    else
+    {
+        // サブリソースごとに状態が違うので、違うものだけ遷移する
+        const u32 subresourceCount = m_pTable->GetSubresourceCount(pResource);
+        for (u32 i = 0; i < subresourceCount; i++)
+        {
+            m_pTable->GetState(pResource, i, &stateBefore);
+            if (stateBefore != stateAfter)
+            {
+                AddTransition(pResource, i, stateBefore, stateAfter, RESOURCE_BARRIER_FLAG_NONE);
+            }
+        }
+    }
+    m_pTable->SetState(pResource, RESOURCE_BARRIER_ALL_SUBRESOURCES, stateAfter);
+}
+
+
+void ResourceStateTracker::BeginSplitTransition(IGraphicsResource* pResource, RESOURCE_STATE stateAfter, u32 subresource)
+{
+    EndSplitTransition(pResource);
+
+    // サブリソースごとに状態が違うときは分割せずに遷移する
+    RESOURCE_STATE stateBefore = RESOURCE_STATE_COMMON;
+    if (!m_pTable->GetState(pResource, subresource, &stateBefore))
+    {
+        Transition(pResource, stateAfter, subresource);
+        return;
+    }
+    if (stateBefore == stateAfter)
+    {
+        m_Statistics.skippedTransitions++;
+        return;
+    }
+
+    AddTransition(pResource, subresource, stateBefore, stateAfter, RESOURCE_BARRIER_FLAG_BEGIN_ONLY);
+    m_Statistics.splitBarriers++;
+
+    SplitTransition split = { pResource, subresource, stateBefore, stateAfter };
+    m_SplitTransitions.push_back(split);
+}
+
+
+void ResourceStateTracker::EndSplitTransition(IGraphicsResource* pResource)
+{
+    for (size_t i = 0; i < m_SplitTransitions.size();)
+    {
+        const SplitTransition split = m_SplitTransitions[i];
+        if (split.pResource != pResource)
+        {
+            i++;
+            continue;
+        }
+
+        AddTransition(split.pResource, split.subresource, split.stateBefore, split.stateAfter, RESOURCE_BARRIER_FLAG_END_ONLY);
+        m_pTable->SetState(split.pResource, split.subresource, split.stateAfter);
+        m_Statistics.splitBarriers++;
+        m_SplitTransitions.erase(m_SplitTransitions.begin() + i);
+    }
+}
+
+
+void ResourceStateTracker::UAVBarrier(IGraphicsResource* pResource)
+{
+    // 同じまとまりに既にあれば不要
+    for (const ResourceBarrierDesc& barrier : m_PendingBarriers)
+    {
+        if (barrier.type == RESOURCE_BARRIER_TYPE_UAV && barrier.pResource == pResource)
+        {
+            return;
+        }
+    }
+
+    ResourceBarrierDesc barrier = {};
+    barrier.type = RESOURCE_BARRIER_TYPE_UAV;
+    barrier.flags = RESOURCE_BARRIER_FLAG_NONE;
+    barrier.pResource = pResource;
+    m_PendingBarriers.push_back(barrier);
+}
+
+
+void ResourceStateTracker::AliasingBarrier(IGraphicsResource* pResourceBefore, IGraphicsResource* pResourceAfter)
+{
+    ResourceBarrierDesc barrier = {};
+    barrier.type = RESOURCE_BARRIER_TYPE_ALIASING;
+    barrier.flags = RESOURCE_BARRIER_FLAG_NONE;
+    barrier.pResource = pResourceBefore;
+    barrier.pResourceAfter = pResourceAfter;
+    m_PendingBarriers.push_back(barrier);
+}
+
+
+void ResourceStateTracker::FlushBarriers(IGraphicsCommandList* pCommandList)
+{
+    if (m_PendingBarriers.empty())
+    {
+        return;
+    }
+
+    pCommandList->ResourceBarrier(static_cast<u32>(m_PendingBarriers.size()), m_PendingBarriers.data());
+    m_Statistics.issuedBarriers += m_PendingBarriers.size();
+    m_Statistics.resourceBarrierCalls++;
+    m_PendingBarriers.clear();
+}
+
+
+bool ResourceStateTracker::HasPendingSplitTransitions() const
+{
+    return !m_SplitTransitions.empty();
+}
+
+
+ResourceStateTable* ResourceStateTracker::GetTable() const
+{
+    return m_pTable;
+}
+
+
+const ResourceStateTrackerStatistics& ResourceStateTracker::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+
+void ResourceStateTracker::AddTransition(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE stateBefore, RESOURCE_STATE stateAfter, RESOURCE_BARRIER_FLAG flags)
+{
+    // 未発行の遷移に続くなら 1 つにまとめる (A -> B -> C を A -> C に、A -> B -> A は消す)
+    if (flags == RESOURCE_BARRIER_FLAG_NONE)
+    {
+        for (size_t i = m_PendingBarriers.size(); i-- > 0;)
+        {
+            ResourceBarrierDesc& barrier = m_PendingBarriers[i];
+            if (barrier.pResource != pResource)
+            {
+                continue;
+            }
+            if (barrier.type == RESOURCE_BARRIER_TYPE_TRANSITION && barrier.flags == RESOURCE_BARRIER_FLAG_NONE && barrier.subresource == subresource && barrier.stateAfter == stateBefore)
+            {
+                m_Statistics.mergedTransitions++;
+                if (barrier.stateBefore == stateAfter)
+                {
+                    m_PendingBarriers.erase(m_PendingBarriers.begin() + i);
+                }
+                else
+                {
+                    barrier.stateAfter = stateAfter;
+                }
+                return;
+            }
+            break; // 間に別のバリアがあるなら順序を変えない
+        }
+    }
+
+    ResourceBarrierDesc barrier = {};
+    barrier.type = RESOURCE_BARRIER_TYPE_TRANSITION;
+    barrier.flags = flags;
+    barrier.pResource = pResource;
+    barrier.subresource = subresource;
+    barrier.stateBefore = stateBefore;
+    barrier.stateAfter = stateAfter;
+    m_PendingBarriers.push_back(barrier);
+}
+
+
+void ResourceStateTracker::TransitionSubresource(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE stateAfter)
+{
+    RESOURCE_STATE stateBefore = RESOURCE_STATE_COMMON;
+    m_pTable->GetState(pResource, subresource, &stateBefore);
+    if (stateBefore == stateAfter)
+    {
+        m_Statistics.skippedTransitions++;
+        return;
+    }
+
+    AddTransition(pResource, subresource, stateBefore, stateAfter, RESOURCE_BARRIER_FLAG_NONE);
+    m_pTable->SetState(pResource, subresource, stateAfter);
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+
+
+// リソースの状態の追跡
+// ResourceStateTable   : リソースごと (必要ならサブリソースごと) の現在の状態
+// ResourceStateTracker : コマンドリストの記録中に遷移を集め、必要なものだけを 1 回の ResourceBarrier にまとめる
+// コマンドリストは記録した順にキューに積む前提で、記録時にテーブルの状態を進める
+
+
+class ResourceStateTable
+{
+public:
+    ResourceStateTable();
+
+    ~ResourceStateTable();
+
+    // 追跡を始める (作成時の状態を渡す)
+    void Register(IGraphicsResource* pResource, RESOURCE_STATE initialState);
+
+    void Unregister(IGraphicsResource* pResource);
+
+    // subresource が RESOURCE_BARRIER_ALL_SUBRESOURCES のときは全体の状態
+    // (サブリソースごとに違う状態なら false)
+    bool GetState(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE* pOut) const;
+
+    void SetState(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE state);
+
+    u32 GetSubresourceCount(IGraphicsResource* pResource) const;
+
+private:
+    struct Entry
+    {
+        RESOURCE_STATE              state;             // subresourceStates が空ならリソース全体の状態
+        std::vector<RESOURCE_STATE> subresourceStates;
+        u32                         subresourceCount;
+    };
+
+private:
+    // 登録されていなければ COMMON で登録する
+    Entry& FindOrRegister(IGraphicsResource* pResource);
+
+private:
+    std::unordered_map<IGraphicsResource*, Entry> m_Entries;
+};
+
+
+// 統計情報
+struct ResourceStateTrackerStatistics
+{
+    u64 requestedTransitions; // Transition の呼び出し
+    u64 skippedTransitions;   // 既にその状態だったもの
+    u64 mergedTransitions;    // 未発行の遷移とまとめたもの
+    u64 splitBarriers;        // BEGIN_ONLY / END_ONLY
+    u64 issuedBarriers;
+    u64 resourceBarrierCalls;
+};
+
+
+class ResourceStateTracker
+{
+public:
+    ResourceStateTracker();
+
+    ~ResourceStateTracker();
+
+    // コマンドリストの記録を始めるときに呼ぶ
+    void Begin(ResourceStateTable* pTable);
+
+    void Transition(IGraphicsResource* pResource, RESOURCE_STATE stateAfter, u32 subresource = RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+    // 分割バリア (間に別の処理を挟んで遷移を隠す)
+    // 終了は EndSplitTransition か、同じリソースへの次の Transition で行う (同じコマンドリストの中で終えること)
+    void BeginSplitTransition(IGraphicsResource* pResource, RESOURCE_STATE stateAfter, u32 subresource = RESOURCE_BARRIER_ALL_SUBRESOURCES);
+
+    void EndSplitTransition(IGraphicsResource* pResource);
+
+    void UAVBarrier(IGraphicsResource* pResource);
+
+    // 同じメモリを使うリソースの切り替え (pResourceBefore は nullptr でもよい)
+    void AliasingBarrier(IGraphicsResource* pResourceBefore, IGraphicsResource* pResourceAfter);
+
+    // 溜まったバリアを 1 回の ResourceBarrier で発行する (描画やディスパッチ、クリアの直前に呼ぶ)
+    void FlushBarriers(IGraphicsCommandList* pCommandList);
+
+    // 終わっていない分割バリアがあるか
+    bool HasPendingSplitTransitions() const;
+
+    ResourceStateTable* GetTable() const;
+
+    const ResourceStateTrackerStatistics& GetStatistics() const;
+
+private:
+    struct SplitTransition
+    {
+        IGraphicsResource* pResource;
+        u32                subresource;
+        RESOURCE_STATE     stateBefore;
+        RESOURCE_STATE     stateAfter;
+    };
+
+private:
+    // 1 つのサブリソース (または全体) の遷移を積む
+    void AddTransition(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE stateBefore, RESOURCE_STATE stateAfter, RESOURCE_BARRIER_FLAG flags);
+
+    void TransitionSubresource(IGraphicsResource* pResource, u32 subresource, RESOURCE_STATE stateAfter);
+
+private:
+    ResourceStateTable*              m_pTable;
+    std::vector<ResourceBarrierDesc> m_PendingBarriers;
+    std::vector<SplitTransition>     m_SplitTransitions;
+    ResourceStateTrackerStatistics   m_Statistics;
+};
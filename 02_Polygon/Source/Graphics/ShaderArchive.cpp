@@ -0,0 +1,261 @@
+﻿
+
+struct ShaderArchiveHeader
+{
+    u32  magic;
+    u32  version;
+    u32  entryCount;
+    u32  reserved;
+    u64  fileSize;
+    char compilerIdentifier[32]; // 終端あり
+};
+
+static const u32 ShaderArchiveMagic = 0x52414853; // 'SHAR'
+static const u32 ShaderArchiveVersion = 1;
+static const u64 ShaderArchiveBytecodeAlignment = 16;
+
+
+static bool IsKeyLess(const Hash128& a, const Hash128& b)
+{
+    return a.high != b.high ? a.high < b.high : a.low < b.low;
+}
+
+
+//-----------------------------------------------------------------
+// ShaderArchiveWriter
+//-----------------------------------------------------------------
+ShaderArchiveWriter::ShaderArchiveWriter()
+{
+
+}
+
+
+ShaderArchiveWriter::~ShaderArchiveWriter()
+{
+
+}
+
+
+void ShaderArchiveWriter::Add(const ShaderCompileDesc& desc, const std::vector<u8>& bytecode)
+{
+    Shader shader;
+    shader.key = ShaderArchive::ComputeKey(desc);
+    shader.name = ShaderArchive::MakeName(desc);
+    shader.bytecode = bytecode;
+
+    for (Shader& other : m_Shaders)
+    {
+        if (other.key == shader.key)
+        {
+            other = std::move(shader);
+            return;
+        }
+    }
+    m_Shaders.push_back(std::move(shader));
+}
+
+
+HRESULT ShaderArchiveWriter::Write(const std::string& path, const std::string& compilerIdentifier) const
+{
+    ShaderArchiveHeader header = {};
+    if (compilerIdentifier.size() >= sizeof(header.compilerIdentifier))
+    {
+        return E_INVALIDARG;
+    }
+
+    // 索引はキーの順 (読み込み時に二分探索する)
+    std::vector<const Shader*> shaders;
+    for (const Shader& shader : m_Shaders)
+    {
+        shaders.push_back(&shader);
+    }
+    std::sort(shaders.begin(), shaders.end(), [](const Shader* pA, const Shader* pB) { return IsKeyLess(pA->key, pB->key); });
+
+    std::vector<ShaderArchiveEntry> entries(shaders.size());
+    u64 offset = sizeof(header) + sizeof(ShaderArchiveEntry) * entries.size();
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        entries[i].key = shaders[i]->key;
+        entries[i].nameOffset = static_cast<u32>(offset);
+        entries[i].nameLength = static_cast<u32>(shaders[i]->name.size());
+        offset += shaders[i]->name.size();
+    }
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        offset = AlignUp(offset, ShaderArchiveBytecodeAlignment);
+        entries[i].offset = offset;
+        entries[i].size = shaders[i]->bytecode.size();
+        offset += shaders[i]->bytecode.size();
+    }
+
+    header.magic = ShaderArchiveMagic;
+    header.version = ShaderArchiveVersion;
+    header.entryCount = static_cast<u32>(entries.size());
+    header.fileSize = offset;
+    std::memcpy(header.compilerIdentifier, compilerIdentifier.c_str(), compilerIdentifier.size() + 1);
+
+    std::vector<u8> data(static_cast<size_t>(header.fileSize), 0);
+    std::memcpy(data.data(), &header, sizeof(header));
+    if (!entries.empty())
+    {
+        std::memcpy(data.data() + sizeof(header), entries.data(), sizeof(ShaderArchiveEntry) * entries.size());
+    }
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        std::copy(shaders[i]->name.begin(), shaders[i]->name.end(), data.begin() + entries[i].nameOffset);
+        std::copy(shaders[i]->bytecode.begin(), shaders[i]->bytecode.end(), data.begin() + static_cast<size_t>(entries[i].offset));
+    }
+
+    // 別の名前に書いてから置き換える
+    const std::string temporaryPath = path + ".tmp";
+    std::FILE* pFile = std::fopen(temporaryPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+    bool isWritten = std::fwrite(data.data(), data.size(), 1, pFile) == 1;
+    isWritten = (std::fclose(pFile) == 0) && isWritten;
+
+    // rename は置き換え先があると失敗する環境があるので先に消す
+    std::remove(path.c_str());
+    if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return E_FAIL;
+    }
+    return S_OK;
+}
+
+
+u32 ShaderArchiveWriter::GetEntryCount() const
+{
+    return static_cast<u32>(m_Shaders.size());
+}
+
+
+//-----------------------------------------------------------------
+// ShaderArchive
+//-----------------------------------------------------------------
+ShaderArchive::ShaderArchive()
+    : m_pEntries(nullptr)
+    , m_EntryCount(0)
+{
+
+}
+
+
+ShaderArchive::~ShaderArchive()
+{
+    Close();
+}
+
+
+HRESULT ShaderArchive::Open(const std::string& path, const std::string& compilerIdentifier)
+{
+    Close();
+
+    if (!m_File.Open(path))
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+
+    // 範囲外を指すものがあれば全体を使わない (ここで確かめれば Find では確かめなくてよい)
+    const u8* pData = m_File.GetData();
+    const u64 fileSize = m_File.GetSize();
+
+    ShaderArchiveHeader header = {};
+    bool isValid = fileSize >= sizeof(header);
+    if (isValid)
+    {
+        std::memcpy(&header, pData, sizeof(header));
+        header.compilerIdentifier[sizeof(header.compilerIdentifier) - 1] = '\0';
+        isValid = header.magic == ShaderArchiveMagic
+            && header.version == ShaderArchiveVersion
+            && header.fileSize == fileSize
+            && compilerIdentifier == header.compilerIdentifier
+            && sizeof(header) + static_cast<u64>(sizeof(ShaderArchiveEntry)) * header.entryCount <= fileSize;
+    }
+
+    const ShaderArchiveEntry* pEntries = reinterpret_cast<const ShaderArchiveEntry*>(pData + sizeof(header));
+    for (u32 i = 0; isValid && i < header.entryCount; i++)
+    {
+        const ShaderArchiveEntry& entry = pEntries[i];
+        isValid = entry.offset <= fileSize
+            && entry.size <= fileSize - entry.offset
+            && static_cast<u64>(entry.nameOffset) + entry.nameLength <= fileSize
+            && (i == 0 || IsKeyLess(pEntries[i - 1].key, entry.key));
+    }
+    if (!isValid)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_pEntries = pEntries;
+    m_EntryCount = header.entryCount;
+    return S_OK;
+}
+
+
+void ShaderArchive::Close()
+{
+    m_File.Close();
+    m_pEntries = nullptr;
+    m_EntryCount = 0;
+}
+
+
+bool ShaderArchive::IsOpen() const
+{
+    return m_File.IsOpen();
+}
+
+
+bool ShaderArchive::Find(const ShaderCompileDesc& desc, ShaderBytecode* pOut) const
+{
+    const Hash128 key = ComputeKey(desc);
+    const ShaderArchiveEntry* pEnd = m_pEntries + m_EntryCount;
+    const ShaderArchiveEntry* pEntry = std::lower_bound(m_pEntries, pEnd, key, [](const ShaderArchiveEntry& entry, const Hash128& value) { return IsKeyLess(entry.key, value); });
+    if (pEntry == pEnd || pEntry->key != key)
+    {
+        return false;
+    }
+
+    pOut->pShaderBytecode = m_File.GetData() + pEntry->offset;
+    pOut->bytecodeLength = static_cast<size_t>(pEntry->size);
+    return true;
+}
+
+
+u32 ShaderArchive::GetEntryCount() const
+{
+    return m_EntryCount;
+}
+
+
+Hash128 ShaderArchive::ComputeKey(const ShaderCompileDesc& desc)
+{
+    Hasher128 hasher;
+    hasher.UpdateString(desc.filePath);
+    hasher.UpdateString(desc.entryPoint);
+    hasher.UpdateString(desc.target);
+    hasher.UpdateValue(desc.flags);
+    hasher.UpdateValue(static_cast<u64>(desc.defines.size()));
+    for (const ShaderMacro& define : desc.defines)
+    {
+        hasher.UpdateString(define.name);
+        hasher.UpdateString(define.definition);
+    }
+    return hasher.Finish();
+}
+
+
+std::string ShaderArchive::MakeName(const ShaderCompileDesc& desc)
+{
+    std::string name = desc.filePath + ":" + desc.entryPoint + ":" + desc.target;
+    for (const ShaderMacro& define : desc.defines)
+    {
+        name += ":" + define.name + "=" + define.definition;
+    }
+    return name;
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+
+
+// コンパイル済みシェーダーのアーカイブ
+// 事前に全てのシェーダーをコンパイルして 1 つのファイルにまとめ、実行時はメモリにマップして
+// バイトコードをコピーせずにそのままパイプラインステートに渡す (コンパイラもシェーダーごとのファイル読み込みも不要)
+//
+// 形式: ヘッダー | キーの順に並べた索引 | 名前 | バイトコード (16 バイト境界)
+// キーはファイルパス、エントリポイント、ターゲット、マクロ、フラグ (ソースの内容は含めないので、変えたら作り直すこと)
+
+
+// 索引の 1 項目
+struct ShaderArchiveEntry
+{
+    Hash128 key;
+    u64     offset;     // ファイル先頭から
+    u64     size;
+    u32     nameOffset; // 確認用の名前 (ファイル先頭から、終端なし)
+    u32     nameLength;
+};
+
+
+// アーカイブの作成
+class ShaderArchiveWriter
+{
+public:
+    ShaderArchiveWriter();
+
+    ~ShaderArchiveWriter();
+
+    // 同じキーがあれば置き換える
+    void Add(const ShaderCompileDesc& desc, const std::vector<u8>& bytecode);
+
+    // compilerIdentifier は読み込み時の確認用 (IShaderCompiler::GetIdentifier)
+    HRESULT Write(const std::string& path, const std::string& compilerIdentifier) const;
+
+    u32 GetEntryCount() const;
+
+private:
+    struct Shader
+    {
+        Hash128         key;
+        std::string     name;
+        std::vector<u8> bytecode;
+    };
+
+private:
+    std::vector<Shader> m_Shaders;
+};
+
+
+// アーカイブの読み込み
+class ShaderArchive
+{
+public:
+    ShaderArchive();
+
+    ~ShaderArchive();
+
+    // 見つからなければ ERROR_FILE_NOT_FOUND、形式かコンパイラが違えば E_FAIL
+    HRESULT Open(const std::string& path, const std::string& compilerIdentifier);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    // バイトコードはマップしたファイルを指す (Close まで有効)
+    bool Find(const ShaderCompileDesc& desc, ShaderBytecode* pOut) const;
+
+    u32 GetEntryCount() const;
+
+    static Hash128 ComputeKey(const ShaderCompileDesc& desc);
+
+    // ファイルパス:エントリポイント:ターゲット (マクロがあれば :名前=値 を続ける)
+    static std::string MakeName(const ShaderCompileDesc& desc);
+
+private:
+    MappedFile                m_File;
+    const ShaderArchiveEntry* m_pEntries;
+    u32                       m_EntryCount;
+};
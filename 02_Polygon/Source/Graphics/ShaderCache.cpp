@@ -0,0 +1,380 @@
+﻿
+
+// エントリのファイル形式 (ヘッダーの後にバイトコードが続く)
+struct ShaderCacheEntryHeader
+{
+    u32     magic;
+    u32     version;
+    Hash128 key;
+    u64     bytecodeSize;
+    Hash128 checksum;
+};
+
+static const u32 ShaderCacheMagic = 0x43444853; // 'SHDC'
+static const u32 ShaderCacheVersion = 1;
+
+
+static bool ReadWholeFile(const std::string& path, std::vector<u8>* pOut)
+{
+    std::FILE* pFile = std::fopen(path.c_str(), "rb");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    pOut->clear();
+
+    u8 buffer[4096];
+    size_t readSize = 0;
+    while ((readSize = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        pOut->insert(pOut->end(), buffer, buffer + readSize);
+    }
+
+    std::fclose(pFile);
+    return true;
+}
+
+
+static void CreateDirectoryIfNeeded(const std::string& path)
+{
+#if defined(_WIN32)
+    CreateDirectoryA(path.c_str(), nullptr);
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+
+// 末尾の区切り文字までを返す (なければ空)
+static std::string GetDirectoryPart(const std::string& path)
+{
+    const std::string::size_type end = path.find_last_of("/\\");
+    return end != std::string::npos ? path.substr(0, end + 1) : std::string();
+}
+
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+
+// ソース内の #include のファイル名を集める
+static void FindIncludes(const std::vector<u8>& source, std::vector<std::string>* pOut)
+{
+    const char* p = reinterpret_cast<const char*>(source.data());
+    const char* pEnd = p + source.size();
+    while (p < pEnd)
+    {
+        const char* pLineEnd = std::find(p, pEnd, '\n');
+
+        const char* q = p;
+        while (q < pLineEnd && IsSpace(*q))
+        {
+            q++;
+        }
+        if (q < pLineEnd && *q == '#')
+        {
+            q++;
+            while (q < pLineEnd && IsSpace(*q))
+            {
+                q++;
+            }
+
+            static const char Keyword[] = "include";
+            const size_t keywordLength = sizeof(Keyword) - 1;
+            if (static_cast<size_t>(pLineEnd - q) > keywordLength && std::memcmp(q, Keyword, keywordLength) == 0)
+            {
+                q += keywordLength;
+                while (q < pLineEnd && IsSpace(*q))
+                {
+                    q++;
+                }
+                if (q < pLineEnd && (*q == '"' || *q == '<'))
+                {
+                    const char close = (*q == '"') ? '"' : '>';
+                    const char* pNameEnd = std::find(q + 1, pLineEnd, close);
+                    if (pNameEnd < pLineEnd)
+                    {
+                        pOut->push_back(std::string(q + 1, pNameEnd));
+                    }
+                }
+            }
+        }
+
+        p = pLineEnd + 1;
+    }
+}
+
+
+// ファイルの内容とインクルード先を深さ優先でハッシュに加える
+static bool HashSourceFile(const std::string& path, Hasher128* pHasher, std::vector<std::string>* pVisited)
+{
+    if (std::find(pVisited->begin(), pVisited->end(), path) != pVisited->end())
+    {
+        return true;
+    }
+    pVisited->push_back(path);
+
+    std::vector<u8> source;
+    if (!ReadWholeFile(path, &source))
+    {
+        return false;
+    }
+    pHasher->UpdateString(path);
+    pHasher->UpdateValue(static_cast<u64>(source.size()));
+    pHasher->Update(source.data(), source.size());
+
+    std::vector<std::string> includes;
+    FindIncludes(source, &includes);
+
+    const std::string directory = GetDirectoryPart(path);
+    for (const std::string& include : includes)
+    {
+        // 見つからないインクルードは名前だけ含める (コンパイラがエラーにする)
+        if (!HashSourceFile(directory + include, pHasher, pVisited))
+        {
+            pHasher->UpdateString("?" + directory + include);
+        }
+    }
+    return true;
+}
+
+
+// ファイルとインクルード先を深さ優先で集める (読めないファイルも含める)
+static void CollectSourceFile(const std::string& path, std::vector<std::string>* pOut)
+{
+    if (std::find(pOut->begin(), pOut->end(), path) != pOut->end())
+    {
+        return;
+    }
+    pOut->push_back(path);
+
+    std::vector<u8> source;
+    if (!ReadWholeFile(path, &source))
+    {
+        return;
+    }
+
+    std::vector<std::string> includes;
+    FindIncludes(source, &includes);
+
+    const std::string directory = GetDirectoryPart(path);
+    for (const std::string& include : includes)
+    {
+        CollectSourceFile(directory + include, pOut);
+    }
+}
+
+
+static f64 GetElapsedMilliseconds(std::chrono::steady_clock::time_point beginTime)
+{
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+}
+
+
+ShaderCache::ShaderCache()
+    : m_pCompiler(nullptr)
+    , m_TemporaryFileCount(0)
+    , m_Statistics()
+{
+
+}
+
+
+ShaderCache::~ShaderCache()
+{
+    Term();
+}
+
+
+void ShaderCache::Init(IShaderCompiler* pCompiler, const std::string& directory)
+{
+    m_pCompiler = pCompiler;
+    m_Directory = directory;
+    m_Statistics = ShaderCacheStatistics();
+    CreateDirectoryIfNeeded(m_Directory);
+}
+
+
+void ShaderCache::Term()
+{
+    m_pCompiler = nullptr;
+}
+
+
+HRESULT ShaderCache::CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText)
+{
+    std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    // ソースが読めなければコンパイラにエラーを作らせる
+    Hash128 key = {};
+    if (!ComputeKey(desc, &key))
+    {
+        return m_pCompiler->CompileFromFile(desc, pBytecode, pErrorText);
+    }
+    const std::string path = GetEntryPath(key);
+    const f64 hashMilliseconds = GetElapsedMilliseconds(beginTime);
+
+    beginTime = std::chrono::steady_clock::now();
+    const bool isHit = LoadEntry(path, key, pBytecode);
+    HRESULT hr = S_OK;
+    bool isStored = true;
+    if (!isHit)
+    {
+        hr = m_pCompiler->CompileFromFile(desc, pBytecode, pErrorText);
+        if (SUCCEEDED(hr))
+        {
+            isStored = StoreEntry(path, key, *pBytecode);
+        }
+    }
+    const f64 milliseconds = GetElapsedMilliseconds(beginTime);
+
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    m_Statistics.hashMilliseconds += hashMilliseconds;
+    if (isHit)
+    {
+        m_Statistics.hitCount++;
+        m_Statistics.hitMilliseconds += milliseconds;
+        return S_OK;
+    }
+    if (FAILED(hr))
+    {
+        m_Statistics.compileErrorCount++;
+        return hr;
+    }
+    if (!isStored)
+    {
+        m_Statistics.writeErrorCount++;
+    }
+    m_Statistics.missCount++;
+    m_Statistics.missMilliseconds += milliseconds;
+    return S_OK;
+}
+
+
+void ShaderCache::CollectSourceFiles(const std::string& filePath, std::vector<std::string>* pOut)
+{
+    pOut->clear();
+    CollectSourceFile(filePath, pOut);
+}
+
+
+const char* ShaderCache::GetIdentifier() const
+{
+    return m_pCompiler->GetIdentifier();
+}
+
+
+bool ShaderCache::ComputeKey(const ShaderCompileDesc& desc, Hash128* pOut) const
+{
+    Hasher128 hasher;
+    hasher.UpdateValue(ShaderCacheVersion);
+    hasher.UpdateString(m_pCompiler->GetIdentifier());
+    hasher.UpdateString(desc.entryPoint);
+    hasher.UpdateString(desc.target);
+    hasher.UpdateValue(desc.flags);
+    hasher.UpdateValue(static_cast<u64>(desc.defines.size()));
+    for (const ShaderMacro& define : desc.defines)
+    {
+        hasher.UpdateString(define.name);
+        hasher.UpdateString(define.definition);
+    }
+
+    std::vector<std::string> visited;
+    if (!HashSourceFile(desc.filePath, &hasher, &visited))
+    {
+        return false;
+    }
+
+    *pOut = hasher.Finish();
+    return true;
+}
+
+
+std::string ShaderCache::GetEntryPath(const Hash128& key) const
+{
+    return m_Directory + "/" + ToHexString(key) + ".bin";
+}
+
+
+void ShaderCache::GetStatistics(ShaderCacheStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    *pOut = m_Statistics;
+}
+
+
+bool ShaderCache::LoadEntry(const std::string& path, const Hash128& key, std::vector<u8>* pBytecode)
+{
+    std::vector<u8> data;
+    if (!ReadWholeFile(path, &data))
+    {
+        return false;
+    }
+
+    // 書き込み途中で止まったものなどは使わない
+    ShaderCacheEntryHeader header = {};
+    bool isValid = data.size() >= sizeof(header);
+    if (isValid)
+    {
+        std::memcpy(&header, data.data(), sizeof(header));
+        isValid = header.magic == ShaderCacheMagic
+            && header.version == ShaderCacheVersion
+            && header.key == key
+            && header.bytecodeSize == data.size() - sizeof(header);
+    }
+    if (isValid)
+    {
+        Hasher128 hasher;
+        hasher.Update(data.data() + sizeof(header), static_cast<size_t>(header.bytecodeSize));
+        isValid = hasher.Finish() == header.checksum;
+    }
+    if (!isValid)
+    {
+        std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+        m_Statistics.invalidEntryCount++;
+        return false;
+    }
+
+    pBytecode->assign(data.begin() + sizeof(header), data.end());
+    return true;
+}
+
+
+bool ShaderCache::StoreEntry(const std::string& path, const Hash128& key, const std::vector<u8>& bytecode)
+{
+    ShaderCacheEntryHeader header = {};
+    header.magic = ShaderCacheMagic;
+    header.version = ShaderCacheVersion;
+    header.key = key;
+    header.bytecodeSize = bytecode.size();
+    {
+        Hasher128 hasher;
+        hasher.Update(bytecode.data(), bytecode.size());
+        header.checksum = hasher.Finish();
+    }
+
+    // 別の名前に書いてから置き換え、読む側が書き込み途中のファイルを見ないようにする
+    const std::string temporaryPath = path + "." + std::to_string(m_TemporaryFileCount++) + ".tmp";
+    std::FILE* pFile = std::fopen(temporaryPath.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+    bool isWritten = std::fwrite(&header, sizeof(header), 1, pFile) == 1;
+    if (isWritten && !bytecode.empty())
+    {
+        isWritten = std::fwrite(bytecode.data(), bytecode.size(), 1, pFile) == 1;
+    }
+    isWritten = (std::fclose(pFile) == 0) && isWritten;
+
+    // 同じキーは同じ内容なので、既にあって置き換えられなくてもよい
+    if (!isWritten || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporaryPath.c_str());
+        return isWritten;
+    }
+    return true;
+}
@@ -0,0 +1,67 @@
+﻿#pragma once
+
+
+// シェーダーのディスクキャッシュ
+// ソースと (再帰的にたどった) インクルードファイルの内容、マクロ、エントリポイント、ターゲット、フラグ、
+// コンパイラの識別子からキーを作り、同じキーのバイトコードがあればコンパイラを呼ばずに返す
+// ファイル名がキーそのものなので、無効化は不要 (古いものは消してよい)
+//
+// インクルードは #include "..." / <...> を書いたファイルのディレクトリから探す
+// (#if の中でも含める。余計に含めてもキーが変わりやすくなるだけ)
+//
+// CompileFromFile は複数のスレッドから呼んでよい (コンパイラも同様であること)
+
+
+// 統計情報
+struct ShaderCacheStatistics
+{
+    u64 hitCount;
+    u64 missCount;
+    u64 compileErrorCount;  // コンパイラが失敗したもの (キャッシュしない)
+    u64 invalidEntryCount;  // 壊れていたエントリ (コンパイルし直して上書きする)
+    u64 writeErrorCount;
+    f64 hashMilliseconds;   // キーの計算 (ソースとインクルードの読み込みを含む)
+    f64 hitMilliseconds;    // ヒット時の読み込み
+    f64 missMilliseconds;   // ミス時のコンパイルと書き込み
+};
+
+
+class ShaderCache : public IShaderCompiler
+{
+public:
+    ShaderCache();
+
+    ~ShaderCache();
+
+    // pCompiler はミスのときに使う (所有しない)
+    // directory がなければ作る
+    void Init(IShaderCompiler* pCompiler, const std::string& directory);
+
+    void Term();
+
+    virtual HRESULT CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText) override;
+
+    virtual const char* GetIdentifier() const override;
+
+    // キーに含めるファイル (ソースと、インクルード先を再帰的にたどったもの、見つからないものを含む)
+    static void CollectSourceFiles(const std::string& filePath, std::vector<std::string>* pOut);
+
+    // ソースが読めなければ false
+    bool ComputeKey(const ShaderCompileDesc& desc, Hash128* pOut) const;
+
+    std::string GetEntryPath(const Hash128& key) const;
+
+    void GetStatistics(ShaderCacheStatistics* pOut) const;
+
+private:
+    bool LoadEntry(const std::string& path, const Hash128& key, std::vector<u8>* pBytecode);
+
+    bool StoreEntry(const std::string& path, const Hash128& key, const std::vector<u8>& bytecode);
+
+private:
+    IShaderCompiler*      m_pCompiler;
+    std::string           m_Directory;
+    std::atomic<u32>      m_TemporaryFileCount; // 書き込み途中のファイル名を分ける
+    mutable std::mutex    m_StatisticsMutex;
+    ShaderCacheStatistics m_Statistics;
+};
@@ -0,0 +1,43 @@
+﻿
+
+HRESULT CreateShaderCompiler(GRAPHICS_BACKEND backend, std::unique_ptr<IShaderCompiler>* pOut)
+{
+    switch (backend)
+    {
+#if defined(_WIN32)
+    case GRAPHICS_BACKEND_D3D12:
+        pOut->reset(new ShaderCompilerD3D12());
+        return S_OK;
+#endif
+
+    case GRAPHICS_BACKEND_NULL:
+        pOut->reset(new ShaderCompilerNull());
+        return S_OK;
+
+    case GRAPHICS_BACKEND_SOFTWARE:
+        pOut->reset(new ShaderCompilerSoftware());
+        return S_OK;
+
+    default:
+        return E_NOTIMPL;
+    }
+}
+
+
+const char* GetShaderCompilerIdentifier(GRAPHICS_BACKEND backend)
+{
+    switch (backend)
+    {
+    case GRAPHICS_BACKEND_D3D12:
+        return "d3dcompiler_47";
+
+    case GRAPHICS_BACKEND_NULL:
+        return "null";
+
+    case GRAPHICS_BACKEND_SOFTWARE:
+        return "software";
+
+    default:
+        return "";
+    }
+}
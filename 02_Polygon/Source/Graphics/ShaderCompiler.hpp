@@ -0,0 +1,52 @@
+﻿#pragma once
+
+
+// シェーダーコンパイルフラグ
+enum SHADER_COMPILE_FLAG
+{
+    SHADER_COMPILE_FLAG_NONE                = 0x0
+
+    , SHADER_COMPILE_FLAG_DEBUG             = 0x1
+    , SHADER_COMPILE_FLAG_SKIP_OPTIMIZATION = 0x2
+};
+
+
+// プリプロセッサマクロ
+struct ShaderMacro
+{
+    std::string name;
+    std::string definition;
+};
+
+
+// コンパイル設定
+struct ShaderCompileDesc
+{
+    std::string              filePath;
+    std::string              entryPoint;
+    std::string              target;
+    std::vector<ShaderMacro> defines;
+    u32                      flags;
+};
+
+
+// シェーダーコンパイラ
+class IShaderCompiler
+{
+public:
+    virtual ~IShaderCompiler() = default;
+
+    // 失敗時は pErrorText にコンパイラのエラー内容を格納する
+    virtual HRESULT CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText) = 0;
+
+    // コンパイラの識別子 (キャッシュのキーに含める、出力が変わるときは変えること)
+    virtual const char* GetIdentifier() const = 0;
+};
+
+
+// バックエンドに合わせたコンパイラの作成
+HRESULT CreateShaderCompiler(GRAPHICS_BACKEND backend, std::unique_ptr<IShaderCompiler>* pOut);
+
+// バックエンドのコンパイラの識別子 (コンパイラを作らずに、アーカイブなどが合っているか確かめる)
+const char* GetShaderCompilerIdentifier(GRAPHICS_BACKEND backend);
+
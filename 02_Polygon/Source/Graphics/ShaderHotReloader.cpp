@@ -0,0 +1,151 @@
+﻿
+
+ShaderHotReloader::ShaderHotReloader()
+    : m_pCompiler(nullptr)
+    , m_pTaskScheduler(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+ShaderHotReloader::~ShaderHotReloader()
+{
+    Term();
+}
+
+
+bool ShaderHotReloader::Init(IShaderCompiler* pCompiler, TaskScheduler* pTaskScheduler)
+{
+    m_pCompiler = pCompiler;
+    m_pTaskScheduler = pTaskScheduler;
+    m_Statistics = ShaderHotReloaderStatistics();
+    return m_FileWatcher.Init();
+}
+
+
+void ShaderHotReloader::Term()
+{
+    // タスクは m_pCompiler を使うので、先に終わらせる
+    for (const Shader& shader : m_Shaders)
+    {
+        if (shader.job)
+        {
+            m_pTaskScheduler->Wait(shader.task);
+        }
+    }
+    m_Shaders.clear();
+    m_WatchedFiles.clear();
+    m_FileWatcher.Term();
+    m_pCompiler = nullptr;
+    m_pTaskScheduler = nullptr;
+}
+
+
+u32 ShaderHotReloader::AddShader(const ShaderCompileDesc& desc)
+{
+    Shader shader;
+    shader.desc = desc;
+    shader.isChanged = false;
+    ShaderCache::CollectSourceFiles(desc.filePath, &shader.sourceFiles);
+    WatchSourceFiles(shader.sourceFiles);
+
+    m_Shaders.push_back(std::move(shader));
+    m_Statistics.shaderCount = static_cast<u32>(m_Shaders.size());
+    return static_cast<u32>(m_Shaders.size() - 1);
+}
+
+
+const ShaderCompileDesc& ShaderHotReloader::GetDesc(u32 shaderIndex) const
+{
+    return m_Shaders[shaderIndex].desc;
+}
+
+
+void ShaderHotReloader::Update(std::vector<ShaderReloadResult>* pOut)
+{
+    pOut->clear();
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // 変更されたファイルを使うシェーダーに印を付ける
+    m_FileWatcher.Poll(&m_ChangedFiles);
+    m_Statistics.changeCount += m_ChangedFiles.size();
+    for (Shader& shader : m_Shaders)
+    {
+        for (const std::string& path : m_ChangedFiles)
+        {
+            if (std::find(shader.sourceFiles.begin(), shader.sourceFiles.end(), path) != shader.sourceFiles.end())
+            {
+                shader.isChanged = true;
+                shader.changedTime = now;
+                break;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < static_cast<u32>(m_Shaders.size()); i++)
+    {
+        Shader& shader = m_Shaders[i];
+
+        // 終わったものを受け取る
+        if (shader.job && m_pTaskScheduler->IsCompleted(shader.task))
+        {
+            CompileJob& job = *shader.job;
+            m_Statistics.compileCount++;
+            m_Statistics.compileMilliseconds += job.milliseconds;
+            if (FAILED(job.result.result))
+            {
+                m_Statistics.compileErrorCount++;
+            }
+
+            shader.sourceFiles = std::move(job.sourceFiles);
+            WatchSourceFiles(shader.sourceFiles);
+            pOut->push_back(std::move(job.result));
+
+            shader.job.reset();
+            shader.task = TaskHandle();
+        }
+
+        // 変更が落ち着いていれば始める
+        const u32 elapsedMilliseconds = static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(now - shader.changedTime).count());
+        if (!shader.isChanged || shader.job || elapsedMilliseconds < SettleMilliseconds)
+        {
+            continue;
+        }
+        shader.isChanged = false;
+
+        std::shared_ptr<CompileJob> job = std::make_shared<CompileJob>();
+        job->result.shaderIndex = i;
+        job->milliseconds = 0.0;
+
+        IShaderCompiler* pCompiler = m_pCompiler;
+        const ShaderCompileDesc desc = shader.desc;
+        shader.job = job;
+        shader.task = m_pTaskScheduler->Submit("ReloadShader", [pCompiler, desc, job]()
+        {
+            const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+            job->result.result = pCompiler->CompileFromFile(desc, &job->result.bytecode, &job->result.errorText);
+            ShaderCache::CollectSourceFiles(desc.filePath, &job->sourceFiles);
+            job->milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+        });
+    }
+}
+
+
+const ShaderHotReloaderStatistics& ShaderHotReloader::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+
+void ShaderHotReloader::WatchSourceFiles(const std::vector<std::string>& sourceFiles)
+{
+    for (const std::string& path : sourceFiles)
+    {
+        if (std::find(m_WatchedFiles.begin(), m_WatchedFiles.end(), path) == m_WatchedFiles.end() && m_FileWatcher.AddFile(path))
+        {
+            m_WatchedFiles.push_back(path);
+        }
+    }
+    m_Statistics.watchedFileCount = static_cast<u32>(m_WatchedFiles.size());
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+
+// シェーダーのホットリロード
+// 登録したシェーダーのソースとインクルード先を監視し、変更されたらワーカーでコンパイルし直す
+// Update はフレームの区切りで呼び、コンパイルが終わったものだけを受け取る (待たない)
+//
+// 保存の途中で読まないよう、最後の変更から少し経ってからコンパイルする
+// コンパイル中に変更されたら、終わってからもう一度コンパイルする
+// インクルードはコンパイルのたびにたどり直すので、追加したインクルードも監視に加わる
+
+
+// コンパイルの結果
+struct ShaderReloadResult
+{
+    u32             shaderIndex; // AddShader の戻り値
+    HRESULT         result;
+    std::vector<u8> bytecode;
+    std::string     errorText;
+};
+
+
+// 統計情報
+struct ShaderHotReloaderStatistics
+{
+    u32 shaderCount;
+    u32 watchedFileCount;
+    u64 changeCount;          // 変更を検出した回数 (ファイルごと)
+    u64 compileCount;
+    u64 compileErrorCount;
+    f64 compileMilliseconds;  // ワーカーでのコンパイル時間の合計
+};
+
+
+class ShaderHotReloader
+{
+public:
+    ShaderHotReloader();
+
+    ~ShaderHotReloader();
+
+    // pCompiler は複数のスレッドから呼べるもの (所有しない)
+    // ファイルを監視できなければ false
+    bool Init(IShaderCompiler* pCompiler, TaskScheduler* pTaskScheduler);
+
+    // コンパイル中のものは終わるのを待つ
+    void Term();
+
+    u32 AddShader(const ShaderCompileDesc& desc);
+
+    const ShaderCompileDesc& GetDesc(u32 shaderIndex) const;
+
+    // 変更を調べてコンパイルを始め、終わったものを pOut に返す
+    void Update(std::vector<ShaderReloadResult>* pOut);
+
+    const ShaderHotReloaderStatistics& GetStatistics() const;
+
+    // 最後の変更からコンパイルを始めるまでの時間
+    static const u32 SettleMilliseconds = 50;
+
+private:
+    // ワーカーでのコンパイル (結果は完了後に Update で読む)
+    struct CompileJob
+    {
+        ShaderReloadResult       result;
+        std::vector<std::string> sourceFiles;
+        f64                      milliseconds;
+    };
+
+    struct Shader
+    {
+        ShaderCompileDesc                     desc;
+        std::vector<std::string>              sourceFiles;
+        bool                                  isChanged;
+        std::chrono::steady_clock::time_point changedTime;
+        std::shared_ptr<CompileJob>           job;
+        TaskHandle                            task;
+    };
+
+private:
+    void WatchSourceFiles(const std::vector<std::string>& sourceFiles);
+
+private:
+    IShaderCompiler*         m_pCompiler;
+    TaskScheduler*           m_pTaskScheduler;
+    FileWatcher              m_FileWatcher;
+    std::vector<Shader>      m_Shaders;
+    std::vector<std::string> m_WatchedFiles;
+    std::vector<std::string> m_ChangedFiles;
+
+    ShaderHotReloaderStatistics m_Statistics;
+};
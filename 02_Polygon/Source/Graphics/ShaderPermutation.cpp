@@ -0,0 +1,484 @@
+﻿
+
+// 使用記録のファイルの先頭行
+static const char ShaderVariantUsageHeader[] = "# ShaderVariantUsage 1";
+
+
+ShaderPermutationManager::ShaderPermutationManager()
+    : m_pTaskScheduler(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+ShaderPermutationManager::~ShaderPermutationManager()
+{
+    Term();
+}
+
+
+void ShaderPermutationManager::Init(TaskScheduler* pTaskScheduler, const LoadFunction& load)
+{
+    m_pTaskScheduler = pTaskScheduler;
+    m_Load = load;
+    m_Statistics = ShaderPermutationStatistics();
+}
+
+
+void ShaderPermutationManager::Term()
+{
+    // タスクは m_Load と m_Shaders を使うので、先に終わらせる
+    std::vector<TaskHandle> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        tasks.swap(m_Tasks);
+    }
+    for (const TaskHandle& task : tasks)
+    {
+        m_pTaskScheduler->Wait(task);
+    }
+
+    m_Shaders.clear();
+    m_PreviousUsages.clear();
+    m_Load = LoadFunction();
+    m_pTaskScheduler = nullptr;
+}
+
+
+u32 ShaderPermutationManager::AddShader(const ShaderCompileDesc& baseDesc, const ShaderFeatureDesc* pFeatures, u32 featureCount)
+{
+    Shader shader;
+    shader.baseDesc = baseDesc;
+    shader.name = ShaderArchive::MakeName(baseDesc);
+    shader.featureHash = ComputeFeatureHash(pFeatures, featureCount);
+    shader.fallback = ShaderBytecode();
+
+    u32 shift = 0;
+    for (u32 i = 0; i < featureCount; i++)
+    {
+        shader.features.push_back(pFeatures[i]);
+        shader.shifts.push_back(shift);
+        shift += GetFeatureBits(pFeatures[i].valueCount);
+    }
+    if (shift > 32)
+    {
+        return InvalidIndex;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Shaders.push_back(std::move(shader));
+    m_Statistics.shaderCount = static_cast<u32>(m_Shaders.size());
+    return static_cast<u32>(m_Shaders.size() - 1);
+}
+
+
+u32 ShaderPermutationManager::FindFeature(u32 shaderIndex, const char* name) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Shader& shader = m_Shaders[shaderIndex];
+    for (u32 i = 0; i < static_cast<u32>(shader.features.size()); i++)
+    {
+        if (std::strcmp(shader.features[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return InvalidIndex;
+}
+
+
+ShaderVariantKey ShaderPermutationManager::SetFeature(u32 shaderIndex, ShaderVariantKey key, u32 featureIndex, u32 value) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Shader& shader = m_Shaders[shaderIndex];
+    const u32 bits = GetFeatureBits(shader.features[featureIndex].valueCount);
+    const u32 mask = static_cast<u32>((1ull << bits) - 1) << shader.shifts[featureIndex];
+    value = std::min(value, shader.features[featureIndex].valueCount - 1);
+    return (key & ~mask) | (value << shader.shifts[featureIndex]);
+}
+
+
+u32 ShaderPermutationManager::GetFeature(u32 shaderIndex, ShaderVariantKey key, u32 featureIndex) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Shader& shader = m_Shaders[shaderIndex];
+    const u32 bits = GetFeatureBits(shader.features[featureIndex].valueCount);
+    return static_cast<u32>((key >> shader.shifts[featureIndex]) & ((1ull << bits) - 1));
+}
+
+
+ShaderCompileDesc ShaderPermutationManager::MakeDesc(u32 shaderIndex, ShaderVariantKey key) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Shader& shader = m_Shaders[shaderIndex];
+
+    ShaderCompileDesc desc;
+    MakeVariantDesc(shader.baseDesc, shader.features.data(), static_cast<u32>(shader.features.size()), key, &desc);
+    return desc;
+}
+
+
+ShaderVariantUsage ShaderPermutationManager::MakeUsage(u32 shaderIndex, ShaderVariantKey key) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Shader& shader = m_Shaders[shaderIndex];
+
+    ShaderVariantUsage usage;
+    usage.shaderName = shader.name;
+    usage.featureHash = shader.featureHash;
+    usage.key = key;
+    return usage;
+}
+
+
+u32 ShaderPermutationManager::FindShader(const std::string& shaderName, u64 featureHash) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (u32 i = 0; i < static_cast<u32>(m_Shaders.size()); i++)
+    {
+        if (m_Shaders[i].name == shaderName && m_Shaders[i].featureHash == featureHash)
+        {
+            return i;
+        }
+    }
+    return InvalidIndex;
+}
+
+
+TaskHandle ShaderPermutationManager::Prepare(u32 shaderIndex, ShaderVariantKey key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const std::shared_ptr<Variant> variant = PrepareLocked(shaderIndex, key);
+    if (!variant)
+    {
+        return TaskHandle();
+    }
+    RecordUsageLocked(m_Shaders[shaderIndex], key);
+    return variant->task;
+}
+
+
+SHADER_VARIANT_STATUS ShaderPermutationManager::Request(u32 shaderIndex, ShaderVariantKey key, ShaderBytecode* pOut)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Statistics.requestCount++;
+
+    std::shared_ptr<Variant> variant = PrepareLocked(shaderIndex, key);
+    if (variant)
+    {
+        RecordUsageLocked(m_Shaders[shaderIndex], key);
+    }
+    if (variant && !variant->isCompleted && m_pTaskScheduler->GetWorkerCount() == 0)
+    {
+        const TaskHandle task = variant->task;
+        lock.unlock();
+        m_pTaskScheduler->Wait(task);
+        lock.lock();
+    }
+
+    if (variant && variant->isCompleted && SUCCEEDED(variant->result))
+    {
+        *pOut = variant->bytecode;
+        return SHADER_VARIANT_STATUS_READY;
+    }
+
+    m_Statistics.fallbackCount++;
+    *pOut = m_Shaders[shaderIndex].fallback;
+    if (pOut->pShaderBytecode == nullptr)
+    {
+        return SHADER_VARIANT_STATUS_UNAVAILABLE;
+    }
+    return (variant && variant->isCompleted) ? SHADER_VARIANT_STATUS_FAILED : SHADER_VARIANT_STATUS_COMPILING;
+}
+
+
+HRESULT ShaderPermutationManager::Wait(u32 shaderIndex, ShaderVariantKey key, ShaderBytecode* pOut, std::string* pErrorText)
+{
+    std::shared_ptr<Variant> variant;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        variant = PrepareLocked(shaderIndex, key);
+        if (variant)
+        {
+            RecordUsageLocked(m_Shaders[shaderIndex], key);
+        }
+    }
+    if (!variant)
+    {
+        *pErrorText = "範囲外の値を持つキーです";
+        return E_INVALIDARG;
+    }
+
+    m_pTaskScheduler->Wait(variant->task);
+
+    // 完了後は書き換えられない
+    *pOut = variant->bytecode;
+    *pErrorText = variant->errorText;
+    return variant->result;
+}
+
+
+void ShaderPermutationManager::Invalidate(u32 shaderIndex)
+{
+    // コンパイル中のものは終わっても捨てられる (タスクは外したものに書き込む)
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Shaders[shaderIndex].variants.clear();
+}
+
+
+u32 ShaderPermutationManager::PrebuildUsedVariants(const std::vector<ShaderVariantUsage>& usages)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_PreviousUsages = usages;
+
+    u32 count = 0;
+    for (const ShaderVariantUsage& usage : usages)
+    {
+        for (u32 i = 0; i < static_cast<u32>(m_Shaders.size()); i++)
+        {
+            const Shader& shader = m_Shaders[i];
+            if (shader.name != usage.shaderName || shader.featureHash != usage.featureHash || shader.variants.count(usage.key) > 0)
+            {
+                continue;
+            }
+            if (PrepareLocked(i, usage.key))
+            {
+                count++;
+            }
+        }
+    }
+    m_Statistics.prebuiltCount += count;
+    return count;
+}
+
+
+HRESULT ShaderPermutationManager::SaveUsage(const std::string& path) const
+{
+    std::string text = ShaderVariantUsageHeader;
+    text += "\n";
+
+    // 行: 機能のハッシュ キー 名前 (名前は空白を含み得るので最後)
+    char line[64];
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const Shader& shader : m_Shaders)
+    {
+        for (ShaderVariantKey key : shader.usedKeys)
+        {
+            std::snprintf(line, sizeof(line), "%016llx %08x ", static_cast<unsigned long long>(shader.featureHash), key);
+            text += line + shader.name + "\n";
+        }
+    }
+    for (const ShaderVariantUsage& usage : m_PreviousUsages)
+    {
+        // 宣言が変わったもの、今回も使ったものは書かない
+        const auto it = std::find_if(m_Shaders.begin(), m_Shaders.end(), [&usage](const Shader& shader) { return shader.name == usage.shaderName; });
+        if (it != m_Shaders.end()
+            && (it->featureHash != usage.featureHash || std::find(it->usedKeys.begin(), it->usedKeys.end(), usage.key) != it->usedKeys.end()))
+        {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), "%016llx %08x ", static_cast<unsigned long long>(usage.featureHash), usage.key);
+        text += line + usage.shaderName + "\n";
+    }
+
+    std::FILE* pFile = std::fopen(path.c_str(), "wb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+    bool isWritten = std::fwrite(text.data(), text.size(), 1, pFile) == 1;
+    isWritten = (std::fclose(pFile) == 0) && isWritten;
+    return isWritten ? S_OK : E_FAIL;
+}
+
+
+void ShaderPermutationManager::GetStatistics(ShaderPermutationStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    *pOut = m_Statistics;
+
+    pOut->variantCount = 0;
+    for (const Shader& shader : m_Shaders)
+    {
+        for (const auto& variant : shader.variants)
+        {
+            if (variant.second->isCompleted && SUCCEEDED(variant.second->result))
+            {
+                pOut->variantCount++;
+            }
+        }
+    }
+}
+
+
+HRESULT ShaderPermutationManager::LoadUsage(const std::string& path, std::vector<ShaderVariantUsage>* pOut)
+{
+    pOut->clear();
+
+    std::FILE* pFile = std::fopen(path.c_str(), "rb");
+    if (pFile == nullptr)
+    {
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+
+    std::string text;
+    char buffer[4096];
+    for (size_t size; (size = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0;)
+    {
+        text.append(buffer, size);
+    }
+    std::fclose(pFile);
+
+    // 形式が違えば全体を使わない
+    if (text.compare(0, sizeof(ShaderVariantUsageHeader) - 1, ShaderVariantUsageHeader) != 0)
+    {
+        return E_FAIL;
+    }
+
+    size_t position = 0;
+    while (position < text.size())
+    {
+        size_t end = text.find('\n', position);
+        end = (end == std::string::npos) ? text.size() : end;
+        const std::string line = text.substr(position, end - position);
+        position = end + 1;
+
+        unsigned long long featureHash = 0;
+        unsigned int key = 0;
+        int nameOffset = 0;
+        if (line.empty() || line[0] == '#' || std::sscanf(line.c_str(), "%16llx %8x %n", &featureHash, &key, &nameOffset) != 2 || nameOffset <= 0)
+        {
+            continue;
+        }
+
+        ShaderVariantUsage usage;
+        usage.shaderName = line.substr(static_cast<size_t>(nameOffset));
+        usage.featureHash = featureHash;
+        usage.key = key;
+        if (!usage.shaderName.empty())
+        {
+            pOut->push_back(std::move(usage));
+        }
+    }
+    return S_OK;
+}
+
+
+u64 ShaderPermutationManager::ComputeFeatureHash(const ShaderFeatureDesc* pFeatures, u32 featureCount)
+{
+    Hasher128 hasher;
+    hasher.UpdateValue(featureCount);
+    for (u32 i = 0; i < featureCount; i++)
+    {
+        hasher.UpdateString(pFeatures[i].name);
+        hasher.UpdateValue(pFeatures[i].valueCount);
+    }
+    return hasher.Finish().low;
+}
+
+
+bool ShaderPermutationManager::MakeVariantDesc(const ShaderCompileDesc& baseDesc, const ShaderFeatureDesc* pFeatures, u32 featureCount, ShaderVariantKey key, ShaderCompileDesc* pOut)
+{
+    *pOut = baseDesc;
+
+    u32 shift = 0;
+    for (u32 i = 0; i < featureCount; i++)
+    {
+        const u32 bits = GetFeatureBits(pFeatures[i].valueCount);
+        const u32 value = static_cast<u32>((static_cast<u64>(key) >> shift) & ((1ull << bits) - 1));
+        if (value >= pFeatures[i].valueCount)
+        {
+            return false;
+        }
+        shift += bits;
+
+        ShaderMacro define;
+        define.name = pFeatures[i].name;
+        define.definition = std::to_string(value);
+        pOut->defines.push_back(std::move(define));
+    }
+
+    // 使っていないビットが立っていれば別のキーと同じ設定になってしまう
+    return shift >= 32 || (static_cast<u64>(key) >> shift) == 0;
+}
+
+
+std::shared_ptr<ShaderPermutationManager::Variant> ShaderPermutationManager::PrepareLocked(u32 shaderIndex, ShaderVariantKey key)
+{
+    Shader& shader = m_Shaders[shaderIndex];
+    const auto it = shader.variants.find(key);
+    if (it != shader.variants.end())
+    {
+        return it->second;
+    }
+
+    ShaderCompileDesc desc;
+    if (!MakeVariantDesc(shader.baseDesc, shader.features.data(), static_cast<u32>(shader.features.size()), key, &desc))
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Variant> variant = std::make_shared<Variant>();
+    variant->result = E_FAIL; // 実行されなければ失敗のまま
+    variant->isCompleted = false;
+    variant->bytecode = ShaderBytecode();
+    variant->milliseconds = 0.0;
+    shader.variants[key] = variant;
+
+    // 終わったものは持たなくてよい
+    m_Tasks.erase(std::remove_if(m_Tasks.begin(), m_Tasks.end(), [this](const TaskHandle& task) { return m_pTaskScheduler->IsCompleted(task); }), m_Tasks.end());
+
+    variant->task = m_pTaskScheduler->Submit("CompileShaderVariant", [this, shaderIndex, key, desc, variant]()
+    {
+        const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+        ShaderBytecode bytecode = {};
+        std::string errorText;
+        const HRESULT hr = m_Load(desc, &bytecode, &errorText);
+        const f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        variant->result = hr;
+        variant->bytecode = bytecode;
+        variant->errorText = std::move(errorText);
+        variant->milliseconds = milliseconds;
+        variant->isCompleted = true;
+
+        m_Statistics.compileCount++;
+        m_Statistics.compileMilliseconds += milliseconds;
+        if (FAILED(hr))
+        {
+            m_Statistics.compileErrorCount++;
+        }
+
+        // Invalidate で外されていなければフォールバックを更新する
+        Shader& shader = m_Shaders[shaderIndex];
+        const auto it = shader.variants.find(key);
+        if (key == 0 && SUCCEEDED(hr) && it != shader.variants.end() && it->second == variant)
+        {
+            shader.fallback = bytecode;
+        }
+    });
+    m_Tasks.push_back(variant->task);
+    return variant;
+}
+
+
+void ShaderPermutationManager::RecordUsageLocked(Shader& shader, ShaderVariantKey key)
+{
+    if (std::find(shader.usedKeys.begin(), shader.usedKeys.end(), key) == shader.usedKeys.end())
+    {
+        shader.usedKeys.push_back(key);
+    }
+}
+
+
+u32 ShaderPermutationManager::GetFeatureBits(u32 valueCount)
+{
+    u32 bits = 1;
+    while (bits < 32 && (1ull << bits) < valueCount)
+    {
+        bits++;
+    }
+    return bits;
+}
@@ -0,0 +1,172 @@
+﻿#pragma once
+
+
+// シェーダーのバリアント (#define の組み合わせ) の管理
+// シェーダーごとに機能 (マクロ名と取り得る値の数) を宣言し、値の組み合わせを 32 ビットのキーに詰める
+// バリアントは要求されたものだけをワーカーでコンパイルし、終わるまではフォールバックを返す
+//
+// フォールバックは全ての機能が 0 のバリアント (キー 0) で、最後に完成したものを使い続ける
+// (Invalidate の後も、作り直したものができるまでは前のものを返す)
+// 全てのバリアントは全ての機能のマクロを定義する (値が 0 でも "NAME=0" を渡す)
+//
+// 要求したバリアントは記録し、SaveUsage で書き出したものを次回の起動で PrebuildUsedVariants に渡すと
+// 描画で要求される前にコンパイルを始められる (アーカイブを作るときにも含める)
+
+
+// 機能
+struct ShaderFeatureDesc
+{
+    const char* name;       // マクロ名
+    u32         valueCount; // 取り得る値の数 (2 以上、2 なら 0 / 1)
+};
+
+
+// 各機能の値を詰めたもの (0 はフォールバック)
+typedef u32 ShaderVariantKey;
+
+
+// 要求の結果
+enum SHADER_VARIANT_STATUS
+{
+    SHADER_VARIANT_STATUS_READY
+
+    , SHADER_VARIANT_STATUS_COMPILING   // フォールバックを返した
+    , SHADER_VARIANT_STATUS_FAILED      // コンパイルに失敗した (フォールバックを返した)
+    , SHADER_VARIANT_STATUS_UNAVAILABLE // フォールバックもまだ無い
+};
+
+
+// 使用記録の 1 項目
+struct ShaderVariantUsage
+{
+    std::string      shaderName;   // ShaderArchive::MakeName (マクロ無し)
+    u64              featureHash;  // 機能の宣言が変わったら使わない
+    ShaderVariantKey key;
+};
+
+
+// 統計情報
+struct ShaderPermutationStatistics
+{
+    u32 shaderCount;
+    u32 variantCount;        // 完成したもの
+    u64 requestCount;
+    u64 fallbackCount;       // 完成していなかった要求
+    u64 compileCount;
+    u64 compileErrorCount;
+    u32 prebuiltCount;       // 使用記録から始めたもの
+    f64 compileMilliseconds; // ワーカーでの読み込み時間の合計
+};
+
+
+class ShaderPermutationManager
+{
+public:
+    static const u32 InvalidIndex = 0xFFFFFFFF;
+
+    // バイトコードの取得 (アーカイブやキャッシュを含む、複数のスレッドから呼ばれる)
+    // バイトコードは Term まで有効であること
+    typedef std::function<HRESULT(const ShaderCompileDesc& desc, ShaderBytecode* pOut, std::string* pErrorText)> LoadFunction;
+
+    ShaderPermutationManager();
+
+    ~ShaderPermutationManager();
+
+    // ワーカーが無ければ Request の中でコンパイルを待つ
+    void Init(TaskScheduler* pTaskScheduler, const LoadFunction& load);
+
+    // コンパイル中のものは終わるのを待つ
+    void Term();
+
+    // baseDesc は機能のマクロを含まない設定 (キーが 32 ビットに収まらなければ InvalidIndex)
+    u32 AddShader(const ShaderCompileDesc& baseDesc, const ShaderFeatureDesc* pFeatures, u32 featureCount);
+
+    // 無ければ InvalidIndex
+    u32 FindFeature(u32 shaderIndex, const char* name) const;
+
+    // key の機能 featureIndex を value にしたもの (範囲外の値は最大値にする)
+    ShaderVariantKey SetFeature(u32 shaderIndex, ShaderVariantKey key, u32 featureIndex, u32 value) const;
+
+    u32 GetFeature(u32 shaderIndex, ShaderVariantKey key, u32 featureIndex) const;
+
+    ShaderCompileDesc MakeDesc(u32 shaderIndex, ShaderVariantKey key) const;
+
+    // 使用記録と同じ形で表したもの
+    ShaderVariantUsage MakeUsage(u32 shaderIndex, ShaderVariantKey key) const;
+
+    // 名前と機能の宣言が同じものを探す (無ければ InvalidIndex)
+    u32 FindShader(const std::string& shaderName, u64 featureHash) const;
+
+    // コンパイルを始める (始めていれば同じタスクを返す、依存関係に使える)
+    TaskHandle Prepare(u32 shaderIndex, ShaderVariantKey key);
+
+    // 完成していればそのバイトコード、まだならコンパイルを始めてフォールバックを返す (待たない)
+    SHADER_VARIANT_STATUS Request(u32 shaderIndex, ShaderVariantKey key, ShaderBytecode* pOut);
+
+    // 完成するまで待つ (フォールバックは返さない)
+    HRESULT Wait(u32 shaderIndex, ShaderVariantKey key, ShaderBytecode* pOut, std::string* pErrorText);
+
+    // ソースが変わったときに呼ぶ (以降の要求はコンパイルし直す)
+    void Invalidate(u32 shaderIndex);
+
+    // 使用記録に載っていて、登録したシェーダーのものをコンパイルし始める (始めた数を返す)
+    u32 PrebuildUsedVariants(const std::vector<ShaderVariantUsage>& usages);
+
+    // 今回の要求に、PrebuildUsedVariants に渡された記録のうち今も使えるもの (機能の宣言が同じもの、登録していないシェーダーのもの) を加えて書き出す
+    HRESULT SaveUsage(const std::string& path) const;
+
+    void GetStatistics(ShaderPermutationStatistics* pOut) const;
+
+    // 無ければ ERROR_FILE_NOT_FOUND、読めない行は飛ばす
+    static HRESULT LoadUsage(const std::string& path, std::vector<ShaderVariantUsage>* pOut);
+
+    static u64 ComputeFeatureHash(const ShaderFeatureDesc* pFeatures, u32 featureCount);
+
+    // キーの値が範囲外なら false
+    static bool MakeVariantDesc(const ShaderCompileDesc& baseDesc, const ShaderFeatureDesc* pFeatures, u32 featureCount, ShaderVariantKey key, ShaderCompileDesc* pOut);
+
+private:
+    struct Variant
+    {
+        HRESULT        result;       // 完成していなければ E_FAIL
+        bool           isCompleted;
+        ShaderBytecode bytecode;
+        std::string    errorText;
+        f64            milliseconds;
+        TaskHandle     task;
+    };
+
+    struct Shader
+    {
+        ShaderCompileDesc                                              baseDesc;
+        std::string                                                    name;
+        std::vector<ShaderFeatureDesc>                                 features;
+        std::vector<u32>                                               shifts;
+        u64                                                            featureHash;
+        std::unordered_map<ShaderVariantKey, std::shared_ptr<Variant>> variants;
+        std::vector<ShaderVariantKey>                                  usedKeys;
+        ShaderBytecode                                                 fallback;
+    };
+
+private:
+    // m_Mutex をロックした状態で呼ぶ
+    std::shared_ptr<Variant> PrepareLocked(u32 shaderIndex, ShaderVariantKey key);
+
+    void RecordUsageLocked(Shader& shader, ShaderVariantKey key);
+
+    static u32 GetFeatureBits(u32 valueCount);
+
+private:
+    TaskScheduler*      m_pTaskScheduler;
+    LoadFunction        m_Load;
+    mutable std::mutex  m_Mutex;
+    std::vector<Shader> m_Shaders;
+
+    // 終わっていないかもしれないタスク (Invalidate で外したものを含む)
+    std::vector<TaskHandle> m_Tasks;
+
+    // PrebuildUsedVariants に渡された記録 (今回使わなかったものも次回のために残す)
+    std::vector<ShaderVariantUsage> m_PreviousUsages;
+
+    ShaderPermutationStatistics m_Statistics;
+};
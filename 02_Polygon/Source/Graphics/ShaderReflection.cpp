@@ -0,0 +1,1250 @@
+﻿
+
+static const u32 UnassignedRegister = 0xFFFFFFFF;
+
+
+static SHADER_VISIBILITY GetShaderStage(const std::string& target)
+{
+    if (target.compare(0, 3, "vs_") == 0)
+    {
+        return SHADER_VISIBILITY_VERTEX;
+    }
+    if (target.compare(0, 3, "ps_") == 0)
+    {
+        return SHADER_VISIBILITY_PIXEL;
+    }
+    return SHADER_VISIBILITY_ALL;
+}
+
+
+static bool IsSameText(const std::string& a, const std::string& b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static bool IsSystemValueSemantic(const std::string& semanticName)
+{
+    return semanticName.size() > 3 && IsSameText(semanticName.substr(0, 3), "SV_");
+}
+
+
+static u32 RoundUp16(u32 value)
+{
+    return (value + 15) & ~15u;
+}
+
+
+//-----------------------------------------------------------------
+// DXBC
+//-----------------------------------------------------------------
+static u32 MakeFourCC(char a, char b, char c, char d)
+{
+    return static_cast<u32>(static_cast<u8>(a)) | (static_cast<u32>(static_cast<u8>(b)) << 8) | (static_cast<u32>(static_cast<u8>(c)) << 16) | (static_cast<u32>(static_cast<u8>(d)) << 24);
+}
+
+
+static u32 ReadU32(const u8* p)
+{
+    u32 value = 0;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+
+// チャンク内の位置にある文字列 (範囲外なら false)
+static bool ReadChunkString(const u8* pChunk, u32 chunkSize, u32 offset, std::string* pOut)
+{
+    if (offset >= chunkSize)
+    {
+        return false;
+    }
+    const char* pBegin = reinterpret_cast<const char*>(pChunk + offset);
+    const char* pEnd = std::find(pBegin, reinterpret_cast<const char*>(pChunk + chunkSize), '\0');
+    if (pEnd == reinterpret_cast<const char*>(pChunk + chunkSize))
+    {
+        return false;
+    }
+    pOut->assign(pBegin, pEnd);
+    return true;
+}
+
+
+// コンテナからチャンクを探す
+// ヘッダー: 'DXBC', チェックサム (16 バイト), 1, 全体の大きさ, チャンクの数, チャンクの位置の配列
+static bool FindDxbcChunk(const u8* pData, size_t size, u32 fourCC, const u8** ppChunk, u32* pChunkSize)
+{
+    const u32 chunkCount = ReadU32(pData + 28);
+    if (32 + static_cast<u64>(chunkCount) * 4 > size)
+    {
+        return false;
+    }
+    for (u32 i = 0; i < chunkCount; i++)
+    {
+        const u32 offset = ReadU32(pData + 32 + i * 4);
+        if (static_cast<u64>(offset) + 8 > size)
+        {
+            return false;
+        }
+        if (ReadU32(pData + offset) != fourCC)
+        {
+            continue;
+        }
+        const u32 chunkSize = ReadU32(pData + offset + 4);
+        if (static_cast<u64>(offset) + 8 + chunkSize > size)
+        {
+            return false;
+        }
+        *ppChunk = pData + offset + 8;
+        *pChunkSize = chunkSize;
+        return true;
+    }
+    return false;
+}
+
+
+// 入力シグネチャ (ISGN は 24 バイト、ISG1 は先頭にストリーム、末尾に精度が付いて 32 バイト)
+static HRESULT ReadDxbcInputSignature(const u8* pChunk, u32 chunkSize, bool isExtended, std::vector<ShaderInputParameter>* pOut)
+{
+    if (chunkSize < 8)
+    {
+        return E_INVALIDARG;
+    }
+    const u32 count = ReadU32(pChunk);
+    const u32 elementSize = isExtended ? 32 : 24;
+    if (8 + static_cast<u64>(count) * elementSize > chunkSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (u32 i = 0; i < count; i++)
+    {
+        const u8* pElement = pChunk + 8 + i * elementSize + (isExtended ? 4 : 0);
+
+        ShaderInputParameter parameter = {};
+        if (!ReadChunkString(pChunk, chunkSize, ReadU32(pElement), &parameter.semanticName))
+        {
+            return E_INVALIDARG;
+        }
+        parameter.semanticIndex = ReadU32(pElement + 4);
+        parameter.isSystemValue = ReadU32(pElement + 8) != 0 || IsSystemValueSemantic(parameter.semanticName);
+
+        switch (ReadU32(pElement + 12))
+        {
+        case 1:  parameter.componentType = SHADER_COMPONENT_TYPE_UINT32; break;
+        case 2:  parameter.componentType = SHADER_COMPONENT_TYPE_SINT32; break;
+        case 3:  parameter.componentType = SHADER_COMPONENT_TYPE_FLOAT32; break;
+        default: parameter.componentType = SHADER_COMPONENT_TYPE_UNKNOWN; break;
+        }
+
+        const u8 mask = pElement[20] & 0xF;
+        parameter.componentCount = ((mask >> 0) & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        pOut->push_back(parameter);
+    }
+    return S_OK;
+}
+
+
+static SHADER_RESOURCE_TYPE ToShaderResourceType(u32 inputType)
+{
+    // D3D_SHADER_INPUT_TYPE
+    switch (inputType)
+    {
+    case 0:  return SHADER_RESOURCE_TYPE_CBV;     // CBUFFER
+    case 3:  return SHADER_RESOURCE_TYPE_SAMPLER; // SAMPLER
+    case 4:                                      // UAV_RWTYPED
+    case 6:                                      // UAV_RWSTRUCTURED
+    case 8:                                      // UAV_RWBYTEADDRESS
+    case 9:                                      // UAV_APPEND_STRUCTURED
+    case 10:                                     // UAV_CONSUME_STRUCTURED
+    case 11:                                     // UAV_RWSTRUCTURED_WITH_COUNTER
+    case 13: return SHADER_RESOURCE_TYPE_UAV;     // UAV_FEEDBACKTEXTURE
+    default: return SHADER_RESOURCE_TYPE_SRV;     // TBUFFER, TEXTURE, STRUCTURED, BYTEADDRESS など
+    }
+}
+
+
+// リソース定義
+// ヘッダー: 定数バッファの数と位置, バインドの数と位置, バージョン (下位 8 ビット、上位 8 ビット), 段階, ...
+// バインドは 32 バイト (5.1 以降は空間と ID が付いて 40 バイト)、定数バッファは 24 バイト
+static HRESULT ReadDxbcResourceDefinition(const u8* pChunk, u32 chunkSize, std::vector<ShaderResourceBinding>* pOut)
+{
+    if (chunkSize < 28)
+    {
+        return E_INVALIDARG;
+    }
+    const u32 constantBufferCount = ReadU32(pChunk);
+    const u32 constantBufferOffset = ReadU32(pChunk + 4);
+    const u32 bindingCount = ReadU32(pChunk + 8);
+    const u32 bindingOffset = ReadU32(pChunk + 12);
+    const u32 minorVersion = pChunk[16];
+    const u32 majorVersion = pChunk[17];
+    const u32 bindingSize = (majorVersion > 5 || (majorVersion == 5 && minorVersion >= 1)) ? 40 : 32;
+
+    if (static_cast<u64>(bindingOffset) + static_cast<u64>(bindingCount) * bindingSize > chunkSize
+        || static_cast<u64>(constantBufferOffset) + static_cast<u64>(constantBufferCount) * 24 > chunkSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (u32 i = 0; i < bindingCount; i++)
+    {
+        const u8* pBinding = pChunk + bindingOffset + i * bindingSize;
+
+        ShaderResourceBinding binding = {};
+        if (!ReadChunkString(pChunk, chunkSize, ReadU32(pBinding), &binding.name))
+        {
+            return E_INVALIDARG;
+        }
+        binding.type = ToShaderResourceType(ReadU32(pBinding + 4));
+        binding.bindPoint = ReadU32(pBinding + 20);
+        binding.bindCount = ReadU32(pBinding + 24);
+        binding.space = (bindingSize == 40) ? ReadU32(pBinding + 32) : 0;
+
+        // 定数バッファの大きさは同じ名前の定義から
+        if (binding.type == SHADER_RESOURCE_TYPE_CBV)
+        {
+            for (u32 j = 0; j < constantBufferCount; j++)
+            {
+                const u8* pConstantBuffer = pChunk + constantBufferOffset + j * 24;
+                std::string name;
+                if (ReadChunkString(pChunk, chunkSize, ReadU32(pConstantBuffer), &name) && name == binding.name)
+                {
+                    binding.size = ReadU32(pConstantBuffer + 12);
+                    break;
+                }
+            }
+        }
+        pOut->push_back(binding);
+    }
+    return S_OK;
+}
+
+
+static HRESULT ReflectDxbc(const ShaderBytecode& bytecode, ShaderReflection* pOut)
+{
+    const u8* pData = static_cast<const u8*>(bytecode.pShaderBytecode);
+    const size_t size = bytecode.bytecodeLength;
+    if (pData == nullptr || size < 32 || ReadU32(pData) != MakeFourCC('D', 'X', 'B', 'C'))
+    {
+        return E_NOTIMPL;
+    }
+
+    const u8* pChunk = nullptr;
+    u32 chunkSize = 0;
+    HRESULT hr = S_OK;
+    if (FindDxbcChunk(pData, size, MakeFourCC('I', 'S', 'G', '1'), &pChunk, &chunkSize))
+    {
+        hr = ReadDxbcInputSignature(pChunk, chunkSize, true, &pOut->inputParameters);
+    }
+    else if (FindDxbcChunk(pData, size, MakeFourCC('I', 'S', 'G', 'N'), &pChunk, &chunkSize))
+    {
+        hr = ReadDxbcInputSignature(pChunk, chunkSize, false, &pOut->inputParameters);
+    }
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // DXIL は RDEF を持たない
+    if (!FindDxbcChunk(pData, size, MakeFourCC('R', 'D', 'E', 'F'), &pChunk, &chunkSize))
+    {
+        return E_NOTIMPL;
+    }
+    return ReadDxbcResourceDefinition(pChunk, chunkSize, &pOut->resourceBindings);
+}
+
+
+//-----------------------------------------------------------------
+// HLSL のソース (Null)
+//-----------------------------------------------------------------
+// 構造体や定数バッファのメンバー
+struct HlslMember
+{
+    std::string typeName;
+    std::string name;
+    std::string semantic;
+    u32         arraySize; // 配列でなければ 0
+};
+
+struct HlslStruct
+{
+    std::string             name;
+    std::vector<HlslMember> members;
+};
+
+
+static bool IsIdentifierChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+
+// 識別子 (数値を含む) と記号 1 文字に分ける (コメントとプリプロセッサの行は除く)
+static void TokenizeHlsl(const char* p, const char* pEnd, std::vector<std::string>* pOut)
+{
+    bool isLineStart = true;
+    while (p < pEnd)
+    {
+        const char c = *p;
+        if (c == '\n')
+        {
+            isLineStart = true;
+            p++;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            p++;
+        }
+        else if (c == '#' && isLineStart)
+        {
+            p = std::find(p, pEnd, '\n');
+        }
+        else if (c == '/' && p + 1 < pEnd && p[1] == '/')
+        {
+            p = std::find(p, pEnd, '\n');
+        }
+        else if (c == '/' && p + 1 < pEnd && p[1] == '*')
+        {
+            const char Terminator[] = "*/";
+            p = std::search(p + 2, pEnd, Terminator, Terminator + 2);
+            p = (p < pEnd) ? p + 2 : pEnd;
+        }
+        else if (IsIdentifierChar(c))
+        {
+            const char* pBegin = p;
+            while (p < pEnd && IsIdentifierChar(*p))
+            {
+                p++;
+            }
+            pOut->push_back(std::string(pBegin, p));
+            isLineStart = false;
+        }
+        else
+        {
+            pOut->push_back(std::string(1, c));
+            p++;
+            isLineStart = false;
+        }
+    }
+}
+
+
+// float3 / uint / float4x4 などの数値型 (行列は rows > 1)
+static bool ParseHlslNumericType(const std::string& name, SHADER_COMPONENT_TYPE* pComponentType, u32* pRows, u32* pColumns)
+{
+    static const struct
+    {
+        const char*           name;
+        SHADER_COMPONENT_TYPE componentType;
+    } BaseTypes[] = {
+        { "min16float", SHADER_COMPONENT_TYPE_FLOAT32 },
+        { "min10float", SHADER_COMPONENT_TYPE_FLOAT32 },
+        { "min16uint",  SHADER_COMPONENT_TYPE_UINT32 },
+        { "min16int",   SHADER_COMPONENT_TYPE_SINT32 },
+        { "min12int",   SHADER_COMPONENT_TYPE_SINT32 },
+        { "float",      SHADER_COMPONENT_TYPE_FLOAT32 },
+        { "half",       SHADER_COMPONENT_TYPE_FLOAT32 },
+        { "dword",      SHADER_COMPONENT_TYPE_UINT32 },
+        { "uint",       SHADER_COMPONENT_TYPE_UINT32 },
+        { "bool",       SHADER_COMPONENT_TYPE_UINT32 },
+        { "int",        SHADER_COMPONENT_TYPE_SINT32 },
+    };
+
+    for (const auto& baseType : BaseTypes)
+    {
+        const size_t length = std::strlen(baseType.name);
+        if (name.compare(0, length, baseType.name) != 0)
+        {
+            continue;
+        }
+
+        const std::string suffix = name.substr(length);
+        u32 rows = 1;
+        u32 columns = 1;
+        if (suffix.size() == 1 && suffix[0] >= '1' && suffix[0] <= '4')
+        {
+            columns = static_cast<u32>(suffix[0] - '0');
+        }
+        else if (suffix.size() == 3 && suffix[1] == 'x' && suffix[0] >= '1' && suffix[0] <= '4' && suffix[2] >= '1' && suffix[2] <= '4')
+        {
+            rows = static_cast<u32>(suffix[0] - '0');
+            columns = static_cast<u32>(suffix[2] - '0');
+        }
+        else if (!suffix.empty())
+        {
+            continue;
+        }
+
+        *pComponentType = baseType.componentType;
+        *pRows = rows;
+        *pColumns = columns;
+        return true;
+    }
+    return false;
+}
+
+
+static const HlslStruct* FindHlslStruct(const std::vector<HlslStruct>& structs, const std::string& name)
+{
+    for (const HlslStruct& hlslStruct : structs)
+    {
+        if (hlslStruct.name == name)
+        {
+            return &hlslStruct;
+        }
+    }
+    return nullptr;
+}
+
+
+static bool PackHlslMembers(const std::vector<HlslMember>& members, const std::vector<HlslStruct>& structs, u32* pSize);
+
+
+// 定数バッファの詰め方で 1 つ置く
+// 配列の要素、構造体、行列はレジスタ (16 バイト) の先頭から始まり、それ以外はレジスタを跨がない位置に置く
+static bool PackHlslMember(const HlslMember& member, const std::vector<HlslStruct>& structs, u32* pOffset)
+{
+    u32 elementSize = 0;
+    bool isAligned = member.arraySize > 0;
+
+    SHADER_COMPONENT_TYPE componentType = SHADER_COMPONENT_TYPE_UNKNOWN;
+    u32 rows = 0;
+    u32 columns = 0;
+    if (ParseHlslNumericType(member.typeName, &componentType, &rows, &columns))
+    {
+        // 行列は列優先 (列ごとに 1 レジスタ)
+        elementSize = (rows > 1) ? (columns - 1) * 16 + rows * 4 : columns * 4;
+        isAligned = isAligned || rows > 1;
+    }
+    else if (const HlslStruct* pStruct = FindHlslStruct(structs, member.typeName))
+    {
+        if (!PackHlslMembers(pStruct->members, structs, &elementSize))
+        {
+            return false;
+        }
+        isAligned = true;
+    }
+    else
+    {
+        return false;
+    }
+
+    const u32 count = std::max(member.arraySize, 1u);
+    const u32 size = RoundUp16(elementSize) * (count - 1) + elementSize;
+    if (isAligned || (*pOffset % 16) + size > 16)
+    {
+        *pOffset = RoundUp16(*pOffset);
+    }
+    *pOffset += size;
+    return true;
+}
+
+
+static bool PackHlslMembers(const std::vector<HlslMember>& members, const std::vector<HlslStruct>& structs, u32* pSize)
+{
+    u32 offset = 0;
+    for (const HlslMember& member : members)
+    {
+        if (!PackHlslMember(member, structs, &offset))
+        {
+            return false;
+        }
+    }
+    *pSize = offset;
+    return true;
+}
+
+
+// 字句を読み進める
+class HlslParser
+{
+public:
+    HlslParser(const std::vector<std::string>& tokens)
+        : m_Tokens(tokens)
+        , m_Index(0)
+    {
+
+    }
+
+    bool IsEnd() const
+    {
+        return m_Index >= m_Tokens.size();
+    }
+
+    const std::string& Peek(size_t offset = 0) const
+    {
+        static const std::string Empty;
+        return (m_Index + offset < m_Tokens.size()) ? m_Tokens[m_Index + offset] : Empty;
+    }
+
+    const std::string& Next()
+    {
+        const std::string& token = Peek();
+        m_Index++;
+        return token;
+    }
+
+    bool Accept(const char* token)
+    {
+        if (Peek() != token)
+        {
+            return false;
+        }
+        m_Index++;
+        return true;
+    }
+
+    // open から対応する close の次まで進める
+    void SkipBlock(const char* open, const char* close)
+    {
+        u32 depth = 0;
+        while (!IsEnd())
+        {
+            const std::string& token = Next();
+            if (token == open)
+            {
+                depth++;
+            }
+            else if (token == close && --depth == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    // [N] (無ければ 0、[] は無制限として 0xFFFFFFFF)
+    u32 ParseArraySize()
+    {
+        if (!Accept("["))
+        {
+            return 0;
+        }
+        u32 size = 0xFFFFFFFF;
+        if (Peek() != "]")
+        {
+            size = static_cast<u32>(std::strtoul(Next().c_str(), nullptr, 0));
+        }
+        Accept("]");
+        return size;
+    }
+
+    // : SEMANTIC または : register(xN, spaceM) (どちらも省略可)
+    void ParseAnnotation(std::string* pSemantic, char* pRegisterType, u32* pRegister, u32* pSpace)
+    {
+        while (Peek() == ":")
+        {
+            Next();
+            if (Peek() == "register" && Peek(1) == "(")
+            {
+                Next();
+                Next();
+                const std::string& slot = Next();
+                if (!slot.empty())
+                {
+                    *pRegisterType = static_cast<char>(std::tolower(static_cast<unsigned char>(slot[0])));
+                    *pRegister = static_cast<u32>(std::strtoul(slot.c_str() + 1, nullptr, 10));
+                }
+                if (Accept(","))
+                {
+                    const std::string& space = Next();
+                    *pSpace = (space.compare(0, 5, "space") == 0) ? static_cast<u32>(std::strtoul(space.c_str() + 5, nullptr, 10)) : 0;
+                }
+                Accept(")");
+            }
+            else if (pSemantic != nullptr)
+            {
+                *pSemantic = Next();
+            }
+            else
+            {
+                Next();
+            }
+        }
+    }
+
+    // { 型 名前 [N] : SEMANTIC; ... } (関数などのメンバー以外は飛ばす)
+    void ParseMembers(std::vector<HlslMember>* pOut)
+    {
+        if (!Accept("{"))
+        {
+            return;
+        }
+        while (!IsEnd() && !Accept("}"))
+        {
+            // 補間や行列の指定などの修飾子を飛ばす
+            std::vector<std::string> words;
+            while (!IsEnd() && Peek() != ";" && Peek() != ":" && Peek() != "[" && Peek() != "}" && Peek() != "(")
+            {
+                words.push_back(Next());
+            }
+            if (Peek() == "(")
+            {
+                SkipBlock("(", ")");
+                if (Peek() == "{")
+                {
+                    SkipBlock("{", "}");
+                }
+                Accept(";");
+                continue;
+            }
+
+            HlslMember member = {};
+            member.arraySize = ParseArraySize();
+            char registerType = 0;
+            u32 registerIndex = 0;
+            u32 space = 0;
+            ParseAnnotation(&member.semantic, &registerType, &registerIndex, &space);
+            Accept(";");
+
+            if (words.size() >= 2)
+            {
+                member.typeName = words[words.size() - 2];
+                member.name = words.back();
+                pOut->push_back(member);
+            }
+        }
+        Accept(";");
+    }
+
+private:
+    const std::vector<std::string>& m_Tokens;
+    size_t                          m_Index;
+};
+
+
+static bool IsHlslResourceType(const std::string& name, SHADER_RESOURCE_TYPE* pOut)
+{
+    if (name == "SamplerState" || name == "SamplerComparisonState")
+    {
+        *pOut = SHADER_RESOURCE_TYPE_SAMPLER;
+        return true;
+    }
+    if (name == "ConstantBuffer")
+    {
+        *pOut = SHADER_RESOURCE_TYPE_CBV;
+        return true;
+    }
+    if (name.compare(0, 2, "RW") == 0 || name == "AppendStructuredBuffer" || name == "ConsumeStructuredBuffer")
+    {
+        *pOut = SHADER_RESOURCE_TYPE_UAV;
+        return true;
+    }
+    if (name.compare(0, 7, "Texture") == 0 || name == "Buffer" || name == "StructuredBuffer" || name == "ByteAddressBuffer" || name == "RaytracingAccelerationStructure")
+    {
+        *pOut = SHADER_RESOURCE_TYPE_SRV;
+        return true;
+    }
+    return false;
+}
+
+
+static bool IsRegisterTypeOf(char registerType, SHADER_RESOURCE_TYPE type)
+{
+    switch (type)
+    {
+    case SHADER_RESOURCE_TYPE_CBV: return registerType == 'b';
+    case SHADER_RESOURCE_TYPE_SRV: return registerType == 't';
+    case SHADER_RESOURCE_TYPE_UAV: return registerType == 'u';
+    default:                       return registerType == 's';
+    }
+}
+
+
+// 入力の型を要素に展開する (行列は行ごとにセマンティクスの番号を増やす)
+static void AddHlslInput(const std::string& typeName, const std::string& semantic, std::vector<ShaderInputParameter>* pOut)
+{
+    ShaderInputParameter parameter = {};
+
+    // 末尾の数字は番号
+    size_t end = semantic.size();
+    while (end > 0 && std::isdigit(static_cast<unsigned char>(semantic[end - 1])))
+    {
+        end--;
+    }
+    parameter.semanticName = semantic.substr(0, end);
+    parameter.semanticIndex = static_cast<u32>(std::strtoul(semantic.c_str() + end, nullptr, 10));
+    parameter.isSystemValue = IsSystemValueSemantic(semantic);
+
+    u32 rows = 1;
+    u32 columns = 0;
+    if (!ParseHlslNumericType(typeName, &parameter.componentType, &rows, &columns))
+    {
+        parameter.componentType = SHADER_COMPONENT_TYPE_UNKNOWN;
+    }
+    parameter.componentCount = columns;
+
+    for (u32 i = 0; i < rows; i++)
+    {
+        pOut->push_back(parameter);
+        parameter.semanticIndex++;
+    }
+}
+
+
+static HRESULT ReflectHlslSource(const ShaderBytecode& bytecode, const std::string& entryPoint, ShaderReflection* pOut)
+{
+    const char* pSource = static_cast<const char*>(bytecode.pShaderBytecode);
+    if (pSource == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::vector<std::string> tokens;
+    TokenizeHlsl(pSource, pSource + bytecode.bytecodeLength, &tokens);
+
+    std::vector<HlslStruct> structs;
+    std::vector<char> registerTypes; // resourceBindings と同じ順
+    bool isEntryFound = false;
+
+    HlslParser parser(tokens);
+    while (!parser.IsEnd())
+    {
+        const std::string& token = parser.Peek();
+        SHADER_RESOURCE_TYPE resourceType = SHADER_RESOURCE_TYPE_SRV;
+
+        if (token == "struct")
+        {
+            parser.Next();
+            HlslStruct hlslStruct;
+            hlslStruct.name = parser.Next();
+            parser.ParseMembers(&hlslStruct.members);
+            structs.push_back(std::move(hlslStruct));
+        }
+        else if (token == "cbuffer" || token == "tbuffer")
+        {
+            parser.Next();
+            ShaderResourceBinding binding = {};
+            binding.type = (token == "cbuffer") ? SHADER_RESOURCE_TYPE_CBV : SHADER_RESOURCE_TYPE_SRV;
+            binding.name = parser.Next();
+            binding.bindPoint = UnassignedRegister;
+            binding.bindCount = 1;
+
+            char registerType = 0;
+            parser.ParseAnnotation(nullptr, &registerType, &binding.bindPoint, &binding.space);
+
+            // 分からない型があれば大きさは 0 (ルート定数にしない)
+            std::vector<HlslMember> members;
+            parser.ParseMembers(&members);
+            if (!PackHlslMembers(members, structs, &binding.size))
+            {
+                binding.size = 0;
+            }
+            binding.size = RoundUp16(binding.size);
+
+            pOut->resourceBindings.push_back(binding);
+            registerTypes.push_back(registerType);
+        }
+        else if (IsHlslResourceType(token, &resourceType))
+        {
+            parser.Next();
+
+            // ConstantBuffer<T> の T は大きさに使う
+            std::string templateType;
+            if (parser.Peek() == "<")
+            {
+                templateType = parser.Peek(1);
+                parser.SkipBlock("<", ">");
+            }
+
+            ShaderResourceBinding binding = {};
+            binding.type = resourceType;
+            binding.name = parser.Next();
+            binding.bindPoint = UnassignedRegister;
+            binding.bindCount = parser.ParseArraySize();
+            binding.bindCount = (binding.bindCount == 0) ? 1 : (binding.bindCount == 0xFFFFFFFF) ? 0 : binding.bindCount;
+
+            char registerType = 0;
+            parser.ParseAnnotation(nullptr, &registerType, &binding.bindPoint, &binding.space);
+            parser.Accept(";");
+
+            const HlslStruct* pStruct = FindHlslStruct(structs, templateType);
+            if (resourceType == SHADER_RESOURCE_TYPE_CBV && pStruct != nullptr && PackHlslMembers(pStruct->members, structs, &binding.size))
+            {
+                binding.size = RoundUp16(binding.size);
+            }
+
+            pOut->resourceBindings.push_back(binding);
+            registerTypes.push_back(registerType);
+        }
+        else if (token == "{")
+        {
+            parser.SkipBlock("{", "}");
+        }
+        else if (token == entryPoint && parser.Peek(1) == "(" && !isEntryFound)
+        {
+            parser.Next();
+            parser.Next();
+            isEntryFound = true;
+
+            // 引数: [修飾子] 型 名前 [: SEMANTIC] を , で区切ったもの (out は出力)
+            while (!parser.IsEnd() && !parser.Accept(")"))
+            {
+                std::vector<std::string> words;
+                while (!parser.IsEnd() && parser.Peek() != "," && parser.Peek() != ")" && parser.Peek() != ":" && parser.Peek() != "[")
+                {
+                    words.push_back(parser.Next());
+                }
+                parser.ParseArraySize();
+                std::string semantic;
+                char registerType = 0;
+                u32 registerIndex = 0;
+                u32 space = 0;
+                parser.ParseAnnotation(&semantic, &registerType, &registerIndex, &space);
+                parser.Accept(",");
+
+                if (words.size() < 2 || std::find(words.begin(), words.end(), "out") != words.end())
+                {
+                    continue;
+                }
+
+                const std::string& typeName = words[words.size() - 2];
+                if (const HlslStruct* pStruct = FindHlslStruct(structs, typeName))
+                {
+                    for (const HlslMember& member : pStruct->members)
+                    {
+                        AddHlslInput(member.typeName, member.semantic, &pOut->inputParameters);
+                    }
+                }
+                else if (!semantic.empty())
+                {
+                    AddHlslInput(typeName, semantic, &pOut->inputParameters);
+                }
+            }
+        }
+        else
+        {
+            parser.Next();
+        }
+    }
+
+    if (!isEntryFound)
+    {
+        return E_INVALIDARG;
+    }
+
+    // register() の無いものは宣言順に空いている番号を割り当てる
+    for (size_t i = 0; i < pOut->resourceBindings.size(); i++)
+    {
+        ShaderResourceBinding& binding = pOut->resourceBindings[i];
+        if (binding.bindPoint != UnassignedRegister && (registerTypes[i] == 0 || IsRegisterTypeOf(registerTypes[i], binding.type)))
+        {
+            continue;
+        }
+
+        binding.bindPoint = 0;
+        for (bool isUsed = true; isUsed;)
+        {
+            isUsed = false;
+            for (const ShaderResourceBinding& other : pOut->resourceBindings)
+            {
+                if (&other != &binding && other.type == binding.type && other.space == binding.space && other.bindPoint != UnassignedRegister
+                    && binding.bindPoint >= other.bindPoint && binding.bindPoint < other.bindPoint + std::max(other.bindCount, 1u))
+                {
+                    binding.bindPoint = other.bindPoint + std::max(other.bindCount, 1u);
+                    isUsed = true;
+                }
+            }
+        }
+    }
+    return S_OK;
+}
+
+
+//-----------------------------------------------------------------
+// ソフトウェア
+//-----------------------------------------------------------------
+static HRESULT ReflectSoftwareShader(const ShaderBytecode& bytecode, ShaderReflection* pOut)
+{
+    const SoftwareShader* pShader = FindSoftwareShader(bytecode);
+    if (pShader == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (u32 i = 0; i < pShader->numInputs; i++)
+    {
+        const SoftwareShaderInput& input = pShader->pInputs[i];
+
+        ShaderInputParameter parameter = {};
+        parameter.semanticName = input.semanticName;
+        parameter.semanticIndex = input.semanticIndex;
+        parameter.componentType = SHADER_COMPONENT_TYPE_FLOAT32;
+        parameter.componentCount = input.componentCount;
+        parameter.isSystemValue = IsSystemValueSemantic(parameter.semanticName);
+        pOut->inputParameters.push_back(parameter);
+    }
+    return S_OK;
+}
+
+
+//-----------------------------------------------------------------
+// ReflectShader / ValidateInputLayout
+//-----------------------------------------------------------------
+HRESULT ReflectShader(GRAPHICS_BACKEND backend, const ShaderCompileDesc& desc, const ShaderBytecode& bytecode, ShaderReflection* pOut)
+{
+    *pOut = ShaderReflection();
+    pOut->stage = GetShaderStage(desc.target);
+
+    switch (backend)
+    {
+    case GRAPHICS_BACKEND_D3D12:    return ReflectDxbc(bytecode, pOut);
+    case GRAPHICS_BACKEND_NULL:     return ReflectHlslSource(bytecode, desc.entryPoint, pOut);
+    case GRAPHICS_BACKEND_SOFTWARE: return ReflectSoftwareShader(bytecode, pOut);
+    default:                        return E_NOTIMPL;
+    }
+}
+
+
+static SHADER_COMPONENT_TYPE GetFormatComponentType(GRAPHICS_FORMAT format)
+{
+    switch (format)
+    {
+    case GRAPHICS_FORMAT_R8G8B8A8_UNORM:
+    case GRAPHICS_FORMAT_R32G32_FLOAT:
+    case GRAPHICS_FORMAT_R32G32B32_FLOAT:
+    case GRAPHICS_FORMAT_R32G32B32A32_FLOAT:
+    case GRAPHICS_FORMAT_D32_FLOAT:
+        return SHADER_COMPONENT_TYPE_FLOAT32;
+
+    case GRAPHICS_FORMAT_R16_UINT:
+    case GRAPHICS_FORMAT_R32_UINT:
+        return SHADER_COMPONENT_TYPE_UINT32;
+
+    default:
+        return SHADER_COMPONENT_TYPE_UNKNOWN;
+    }
+}
+
+
+HRESULT ValidateInputLayout(const ShaderReflection& vertexShader, const InputLayoutDesc& inputLayout, std::string* pErrorText)
+{
+    pErrorText->clear();
+
+    for (const ShaderInputParameter& parameter : vertexShader.inputParameters)
+    {
+        if (parameter.isSystemValue)
+        {
+            continue;
+        }
+
+        const std::string name = parameter.semanticName + std::to_string(parameter.semanticIndex);
+        const InputElementDesc* pElement = nullptr;
+        for (u32 i = 0; i < inputLayout.numElements; i++)
+        {
+            const InputElementDesc& element = inputLayout.pInputElementDescs[i];
+            if (IsSameText(element.semanticName, parameter.semanticName) && element.semanticIndex == parameter.semanticIndex)
+            {
+                pElement = &element;
+                break;
+            }
+        }
+
+        if (pElement == nullptr)
+        {
+            *pErrorText += "入力レイアウトに " + name + " がありません\n";
+            continue;
+        }
+
+        // 整数と浮動小数点数は変換されない
+        const SHADER_COMPONENT_TYPE formatType = GetFormatComponentType(pElement->format);
+        const bool isShaderInteger = parameter.componentType == SHADER_COMPONENT_TYPE_UINT32 || parameter.componentType == SHADER_COMPONENT_TYPE_SINT32;
+        const bool isFormatInteger = formatType == SHADER_COMPONENT_TYPE_UINT32 || formatType == SHADER_COMPONENT_TYPE_SINT32;
+        if (parameter.componentType != SHADER_COMPONENT_TYPE_UNKNOWN && formatType != SHADER_COMPONENT_TYPE_UNKNOWN && isShaderInteger != isFormatInteger)
+        {
+            *pErrorText += name + " の型が入力レイアウトの形式と合いません\n";
+        }
+    }
+
+    return pErrorText->empty() ? S_OK : E_INVALIDARG;
+}
+
+
+//-----------------------------------------------------------------
+// ReflectedRootSignature
+//-----------------------------------------------------------------
+ReflectedRootSignature::ReflectedRootSignature()
+    : m_Desc()
+    , m_Size(0)
+{
+
+}
+
+
+ReflectedRootSignature::~ReflectedRootSignature()
+{
+
+}
+
+
+HRESULT ReflectedRootSignature::Build(const ShaderReflection* const* ppStages, u32 stageCount)
+{
+    m_Parameters.clear();
+    m_Ranges.clear();
+    m_Bindings.clear();
+    m_Desc = RootSignatureDesc();
+    m_Size = 0;
+
+    // 段階をまたいで同じバインドをまとめる
+    struct MergedBinding
+    {
+        ShaderResourceBinding binding;
+        SHADER_VISIBILITY     visibility;
+        bool                  isRootConstants;
+    };
+    std::vector<MergedBinding> merged;
+    bool usesInputAssembler = false;
+
+    for (u32 i = 0; i < stageCount; i++)
+    {
+        const ShaderReflection& stage = *ppStages[i];
+        if (stage.stage == SHADER_VISIBILITY_VERTEX)
+        {
+            for (const ShaderInputParameter& parameter : stage.inputParameters)
+            {
+                usesInputAssembler = usesInputAssembler || !parameter.isSystemValue;
+            }
+        }
+
+        for (const ShaderResourceBinding& binding : stage.resourceBindings)
+        {
+            if (binding.bindCount == 0)
+            {
+                return E_NOTIMPL;
+            }
+
+            auto it = std::find_if(merged.begin(), merged.end(), [&binding](const MergedBinding& m)
+            {
+                return m.binding.type == binding.type && m.binding.space == binding.space && m.binding.bindPoint == binding.bindPoint;
+            });
+            if (it == merged.end())
+            {
+                MergedBinding m = { binding, stage.stage, false };
+                merged.push_back(m);
+                continue;
+            }
+            if (it->binding.bindCount != binding.bindCount || it->binding.size != binding.size)
+            {
+                return E_INVALIDARG;
+            }
+            if (it->visibility != stage.stage)
+            {
+                it->visibility = SHADER_VISIBILITY_ALL;
+            }
+        }
+    }
+
+    // 並びを決めておく (同じ入力なら同じルートシグネチャになる)
+    std::sort(merged.begin(), merged.end(), [](const MergedBinding& a, const MergedBinding& b)
+    {
+        if (a.binding.type != b.binding.type)
+        {
+            return a.binding.type < b.binding.type;
+        }
+        if (a.binding.space != b.binding.space)
+        {
+            return a.binding.space < b.binding.space;
+        }
+        return a.binding.bindPoint < b.binding.bindPoint;
+    });
+
+    // まず定数バッファを全てルート CBV (2 DWORD) とし、テーブル (1 DWORD) を数える
+    static const SHADER_VISIBILITY Visibilities[] = { SHADER_VISIBILITY_ALL, SHADER_VISIBILITY_VERTEX, SHADER_VISIBILITY_PIXEL };
+    u32 size = 0;
+    for (SHADER_VISIBILITY visibility : Visibilities)
+    {
+        bool hasViews = false;
+        bool hasSamplers = false;
+        for (const MergedBinding& m : merged)
+        {
+            if (m.visibility == visibility)
+            {
+                hasViews = hasViews || m.binding.type == SHADER_RESOURCE_TYPE_SRV || m.binding.type == SHADER_RESOURCE_TYPE_UAV;
+                hasSamplers = hasSamplers || m.binding.type == SHADER_RESOURCE_TYPE_SAMPLER;
+            }
+        }
+        size += (hasViews ? 1 : 0) + (hasSamplers ? 1 : 0);
+    }
+
+    std::vector<MergedBinding*> constantBuffers;
+    for (MergedBinding& m : merged)
+    {
+        if (m.binding.type == SHADER_RESOURCE_TYPE_CBV)
+        {
+            size += 2 * m.binding.bindCount;
+            constantBuffers.push_back(&m);
+        }
+    }
+
+    // 小さいものから、収まる限りルート定数にする (大きさが分からないもの、配列はしない)
+    std::stable_sort(constantBuffers.begin(), constantBuffers.end(), [](const MergedBinding* a, const MergedBinding* b) { return a->binding.size < b->binding.size; });
+    for (MergedBinding* pConstantBuffer : constantBuffers)
+    {
+        const u32 num32BitValues = pConstantBuffer->binding.size / 4;
+        if (num32BitValues == 0 || num32BitValues > MaxRootConstantsPerBuffer || pConstantBuffer->binding.bindCount != 1 || size + num32BitValues - 2 > MaxRootSignatureSize)
+        {
+            continue;
+        }
+        pConstantBuffer->isRootConstants = true;
+        size = size + num32BitValues - 2;
+    }
+    if (size > MaxRootSignatureSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    // ルート定数、ルート CBV
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (const MergedBinding& m : merged)
+        {
+            if (m.binding.type != SHADER_RESOURCE_TYPE_CBV || m.isRootConstants != (pass == 0))
+            {
+                continue;
+            }
+            for (u32 i = 0; i < m.binding.bindCount; i++)
+            {
+                RootParameter parameter = {};
+                parameter.parameterType = m.isRootConstants ? ROOT_PARAMETER_TYPE_32BIT_CONSTANTS : ROOT_PARAMETER_TYPE_CBV;
+                parameter.shaderVisibility = m.visibility;
+                parameter.shaderRegister = m.binding.bindPoint + i;
+                parameter.registerSpace = m.binding.space;
+                parameter.num32BitValues = m.isRootConstants ? m.binding.size / 4 : 0;
+
+                // 配列は先頭の要素だけを名前で引けるようにする
+                if (i == 0)
+                {
+                    ShaderRootBinding binding = { m.binding.name, m.binding.type, m.binding.bindPoint, m.binding.space, static_cast<u32>(m_Parameters.size()), 0, parameter.num32BitValues };
+                    m_Bindings.push_back(binding);
+                }
+                m_Parameters.push_back(parameter);
+            }
+        }
+    }
+
+    // テーブル (SRV / UAV、サンプラーの順に可視性ごと)
+    // 連続したレジスタは 1 つのレンジにまとめる
+    std::vector<size_t> firstRanges;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (SHADER_VISIBILITY visibility : Visibilities)
+        {
+            const size_t firstRange = m_Ranges.size();
+            u32 tableOffset = 0;
+            for (const MergedBinding& m : merged)
+            {
+                const bool isSampler = m.binding.type == SHADER_RESOURCE_TYPE_SAMPLER;
+                if (m.visibility != visibility || m.binding.type == SHADER_RESOURCE_TYPE_CBV || isSampler != (pass == 1))
+                {
+                    continue;
+                }
+
+                const DESCRIPTOR_RANGE_TYPE rangeType =
+                    m.binding.type == SHADER_RESOURCE_TYPE_SRV ? DESCRIPTOR_RANGE_TYPE_SRV :
+                    m.binding.type == SHADER_RESOURCE_TYPE_UAV ? DESCRIPTOR_RANGE_TYPE_UAV :
+                    DESCRIPTOR_RANGE_TYPE_SAMPLER;
+
+                DescriptorRange* pLast = (m_Ranges.size() > firstRange) ? &m_Ranges.back() : nullptr;
+                if (pLast != nullptr && pLast->rangeType == rangeType && pLast->registerSpace == m.binding.space && pLast->baseShaderRegister + pLast->numDescriptors == m.binding.bindPoint)
+                {
+                    pLast->numDescriptors += m.binding.bindCount;
+                }
+                else
+                {
+                    DescriptorRange range = { rangeType, m.binding.bindCount, m.binding.bindPoint, m.binding.space, tableOffset };
+                    m_Ranges.push_back(range);
+                }
+
+                ShaderRootBinding binding = { m.binding.name, m.binding.type, m.binding.bindPoint, m.binding.space, static_cast<u32>(m_Parameters.size()), tableOffset, 0 };
+                m_Bindings.push_back(binding);
+                tableOffset += m.binding.bindCount;
+            }
+
+            if (m_Ranges.size() > firstRange)
+            {
+                RootParameter parameter = {};
+                parameter.parameterType = ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+                parameter.shaderVisibility = visibility;
+                parameter.numDescriptorRanges = static_cast<u32>(m_Ranges.size() - firstRange);
+                m_Parameters.push_back(parameter);
+                firstRanges.push_back(firstRange);
+            }
+        }
+    }
+
+    // レンジの配列が確定してから指す
+    size_t tableIndex = 0;
+    for (RootParameter& parameter : m_Parameters)
+    {
+        if (parameter.parameterType == ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+        {
+            parameter.pDescriptorRanges = m_Ranges.data() + firstRanges[tableIndex++];
+        }
+    }
+
+    // 使わない段階からはルートシグネチャを見えなくする
+    u32 flags = usesInputAssembler ? ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT : ROOT_SIGNATURE_FLAG_NONE;
+    bool isVertexVisible = false;
+    bool isPixelVisible = false;
+    for (const RootParameter& parameter : m_Parameters)
+    {
+        isVertexVisible = isVertexVisible || parameter.shaderVisibility != SHADER_VISIBILITY_PIXEL;
+        isPixelVisible = isPixelVisible || parameter.shaderVisibility != SHADER_VISIBILITY_VERTEX;
+    }
+    if (!isVertexVisible)
+    {
+        flags |= ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
+    }
+    if (!isPixelVisible)
+    {
+        flags |= ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
+    }
+
+    m_Desc.numParameters = static_cast<u32>(m_Parameters.size());
+    m_Desc.pParameters = m_Parameters.data();
+    m_Desc.flags = static_cast<ROOT_SIGNATURE_FLAG>(flags);
+    m_Size = size;
+    return S_OK;
+}
+
+
+const RootSignatureDesc& ReflectedRootSignature::GetDesc() const
+{
+    return m_Desc;
+}
+
+
+const ShaderRootBinding* ReflectedRootSignature::FindBinding(const char* name) const
+{
+    for (const ShaderRootBinding& binding : m_Bindings)
+    {
+        if (binding.name == name)
+        {
+            return &binding;
+        }
+    }
+    return nullptr;
+}
+
+
+const std::vector<ShaderRootBinding>& ReflectedRootSignature::GetBindings() const
+{
+    return m_Bindings;
+}
+
+
+u32 ReflectedRootSignature::GetSize() const
+{
+    return m_Size;
+}
@@ -0,0 +1,131 @@
+﻿#pragma once
+
+
+// シェーダーのリフレクション
+// バイトコードから頂点入力とリソースのバインドを取り出し、
+// 最小のルートシグネチャを作ったり、入力レイアウトが合っているかを確かめたりする
+//
+// バイトコードの形式はバックエンドごとに違う
+//   D3D12      : DXBC (ISGN / ISG1 と RDEF を読む、d3dcompiler は使わない)
+//   Null       : HLSL のソース (宣言を簡易的に読む、#include は展開しない)
+//   ソフトウェア : SoftwareShader の表
+// リソースの register() を省略した場合、Null は宣言順に空いている番号を割り当てる (コンパイラと違うことがある)
+
+
+// 値の種類
+enum SHADER_COMPONENT_TYPE
+{
+    SHADER_COMPONENT_TYPE_UNKNOWN
+
+    , SHADER_COMPONENT_TYPE_FLOAT32
+    , SHADER_COMPONENT_TYPE_UINT32
+    , SHADER_COMPONENT_TYPE_SINT32
+};
+
+
+// リソースの種類 (ルートシグネチャでの扱いで分ける)
+enum SHADER_RESOURCE_TYPE
+{
+    SHADER_RESOURCE_TYPE_CBV
+
+    , SHADER_RESOURCE_TYPE_SRV
+    , SHADER_RESOURCE_TYPE_UAV
+    , SHADER_RESOURCE_TYPE_SAMPLER
+};
+
+
+// 頂点シェーダーなどの入力
+struct ShaderInputParameter
+{
+    std::string           semanticName;
+    u32                   semanticIndex;
+    SHADER_COMPONENT_TYPE componentType;
+    u32                   componentCount;
+    bool                  isSystemValue; // SV_VertexID など (入力レイアウトからは来ない)
+};
+
+
+// リソースのバインド
+struct ShaderResourceBinding
+{
+    std::string          name;
+    SHADER_RESOURCE_TYPE type;
+    u32                  bindPoint;
+    u32                  bindCount;  // 配列の要素数 (0 は無制限)
+    u32                  space;
+    u32                  size;       // 定数バッファのバイト数
+};
+
+
+struct ShaderReflection
+{
+    SHADER_VISIBILITY                  stage;
+    std::vector<ShaderInputParameter>  inputParameters;
+    std::vector<ShaderResourceBinding> resourceBindings;
+};
+
+
+// desc はシェーダーの段階 (target) と、Null でソースからエントリポイントを探すのに使う
+// 読めない形式なら E_NOTIMPL、壊れていれば E_INVALIDARG
+HRESULT ReflectShader(GRAPHICS_BACKEND backend, const ShaderCompileDesc& desc, const ShaderBytecode& bytecode, ShaderReflection* pOut);
+
+// 頂点シェーダーの入力が全て入力レイアウトにあり、値の種類が合っているか
+// (要素数は少なくてもよい、足りない成分は 0 か 1 になる)
+HRESULT ValidateInputLayout(const ShaderReflection& vertexShader, const InputLayoutDesc& inputLayout, std::string* pErrorText);
+
+
+// ルートシグネチャのどこにバインドするか
+struct ShaderRootBinding
+{
+    std::string          name;
+    SHADER_RESOURCE_TYPE type;
+    u32                  bindPoint;
+    u32                  space;
+    u32                  rootParameterIndex;
+    u32                  tableOffset;     // ディスクリプタテーブルの中の位置
+    u32                  num32BitValues;  // ルート定数にしたもの (それ以外は 0)
+};
+
+
+// リフレクションから作ったルートシグネチャの設定 (GetDesc が指す配列を持つ)
+// 定数バッファは小さいものからルート定数にし (MaxRootConstantsPerBuffer まで、全体の上限内で)、
+// 残りはルート CBV、SRV / UAV とサンプラーは可視性ごとに 1 つのテーブルにまとめる
+// パラメータは頻繁に変わるもの (ルート定数、ルート CBV、テーブル) の順に並べる
+class ReflectedRootSignature
+{
+public:
+    // ルート定数にする定数バッファの大きさの上限 [DWORD]
+    static const u32 MaxRootConstantsPerBuffer = 16;
+
+    // ルートシグネチャ全体の大きさの上限 [DWORD]
+    static const u32 MaxRootSignatureSize = 64;
+
+    ReflectedRootSignature();
+
+    ~ReflectedRootSignature();
+
+    // 同じバインドが複数の段階にあれば共有する (種類か大きさが違えば E_INVALIDARG)
+    // 無制限の配列は E_NOTIMPL
+    HRESULT Build(const ShaderReflection* const* ppStages, u32 stageCount);
+
+    const RootSignatureDesc& GetDesc() const;
+
+    // 名前から探す (無ければ nullptr)
+    const ShaderRootBinding* FindBinding(const char* name) const;
+
+    const std::vector<ShaderRootBinding>& GetBindings() const;
+
+    // ルートシグネチャの大きさ [DWORD]
+    u32 GetSize() const;
+
+private:
+    ReflectedRootSignature(const ReflectedRootSignature&) = delete;
+    ReflectedRootSignature& operator=(const ReflectedRootSignature&) = delete;
+
+private:
+    std::vector<RootParameter>     m_Parameters;
+    std::vector<DescriptorRange>   m_Ranges;
+    std::vector<ShaderRootBinding> m_Bindings;
+    RootSignatureDesc              m_Desc;
+    u32                            m_Size;
+};
@@ -0,0 +1,40 @@
+﻿
+
+GraphicsDeviceSoftware::GraphicsDeviceSoftware()
+{
+
+}
+
+
+GraphicsDeviceSoftware::~GraphicsDeviceSoftware()
+{
+    m_Rasterizer.Term();
+}
+
+
+bool GraphicsDeviceSoftware::Init(u32 workerCount, f64 emulatedGpuMilliseconds)
+{
+    if (!m_Rasterizer.Init(workerCount))
+    {
+        return false;
+    }
+    return GraphicsDeviceNull::Init(&m_Rasterizer, emulatedGpuMilliseconds);
+}
+
+
+GRAPHICS_BACKEND GraphicsDeviceSoftware::GetBackend() const
+{
+    return GRAPHICS_BACKEND_SOFTWARE;
+}
+
+
+void GraphicsDeviceSoftware::GetStatistics(GraphicsStatistics* pOut) const
+{
+    GraphicsDeviceNull::GetStatistics(pOut);
+
+    SoftwareRasterizerStatistics statistics = {};
+    m_Rasterizer.GetStatistics(&statistics);
+    pOut->triangleCount = statistics.triangleCount;
+    pOut->pixelCount = statistics.pixelCount;
+    pOut->rasterizeMilliseconds = statistics.rasterizeMilliseconds;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+
+// ソフトウェアバックエンド
+// Null バックエンドのリソース・コマンド記録をそのまま使い、実行時に SoftwareRasterizer で描画する
+class GraphicsDeviceSoftware : public GraphicsDeviceNull
+{
+public:
+    GraphicsDeviceSoftware();
+
+    ~GraphicsDeviceSoftware();
+
+    // workerCount が 0 ならハードウェアスレッド数
+    // emulatedGpuMilliseconds は GraphicsDeviceNull::Init を参照
+    bool Init(u32 workerCount, f64 emulatedGpuMilliseconds);
+
+    virtual GRAPHICS_BACKEND GetBackend() const override;
+
+    virtual void GetStatistics(GraphicsStatistics* pOut) const override;
+
+private:
+    SoftwareRasterizer m_Rasterizer;
+};
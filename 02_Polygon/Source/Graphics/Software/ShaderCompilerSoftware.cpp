@@ -0,0 +1,48 @@
+﻿
+
+ShaderCompilerSoftware::ShaderCompilerSoftware()
+{
+
+}
+
+
+ShaderCompilerSoftware::~ShaderCompilerSoftware()
+{
+
+}
+
+
+HRESULT ShaderCompilerSoftware::CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText)
+{
+    std::FILE* pFile = std::fopen(desc.filePath.c_str(), "rb");
+    if (pFile == nullptr)
+    {
+        *pErrorText = desc.filePath;
+        return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+    }
+    std::fclose(pFile);
+
+    // ファイル名 (拡張子なし) とエントリポイントから名前を作る
+    std::string::size_type begin = desc.filePath.find_last_of("/\\");
+    begin = begin != std::string::npos ? begin + 1 : 0;
+
+    std::string::size_type end = desc.filePath.find_last_of('.');
+    end = end != std::string::npos && end > begin ? end : desc.filePath.size();
+
+    const std::string name = desc.filePath.substr(begin, end - begin) + "/" + desc.entryPoint;
+
+    if (FindSoftwareShader(name) == nullptr)
+    {
+        *pErrorText = "ソフトウェア実装がありません: " + name;
+        return E_NOTIMPL;
+    }
+
+    MakeSoftwareShaderBytecode(name, pBytecode);
+    return S_OK;
+}
+
+
+const char* ShaderCompilerSoftware::GetIdentifier() const
+{
+    return GetShaderCompilerIdentifier(GRAPHICS_BACKEND_SOFTWARE);
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+
+
+// ソフトウェアバックエンド用のシェーダーコンパイラ
+// ソースファイルの存在を確認し、対応する C++ 実装を指すバイトコードを返す
+class ShaderCompilerSoftware : public IShaderCompiler
+{
+public:
+    ShaderCompilerSoftware();
+
+    ~ShaderCompilerSoftware();
+
+    virtual HRESULT CompileFromFile(const ShaderCompileDesc& desc, std::vector<u8>* pBytecode, std::string* pErrorText) override;
+
+    virtual const char* GetIdentifier() const override;
+};
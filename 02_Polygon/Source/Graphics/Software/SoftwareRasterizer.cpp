@@ -0,0 +1,886 @@
+﻿
+
+// 並列に頂点シェーダーを実行する 1 タスクあたりの頂点数
+static const u32 VertexShadingChunkSize = 1024;
+
+
+// 色を R8G8B8A8 に詰める
+static u32 PackColor(f32 r, f32 g, f32 b, f32 a)
+{
+    const f32 color[4] = { r, g, b, a };
+    u32 packed = 0;
+    for (u32 i = 0; i < 4; ++i)
+    {
+        f32 value = std::min(std::max(color[i], 0.0f), 1.0f);
+        packed |= static_cast<u32>(value * 255.0f + 0.5f) << (i * 8);
+    }
+    return packed;
+}
+
+
+// COLOR_WRITE_ENABLE をバイト単位のマスクに展開
+static u32 ExpandWriteMask(u8 renderTargetWriteMask)
+{
+    u32 mask = 0;
+    for (u32 i = 0; i < 4; ++i)
+    {
+        if (renderTargetWriteMask & (1 << i))
+        {
+            mask |= 0xFFu << (i * 8);
+        }
+    }
+    return mask;
+}
+
+
+static u32 CountBits(u32 value)
+{
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    value = (value + (value >> 4)) & 0x0F0F0F0F;
+    return (value * 0x01010101) >> 24;
+}
+
+
+// 1 行分を塗る (e0 ～ e2 は先頭ピクセルのエッジ関数、dx0 ～ dx2 は 1 ピクセルあたりの増分)
+// 戻り値は書き込んだピクセル数
+static u32 RasterizeRow(u32* pDst, s32 count, s32 e0, s32 e1, s32 e2, s32 dx0, s32 dx1, s32 dx2, u32 color, u32 writeMask)
+{
+    u32 pixelCount = 0;
+    s32 x = 0;
+
+#if defined(SIMD_ENABLE_AVX2)
+    {
+        __m256i ve0 = _mm256_setr_epi32(e0, e0 + dx0, e0 + dx0 * 2, e0 + dx0 * 3, e0 + dx0 * 4, e0 + dx0 * 5, e0 + dx0 * 6, e0 + dx0 * 7);
+        __m256i ve1 = _mm256_setr_epi32(e1, e1 + dx1, e1 + dx1 * 2, e1 + dx1 * 3, e1 + dx1 * 4, e1 + dx1 * 5, e1 + dx1 * 6, e1 + dx1 * 7);
+        __m256i ve2 = _mm256_setr_epi32(e2, e2 + dx2, e2 + dx2 * 2, e2 + dx2 * 3, e2 + dx2 * 4, e2 + dx2 * 5, e2 + dx2 * 6, e2 + dx2 * 7);
+        const __m256i vstep0 = _mm256_set1_epi32(dx0 * 8);
+        const __m256i vstep1 = _mm256_set1_epi32(dx1 * 8);
+        const __m256i vstep2 = _mm256_set1_epi32(dx2 * 8);
+        const __m256i vcolor = _mm256_set1_epi32(static_cast<s32>(color & writeMask));
+        const __m256i vwriteMask = _mm256_set1_epi32(static_cast<s32>(writeMask));
+        for (; x + 8 <= count; x += 8)
+        {
+            // 3 辺とも符号ビットが立っていないレーンが内側
+            __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(ve0, ve1), ve2), 31);
+            u32 laneMask = static_cast<u32>(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) ^ 0xFF;
+            if (laneMask != 0)
+            {
+                __m256i* pPixels = reinterpret_cast<__m256i*>(pDst + x);
+                __m256i mask = _mm256_andnot_si256(outside, vwriteMask);
+                __m256i dst = _mm256_loadu_si256(pPixels);
+                _mm256_storeu_si256(pPixels, _mm256_or_si256(_mm256_andnot_si256(mask, dst), _mm256_and_si256(mask, vcolor)));
+                pixelCount += CountBits(laneMask);
+            }
+            ve0 = _mm256_add_epi32(ve0, vstep0);
+            ve1 = _mm256_add_epi32(ve1, vstep1);
+            ve2 = _mm256_add_epi32(ve2, vstep2);
+        }
+    }
+#elif defined(SIMD_ENABLE_SSE2)
+    {
+        __m128i ve0 = _mm_setr_epi32(e0, e0 + dx0, e0 + dx0 * 2, e0 + dx0 * 3);
+        __m128i ve1 = _mm_setr_epi32(e1, e1 + dx1, e1 + dx1 * 2, e1 + dx1 * 3);
+        __m128i ve2 = _mm_setr_epi32(e2, e2 + dx2, e2 + dx2 * 2, e2 + dx2 * 3);
+        const __m128i vstep0 = _mm_set1_epi32(dx0 * 4);
+        const __m128i vstep1 = _mm_set1_epi32(dx1 * 4);
+        const __m128i vstep2 = _mm_set1_epi32(dx2 * 4);
+        const __m128i vcolor = _mm_set1_epi32(static_cast<s32>(color & writeMask));
+        const __m128i vwriteMask = _mm_set1_epi32(static_cast<s32>(writeMask));
+        for (; x + 4 <= count; x += 4)
+        {
+            // 3 辺とも符号ビットが立っていないレーンが内側
+            __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(ve0, ve1), ve2), 31);
+            u32 laneMask = static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(outside))) ^ 0xF;
+            if (laneMask != 0)
+            {
+                __m128i* pPixels = reinterpret_cast<__m128i*>(pDst + x);
+                __m128i mask = _mm_andnot_si128(outside, vwriteMask);
+                __m128i dst = _mm_loadu_si128(pPixels);
+                _mm_storeu_si128(pPixels, _mm_or_si128(_mm_andnot_si128(mask, dst), _mm_and_si128(mask, vcolor)));
+                pixelCount += CountBits(laneMask);
+            }
+            ve0 = _mm_add_epi32(ve0, vstep0);
+            ve1 = _mm_add_epi32(ve1, vstep1);
+            ve2 = _mm_add_epi32(ve2, vstep2);
+        }
+    }
+#endif
+
+    // 残り
+    e0 += dx0 * x;
+    e1 += dx1 * x;
+    e2 += dx2 * x;
+    for (; x < count; ++x)
+    {
+        if ((e0 | e1 | e2) >= 0)
+        {
+            pDst[x] = (pDst[x] & ~writeMask) | (color & writeMask);
+            ++pixelCount;
+        }
+        e0 += dx0;
+        e1 += dx1;
+        e2 += dx2;
+    }
+    return pixelCount;
+}
+
+
+SoftwareRasterizer::SoftwareRasterizer()
+    : m_State()
+    , m_pPendingTarget(nullptr)
+    , m_TileCountX(0)
+    , m_TileCountY(0)
+    , m_pTask(nullptr)
+    , m_TaskCount(0)
+    , m_NextTask(0)
+    , m_Generation(0)
+    , m_RunningWorkers(0)
+    , m_IsTerminating(false)
+    , m_Statistics()
+{
+
+}
+
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+    Term();
+}
+
+
+bool SoftwareRasterizer::Init(u32 workerCount)
+{
+    if (workerCount == 0)
+    {
+        workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // ワーカー 0 は呼び出しスレッド
+    m_IsTerminating = false;
+    m_WorkerCounters.resize(workerCount);
+    for (u32 i = 1; i < workerCount; ++i)
+    {
+        m_Workers.emplace_back(&SoftwareRasterizer::WorkerMain, this, i);
+    }
+    m_Bins.resize(workerCount);
+    return true;
+}
+
+
+void SoftwareRasterizer::Term()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_IsTerminating = true;
+    }
+    m_StartCondition.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+    m_Workers.clear();
+    m_WorkerCounters.clear();
+    m_Bins.clear();
+}
+
+
+void SoftwareRasterizer::Execute(const NullCommandStream& commandStream)
+{
+    std::lock_guard<std::mutex> lock(m_ExecuteMutex);
+
+    // コマンドリストごとに状態は初期値から始まる
+    m_State = State();
+
+    for (const NullCommandHeader* pHeader = commandStream.GetFirst(); pHeader != nullptr; pHeader = commandStream.GetNext(pHeader))
+    {
+        switch (pHeader->type)
+        {
+        case NULL_COMMAND_TYPE_OM_SET_RENDER_TARGETS:
+            {
+                const NullCommand_OMSetRenderTargets* pCommand = reinterpret_cast<const NullCommand_OMSetRenderTargets*>(pHeader);
+                const CpuDescriptorHandle* pHandles = NullCommandStream::GetArray<NullCommand_OMSetRenderTargets, CpuDescriptorHandle>(pCommand);
+                m_State.pRenderTarget = (pCommand->numRenderTargets > 0) ? GetRenderTarget(pHandles[0]) : nullptr;
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_CLEAR_RENDER_TARGET_VIEW:
+            {
+                const NullCommand_ClearRenderTargetView* pCommand = reinterpret_cast<const NullCommand_ClearRenderTargetView*>(pHeader);
+                ClearRenderTarget(pCommand->renderTarget, pCommand->color);
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_SET_PIPELINE_STATE:
+            {
+                const NullCommand_SetPipelineState* pCommand = reinterpret_cast<const NullCommand_SetPipelineState*>(pHeader);
+                m_State.pPipelineState = static_cast<GraphicsPipelineStateNull*>(pCommand->pPipelineState);
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_RS_SET_VIEWPORTS:
+            {
+                const NullCommand_RSSetViewports* pCommand = reinterpret_cast<const NullCommand_RSSetViewports*>(pHeader);
+                m_State.hasViewport = pCommand->numViewports > 0;
+                if (m_State.hasViewport)
+                {
+                    m_State.viewport = NullCommandStream::GetArray<NullCommand_RSSetViewports, Viewport>(pCommand)[0];
+                }
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_RS_SET_SCISSOR_RECTS:
+            {
+                const NullCommand_RSSetScissorRects* pCommand = reinterpret_cast<const NullCommand_RSSetScissorRects*>(pHeader);
+                m_State.hasScissor = pCommand->numRects > 0;
+                if (m_State.hasScissor)
+                {
+                    m_State.scissor = NullCommandStream::GetArray<NullCommand_RSSetScissorRects, Rect>(pCommand)[0];
+                }
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_IA_SET_PRIMITIVE_TOPOLOGY:
+            {
+                const NullCommand_IASetPrimitiveTopology* pCommand = reinterpret_cast<const NullCommand_IASetPrimitiveTopology*>(pHeader);
+                m_State.topology = pCommand->primitiveTopology;
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_IA_SET_VERTEX_BUFFERS:
+            {
+                const NullCommand_IASetVertexBuffers* pCommand = reinterpret_cast<const NullCommand_IASetVertexBuffers*>(pHeader);
+                const VertexBufferView* pViews = NullCommandStream::GetArray<NullCommand_IASetVertexBuffers, VertexBufferView>(pCommand);
+                for (u32 i = 0; i < pCommand->numViews && pCommand->startSlot + i < _countof(m_State.vertexBuffers); ++i)
+                {
+                    m_State.vertexBuffers[pCommand->startSlot + i] = pViews[i];
+                }
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_IA_SET_INDEX_BUFFER:
+            {
+                const NullCommand_IASetIndexBuffer* pCommand = reinterpret_cast<const NullCommand_IASetIndexBuffer*>(pHeader);
+                m_State.hasIndexBuffer = pCommand->hasView;
+                m_State.indexBuffer = pCommand->view;
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_DRAW_INSTANCED:
+            {
+                const NullCommand_DrawInstanced* pCommand = reinterpret_cast<const NullCommand_DrawInstanced*>(pHeader);
+                EnqueueDraw(pCommand->vertexCountPerInstance, pCommand->instanceCount, pCommand->startVertexLocation, 0, false);
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_DRAW_INDEXED_INSTANCED:
+            {
+                const NullCommand_DrawIndexedInstanced* pCommand = reinterpret_cast<const NullCommand_DrawIndexedInstanced*>(pHeader);
+                EnqueueDraw(pCommand->indexCountPerInstance, pCommand->instanceCount, pCommand->startIndexLocation, pCommand->baseVertexLocation, true);
+            }
+            break;
+
+        case NULL_COMMAND_TYPE_COPY_BUFFER_REGION:
+            {
+                // 描画結果に依存しないので積まれた描画を待たなくてよい
+                const NullCommand_CopyBufferRegion* pCommand = reinterpret_cast<const NullCommand_CopyBufferRegion*>(pHeader);
+                GraphicsResourceNull* pDst = static_cast<GraphicsResourceNull*>(pCommand->pDstBuffer);
+                GraphicsResourceNull* pSrc = static_cast<GraphicsResourceNull*>(pCommand->pSrcBuffer);
+                if (pCommand->dstOffset + pCommand->numBytes <= pDst->GetDataSize() && pCommand->srcOffset + pCommand->numBytes <= pSrc->GetDataSize())
+                {
+                    std::memmove(pDst->GetData() + pCommand->dstOffset, pSrc->GetData() + pCommand->srcOffset, static_cast<size_t>(pCommand->numBytes));
+                }
+            }
+            break;
+
+        default:
+            // バリアやルート引数は描画に影響しない
+            break;
+        }
+    }
+
+    Flush();
+}
+
+
+void SoftwareRasterizer::GetStatistics(SoftwareRasterizerStatistics* pOut) const
+{
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    *pOut = m_Statistics;
+}
+
+
+u32 SoftwareRasterizer::GetWorkerCount() const
+{
+    return static_cast<u32>(m_WorkerCounters.size());
+}
+
+
+GraphicsResourceNull* SoftwareRasterizer::GetRenderTarget(CpuDescriptorHandle handle)
+{
+    const NullDescriptor* pDescriptor = reinterpret_cast<const NullDescriptor*>(handle.ptr);
+    if (pDescriptor == nullptr || pDescriptor->pResource == nullptr)
+    {
+        return nullptr;
+    }
+
+    GraphicsResourceNull* pResource = static_cast<GraphicsResourceNull*>(pDescriptor->pResource);
+    const ResourceDesc& desc = pResource->GetDesc();
+    if (desc.dimension != RESOURCE_DIMENSION_TEXTURE2D || desc.format != GRAPHICS_FORMAT_R8G8B8A8_UNORM)
+    {
+        return nullptr; // 対応していない形式
+    }
+    return pResource;
+}
+
+
+void SoftwareRasterizer::ClearRenderTarget(CpuDescriptorHandle handle, const f32 color[4])
+{
+    GraphicsResourceNull* pTarget = GetRenderTarget(handle);
+    if (pTarget == nullptr)
+    {
+        return;
+    }
+    if (pTarget == m_pPendingTarget)
+    {
+        Flush(); // 先に積まれた描画を反映する
+    }
+
+    const u32 packed = PackColor(color[0], color[1], color[2], color[3]);
+    u32* pPixels = reinterpret_cast<u32*>(pTarget->GetData());
+    std::fill_n(pPixels, pTarget->GetDataSize() / sizeof(u32), packed);
+}
+
+
+void SoftwareRasterizer::EnqueueDraw(u32 vertexCount, u32 instanceCount, u32 startLocation, s32 baseVertexLocation, bool isIndexed)
+{
+    // D3D12 と同じく、ビューポートとシザー矩形が無ければ何も描かない
+    if (m_State.pRenderTarget == nullptr || m_State.pPipelineState == nullptr || !m_State.hasViewport || !m_State.hasScissor)
+    {
+        return;
+    }
+    if (m_State.topology != PRIMITIVE_TOPOLOGY_TRIANGLELIST && m_State.topology != PRIMITIVE_TOPOLOGY_TRIANGLESTRIP)
+    {
+        return;
+    }
+    if (vertexCount < 3 || instanceCount == 0 || (isIndexed && !m_State.hasIndexBuffer))
+    {
+        return;
+    }
+
+    const GraphicsPipelineStateDesc& pipelineDesc = m_State.pPipelineState->GetDesc();
+    const SoftwareShader* pVertexShader = FindSoftwareShader(pipelineDesc.VS);
+    const SoftwareShader* pPixelShader = FindSoftwareShader(pipelineDesc.PS);
+    if (pVertexShader == nullptr || pVertexShader->pVertexShader == nullptr || pPixelShader == nullptr || pPixelShader->pPixelShader == nullptr)
+    {
+        return;
+    }
+    if (pipelineDesc.inputLayout.numElements > SOFTWARE_SHADER_MAX_INPUT_ELEMENTS)
+    {
+        return;
+    }
+
+    // レンダーターゲットが変わったら、前のターゲットへの描画を済ませる
+    if (m_pPendingTarget != m_State.pRenderTarget)
+    {
+        Flush();
+        m_pPendingTarget = m_State.pRenderTarget;
+    }
+
+    // 描画の設定
+    const u32 drawIndex = static_cast<u32>(m_Draws.size());
+    {
+        const ResourceDesc& targetDesc = m_State.pRenderTarget->GetDesc();
+        Draw draw = {};
+        draw.scissor.left = std::max(m_State.scissor.left, 0);
+        draw.scissor.top = std::max(m_State.scissor.top, 0);
+        draw.scissor.right = std::min(m_State.scissor.right, static_cast<s32>(targetDesc.width));
+        draw.scissor.bottom = std::min(m_State.scissor.bottom, static_cast<s32>(targetDesc.height));
+        draw.cullMode = pipelineDesc.rasterizerState.cullMode;
+        draw.writeMask = ExpandWriteMask(pipelineDesc.blendState.renderTargetWriteMask);
+
+        // ピクセルシェーダーは入力を持たないので描画ごとに 1 回だけ評価する
+        const Float4 color = pPixelShader->pPixelShader();
+        draw.color = PackColor(color.x, color.y, color.z, color.w);
+
+        if (draw.scissor.left >= draw.scissor.right || draw.scissor.top >= draw.scissor.bottom || draw.writeMask == 0)
+        {
+            return;
+        }
+        m_Draws.push_back(draw);
+    }
+
+    // 頂点番号を列挙
+    m_DrawVertices.clear();
+    if (isIndexed)
+    {
+        const IndexBufferView& view = m_State.indexBuffer;
+        const u32 indexSize = (view.format == GRAPHICS_FORMAT_R16_UINT) ? 2 : 4;
+        const u64 availableCount = view.sizeInBytes / indexSize;
+        for (u32 i = 0; i < vertexCount; ++i)
+        {
+            const u64 location = static_cast<u64>(startLocation) + i;
+            u32 index = 0; // 範囲外は 0 を読む
+            if (location < availableCount)
+            {
+                const u8* pIndex = reinterpret_cast<const u8*>(view.bufferLocation) + location * indexSize;
+                if (indexSize == 2)
+                {
+                    u16 value;
+                    std::memcpy(&value, pIndex, sizeof(value));
+                    index = value;
+                }
+                else
+                {
+                    std::memcpy(&index, pIndex, sizeof(index));
+                }
+            }
+            m_DrawVertices.push_back(static_cast<u32>(static_cast<s64>(index) + baseVertexLocation));
+        }
+    }
+    else
+    {
+        for (u32 i = 0; i < vertexCount; ++i)
+        {
+            m_DrawVertices.push_back(startLocation + i);
+        }
+    }
+
+    const u32 minVertex = *std::min_element(m_DrawVertices.begin(), m_DrawVertices.end());
+    const u32 maxVertex = *std::max_element(m_DrawVertices.begin(), m_DrawVertices.end());
+    const u32 shadeCount = maxVertex - minVertex + 1;
+    const u32 vertexBase = static_cast<u32>(m_Vertices.size());
+    m_Vertices.resize(m_Vertices.size() + shadeCount);
+
+    // 入力要素ごとの読み出し位置
+    struct InputElement
+    {
+        const VertexBufferView* pView;
+        u32                     offset;
+        u32                     size;
+    };
+    InputElement elements[SOFTWARE_SHADER_MAX_INPUT_ELEMENTS] = {};
+    {
+        u32 slotOffsets[_countof(m_State.vertexBuffers)] = {};
+        for (u32 i = 0; i < pipelineDesc.inputLayout.numElements; ++i)
+        {
+            const InputElementDesc& element = pipelineDesc.inputLayout.pInputElementDescs[i];
+            const u32 slot = std::min(element.inputSlot, static_cast<u32>(_countof(m_State.vertexBuffers) - 1));
+            const u32 offset = (element.alignedByteOffset == APPEND_ALIGNED_ELEMENT) ? slotOffsets[slot] : element.alignedByteOffset;
+            elements[i].pView = &m_State.vertexBuffers[slot];
+            elements[i].offset = offset;
+            elements[i].size = GetFormatByteSize(element.format);
+            slotOffsets[slot] = offset + elements[i].size;
+        }
+    }
+    const u32 numElements = pipelineDesc.inputLayout.numElements;
+
+    // 頂点シェーダー実行とビューポート変換
+    const Viewport viewport = m_State.viewport;
+    const SoftwareVertexShader vertexShader = pVertexShader->pVertexShader;
+    std::function<void(u32, u32)> shadeVertices = [&](u32 taskIndex, u32 workerIndex)
+    {
+        workerIndex;
+        const u8 zeros[16] = {};
+        const u32 begin = taskIndex * VertexShadingChunkSize;
+        const u32 end = std::min(begin + VertexShadingChunkSize, shadeCount);
+        for (u32 i = begin; i < end; ++i)
+        {
+            const u64 vertexIndex = static_cast<u64>(minVertex) + i;
+
+            SoftwareVertexInput input = {};
+            for (u32 e = 0; e < numElements; ++e)
+            {
+                const InputElement& element = elements[e];
+                const u64 offset = vertexIndex * element.pView->strideInBytes + element.offset;
+                const bool isInside = element.pView->bufferLocation != 0 && offset + element.size <= element.pView->sizeInBytes;
+                input.pElements[e] = isInside ? reinterpret_cast<const u8*>(element.pView->bufferLocation) + offset : zeros; // 範囲外は 0 を読む
+            }
+
+            const Float4 position = vertexShader(input);
+
+            Vertex& vertex = m_Vertices[vertexBase + i];
+            vertex.isValid = 0;
+            if (!(position.w > 0.0f))
+            {
+                continue; // ニアクリップは行わない
+            }
+            const f32 screenX = viewport.topLeftX + (position.x / position.w + 1.0f) * 0.5f * viewport.width;
+            const f32 screenY = viewport.topLeftY + (1.0f - position.y / position.w) * 0.5f * viewport.height;
+            if (!(std::fabs(screenX) < static_cast<f32>(GuardBand) && std::fabs(screenY) < static_cast<f32>(GuardBand)))
+            {
+                continue; // ガードバンド外 (NaN も含む)
+            }
+            vertex.x = static_cast<s32>(std::floor(screenX * (1 << SubPixelBits) + 0.5f));
+            vertex.y = static_cast<s32>(std::floor(screenY * (1 << SubPixelBits) + 0.5f));
+            vertex.isValid = 1;
+        }
+    };
+    Dispatch((shadeCount + VertexShadingChunkSize - 1) / VertexShadingChunkSize, shadeVertices);
+
+    // プリミティブを組み立てる (インスタンス間で頂点は共通)
+    for (u32 instance = 0; instance < instanceCount; ++instance)
+    {
+        if (m_State.topology == PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+        {
+            for (u32 i = 0; i + 3 <= vertexCount; i += 3)
+            {
+                Primitive primitive = {};
+                primitive.vertices[0] = vertexBase + m_DrawVertices[i + 0] - minVertex;
+                primitive.vertices[1] = vertexBase + m_DrawVertices[i + 1] - minVertex;
+                primitive.vertices[2] = vertexBase + m_DrawVertices[i + 2] - minVertex;
+                primitive.drawIndex = drawIndex;
+                m_Primitives.push_back(primitive);
+            }
+        }
+        else
+        {
+            // ストリップは奇数番目で向きを揃える
+            for (u32 i = 0; i + 3 <= vertexCount; ++i)
+            {
+                const u32 odd = i & 1;
+                Primitive primitive = {};
+                primitive.vertices[0] = vertexBase + m_DrawVertices[i + 0] - minVertex;
+                primitive.vertices[1] = vertexBase + m_DrawVertices[i + 1 + odd] - minVertex;
+                primitive.vertices[2] = vertexBase + m_DrawVertices[i + 2 - odd] - minVertex;
+                primitive.drawIndex = drawIndex;
+                m_Primitives.push_back(primitive);
+            }
+        }
+    }
+}
+
+
+void SoftwareRasterizer::Flush()
+{
+    if (m_Primitives.empty() || m_pPendingTarget == nullptr)
+    {
+        m_Primitives.clear();
+        m_Vertices.clear();
+        m_Draws.clear();
+        return;
+    }
+
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    const ResourceDesc& targetDesc = m_pPendingTarget->GetDesc();
+    m_TileCountX = (static_cast<s32>(targetDesc.width) + TileSize - 1) / TileSize;
+    m_TileCountY = (static_cast<s32>(targetDesc.height) + TileSize - 1) / TileSize;
+    const u32 tileCount = static_cast<u32>(m_TileCountX * m_TileCountY);
+
+    // セットアップとビニング (プリミティブを分割し、ビンごとに描画順を保つ)
+    for (Bin& bin : m_Bins)
+    {
+        bin.triangles.clear();
+        bin.tiles.resize(tileCount);
+        for (std::vector<u32>& tile : bin.tiles)
+        {
+            tile.clear();
+        }
+    }
+    std::function<void(u32, u32)> setupTask = [this](u32 taskIndex, u32 workerIndex)
+    {
+        workerIndex;
+        SetupAndBin(taskIndex);
+    };
+    Dispatch(static_cast<u32>(m_Bins.size()), setupTask);
+
+    // タイルごとにラスタライズ (ビンの順に処理するので描画順は保たれる)
+    std::function<void(u32, u32)> rasterizeTask = [this](u32 taskIndex, u32 workerIndex)
+    {
+        RasterizeTile(taskIndex, workerIndex);
+    };
+    Dispatch(tileCount, rasterizeTask);
+
+    u64 triangleCount = 0;
+    u64 pixelCount = 0;
+    for (const Bin& bin : m_Bins)
+    {
+        triangleCount += bin.triangles.size();
+    }
+    for (WorkerCounter& counter : m_WorkerCounters)
+    {
+        pixelCount += counter.pixelCount;
+        counter.pixelCount = 0;
+    }
+
+    m_Primitives.clear();
+    m_Vertices.clear();
+    m_Draws.clear();
+
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+    m_Statistics.triangleCount += triangleCount;
+    m_Statistics.pixelCount += pixelCount;
+    m_Statistics.rasterizeMilliseconds += std::chrono::duration<f64, std::milli>(endTime - beginTime).count();
+}
+
+
+void SoftwareRasterizer::SetupAndBin(u32 binIndex)
+{
+    Bin& bin = m_Bins[binIndex];
+    const u32 primitiveCount = static_cast<u32>(m_Primitives.size());
+    const u32 binCount = static_cast<u32>(m_Bins.size());
+    const u32 chunkSize = (primitiveCount + binCount - 1) / binCount;
+    const u32 begin = std::min(binIndex * chunkSize, primitiveCount);
+    const u32 end = std::min(begin + chunkSize, primitiveCount);
+
+    const s32 half = 1 << (SubPixelBits - 1);
+    for (u32 p = begin; p < end; ++p)
+    {
+        const Primitive& primitive = m_Primitives[p];
+        const Draw& draw = m_Draws[primitive.drawIndex];
+        const Vertex* pVertices[3] = {
+            &m_Vertices[primitive.vertices[0]],
+            &m_Vertices[primitive.vertices[1]],
+            &m_Vertices[primitive.vertices[2]],
+        };
+        if (!pVertices[0]->isValid || !pVertices[1]->isValid || !pVertices[2]->isValid)
+        {
+            continue;
+        }
+
+        // y 下向きのスクリーン座標で時計回り (面積が正) が表面
+        const s64 area =
+            static_cast<s64>(pVertices[1]->x - pVertices[0]->x) * (pVertices[2]->y - pVertices[0]->y) -
+            static_cast<s64>(pVertices[1]->y - pVertices[0]->y) * (pVertices[2]->x - pVertices[0]->x);
+        if (area == 0)
+        {
+            continue;
+        }
+        if ((draw.cullMode == CULL_MODE_BACK && area < 0) || (draw.cullMode == CULL_MODE_FRONT && area > 0))
+        {
+            continue;
+        }
+        if (area < 0)
+        {
+            std::swap(pVertices[1], pVertices[2]);
+        }
+
+        // ピクセル中心 (16x + 8) が含まれる範囲に絞る
+        Triangle triangle = {};
+        const s32 minX = std::min(std::min(pVertices[0]->x, pVertices[1]->x), pVertices[2]->x);
+        const s32 minY = std::min(std::min(pVertices[0]->y, pVertices[1]->y), pVertices[2]->y);
+        const s32 maxX = std::max(std::max(pVertices[0]->x, pVertices[1]->x), pVertices[2]->x);
+        const s32 maxY = std::max(std::max(pVertices[0]->y, pVertices[1]->y), pVertices[2]->y);
+        triangle.minX = std::max((minX - half + (1 << SubPixelBits) - 1) >> SubPixelBits, draw.scissor.left);
+        triangle.minY = std::max((minY - half + (1 << SubPixelBits) - 1) >> SubPixelBits, draw.scissor.top);
+        triangle.maxX = std::min((maxX - half) >> SubPixelBits, draw.scissor.right - 1);
+        triangle.maxY = std::min((maxY - half) >> SubPixelBits, draw.scissor.bottom - 1);
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        {
+            continue;
+        }
+
+        // エッジ関数 (左上ルール: 左辺・上辺以外は境界上のピクセルを含めない)
+        for (u32 i = 0; i < 3; ++i)
+        {
+            const Vertex& a = *pVertices[i];
+            const Vertex& b = *pVertices[(i + 1) % 3];
+            triangle.a[i] = a.y - b.y;
+            triangle.b[i] = b.x - a.x;
+            triangle.c[i] = static_cast<s64>(b.y - a.y) * a.x - static_cast<s64>(b.x - a.x) * a.y;
+            const bool isTopLeft = triangle.a[i] > 0 || (triangle.a[i] == 0 && triangle.b[i] > 0);
+            if (!isTopLeft)
+            {
+                triangle.c[i] -= 1;
+            }
+        }
+        triangle.color = draw.color;
+        triangle.writeMask = draw.writeMask;
+
+        const u32 triangleIndex = static_cast<u32>(bin.triangles.size());
+        bin.triangles.push_back(triangle);
+        for (s32 ty = triangle.minY / TileSize; ty <= triangle.maxY / TileSize; ++ty)
+        {
+            for (s32 tx = triangle.minX / TileSize; tx <= triangle.maxX / TileSize; ++tx)
+            {
+                bin.tiles[ty * m_TileCountX + tx].push_back(triangleIndex);
+            }
+        }
+    }
+}
+
+
+void SoftwareRasterizer::RasterizeTile(u32 tileIndex, u32 workerIndex)
+{
+    const s32 tileX = static_cast<s32>(tileIndex) % m_TileCountX;
+    const s32 tileY = static_cast<s32>(tileIndex) / m_TileCountX;
+    const ResourceDesc& targetDesc = m_pPendingTarget->GetDesc();
+    const s32 tileLeft = tileX * TileSize;
+    const s32 tileTop = tileY * TileSize;
+    const s32 tileRight = std::min(tileLeft + TileSize, static_cast<s32>(targetDesc.width));
+    const s32 tileBottom = std::min(tileTop + TileSize, static_cast<s32>(targetDesc.height));
+
+    u8* pTargetData = m_pPendingTarget->GetData();
+    const u32 rowPitch = m_pPendingTarget->GetRowPitch();
+    const s32 subPixel = 1 << SubPixelBits;
+    const s32 half = subPixel / 2;
+
+    u64 pixelCount = 0;
+    for (const Bin& bin : m_Bins)
+    {
+        for (u32 triangleIndex : bin.tiles[tileIndex])
+        {
+            const Triangle& triangle = bin.triangles[triangleIndex];
+            const s32 left = std::max(triangle.minX, tileLeft);
+            const s32 top = std::max(triangle.minY, tileTop);
+            const s32 right = std::min(triangle.maxX + 1, tileRight);
+            const s32 bottom = std::min(triangle.maxY + 1, tileBottom);
+            if (left >= right || top >= bottom)
+            {
+                continue;
+            }
+
+            // 矩形の四隅で評価し、完全に外側 / 完全に内側 / 部分的 に分類
+            s32 e[3];
+            s32 stepX[3];
+            s32 stepY[3];
+            bool isPartial = false;
+            bool isOutside = false;
+            for (u32 i = 0; i < 3 && !isOutside; ++i)
+            {
+                const s64 x0 = static_cast<s64>(left) * subPixel + half;
+                const s64 y0 = static_cast<s64>(top) * subPixel + half;
+                const s64 x1 = static_cast<s64>(right - 1) * subPixel + half;
+                const s64 y1 = static_cast<s64>(bottom - 1) * subPixel + half;
+                const s64 e00 = triangle.a[i] * x0 + triangle.b[i] * y0 + triangle.c[i];
+                const s64 e10 = triangle.a[i] * x1 + triangle.b[i] * y0 + triangle.c[i];
+                const s64 e01 = triangle.a[i] * x0 + triangle.b[i] * y1 + triangle.c[i];
+                const s64 e11 = triangle.a[i] * x1 + triangle.b[i] * y1 + triangle.c[i];
+                const s64 minE = std::min(std::min(e00, e10), std::min(e01, e11));
+                const s64 maxE = std::max(std::max(e00, e10), std::max(e01, e11));
+                if (maxE < 0)
+                {
+                    isOutside = true;
+                }
+                else if (minE >= 0)
+                {
+                    e[i] = 0;
+                    stepX[i] = 0;
+                    stepY[i] = 0;
+                }
+                else
+                {
+                    // ガードバンド内なら矩形内の値は 32bit に収まる
+                    e[i] = static_cast<s32>(e00);
+                    stepX[i] = triangle.a[i] * subPixel;
+                    stepY[i] = triangle.b[i] * subPixel;
+                    isPartial = true;
+                }
+            }
+            if (isOutside)
+            {
+                continue;
+            }
+
+            const s32 width = right - left;
+            if (!isPartial)
+            {
+                // 矩形全体が内側
+                for (s32 y = top; y < bottom; ++y)
+                {
+                    u32* pRow = reinterpret_cast<u32*>(pTargetData + static_cast<size_t>(y) * rowPitch) + left;
+                    if (triangle.writeMask == 0xFFFFFFFF)
+                    {
+                        std::fill_n(pRow, width, triangle.color);
+                    }
+                    else
+                    {
+                        for (s32 x = 0; x < width; ++x)
+                        {
+                            pRow[x] = (pRow[x] & ~triangle.writeMask) | (triangle.color & triangle.writeMask);
+                        }
+                    }
+                }
+                pixelCount += static_cast<u64>(width) * (bottom - top);
+                continue;
+            }
+
+            for (s32 y = top; y < bottom; ++y)
+            {
+                u32* pRow = reinterpret_cast<u32*>(pTargetData + static_cast<size_t>(y) * rowPitch) + left;
+                pixelCount += RasterizeRow(pRow, width, e[0], e[1], e[2], stepX[0], stepX[1], stepX[2], triangle.color, triangle.writeMask);
+                e[0] += stepY[0];
+                e[1] += stepY[1];
+                e[2] += stepY[2];
+            }
+        }
+    }
+    m_WorkerCounters[workerIndex].pixelCount += pixelCount;
+}
+
+
+void SoftwareRasterizer::Dispatch(u32 taskCount, const std::function<void(u32 taskIndex, u32 workerIndex)>& task)
+{
+    if (taskCount == 0)
+    {
+        return;
+    }
+    if (m_Workers.empty() || taskCount == 1)
+    {
+        for (u32 i = 0; i < taskCount; ++i)
+        {
+            task(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_pTask = &task;
+        m_TaskCount = taskCount;
+        m_NextTask = 0;
+        m_RunningWorkers = static_cast<u32>(m_Workers.size());
+        ++m_Generation;
+    }
+    m_StartCondition.notify_all();
+
+    RunTasks(0);
+
+    // 全ワーカーが抜けるまで待つ (task の寿命を保証するため)
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_FinishCondition.wait(lock, [this]() { return m_RunningWorkers == 0; });
+    m_pTask = nullptr;
+}
+
+
+void SoftwareRasterizer::RunTasks(u32 workerIndex)
+{
+    for (;;)
+    {
+        const u32 taskIndex = m_NextTask.fetch_add(1);
+        if (taskIndex >= m_TaskCount)
+        {
+            break;
+        }
+        (*m_pTask)(taskIndex, workerIndex);
+    }
+}
+
+
+void SoftwareRasterizer::WorkerMain(u32 workerIndex)
+{
+    u32 generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_StartCondition.wait(lock, [&]() { return m_IsTerminating || m_Generation != generation; });
+            if (m_IsTerminating)
+            {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        RunTasks(workerIndex);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_RunningWorkers == 0)
+        {
+            m_FinishCondition.notify_one();
+        }
+    }
+}
@@ -0,0 +1,173 @@
+﻿#pragma once
+
+
+// ソフトウェアラスタライザ
+// Null バックエンドのコマンドリストを解釈し、R8G8B8A8_UNORM のレンダーターゲットへ描画する
+//   1. 頂点シェーダー (C++ 実装) を実行し、固定小数点 (4bit) のスクリーン座標に変換
+//   2. 三角形をセットアップし、画面を分割したタイルへビニング (プリミティブを分割して並列)
+//   3. タイルごとにワーカーへ分配し、エッジ関数を SIMD (SSE2 / AVX2) で評価して塗りつぶす
+// 未対応: 深度、ブレンド、ニアクリップ (w <= 0 やガードバンド外の頂点を含む三角形は破棄)
+
+
+// 統計情報
+struct SoftwareRasterizerStatistics
+{
+    u64 triangleCount; // セットアップを通過した三角形の数
+    u64 pixelCount;    // 書き込んだピクセルの数
+    f64 rasterizeMilliseconds;
+};
+
+
+class SoftwareRasterizer : public INullCommandExecutor
+{
+public:
+    // タイルのサイズ [ピクセル]
+    static const s32 TileSize = 64;
+
+    // スクリーン座標の有効範囲 [ピクセル] (固定小数点のエッジ関数が 32bit に収まる範囲)
+    static const s32 GuardBand = 16384;
+
+    // サブピクセルの精度 [bit]
+    static const s32 SubPixelBits = 4;
+
+    SoftwareRasterizer();
+
+    ~SoftwareRasterizer();
+
+    // workerCount が 0 ならハードウェアスレッド数に合わせる
+    bool Init(u32 workerCount);
+
+    void Term();
+
+    virtual void Execute(const NullCommandStream& commandStream) override;
+
+    void GetStatistics(SoftwareRasterizerStatistics* pOut) const;
+
+    u32 GetWorkerCount() const;
+
+private:
+    // 頂点 (固定小数点のスクリーン座標)
+    struct Vertex
+    {
+        s32 x;
+        s32 y;
+        u32 isValid;
+    };
+
+    // 描画ごとの設定
+    struct Draw
+    {
+        Rect      scissor;
+        CULL_MODE cullMode;
+        u32       color;
+        u32       writeMask;
+    };
+
+    // プリミティブ (m_Vertices の番号)
+    struct Primitive
+    {
+        u32 vertices[3];
+        u32 drawIndex;
+    };
+
+    // セットアップ済みの三角形
+    // エッジ関数 E(x, y) = a * x + b * y + c (x, y はサブピクセル単位、内側が E >= 0)
+    struct Triangle
+    {
+        s32 minX;
+        s32 minY;
+        s32 maxX;
+        s32 maxY;
+        s32 a[3];
+        s32 b[3];
+        s64 c[3];
+        u32 color;
+        u32 writeMask;
+    };
+
+    // ビニング結果 (セットアップのタスクごと)
+    struct Bin
+    {
+        std::vector<Triangle>         triangles;
+        std::vector<std::vector<u32>> tiles; // タイルごとの三角形番号
+    };
+
+    // ワーカーごとのカウンタ (フォルスシェアリング回避のため 64 バイト)
+    struct WorkerCounter
+    {
+        u64 pixelCount;
+        u8  padding[56];
+    };
+
+    // コマンドリストの状態
+    struct State
+    {
+        GraphicsResourceNull*      pRenderTarget;
+        GraphicsPipelineStateNull* pPipelineState;
+        bool                       hasViewport;
+        Viewport                   viewport;
+        bool                       hasScissor;
+        Rect                       scissor;
+        PRIMITIVE_TOPOLOGY         topology;
+        VertexBufferView           vertexBuffers[16];
+        bool                       hasIndexBuffer;
+        IndexBufferView            indexBuffer;
+    };
+
+private:
+    // ディスクリプタからレンダーターゲットを取得
+    static GraphicsResourceNull* GetRenderTarget(CpuDescriptorHandle handle);
+
+    void ClearRenderTarget(CpuDescriptorHandle handle, const f32 color[4]);
+
+    // 描画を積む (頂点シェーダーはこの時点で実行する)
+    void EnqueueDraw(u32 vertexCount, u32 instanceCount, u32 startLocation, s32 baseVertexLocation, bool isIndexed);
+
+    // 積まれた描画をセットアップ・ビニング・ラスタライズする
+    void Flush();
+
+    void SetupAndBin(u32 binIndex);
+
+    void RasterizeTile(u32 tileIndex, u32 workerIndex);
+
+    // タスクを全ワーカーで分担して実行 (呼び出しスレッドもワーカー 0 として参加)
+    void Dispatch(u32 taskCount, const std::function<void(u32 taskIndex, u32 workerIndex)>& task);
+
+    void RunTasks(u32 workerIndex);
+
+    void WorkerMain(u32 workerIndex);
+
+private:
+    State m_State;
+
+    // 積まれた描画
+    GraphicsResourceNull*  m_pPendingTarget;
+    std::vector<Vertex>    m_Vertices;
+    std::vector<Primitive> m_Primitives;
+    std::vector<Draw>      m_Draws;
+    std::vector<u32>       m_DrawVertices; // 作業用
+
+    // ビニング
+    std::vector<Bin> m_Bins;
+    s32              m_TileCountX;
+    s32              m_TileCountY;
+
+    // ワーカー
+    std::vector<std::thread>   m_Workers;
+    std::vector<WorkerCounter> m_WorkerCounters;
+    std::mutex                 m_Mutex;
+    std::condition_variable    m_StartCondition;
+    std::condition_variable    m_FinishCondition;
+    const std::function<void(u32, u32)>* m_pTask;
+    u32                        m_TaskCount;
+    std::atomic<u32>           m_NextTask;
+    u32                        m_Generation;
+    u32                        m_RunningWorkers;
+    bool                       m_IsTerminating;
+
+    // 複数のキューから同時に実行されないようにする
+    std::mutex m_ExecuteMutex;
+
+    mutable std::mutex           m_StatisticsMutex;
+    SoftwareRasterizerStatistics m_Statistics;
+};
@@ -0,0 +1,70 @@
+﻿
+
+// バイトコードの先頭に付ける識別子
+static const char SoftwareShaderMagic[4] = { 'S', 'W', 'S', 'H' };
+
+
+// Shaders/Basic_VS.hlsl
+static Float4 Basic_VS_main(const SoftwareVertexInput& input)
+{
+    Float3 pos;
+    std::memcpy(&pos, input.pElements[0], sizeof(pos)); // float3 pos : POSITION
+
+    Float4 result = { pos.x, pos.y, pos.z, 1.0f };
+    return result;
+}
+
+static const SoftwareShaderInput Basic_VS_main_Inputs[] = {
+    { "POSITION", 0, 3 },
+};
+
+
+// Shaders/Basic_PS.hlsl
+static Float4 Basic_PS_main()
+{
+    Float4 result = { 1.0f, 1.0f, 1.0f, 1.0f };
+    return result;
+}
+
+
+static const SoftwareShader SoftwareShaders[] = {
+    { "Basic_VS/main", Basic_VS_main, nullptr, Basic_VS_main_Inputs, _countof(Basic_VS_main_Inputs) },
+    { "Basic_PS/main", nullptr, Basic_PS_main, nullptr, 0 },
+};
+
+
+const SoftwareShader* FindSoftwareShader(const std::string& name)
+{
+    for (const SoftwareShader& shader : SoftwareShaders)
+    {
+        if (name == shader.name)
+        {
+            return &shader;
+        }
+    }
+    return nullptr;
+}
+
+
+const SoftwareShader* FindSoftwareShader(const ShaderBytecode& bytecode)
+{
+    const char* pBytecode = reinterpret_cast<const char*>(bytecode.pShaderBytecode);
+    if (pBytecode == nullptr || bytecode.bytecodeLength < sizeof(SoftwareShaderMagic))
+    {
+        return nullptr;
+    }
+    if (std::memcmp(pBytecode, SoftwareShaderMagic, sizeof(SoftwareShaderMagic)) != 0)
+    {
+        return nullptr;
+    }
+
+    const std::string name(pBytecode + sizeof(SoftwareShaderMagic), pBytecode + bytecode.bytecodeLength);
+    return FindSoftwareShader(name);
+}
+
+
+void MakeSoftwareShaderBytecode(const std::string& name, std::vector<u8>* pBytecode)
+{
+    pBytecode->assign(SoftwareShaderMagic, SoftwareShaderMagic + sizeof(SoftwareShaderMagic));
+    pBytecode->insert(pBytecode->end(), name.begin(), name.end());
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+
+
+// ソフトウェアバックエンド用シェーダー
+// HLSL は実行できないので、同じ処理を C++ で書いたものを名前で引き当てる
+// 名前は "<ファイル名 (拡張子なし)>/<エントリポイント>" (例: "Basic_VS/main")
+
+
+// 頂点シェーダーが受け取れる入力要素の最大数
+static const u32 SOFTWARE_SHADER_MAX_INPUT_ELEMENTS = 8;
+
+
+// 頂点シェーダーの入力 (入力レイアウトの要素順)
+struct SoftwareVertexInput
+{
+    const u8* pElements[SOFTWARE_SHADER_MAX_INPUT_ELEMENTS];
+};
+
+
+// 頂点シェーダー (SV_POSITION を返す)
+typedef Float4 (*SoftwareVertexShader)(const SoftwareVertexInput& input);
+
+// ピクセルシェーダー (入力を持たず、描画ごとに一定の色を返すもののみ)
+typedef Float4 (*SoftwarePixelShader)();
+
+
+// 頂点シェーダーの入力要素 (リフレクション用、HLSL の宣言と合わせる)
+struct SoftwareShaderInput
+{
+    const char* semanticName;
+    u32         semanticIndex;
+    u32         componentCount;
+};
+
+
+struct SoftwareShader
+{
+    const char*                name;
+    SoftwareVertexShader       pVertexShader;
+    SoftwarePixelShader        pPixelShader;
+    const SoftwareShaderInput* pInputs;
+    u32                        numInputs;
+};
+
+
+// 名前から検索 (見つからなければ nullptr)
+const SoftwareShader* FindSoftwareShader(const std::string& name);
+
+// バイトコードから検索 (見つからなければ nullptr)
+const SoftwareShader* FindSoftwareShader(const ShaderBytecode& bytecode);
+
+// バイトコードを作成
+void MakeSoftwareShaderBytecode(const std::string& name, std::vector<u8>* pBytecode);
@@ -0,0 +1,415 @@
+﻿
+
+static bool IsSameViewport(const Viewport& a, const Viewport& b)
+{
+    return a.topLeftX == b.topLeftX && a.topLeftY == b.topLeftY && a.width == b.width && a.height == b.height && a.minDepth == b.minDepth && a.maxDepth == b.maxDepth;
+}
+
+
+static bool IsSameRect(const Rect& a, const Rect& b)
+{
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+
+static bool IsSameVertexBufferView(const VertexBufferView& a, const VertexBufferView& b)
+{
+    return a.bufferLocation == b.bufferLocation && a.sizeInBytes == b.sizeInBytes && a.strideInBytes == b.strideInBytes;
+}
+
+
+static bool IsSameIndexBufferView(const IndexBufferView& a, const IndexBufferView& b)
+{
+    return a.bufferLocation == b.bufferLocation && a.sizeInBytes == b.sizeInBytes && a.format == b.format;
+}
+
+
+StateFilterCommandList::StateFilterCommandList(IGraphicsCommandList* pCommandList, bool isFilterEnabled)
+    : m_pCommandList(pCommandList)
+    , m_IsFilterEnabled(isFilterEnabled)
+    , m_IsRenderTargetsKnown(false)
+    , m_RenderTargetCount(0)
+    , m_RenderTargets()
+    , m_HasDepthStencil(false)
+    , m_DepthStencil()
+    , m_IsPipelineStateKnown(false)
+    , m_pPipelineState(nullptr)
+    , m_IsRootSignatureKnown(false)
+    , m_pRootSignature(nullptr)
+    , m_IsDescriptorHeapsKnown(false)
+    , m_DescriptorHeapCount(0)
+    , m_pDescriptorHeaps()
+    , m_RootArguments()
+    , m_IsViewportsKnown(false)
+    , m_ViewportCount(0)
+    , m_Viewports()
+    , m_IsScissorRectsKnown(false)
+    , m_ScissorRectCount(0)
+    , m_ScissorRects()
+    , m_IsPrimitiveTopologyKnown(false)
+    , m_PrimitiveTopology()
+    , m_IsVertexBufferKnown()
+    , m_VertexBuffers()
+    , m_IsIndexBufferKnown(false)
+    , m_HasIndexBuffer(false)
+    , m_IndexBuffer()
+    , m_Statistics()
+{
+
+}
+
+
+StateFilterCommandList::~StateFilterCommandList()
+{
+
+}
+
+
+COMMAND_LIST_TYPE StateFilterCommandList::GetType() const
+{
+    return m_pCommandList->GetType();
+}
+
+
+HRESULT StateFilterCommandList::Close()
+{
+    return m_pCommandList->Close();
+}
+
+
+HRESULT StateFilterCommandList::Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState)
+{
+    // 記録し直したリストは何も設定されていない
+    ForgetState();
+    HRESULT hr = m_pCommandList->Reset(pAllocator, pInitialState);
+    if (SUCCEEDED(hr) && pInitialState != nullptr)
+    {
+        m_IsPipelineStateKnown = true;
+        m_pPipelineState = pInitialState;
+    }
+    return hr;
+}
+
+
+void StateFilterCommandList::ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers)
+{
+    m_pCommandList->ResourceBarrier(numBarriers, pBarriers);
+}
+
+
+void StateFilterCommandList::OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil)
+{
+    bool isSame = m_IsRenderTargetsKnown && m_RenderTargetCount == numRenderTargets && m_HasDepthStencil == (pDepthStencil != nullptr);
+    for (u32 i = 0; isSame && i < numRenderTargets; i++)
+    {
+        isSame = m_RenderTargets[i].ptr == pRenderTargets[i].ptr;
+    }
+    if (isSame && pDepthStencil != nullptr)
+    {
+        isSame = m_DepthStencil.ptr == pDepthStencil->ptr;
+    }
+    if (Filter(STATE_FILTER_CALL_RENDER_TARGETS, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->OMSetRenderTargets(numRenderTargets, pRenderTargets, pDepthStencil);
+    m_IsRenderTargetsKnown = numRenderTargets <= MaxRenderTargets;
+    m_RenderTargetCount = numRenderTargets;
+    std::copy_n(pRenderTargets, std::min(numRenderTargets, static_cast<u32>(MaxRenderTargets)), m_RenderTargets);
+    m_HasDepthStencil = pDepthStencil != nullptr;
+    m_DepthStencil = m_HasDepthStencil ? *pDepthStencil : CpuDescriptorHandle();
+}
+
+
+void StateFilterCommandList::ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4])
+{
+    m_pCommandList->ClearRenderTargetView(renderTarget, color);
+}
+
+
+void StateFilterCommandList::SetPipelineState(IGraphicsPipelineState* pPipelineState)
+{
+    if (Filter(STATE_FILTER_CALL_PIPELINE_STATE, m_IsPipelineStateKnown && m_pPipelineState == pPipelineState))
+    {
+        return;
+    }
+
+    m_pCommandList->SetPipelineState(pPipelineState);
+    m_IsPipelineStateKnown = true;
+    m_pPipelineState = pPipelineState;
+}
+
+
+void StateFilterCommandList::SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature)
+{
+    if (Filter(STATE_FILTER_CALL_ROOT_SIGNATURE, m_IsRootSignatureKnown && m_pRootSignature == pRootSignature))
+    {
+        return;
+    }
+
+    // 設定し直すとルート引数は未定義になる
+    m_pCommandList->SetGraphicsRootSignature(pRootSignature);
+    m_IsRootSignatureKnown = true;
+    m_pRootSignature = pRootSignature;
+    ForgetRootArguments();
+}
+
+
+void StateFilterCommandList::SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps)
+{
+    bool isSame = m_IsDescriptorHeapsKnown && m_DescriptorHeapCount == numHeaps;
+    for (u32 i = 0; isSame && i < numHeaps; i++)
+    {
+        isSame = m_pDescriptorHeaps[i] == ppHeaps[i];
+    }
+    if (Filter(STATE_FILTER_CALL_DESCRIPTOR_HEAPS, isSame))
+    {
+        return;
+    }
+
+    // テーブルは前のヒープを指しているので設定し直しにする
+    m_pCommandList->SetDescriptorHeaps(numHeaps, ppHeaps);
+    m_IsDescriptorHeapsKnown = numHeaps <= MaxDescriptorHeaps;
+    m_DescriptorHeapCount = numHeaps;
+    std::copy_n(ppHeaps, std::min(numHeaps, static_cast<u32>(MaxDescriptorHeaps)), m_pDescriptorHeaps);
+    ForgetRootArguments();
+}
+
+
+void StateFilterCommandList::SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor)
+{
+    const bool isSame = rootParameterIndex < MaxRootParameters
+        && m_RootArguments[rootParameterIndex].type == ROOT_ARGUMENT_TYPE_DESCRIPTOR_TABLE
+        && m_RootArguments[rootParameterIndex].value == baseDescriptor.ptr;
+    if (Filter(STATE_FILTER_CALL_ROOT_ARGUMENT, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->SetGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+    SetRootArgument(rootParameterIndex, ROOT_ARGUMENT_TYPE_DESCRIPTOR_TABLE, baseDescriptor.ptr);
+}
+
+
+void StateFilterCommandList::SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues)
+{
+    // 定数は一部だけ書き換えることもあるので比べない
+    m_pCommandList->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, pData, destOffsetIn32BitValues);
+}
+
+
+void StateFilterCommandList::SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation)
+{
+    const bool isSame = rootParameterIndex < MaxRootParameters
+        && m_RootArguments[rootParameterIndex].type == ROOT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW
+        && m_RootArguments[rootParameterIndex].value == bufferLocation;
+    if (Filter(STATE_FILTER_CALL_ROOT_ARGUMENT, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+    SetRootArgument(rootParameterIndex, ROOT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW, bufferLocation);
+}
+
+
+void StateFilterCommandList::RSSetViewports(u32 numViewports, const Viewport* pViewports)
+{
+    bool isSame = m_IsViewportsKnown && m_ViewportCount == numViewports;
+    for (u32 i = 0; isSame && i < numViewports; i++)
+    {
+        isSame = IsSameViewport(m_Viewports[i], pViewports[i]);
+    }
+    if (Filter(STATE_FILTER_CALL_VIEWPORTS, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->RSSetViewports(numViewports, pViewports);
+    m_IsViewportsKnown = numViewports <= MaxViewports;
+    m_ViewportCount = numViewports;
+    std::copy_n(pViewports, std::min(numViewports, static_cast<u32>(MaxViewports)), m_Viewports);
+}
+
+
+void StateFilterCommandList::RSSetScissorRects(u32 numRects, const Rect* pRects)
+{
+    bool isSame = m_IsScissorRectsKnown && m_ScissorRectCount == numRects;
+    for (u32 i = 0; isSame && i < numRects; i++)
+    {
+        isSame = IsSameRect(m_ScissorRects[i], pRects[i]);
+    }
+    if (Filter(STATE_FILTER_CALL_SCISSOR_RECTS, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->RSSetScissorRects(numRects, pRects);
+    m_IsScissorRectsKnown = numRects <= MaxViewports;
+    m_ScissorRectCount = numRects;
+    std::copy_n(pRects, std::min(numRects, static_cast<u32>(MaxViewports)), m_ScissorRects);
+}
+
+
+void StateFilterCommandList::IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+    if (Filter(STATE_FILTER_CALL_PRIMITIVE_TOPOLOGY, m_IsPrimitiveTopologyKnown && m_PrimitiveTopology == primitiveTopology))
+    {
+        return;
+    }
+
+    m_pCommandList->IASetPrimitiveTopology(primitiveTopology);
+    m_IsPrimitiveTopologyKnown = true;
+    m_PrimitiveTopology = primitiveTopology;
+}
+
+
+void StateFilterCommandList::IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews)
+{
+    // 1 つでも違えば全て設定する
+    bool isSame = static_cast<u64>(startSlot) + numViews <= MaxVertexBuffers;
+    for (u32 i = 0; isSame && i < numViews; i++)
+    {
+        isSame = m_IsVertexBufferKnown[startSlot + i] && IsSameVertexBufferView(m_VertexBuffers[startSlot + i], pViews[i]);
+    }
+    if (Filter(STATE_FILTER_CALL_VERTEX_BUFFERS, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->IASetVertexBuffers(startSlot, numViews, pViews);
+    for (u32 i = 0; i < numViews && startSlot + i < MaxVertexBuffers; i++)
+    {
+        m_IsVertexBufferKnown[startSlot + i] = true;
+        m_VertexBuffers[startSlot + i] = pViews[i];
+    }
+}
+
+
+void StateFilterCommandList::IASetIndexBuffer(const IndexBufferView* pView)
+{
+    bool isSame = m_IsIndexBufferKnown && m_HasIndexBuffer == (pView != nullptr);
+    if (isSame && pView != nullptr)
+    {
+        isSame = IsSameIndexBufferView(m_IndexBuffer, *pView);
+    }
+    if (Filter(STATE_FILTER_CALL_INDEX_BUFFER, isSame))
+    {
+        return;
+    }
+
+    m_pCommandList->IASetIndexBuffer(pView);
+    m_IsIndexBufferKnown = true;
+    m_HasIndexBuffer = pView != nullptr;
+    m_IndexBuffer = m_HasIndexBuffer ? *pView : IndexBufferView();
+}
+
+
+void StateFilterCommandList::DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation)
+{
+    m_pCommandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+    m_Statistics.drawCalls++;
+}
+
+
+void StateFilterCommandList::DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation)
+{
+    m_pCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+    m_Statistics.drawCalls++;
+}
+
+
+void StateFilterCommandList::CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes)
+{
+    m_pCommandList->CopyBufferRegion(pDstBuffer, dstOffset, pSrcBuffer, srcOffset, numBytes);
+}
+
+
+IGraphicsCommandList* StateFilterCommandList::GetCommandList() const
+{
+    return m_pCommandList;
+}
+
+
+const StateFilterStatistics& StateFilterCommandList::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+
+void StateFilterCommandList::AddStatistics(const StateFilterStatistics& statistics, StateFilterStatistics* pTotal)
+{
+    for (u32 i = 0; i < STATE_FILTER_CALL_NUM; i++)
+    {
+        pTotal->issuedCalls[i] += statistics.issuedCalls[i];
+        pTotal->filteredCalls[i] += statistics.filteredCalls[i];
+    }
+    pTotal->drawCalls += statistics.drawCalls;
+}
+
+
+const char* StateFilterCommandList::GetCallName(STATE_FILTER_CALL call)
+{
+    static const char* const Names[] =
+    {
+        "render targets",
+        "pipeline",
+        "root signature",
+        "descriptor heaps",
+        "root arguments",
+        "viewports",
+        "scissor",
+        "topology",
+        "vertex buffers",
+        "index buffer",
+    };
+    static_assert(_countof(Names) == STATE_FILTER_CALL_NUM, "STATE_FILTER_CALL と数が合わない");
+    return Names[call];
+}
+
+
+bool StateFilterCommandList::Filter(STATE_FILTER_CALL call, bool isSame)
+{
+    if (isSame && m_IsFilterEnabled)
+    {
+        m_Statistics.filteredCalls[call]++;
+        return true;
+    }
+    m_Statistics.issuedCalls[call]++;
+    return false;
+}
+
+
+void StateFilterCommandList::ForgetState()
+{
+    m_IsRenderTargetsKnown = false;
+    m_IsPipelineStateKnown = false;
+    m_IsRootSignatureKnown = false;
+    m_IsDescriptorHeapsKnown = false;
+    m_IsViewportsKnown = false;
+    m_IsScissorRectsKnown = false;
+    m_IsPrimitiveTopologyKnown = false;
+    std::fill_n(m_IsVertexBufferKnown, static_cast<u32>(MaxVertexBuffers), false);
+    m_IsIndexBufferKnown = false;
+    ForgetRootArguments();
+}
+
+
+void StateFilterCommandList::ForgetRootArguments()
+{
+    for (RootArgument& argument : m_RootArguments)
+    {
+        argument.type = ROOT_ARGUMENT_TYPE_UNKNOWN;
+    }
+}
+
+
+void StateFilterCommandList::SetRootArgument(u32 rootParameterIndex, ROOT_ARGUMENT_TYPE type, u64 value)
+{
+    if (rootParameterIndex < MaxRootParameters)
+    {
+        m_RootArguments[rootParameterIndex].type = type;
+        m_RootArguments[rootParameterIndex].value = value;
+    }
+}
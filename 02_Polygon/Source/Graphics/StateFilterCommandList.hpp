@@ -0,0 +1,164 @@
+﻿#pragma once
+
+
+// 重複した状態設定を捨てるコマンドリスト
+// 下のコマンドリストに設定した状態を覚えておき、同じ値の SetPipelineState / IASet* / RSSet* / ルート引数などは渡さない
+// 描画ごとに全ての状態を設定しても、変わったものだけが記録される
+//
+// 記録はこのラッパーだけを通すこと (下のリストに直接記録すると覚えている状態とずれる)
+// ExecuteCommandLists には下のコマンドリストを渡す
+// ルートシグネチャを変えるとルート引数は設定し直しになる (D3D12 と同じ)
+
+
+// 状態設定の種類
+enum STATE_FILTER_CALL
+{
+    STATE_FILTER_CALL_RENDER_TARGETS
+
+    , STATE_FILTER_CALL_PIPELINE_STATE
+    , STATE_FILTER_CALL_ROOT_SIGNATURE
+    , STATE_FILTER_CALL_DESCRIPTOR_HEAPS
+    , STATE_FILTER_CALL_ROOT_ARGUMENT     // ディスクリプタテーブル、CBV (定数は常に渡す)
+    , STATE_FILTER_CALL_VIEWPORTS
+    , STATE_FILTER_CALL_SCISSOR_RECTS
+    , STATE_FILTER_CALL_PRIMITIVE_TOPOLOGY
+    , STATE_FILTER_CALL_VERTEX_BUFFERS
+    , STATE_FILTER_CALL_INDEX_BUFFER
+
+    , STATE_FILTER_CALL_NUM
+};
+
+
+// 統計情報 (呼び出しの数)
+struct StateFilterStatistics
+{
+    u64 issuedCalls[STATE_FILTER_CALL_NUM];   // 下のコマンドリストに渡したもの
+    u64 filteredCalls[STATE_FILTER_CALL_NUM]; // 同じ状態なので捨てたもの
+    u64 drawCalls;
+};
+
+
+class StateFilterCommandList : public IGraphicsCommandList
+{
+public:
+    static const u32 MaxRenderTargets = 8;
+    static const u32 MaxViewports = 16;
+    static const u32 MaxVertexBuffers = 32;
+    static const u32 MaxRootParameters = 64;
+    static const u32 MaxDescriptorHeaps = 2;
+
+    // isFilterEnabled が false なら全て渡す (統計だけ取る)
+    StateFilterCommandList(IGraphicsCommandList* pCommandList, bool isFilterEnabled);
+
+    ~StateFilterCommandList();
+
+    virtual COMMAND_LIST_TYPE GetType() const override;
+
+    virtual HRESULT Close() override;
+
+    // 状態は忘れる
+    virtual HRESULT Reset(IGraphicsCommandAllocator* pAllocator, IGraphicsPipelineState* pInitialState) override;
+
+    virtual void ResourceBarrier(u32 numBarriers, const ResourceBarrierDesc* pBarriers) override;
+
+    virtual void OMSetRenderTargets(u32 numRenderTargets, const CpuDescriptorHandle* pRenderTargets, const CpuDescriptorHandle* pDepthStencil) override;
+
+    virtual void ClearRenderTargetView(CpuDescriptorHandle renderTarget, const f32 color[4]) override;
+
+    virtual void SetPipelineState(IGraphicsPipelineState* pPipelineState) override;
+
+    virtual void SetGraphicsRootSignature(IGraphicsRootSignature* pRootSignature) override;
+
+    virtual void SetDescriptorHeaps(u32 numHeaps, IGraphicsDescriptorHeap* const* ppHeaps) override;
+
+    virtual void SetGraphicsRootDescriptorTable(u32 rootParameterIndex, GpuDescriptorHandle baseDescriptor) override;
+
+    virtual void SetGraphicsRoot32BitConstants(u32 rootParameterIndex, u32 num32BitValues, const void* pData, u32 destOffsetIn32BitValues) override;
+
+    virtual void SetGraphicsRootConstantBufferView(u32 rootParameterIndex, u64 bufferLocation) override;
+
+    virtual void RSSetViewports(u32 numViewports, const Viewport* pViewports) override;
+
+    virtual void RSSetScissorRects(u32 numRects, const Rect* pRects) override;
+
+    virtual void IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+    virtual void IASetVertexBuffers(u32 startSlot, u32 numViews, const VertexBufferView* pViews) override;
+
+    virtual void IASetIndexBuffer(const IndexBufferView* pView) override;
+
+    virtual void DrawInstanced(u32 vertexCountPerInstance, u32 instanceCount, u32 startVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void DrawIndexedInstanced(u32 indexCountPerInstance, u32 instanceCount, u32 startIndexLocation, s32 baseVertexLocation, u32 startInstanceLocation) override;
+
+    virtual void CopyBufferRegion(IGraphicsResource* pDstBuffer, u64 dstOffset, IGraphicsResource* pSrcBuffer, u64 srcOffset, u64 numBytes) override;
+
+    IGraphicsCommandList* GetCommandList() const;
+
+    const StateFilterStatistics& GetStatistics() const;
+
+    // pTotal に足す
+    static void AddStatistics(const StateFilterStatistics& statistics, StateFilterStatistics* pTotal);
+
+    static const char* GetCallName(STATE_FILTER_CALL call);
+
+private:
+    // ルート引数 (ディスクリプタテーブルか CBV)
+    enum ROOT_ARGUMENT_TYPE
+    {
+        ROOT_ARGUMENT_TYPE_UNKNOWN
+
+        , ROOT_ARGUMENT_TYPE_DESCRIPTOR_TABLE
+        , ROOT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW
+    };
+
+    struct RootArgument
+    {
+        ROOT_ARGUMENT_TYPE type;
+        u64                value;
+    };
+
+private:
+    // 設定済みの状態と同じなら捨てる、違えば渡すものとして数える
+    bool Filter(STATE_FILTER_CALL call, bool isSame);
+
+    void ForgetState();
+
+    void ForgetRootArguments();
+
+    void SetRootArgument(u32 rootParameterIndex, ROOT_ARGUMENT_TYPE type, u64 value);
+
+private:
+    IGraphicsCommandList* m_pCommandList;
+    bool                  m_IsFilterEnabled;
+
+    // 下のコマンドリストに設定した状態 (is*Known が false なら分からない)
+    bool                     m_IsRenderTargetsKnown;
+    u32                      m_RenderTargetCount;
+    CpuDescriptorHandle      m_RenderTargets[MaxRenderTargets];
+    bool                     m_HasDepthStencil;
+    CpuDescriptorHandle      m_DepthStencil;
+    bool                     m_IsPipelineStateKnown;
+    IGraphicsPipelineState*  m_pPipelineState;
+    bool                     m_IsRootSignatureKnown;
+    IGraphicsRootSignature*  m_pRootSignature;
+    bool                     m_IsDescriptorHeapsKnown;
+    u32                      m_DescriptorHeapCount;
+    IGraphicsDescriptorHeap* m_pDescriptorHeaps[MaxDescriptorHeaps];
+    RootArgument             m_RootArguments[MaxRootParameters];
+    bool                     m_IsViewportsKnown;
+    u32                      m_ViewportCount;
+    Viewport                 m_Viewports[MaxViewports];
+    bool                     m_IsScissorRectsKnown;
+    u32                      m_ScissorRectCount;
+    Rect                     m_ScissorRects[MaxViewports];
+    bool                     m_IsPrimitiveTopologyKnown;
+    PRIMITIVE_TOPOLOGY       m_PrimitiveTopology;
+    bool                     m_IsVertexBufferKnown[MaxVertexBuffers];
+    VertexBufferView         m_VertexBuffers[MaxVertexBuffers];
+    bool                     m_IsIndexBufferKnown;
+    bool                     m_HasIndexBuffer;
+    IndexBufferView          m_IndexBuffer;
+
+    StateFilterStatistics m_Statistics;
+};
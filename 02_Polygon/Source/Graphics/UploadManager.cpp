@@ -0,0 +1,277 @@
+﻿
+
+// ステージングの切り出しのアライメント
+static const u64 StagingAlignment = 16;
+
+
+UploadManager::UploadManager()
+    : m_pDevice(nullptr)
+    , m_FenceValue(0)
+    , m_ChunkSize(0)
+    , m_Statistics()
+{
+
+}
+
+
+UploadManager::~UploadManager()
+{
+    Term();
+}
+
+
+HRESULT UploadManager::Init(IGraphicsDevice* pDevice, u64 stagingCapacity)
+{
+    m_pDevice = pDevice;
+
+    HRESULT hr = m_pDevice->CreateCommandQueue(COMMAND_LIST_TYPE_COPY, &m_CopyQueue);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<IGraphicsCommandAllocator> commandAllocator;
+    hr = m_pDevice->CreateCommandAllocator(COMMAND_LIST_TYPE_COPY, &commandAllocator);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // 記録を始めるときに Reset するので閉じておく
+    hr = m_pDevice->CreateCommandList(COMMAND_LIST_TYPE_COPY, commandAllocator.get(), &m_CommandList);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    hr = m_CommandList->Close();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    m_FreeAllocators.push_back(std::move(commandAllocator));
+
+    m_FenceValue = 0;
+    hr = m_pDevice->CreateFence(m_FenceValue, &m_Fence);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = m_Staging.Init(m_pDevice, stagingCapacity);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // リングのどこから始めても、空になれば必ず確保できる大きさに分割する
+    m_ChunkSize = (stagingCapacity / 2) & ~(StagingAlignment - 1);
+    return S_OK;
+}
+
+
+void UploadManager::Term()
+{
+    if (m_Fence)
+    {
+        m_Fence->Wait(m_FenceValue);
+    }
+
+    // 積まなかった記録は捨てる
+    if (m_RecordingAllocator)
+    {
+        m_CommandList->Close();
+        m_RecordingAllocator.reset();
+    }
+
+    m_PendingBatches.clear();
+    m_FreeAllocators.clear();
+    m_Staging.Term();
+    m_Fence.reset();
+    m_CommandList.reset();
+    m_CopyQueue.reset();
+    m_pDevice = nullptr;
+}
+
+
+HRESULT UploadManager::UploadBuffer(IGraphicsResource* pDst, u64 dstOffset, const void* pData, u64 size)
+{
+    const u8* pSrc = static_cast<const u8*>(pData);
+    while (size > 0)
+    {
+        const u64 chunkSize = std::min(size, m_ChunkSize);
+
+        UploadAllocation staging = {};
+        if (!m_Staging.Upload(pSrc, chunkSize, StagingAlignment, &staging))
+        {
+            HRESULT hr = WaitForStaging();
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+            if (!m_Staging.Upload(pSrc, chunkSize, StagingAlignment, &staging))
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        if (!m_RecordingAllocator)
+        {
+            HRESULT hr = BeginBatch();
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+        }
+        m_CommandList->CopyBufferRegion(pDst, dstOffset, staging.pResource, staging.offset, chunkSize);
+        m_Statistics.copyCount++;
+
+        pSrc += chunkSize;
+        dstOffset += chunkSize;
+        size -= chunkSize;
+        m_Statistics.uploadedBytes += chunkSize;
+    }
+
+    m_Statistics.uploadCount++;
+    return S_OK;
+}
+
+
+HRESULT UploadManager::Flush(u64* pFenceValue)
+{
+    if (!m_RecordingAllocator)
+    {
+        *pFenceValue = m_FenceValue;
+        return S_OK;
+    }
+
+    HRESULT hr = m_CommandList->Close();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    IGraphicsCommandList* commandLists[] = { m_CommandList.get() };
+    m_CopyQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+
+    hr = m_CopyQueue->Signal(m_Fence.get(), ++m_FenceValue);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // このまとまりのステージングとアロケータは、フェンスが進むまで再利用しない
+    m_Staging.FinishFrame(m_FenceValue);
+
+    Batch batch;
+    batch.commandAllocator = std::move(m_RecordingAllocator);
+    batch.fenceValue = m_FenceValue;
+    m_PendingBatches.push_back(std::move(batch));
+    m_Statistics.batchCount++;
+
+    *pFenceValue = m_FenceValue;
+    return S_OK;
+}
+
+
+HRESULT UploadManager::WaitOnQueue(IGraphicsCommandQueue* pQueue, u64 fenceValue)
+{
+    if (fenceValue == 0)
+    {
+        return S_OK;
+    }
+    return pQueue->Wait(m_Fence.get(), fenceValue);
+}
+
+
+void UploadManager::Reclaim()
+{
+    const u64 completedValue = m_Fence->GetCompletedValue();
+    m_Staging.Reclaim(completedValue);
+
+    while (!m_PendingBatches.empty() && m_PendingBatches.front().fenceValue <= completedValue)
+    {
+        m_FreeAllocators.push_back(std::move(m_PendingBatches.front().commandAllocator));
+        m_PendingBatches.pop_front();
+    }
+}
+
+
+bool UploadManager::IsCompleted(u64 fenceValue) const
+{
+    return m_Fence->GetCompletedValue() >= fenceValue;
+}
+
+
+const UploadManagerStatistics& UploadManager::GetStatistics() const
+{
+    return m_Statistics;
+}
+
+
+const LinearRingAllocator& UploadManager::GetStagingAllocator() const
+{
+    return m_Staging.GetAllocator();
+}
+
+
+HRESULT UploadManager::BeginBatch()
+{
+    Reclaim();
+
+    std::unique_ptr<IGraphicsCommandAllocator> commandAllocator;
+    if (!m_FreeAllocators.empty())
+    {
+        commandAllocator = std::move(m_FreeAllocators.back());
+        m_FreeAllocators.pop_back();
+
+        HRESULT hr = commandAllocator->Reset();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+    else
+    {
+        HRESULT hr = m_pDevice->CreateCommandAllocator(COMMAND_LIST_TYPE_COPY, &commandAllocator);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    HRESULT hr = m_CommandList->Reset(commandAllocator.get(), nullptr);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_RecordingAllocator = std::move(commandAllocator);
+    return S_OK;
+}
+
+
+HRESULT UploadManager::WaitForStaging()
+{
+    // 記録中の分もステージングを使っているので、先に積む
+    u64 fenceValue = 0;
+    HRESULT hr = Flush(&fenceValue);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    hr = m_Fence->Wait(fenceValue);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    m_Statistics.stallCount++;
+    m_Statistics.stallMilliseconds += std::chrono::duration<f64, std::milli>(endTime - beginTime).count();
+
+    Reclaim();
+    return S_OK;
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+
+// 静的なデータ (頂点、インデックスなど) を DEFAULT ヒープのバッファへ転送する
+// ステージングリング (UploadRingBuffer) に書き込み、専用の COPY キューでコピーする
+// 複数の転送を 1 回の ExecuteCommandLists にまとめ、完了はフェンスで示す
+// 使う側のキューは WaitOnQueue で GPU 上で完了を待つ (CPU は待たない)
+// 転送先は COMMON で作っておけば COPY キューで暗黙に COPY_DEST になり、実行後は COMMON に戻るのでバリアは不要
+
+
+// 統計情報
+struct UploadManagerStatistics
+{
+    u64 uploadCount;       // UploadBuffer の呼び出し回数
+    u64 uploadedBytes;
+    u64 copyCount;         // 記録したコピー (分割した分を含む)
+    u64 batchCount;        // COPY キューへの ExecuteCommandLists の回数
+    u64 stallCount;        // ステージングが足りず CPU で待った回数
+    f64 stallMilliseconds;
+};
+
+
+class UploadManager
+{
+public:
+    UploadManager();
+
+    ~UploadManager();
+
+    HRESULT Init(IGraphicsDevice* pDevice, u64 stagingCapacity);
+
+    // 転送の完了を待ってから解放する
+    void Term();
+
+    // pDst への転送を記録する (Flush するまで実行されない)
+    // ステージングに収まらない大きさは分割し、空きが無ければ溜まった分を積んで待つ
+    HRESULT UploadBuffer(IGraphicsResource* pDst, u64 dstOffset, const void* pData, u64 size);
+
+    // 記録した転送を COPY キューに積み、完了を示すフェンス値を返す
+    // 記録が無ければ最後に積んだ値を返す
+    HRESULT Flush(u64* pFenceValue);
+
+    // pQueue の以降の処理を、fenceValue までの転送が終わるまで始めさせない
+    HRESULT WaitOnQueue(IGraphicsCommandQueue* pQueue, u64 fenceValue);
+
+    // 完了した転送のステージングとコマンドアロケータを再利用可能にする
+    void Reclaim();
+
+    bool IsCompleted(u64 fenceValue) const;
+
+    const UploadManagerStatistics& GetStatistics() const;
+
+    const LinearRingAllocator& GetStagingAllocator() const;
+
+private:
+    // COPY キューで実行中のまとまり
+    struct Batch
+    {
+        std::unique_ptr<IGraphicsCommandAllocator> commandAllocator;
+        u64                                        fenceValue;
+    };
+
+private:
+    HRESULT BeginBatch();
+
+    // 積んだ転送を全て待ってステージングを空ける
+    HRESULT WaitForStaging();
+
+private:
+    IGraphicsDevice*                                        m_pDevice;
+    std::unique_ptr<IGraphicsCommandQueue>                  m_CopyQueue;
+    std::unique_ptr<IGraphicsCommandList>                   m_CommandList;
+    std::unique_ptr<IGraphicsFence>                         m_Fence;
+    u64                                                     m_FenceValue; // 最後に積んだ値
+
+    UploadRingBuffer                                        m_Staging;
+    u64                                                     m_ChunkSize;  // 1 回のコピーの最大サイズ
+
+    std::unique_ptr<IGraphicsCommandAllocator>              m_RecordingAllocator; // 記録中のまとまり (無ければ nullptr)
+    std::deque<Batch>                                       m_PendingBatches;     // フェンス値の順
+    std::vector<std::unique_ptr<IGraphicsCommandAllocator>> m_FreeAllocators;
+
+    UploadManagerStatistics                                 m_Statistics;
+};
@@ -0,0 +1,101 @@
+﻿
+
+UploadRingBuffer::UploadRingBuffer()
+    : m_pCpuAddress(nullptr)
+    , m_GpuAddress(0)
+{
+
+}
+
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+    Term();
+}
+
+
+HRESULT UploadRingBuffer::Init(IGraphicsDevice* pDevice, u64 capacity)
+{
+    HRESULT hr = pDevice->CreateCommittedResource(
+        HEAP_TYPE_UPLOAD,
+        MakeBufferResourceDesc(capacity),
+        RESOURCE_STATE_GENERIC_READ,
+        &m_Buffer
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // UPLOAD ヒープは Map したままでよい
+    void* pData = nullptr;
+    hr = m_Buffer->Map(0, &pData);
+    if (FAILED(hr))
+    {
+        m_Buffer.reset();
+        return hr;
+    }
+
+    m_pCpuAddress = static_cast<u8*>(pData);
+    m_GpuAddress = m_Buffer->GetGPUVirtualAddress();
+    m_Allocator.Init(capacity);
+    return S_OK;
+}
+
+
+void UploadRingBuffer::Term()
+{
+    if (m_Buffer)
+    {
+        m_Buffer->Unmap(0);
+        m_Buffer.reset();
+    }
+    m_pCpuAddress = nullptr;
+    m_GpuAddress = 0;
+}
+
+
+bool UploadRingBuffer::Allocate(u64 size, u64 alignment, UploadAllocation* pOut)
+{
+    const u64 offset = m_Allocator.Allocate(size, alignment);
+    if (offset == LinearRingAllocator::InvalidOffset)
+    {
+        return false;
+    }
+
+    pOut->pResource = m_Buffer.get();
+    pOut->offset = offset;
+    pOut->size = size;
+    pOut->pCpuAddress = m_pCpuAddress + offset;
+    pOut->gpuAddress = m_GpuAddress + offset;
+    return true;
+}
+
+
+bool UploadRingBuffer::Upload(const void* pData, u64 size, u64 alignment, UploadAllocation* pOut)
+{
+    if (!Allocate(size, alignment, pOut))
+    {
+        return false;
+    }
+    std::memcpy(pOut->pCpuAddress, pData, static_cast<size_t>(size));
+    return true;
+}
+
+
+void UploadRingBuffer::FinishFrame(u64 fenceValue)
+{
+    m_Allocator.FinishFrame(fenceValue);
+}
+
+
+void UploadRingBuffer::Reclaim(u64 completedFenceValue)
+{
+    m_Allocator.Reclaim(completedFenceValue);
+}
+
+
+const LinearRingAllocator& UploadRingBuffer::GetAllocator() const
+{
+    return m_Allocator;
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+
+// 毎フレーム書き換えるデータ (定数、頂点など) 用のアップロードバッファ
+// UPLOAD ヒープのバッファを 1 つ作って Map したままにし、LinearRingAllocator で切り出す
+// 確保ごとのリソース作成や Map / Unmap は行わない
+
+
+// 切り出した領域
+struct UploadAllocation
+{
+    IGraphicsResource* pResource;
+    u64                offset;      // pResource 内のオフセット
+    u64                size;
+    void*              pCpuAddress; // 書き込み先
+    u64                gpuAddress;  // ビューに設定するアドレス
+};
+
+
+class UploadRingBuffer
+{
+public:
+    UploadRingBuffer();
+
+    ~UploadRingBuffer();
+
+    HRESULT Init(IGraphicsDevice* pDevice, u64 capacity);
+
+    void Term();
+
+    // alignment は 2 のべき乗 (空きが無ければ false)
+    bool Allocate(u64 size, u64 alignment, UploadAllocation* pOut);
+
+    // データをコピーして確保
+    bool Upload(const void* pData, u64 size, u64 alignment, UploadAllocation* pOut);
+
+    // このフレームの確保をキューに積んだフェンス値に結び付ける
+    void FinishFrame(u64 fenceValue);
+
+    // GPU が完了したフレームの領域を再利用可能にする
+    void Reclaim(u64 completedFenceValue);
+
+    const LinearRingAllocator& GetAllocator() const;
+
+private:
+    std::unique_ptr<IGraphicsResource> m_Buffer;
+    u8*                                m_pCpuAddress;
+    u64                                m_GpuAddress;
+    LinearRingAllocator                m_Allocator;
+};
@@ -0,0 +1,155 @@
+﻿#pragma once
+
+
+// 128 ビットのハッシュ (内容をキーにするキャッシュ用、暗号用途ではない)
+// 8 バイト単位で 2 系統を混ぜ、最後に長さと合わせて撹拌する
+struct Hash128
+{
+    u64 low;
+    u64 high;
+};
+
+
+inline bool operator==(const Hash128& a, const Hash128& b)
+{
+    return a.low == b.low && a.high == b.high;
+}
+
+
+inline bool operator!=(const Hash128& a, const Hash128& b)
+{
+    return !(a == b);
+}
+
+
+// std::unordered_map 用 (既に撹拌済みなので下位をそのまま使う)
+struct Hash128Hasher
+{
+    size_t operator()(const Hash128& hash) const
+    {
+        return static_cast<size_t>(hash.low);
+    }
+};
+
+
+// 32 文字の 16 進文字列
+inline std::string ToHexString(const Hash128& hash)
+{
+    char text[33];
+    std::snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(hash.high), static_cast<unsigned long long>(hash.low));
+    return text;
+}
+
+
+class Hasher128
+{
+public:
+    Hasher128()
+        : m_Low(0x9E3779B97F4A7C15ull)
+        , m_High(0xC2B2AE3D27D4EB4Full)
+        , m_Length(0)
+        , m_Tail(0)
+        , m_TailSize(0)
+    {
+
+    }
+
+    void Update(const void* pData, size_t size)
+    {
+        const u8* pBytes = static_cast<const u8*>(pData);
+        m_Length += size;
+
+        // 前回の端数を埋める
+        while (m_TailSize != 0 && size > 0)
+        {
+            m_Tail |= static_cast<u64>(*pBytes++) << (m_TailSize * 8);
+            size--;
+            if (++m_TailSize == 8)
+            {
+                Mix(m_Tail);
+                m_Tail = 0;
+                m_TailSize = 0;
+            }
+        }
+
+        for (; size >= 8; size -= 8, pBytes += 8)
+        {
+            u64 word;
+            std::memcpy(&word, pBytes, sizeof(word));
+            Mix(word);
+        }
+
+        for (; size > 0; size--)
+        {
+            m_Tail |= static_cast<u64>(*pBytes++) << (m_TailSize * 8);
+            m_TailSize++;
+        }
+    }
+
+    // 長さも含めるので、続けて渡した文字列の区切りが変わると別の値になる
+    void UpdateString(const std::string& text)
+    {
+        UpdateValue(static_cast<u64>(text.size()));
+        Update(text.data(), text.size());
+    }
+
+    template<class T>
+    void UpdateValue(const T& value)
+    {
+        Update(&value, sizeof(value));
+    }
+
+    Hash128 Finish() const
+    {
+        u64 low = m_Low;
+        u64 high = m_High;
+        if (m_TailSize != 0)
+        {
+            low ^= m_Tail * 0x87C37B91114253D5ull;
+            high ^= RotateLeft(m_Tail, 31) * 0x4CF5AD432745937Full;
+        }
+        low ^= m_Length;
+        high ^= m_Length;
+
+        low += high;
+        high += low;
+        low = Finalize(low);
+        high = Finalize(high);
+        low += high;
+        high += low;
+
+        Hash128 hash = { low, high };
+        return hash;
+    }
+
+private:
+    static u64 RotateLeft(u64 value, u32 shift)
+    {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    // MurmurHash3 の最終撹拌
+    static u64 Finalize(u64 value)
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    void Mix(u64 word)
+    {
+        m_Low = RotateLeft(m_Low ^ (word * 0x87C37B91114253D5ull), 27) * 5 + 0x52DCE729;
+        m_High = RotateLeft(m_High ^ (RotateLeft(word, 31) * 0x4CF5AD432745937Full), 31) * 5 + 0x38495AB5;
+        m_High += m_Low;
+    }
+
+private:
+    u64 m_Low;
+    u64 m_High;
+    u64 m_Length;
+    u64 m_Tail;
+    u32 m_TailSize;
+};
@@ -0,0 +1,139 @@
+﻿
+
+MappedFile::MappedFile()
+    : m_pData(nullptr)
+    , m_Size(0)
+#if defined(_WIN32)
+    , m_File(INVALID_HANDLE_VALUE)
+    , m_Mapping(nullptr)
+#endif
+{
+
+}
+
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_Mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    m_pData = static_cast<const u8*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr)
+    {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+    if (m_Mapping != nullptr)
+    {
+        CloseHandle(m_Mapping);
+        m_Mapping = nullptr;
+    }
+    if (m_File != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+    m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat status = {};
+    if (fstat(file, &status) != 0 || status.st_size <= 0)
+    {
+        close(file);
+        return false;
+    }
+
+    // マップはファイルを閉じても残る
+    void* pData = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (pData == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_pData = static_cast<const u8*>(pData);
+    m_Size = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr)
+    {
+        munmap(const_cast<u8*>(m_pData), m_Size);
+        m_pData = nullptr;
+    }
+    m_Size = 0;
+}
+
+#endif // defined(_WIN32)
+
+
+bool MappedFile::IsOpen() const
+{
+    return m_pData != nullptr;
+}
+
+
+const u8* MappedFile::GetData() const
+{
+    return m_pData;
+}
+
+
+size_t MappedFile::GetSize() const
+{
+    return m_Size;
+}
@@ -0,0 +1,35 @@
+﻿#pragma once
+
+
+// 読み込み専用でメモリにマップしたファイル
+// 内容はページ単位で必要になったときに読まれる
+class MappedFile
+{
+public:
+    MappedFile();
+
+    ~MappedFile();
+
+    // 失敗時は false (空のファイルも失敗)
+    bool Open(const std::string& path);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    const u8* GetData() const;
+
+    size_t GetSize() const;
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+private:
+    const u8* m_pData;
+    size_t    m_Size;
+#if defined(_WIN32)
+    HANDLE    m_File;
+    HANDLE    m_Mapping;
+#endif
+};
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+
+// ビット操作 (value が 0 のときの結果は不定)
+
+
+// 最下位の 1 のビット位置
+inline u32 FindFirstSetBit(u64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return static_cast<u32>(__builtin_ctzll(value));
+#endif
+}
+
+
+// 最上位の 1 のビット位置 (= floor(log2(value)))
+inline u32 FindLastSetBit(u64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<u32>(index);
+#else
+    return 63 - static_cast<u32>(__builtin_clzll(value));
+#endif
+}
+
+
+// alignment (2 のべき乗) の倍数に切り上げ
+inline u64 AlignUp(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
@@ -0,0 +1,99 @@
+﻿
+
+LinearRingAllocator::LinearRingAllocator()
+    : m_Capacity(0)
+    , m_Head(0)
+    , m_Tail(0)
+    , m_Statistics()
+{
+
+}
+
+
+LinearRingAllocator::~LinearRingAllocator()
+{
+
+}
+
+
+void LinearRingAllocator::Init(u64 capacity)
+{
+    m_Capacity = capacity;
+    m_Head = 0;
+    m_Tail = 0;
+    m_Frames.clear();
+    m_Statistics = LinearRingAllocatorStatistics();
+}
+
+
+u64 LinearRingAllocator::Allocate(u64 size, u64 alignment)
+{
+    if (size == 0 || size > m_Capacity)
+    {
+        m_Statistics.failedCount++;
+        return InvalidOffset;
+    }
+
+    // リング上の位置でアライメントを取り、末尾をまたぐなら先頭へ折り返す
+    u64 head = m_Head;
+    u64 offset = (head % m_Capacity + alignment - 1) & ~(alignment - 1);
+    bool isWrapped = false;
+    if (offset + size > m_Capacity)
+    {
+        head += m_Capacity - head % m_Capacity;
+        offset = 0;
+        isWrapped = true;
+    }
+    const u64 newHead = head - head % m_Capacity + offset + size;
+
+    // 解放されていない区間に追いつくなら失敗
+    if (newHead - m_Tail > m_Capacity)
+    {
+        m_Statistics.failedCount++;
+        return InvalidOffset;
+    }
+
+    m_Statistics.allocationCount++;
+    m_Statistics.allocatedBytes += size;
+    m_Statistics.paddingBytes += newHead - m_Head - size;
+    m_Statistics.wrapCount += isWrapped ? 1 : 0;
+    m_Head = newHead;
+    m_Statistics.peakUsedBytes = std::max(m_Statistics.peakUsedBytes, m_Head - m_Tail);
+    return offset;
+}
+
+
+void LinearRingAllocator::FinishFrame(u64 fenceValue)
+{
+    // 確保が無くても区切りは積む (Reclaim の順序を保つため)
+    FrameMarker marker = { fenceValue, m_Head };
+    m_Frames.push_back(marker);
+}
+
+
+void LinearRingAllocator::Reclaim(u64 completedFenceValue)
+{
+    while (!m_Frames.empty() && m_Frames.front().fenceValue <= completedFenceValue)
+    {
+        m_Tail = m_Frames.front().end;
+        m_Frames.pop_front();
+    }
+}
+
+
+u64 LinearRingAllocator::GetCapacity() const
+{
+    return m_Capacity;
+}
+
+
+u64 LinearRingAllocator::GetUsedSize() const
+{
+    return m_Head - m_Tail;
+}
+
+
+const LinearRingAllocatorStatistics& LinearRingAllocator::GetStatistics() const
+{
+    return m_Statistics;
+}
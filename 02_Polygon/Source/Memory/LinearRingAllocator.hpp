@@ -0,0 +1,63 @@
+﻿#pragma once
+
+
+// フェンス値で解放するリング状の線形アロケータ
+// メモリそのものは持たず、[0, capacity) のオフセットだけを管理する (GPU に依存しない)
+//   Allocate    : 先頭を進めて切り出す (解放は個別に行わない)
+//   FinishFrame : それまでの確保をフェンス値で区切る
+//   Reclaim     : 完了したフェンス値までの区間をまとめて解放する
+
+
+// 統計情報
+struct LinearRingAllocatorStatistics
+{
+    u64 allocationCount;
+    u64 allocatedBytes;
+    u64 paddingBytes;     // アライメントと折り返しで捨てたバイト数
+    u64 wrapCount;        // 末尾から先頭へ折り返した回数
+    u64 failedCount;      // 空きが足りず失敗した回数
+    u64 peakUsedBytes;
+};
+
+
+class LinearRingAllocator
+{
+public:
+    static const u64 InvalidOffset = ~0ull;
+
+    LinearRingAllocator();
+
+    ~LinearRingAllocator();
+
+    void Init(u64 capacity);
+
+    // alignment は 2 のべき乗 (失敗時は InvalidOffset)
+    u64 Allocate(u64 size, u64 alignment);
+
+    // ここまでの確保を fenceValue の完了で解放できるものとする
+    void FinishFrame(u64 fenceValue);
+
+    // completedFenceValue までに完了したフレームの区間を解放
+    void Reclaim(u64 completedFenceValue);
+
+    u64 GetCapacity() const;
+
+    u64 GetUsedSize() const;
+
+    const LinearRingAllocatorStatistics& GetStatistics() const;
+
+private:
+    // フレームの区切り (m_Head の位置を記録する)
+    struct FrameMarker
+    {
+        u64 fenceValue;
+        u64 end;
+    };
+
+private:
+    u64                           m_Capacity;
+    u64                           m_Head; // 次に確保する位置 (折り返さずに増え続ける)
+    u64                           m_Tail; // 使用中の先頭 (同上)
+    std::deque<FrameMarker>       m_Frames;
+    LinearRingAllocatorStatistics m_Statistics;
+};
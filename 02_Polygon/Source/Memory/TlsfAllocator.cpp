@@ -0,0 +1,332 @@
+﻿
+
+TlsfAllocator::TlsfAllocator()
+    : m_Capacity(0)
+    , m_Granularity(1)
+    , m_GranularityLog2(0)
+    , m_FirstBlock(InvalidNode)
+    , m_FirstLevelBitmap(0)
+    , m_SecondLevelBitmaps()
+    , m_FreeLists()
+    , m_UsedBytes(0)
+    , m_AllocationCount(0)
+    , m_FreeBlockCount(0)
+{
+
+}
+
+
+TlsfAllocator::~TlsfAllocator()
+{
+
+}
+
+
+void TlsfAllocator::Init(u64 capacity, u64 granularity)
+{
+    m_Granularity = granularity;
+    m_GranularityLog2 = FindLastSetBit(granularity);
+    m_Capacity = capacity & ~(granularity - 1); // 端数は使わない
+    m_Blocks.clear();
+    m_UnusedBlocks.clear();
+    m_FirstLevelBitmap = 0;
+    std::fill_n(m_SecondLevelBitmaps, FirstLevelCount, 0u);
+    std::fill_n(&m_FreeLists[0][0], FirstLevelCount * SecondLevelCount, static_cast<u32>(InvalidNode));
+    m_UsedBytes = 0;
+    m_AllocationCount = 0;
+    m_FreeBlockCount = 0;
+
+    m_FirstBlock = InvalidNode;
+    if (m_Capacity > 0)
+    {
+        m_FirstBlock = CreateBlock(0, m_Capacity);
+        InsertFreeBlock(m_FirstBlock);
+    }
+}
+
+
+bool TlsfAllocator::Allocate(u64 size, u64 alignment, TlsfAllocation* pOut)
+{
+    if (size == 0 || size > m_Capacity)
+    {
+        return false;
+    }
+    size = AlignUp(size, m_Granularity);
+    alignment = std::max(alignment, m_Granularity);
+
+    // アライメントのずれを吸収できる大きさで探す
+    const u64 searchSize = size + (alignment - m_Granularity);
+    const u32 index = FindFreeBlock(searchSize);
+    if (index == InvalidNode)
+    {
+        return false;
+    }
+    RemoveFreeBlock(index);
+
+    // 前側の余りを空きブロックとして切り離す (直前のブロックは使用中なので結合は不要)
+    const u64 alignedOffset = AlignUp(m_Blocks[index].offset, alignment);
+    const u64 padding = alignedOffset - m_Blocks[index].offset;
+    if (padding > 0)
+    {
+        const u32 paddingIndex = CreateBlock(m_Blocks[index].offset, padding);
+        Block& paddingBlock = m_Blocks[paddingIndex];
+        paddingBlock.prevPhysical = m_Blocks[index].prevPhysical;
+        paddingBlock.nextPhysical = index;
+        if (paddingBlock.prevPhysical != InvalidNode)
+        {
+            m_Blocks[paddingBlock.prevPhysical].nextPhysical = paddingIndex;
+        }
+        else
+        {
+            m_FirstBlock = paddingIndex;
+        }
+        m_Blocks[index].prevPhysical = paddingIndex;
+        m_Blocks[index].offset = alignedOffset;
+        m_Blocks[index].size -= padding;
+        InsertFreeBlock(paddingIndex);
+    }
+
+    // 後ろ側の余りを空きブロックとして切り離す
+    if (m_Blocks[index].size > size)
+    {
+        const u32 remainderIndex = CreateBlock(alignedOffset + size, m_Blocks[index].size - size);
+        Block& remainderBlock = m_Blocks[remainderIndex];
+        remainderBlock.prevPhysical = index;
+        remainderBlock.nextPhysical = m_Blocks[index].nextPhysical;
+        if (remainderBlock.nextPhysical != InvalidNode)
+        {
+            m_Blocks[remainderBlock.nextPhysical].prevPhysical = remainderIndex;
+        }
+        m_Blocks[index].nextPhysical = remainderIndex;
+        m_Blocks[index].size = size;
+        InsertFreeBlock(remainderIndex);
+    }
+
+    m_UsedBytes += size;
+    m_AllocationCount++;
+
+    pOut->handle = index;
+    pOut->offset = alignedOffset;
+    pOut->size = size;
+    return true;
+}
+
+
+void TlsfAllocator::Free(u32 handle)
+{
+    u32 index = handle;
+    m_UsedBytes -= m_Blocks[index].size;
+    m_AllocationCount--;
+
+    // 前後の空きブロックと結合する
+    const u32 prevIndex = m_Blocks[index].prevPhysical;
+    if (prevIndex != InvalidNode && m_Blocks[prevIndex].isFree)
+    {
+        RemoveFreeBlock(prevIndex);
+        m_Blocks[prevIndex].size += m_Blocks[index].size;
+        m_Blocks[prevIndex].nextPhysical = m_Blocks[index].nextPhysical;
+        if (m_Blocks[index].nextPhysical != InvalidNode)
+        {
+            m_Blocks[m_Blocks[index].nextPhysical].prevPhysical = prevIndex;
+        }
+        DestroyBlock(index);
+        index = prevIndex;
+    }
+
+    const u32 nextIndex = m_Blocks[index].nextPhysical;
+    if (nextIndex != InvalidNode && m_Blocks[nextIndex].isFree)
+    {
+        RemoveFreeBlock(nextIndex);
+        m_Blocks[index].size += m_Blocks[nextIndex].size;
+        m_Blocks[index].nextPhysical = m_Blocks[nextIndex].nextPhysical;
+        if (m_Blocks[nextIndex].nextPhysical != InvalidNode)
+        {
+            m_Blocks[m_Blocks[nextIndex].nextPhysical].prevPhysical = index;
+        }
+        DestroyBlock(nextIndex);
+    }
+
+    InsertFreeBlock(index);
+}
+
+
+bool TlsfAllocator::IsEmpty() const
+{
+    return m_AllocationCount == 0;
+}
+
+
+void TlsfAllocator::GetStatistics(TlsfAllocatorStatistics* pOut) const
+{
+    pOut->capacity = m_Capacity;
+    pOut->usedBytes = m_UsedBytes;
+    pOut->freeBytes = m_Capacity - m_UsedBytes;
+    pOut->allocationCount = m_AllocationCount;
+    pOut->freeBlockCount = m_FreeBlockCount;
+
+    // 最大の空きブロックは、空でない最上位のリストにある
+    pOut->largestFreeBytes = 0;
+    if (m_FirstLevelBitmap != 0)
+    {
+        const u32 firstLevel = FindLastSetBit(m_FirstLevelBitmap);
+        const u32 secondLevel = FindLastSetBit(m_SecondLevelBitmaps[firstLevel]);
+        for (u32 index = m_FreeLists[firstLevel][secondLevel]; index != InvalidNode; index = m_Blocks[index].nextFree)
+        {
+            pOut->largestFreeBytes = std::max(pOut->largestFreeBytes, m_Blocks[index].size);
+        }
+    }
+}
+
+
+f64 TlsfAllocator::GetFragmentation() const
+{
+    TlsfAllocatorStatistics statistics;
+    GetStatistics(&statistics);
+    if (statistics.freeBytes == 0)
+    {
+        return 0.0;
+    }
+    return 1.0 - static_cast<f64>(statistics.largestFreeBytes) / static_cast<f64>(statistics.freeBytes);
+}
+
+
+void TlsfAllocator::GetAllocations(std::vector<TlsfAllocation>* pOut) const
+{
+    pOut->clear();
+    for (u32 index = m_FirstBlock; index != InvalidNode; index = m_Blocks[index].nextPhysical)
+    {
+        const Block& block = m_Blocks[index];
+        if (!block.isFree)
+        {
+            TlsfAllocation allocation = { index, block.offset, block.size };
+            pOut->push_back(allocation);
+        }
+    }
+}
+
+
+void TlsfAllocator::Mapping(u64 units, u32* pFirstLevel, u32* pSecondLevel)
+{
+    if (units < SecondLevelCount)
+    {
+        // 小さいサイズは第 1 レベル 0 に線形に並べる
+        *pFirstLevel = 0;
+        *pSecondLevel = static_cast<u32>(units);
+        return;
+    }
+
+    const u32 log2 = FindLastSetBit(units);
+    *pFirstLevel = log2 - SecondLevelLog2 + 1;
+    *pSecondLevel = static_cast<u32>(units >> (log2 - SecondLevelLog2)) - SecondLevelCount;
+}
+
+
+u32 TlsfAllocator::CreateBlock(u64 offset, u64 size)
+{
+    Block block = { offset, size, InvalidNode, InvalidNode, InvalidNode, InvalidNode, false };
+    if (!m_UnusedBlocks.empty())
+    {
+        const u32 index = m_UnusedBlocks.back();
+        m_UnusedBlocks.pop_back();
+        m_Blocks[index] = block;
+        return index;
+    }
+    m_Blocks.push_back(block);
+    return static_cast<u32>(m_Blocks.size() - 1);
+}
+
+
+void TlsfAllocator::DestroyBlock(u32 index)
+{
+    m_UnusedBlocks.push_back(index);
+}
+
+
+void TlsfAllocator::InsertFreeBlock(u32 index)
+{
+    u32 firstLevel;
+    u32 secondLevel;
+    Mapping(m_Blocks[index].size >> m_GranularityLog2, &firstLevel, &secondLevel);
+
+    Block& block = m_Blocks[index];
+    const u32 head = m_FreeLists[firstLevel][secondLevel];
+    block.isFree = true;
+    block.prevFree = InvalidNode;
+    block.nextFree = head;
+    if (head != InvalidNode)
+    {
+        m_Blocks[head].prevFree = index;
+    }
+    m_FreeLists[firstLevel][secondLevel] = index;
+
+    m_FirstLevelBitmap |= 1ull << firstLevel;
+    m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+    m_FreeBlockCount++;
+}
+
+
+void TlsfAllocator::RemoveFreeBlock(u32 index)
+{
+    u32 firstLevel;
+    u32 secondLevel;
+    Mapping(m_Blocks[index].size >> m_GranularityLog2, &firstLevel, &secondLevel);
+
+    Block& block = m_Blocks[index];
+    if (block.prevFree != InvalidNode)
+    {
+        m_Blocks[block.prevFree].nextFree = block.nextFree;
+    }
+    else
+    {
+        m_FreeLists[firstLevel][secondLevel] = block.nextFree;
+    }
+    if (block.nextFree != InvalidNode)
+    {
+        m_Blocks[block.nextFree].prevFree = block.prevFree;
+    }
+    block.isFree = false;
+
+    if (m_FreeLists[firstLevel][secondLevel] == InvalidNode)
+    {
+        m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+        if (m_SecondLevelBitmaps[firstLevel] == 0)
+        {
+            m_FirstLevelBitmap &= ~(1ull << firstLevel);
+        }
+    }
+    m_FreeBlockCount--;
+}
+
+
+u32 TlsfAllocator::FindFreeBlock(u64 size) const
+{
+    // リスト内のどのブロックでも足りるように、次の区切りまで切り上げてから探す
+    u64 units = size >> m_GranularityLog2;
+    if (units >= SecondLevelCount)
+    {
+        units += (1ull << (FindLastSetBit(units) - SecondLevelLog2)) - 1;
+    }
+
+    u32 firstLevel;
+    u32 secondLevel;
+    Mapping(units, &firstLevel, &secondLevel);
+    if (firstLevel >= FirstLevelCount)
+    {
+        return InvalidNode;
+    }
+
+    u32 secondLevelMap = m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0)
+    {
+        // 同じ第 1 レベルに無ければ、より大きい第 1 レベルから探す
+        const u64 firstLevelMap = (firstLevel + 1 < 64) ? (m_FirstLevelBitmap & (~0ull << (firstLevel + 1))) : 0;
+        if (firstLevelMap == 0)
+        {
+            return InvalidNode;
+        }
+        firstLevel = FindFirstSetBit(firstLevelMap);
+        secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+    }
+    secondLevel = FindFirstSetBit(secondLevelMap);
+    return m_FreeLists[firstLevel][secondLevel];
+}
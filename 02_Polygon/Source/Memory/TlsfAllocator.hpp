@@ -0,0 +1,110 @@
+﻿#pragma once
+
+
+// TLSF (Two-Level Segregated Fit) アロケータ
+// メモリそのものは持たず、[0, capacity) のオフセットだけを管理する (GPU に依存しない)
+// 空き領域をサイズで 2 段階に分類したリストとビットマップで管理し、確保・解放とも O(1)
+// ブロックの情報は管理対象のメモリの外 (ノード配列) に持つので、GPU のヒープにも使える
+
+
+// 確保した領域
+struct TlsfAllocation
+{
+    u32 handle; // 解放に使う
+    u64 offset;
+    u64 size;
+};
+
+
+// 統計情報
+struct TlsfAllocatorStatistics
+{
+    u64 capacity;
+    u64 usedBytes;
+    u64 freeBytes;
+    u64 largestFreeBytes;
+    u32 allocationCount;
+    u32 freeBlockCount;
+};
+
+
+class TlsfAllocator
+{
+public:
+    static const u32 InvalidHandle = 0xFFFFFFFF;
+
+    TlsfAllocator();
+
+    ~TlsfAllocator();
+
+    // granularity は 2 のべき乗 (サイズとオフセットはこの倍数に切り上げる)
+    void Init(u64 capacity, u64 granularity);
+
+    // alignment は 2 のべき乗 (空きが無ければ false)
+    bool Allocate(u64 size, u64 alignment, TlsfAllocation* pOut);
+
+    void Free(u32 handle);
+
+    bool IsEmpty() const;
+
+    void GetStatistics(TlsfAllocatorStatistics* pOut) const;
+
+    // 空き領域の断片化の度合い (0 なら 1 つにまとまっている、1 に近いほど細切れ)
+    f64 GetFragmentation() const;
+
+    // 使用中の領域をオフセット順に列挙 (デフラグで移動するものを選ぶのに使う)
+    void GetAllocations(std::vector<TlsfAllocation>* pOut) const;
+
+private:
+    // 第 2 レベルの分割数
+    static const u32 SecondLevelLog2 = 4;
+    static const u32 SecondLevelCount = 1 << SecondLevelLog2;
+
+    // 第 1 レベルの数 (64bit のサイズを全て表せる数)
+    static const u32 FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+    static const u32 InvalidNode = 0xFFFFFFFF;
+
+    // 物理的に隣接するブロックと、同じ空きリストのブロックを双方向につなぐ
+    struct Block
+    {
+        u64  offset;
+        u64  size;
+        u32  prevPhysical;
+        u32  nextPhysical;
+        u32  prevFree;
+        u32  nextFree;
+        bool isFree;
+    };
+
+private:
+    // サイズ (granularity 単位) からリストの位置を求める
+    static void Mapping(u64 units, u32* pFirstLevel, u32* pSecondLevel);
+
+    u32 CreateBlock(u64 offset, u64 size);
+
+    void DestroyBlock(u32 index);
+
+    void InsertFreeBlock(u32 index);
+
+    void RemoveFreeBlock(u32 index);
+
+    // size 以上の空きブロックを探す (見つからなければ InvalidNode)
+    u32 FindFreeBlock(u64 size) const;
+
+private:
+    u64                m_Capacity;
+    u64                m_Granularity;
+    u32                m_GranularityLog2;
+    u32                m_FirstBlock;
+    std::vector<Block> m_Blocks;
+    std::vector<u32>   m_UnusedBlocks; // m_Blocks の空き番号
+
+    u64 m_FirstLevelBitmap;
+    u32 m_SecondLevelBitmaps[FirstLevelCount];
+    u32 m_FreeLists[FirstLevelCount][SecondLevelCount];
+
+    u64 m_UsedBytes;
+    u32 m_AllocationCount;
+    u32 m_FreeBlockCount;
+};
@@ -7,6 +7,8 @@
 //-----------------------------------------------------------------
 // Windows 関連
 //-----------------------------------------------------------------
+#if defined(_WIN32)
+
 #if !defined(STRICT)
 #   define STRICT
 #endif
@@ -37,6 +39,8 @@
 template<class T>
 using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+#endif // defined(_WIN32)
+
 
 //-----------------------------------------------------------------
 // STL 関連
@@ -47,9 +51,43 @@ using ComPtr = Microsoft::WRL::ComPtr<T>;
 #endif
 
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cstring>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
 #include <string>
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+
+//-----------------------------------------------------------------
+// SIMD 関連
+//-----------------------------------------------------------------
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define SIMD_ENABLE_SSE2
+#   include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#   define SIMD_ENABLE_AVX2
+#   include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h> // _BitScanForward64 など
+#endif
 
 
 //-----------------------------------------------------------------
@@ -69,6 +107,103 @@ typedef float  f32;
 typedef double f64;
 
 
+//-----------------------------------------------------------------
+// Windows 以外の互換定義
+//-----------------------------------------------------------------
+#if !defined(_WIN32)
+
+#include <sys/stat.h> // mkdir, fstat
+#include <sys/mman.h> // mmap
+#include <fcntl.h>    // open
+#include <unistd.h>   // close
+#include <sys/inotify.h> // inotify
+#include <sched.h>    // sched_setaffinity
+
+typedef s32 HRESULT;
+
+#define S_OK                    ((HRESULT)0x00000000L)
+#define S_FALSE                 ((HRESULT)0x00000001L)
+#define E_NOTIMPL               ((HRESULT)0x80004001L)
+#define E_FAIL                  ((HRESULT)0x80004005L)
+#define E_OUTOFMEMORY           ((HRESULT)0x8007000EL)
+#define E_INVALIDARG            ((HRESULT)0x80070057L)
+#define ERROR_FILE_NOT_FOUND    2L
+#define SUCCEEDED(hr)           (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)              (((HRESULT)(hr)) < 0)
+#define HRESULT_FROM_WIN32(x)   ((HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000))
+
+#define _countof(a) (sizeof(a) / sizeof((a)[0]))
+
+#endif // !defined(_WIN32)
+
+
+//-----------------------------------------------------------------
+// デバッグ関連
+//-----------------------------------------------------------------
+#include "DebugUtil.hpp"
+
+
+//-----------------------------------------------------------------
+// ハッシュ
+//-----------------------------------------------------------------
+#include "HashUtil.hpp"
+
+
+//-----------------------------------------------------------------
+// ファイル
+//-----------------------------------------------------------------
+#include "MappedFile.hpp"
+#include "FileWatcher.hpp"
+
+
+//-----------------------------------------------------------------
+// メモリ管理
+//-----------------------------------------------------------------
+#include "Memory/BitUtil.hpp"
+#include "Memory/LinearRingAllocator.hpp"
+#include "Memory/TlsfAllocator.hpp"
+
+
+//-----------------------------------------------------------------
+// タスク
+//-----------------------------------------------------------------
+#include "Task/CpuTopology.hpp"
+#include "Task/TaskScheduler.hpp"
+#include "Task/RadixSorter.hpp"
+
+
+//-----------------------------------------------------------------
+// グラフィックス関連
+//-----------------------------------------------------------------
+#include "Graphics/GraphicsTypes.hpp"
+#include "Graphics/Graphics.hpp"
+#include "Graphics/ShaderCompiler.hpp"
+#include "Graphics/ShaderCache.hpp"
+#include "Graphics/ShaderArchive.hpp"
+#include "Graphics/ShaderReflection.hpp"
+#include "Graphics/ShaderPermutation.hpp"
+#include "Graphics/UploadRingBuffer.hpp"
+#include "Graphics/GpuHeapAllocator.hpp"
+#include "Graphics/UploadManager.hpp"
+#include "Graphics/DescriptorAllocator.hpp"
+#include "Graphics/ResourceStateTracker.hpp"
+#include "Graphics/CommandListPool.hpp"
+#include "Graphics/StateFilterCommandList.hpp"
+#include "Graphics/DrawQueue.hpp"
+#include "Graphics/RenderGraph.hpp"
+#include "Graphics/PipelineStateCache.hpp"
+#include "Graphics/PipelineTrace.hpp"
+#include "Graphics/ShaderHotReloader.hpp"
+#include "Graphics/D3D12/GraphicsD3D12.hpp"
+#include "Graphics/D3D12/ShaderCompilerD3D12.hpp"
+#include "Graphics/Null/NullCommandStream.hpp"
+#include "Graphics/Null/GraphicsNull.hpp"
+#include "Graphics/Null/ShaderCompilerNull.hpp"
+#include "Graphics/Software/SoftwareShader.hpp"
+#include "Graphics/Software/SoftwareRasterizer.hpp"
+#include "Graphics/Software/GraphicsSoftware.hpp"
+#include "Graphics/Software/ShaderCompilerSoftware.hpp"
+
 
 //-----------------------------------------------------------------
 // アプリケーション関連
@@ -76,6 +211,7 @@ typedef double f64;
 #include "KeyCode.hpp"
 #include "App.hpp"
 #include "AppWin.hpp"
+#include "AppHeadless.hpp"
 #include "Sample/ResultUtil.hpp"
 #include "Sample/SampleApp.hpp"
 #include "Sample/Vertex.hpp"
@@ -0,0 +1,12 @@
+﻿
+
+#if !defined(_WIN32)
+
+int main(int argc, char** argv)
+{
+    AppMain(argc, argv);
+
+    return 0;
+}
+
+#endif
@@ -14,6 +14,7 @@ ResultUtil::ResultUtil(HRESULT hr)
     m_HRESULT = hr;
     m_IsSucceeded = SUCCEEDED(hr);
 
+#if defined(_WIN32)
     LPVOID lpMsgBuf;
 
     FormatMessageA(
@@ -36,6 +37,12 @@ ResultUtil::ResultUtil(HRESULT hr)
 
     // バッファを解放する。
     LocalFree(lpMsgBuf);
+#else
+    // システムのメッセージが無いのでコードのみ
+    char buff[32];
+    std::snprintf(buff, sizeof(buff), "HRESULT 0x%08X", static_cast<u32>(hr));
+    m_Text = buff;
+#endif
 }
 
 ResultUtil::~ResultUtil()
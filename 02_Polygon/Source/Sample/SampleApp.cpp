@@ -1,52 +1,127 @@
 ﻿#include "SampleApp.hpp"
 
 
-// DXGI & D3D12 のライブラリをリンク
-#pragma comment(lib, "dxgi.lib")
-#pragma comment(lib, "d3d12.lib")
-#pragma comment(lib, "d3dcompiler.lib")
+// 入力レイアウトの実体
+constexpr InputElementDesc Vertex_Position::pInputElementDescs[];
 
 
-void DebugOutputFormatString(const char* format, ...)
+// 静的なバッファを置くヒープ 1 つのサイズ
+static const u64 BufferHeapBlockSize = 4 * 1024 * 1024;
+
+// 転送用のステージングリングのサイズ
+static const u64 UploadStagingSize = 1024 * 1024;
+
+// 1 フレームあたりのシェーダーから見えるディスクリプタの数
+static const u32 DescriptorRingSizePerFrame = 256;
+
+
+// 四角形 (初期化時に DEFAULT ヒープへ転送する)
+static const Vertex_Position QuadVertices[] = {
+    { { -0.4f, -0.7f,  0.0f }, },
+    { { -0.4f,  0.7f,  0.0f }, },
+    { {  0.4f, -0.7f,  0.0f }, },
+    { {  0.4f,  0.7f,  0.0f }, },
+};
+
+static const u16 QuadIndices[] = {
+    0, 1, 2,
+    2, 1, 3,
+};
+
+
+// 使うシェーダー (アーカイブを作るときはこれの既定のバリアントと、前回使ったバリアントをコンパイルする)
+struct SampleShader
 {
-    char buff[1024];
-    va_list valist;
-    va_start(valist, format);
-    vsprintf_s(buff, format, valist);
-    va_end(valist);
+    const char*              filePath;
+    const char*              entryPoint;
+    const char*              target;
+    const ShaderFeatureDesc* pFeatures;
+    u32                      featureCount;
+};
 
-    size_t length = strnlen_s(buff, 1024);
+static const ShaderFeatureDesc BasicPixelShaderFeatures[] = {
+    { "COLOR_MODE", 4 },
+};
 
-    if (length < 1023)
-    {
-        buff[length] = '\n';
-        buff[length + 1] = '\0';
-        OutputDebugStringA(buff);
-    }
-    else
-    {
-        OutputDebugStringA(buff);
-        OutputDebugStringA("\n");
-    }
-}
+static const SampleShader BasicVertexShader = { "Shaders/Basic_VS.hlsl", "main", "vs_5_0", nullptr, 0 };
+static const SampleShader BasicPixelShader = { "Shaders/Basic_PS.hlsl", "main", "ps_5_0", BasicPixelShaderFeatures, _countof(BasicPixelShaderFeatures) };
+
+static const SampleShader* const SampleShaders[] = {
+    &BasicVertexShader,
+    &BasicPixelShader,
+};
+
+
+// 使ったバリアントの記録 (次回の起動とアーカイブの作成で先にコンパイルする)
+static const char ShaderVariantUsagePath[] = "ShaderVariants.txt";
+
+// パイプラインの使用記録 (次回の起動で事前に作る)
+static const char PipelineTracePath[] = "PipelineTrace.bin";
 
 
-void EnableDebugLayer()
+// 機能のマクロを含まない設定
+static ShaderCompileDesc MakeShaderCompileDesc(const SampleShader& shader)
 {
-    ComPtr<ID3D12Debug> debugLayer;
-    ResultUtil result = D3D12GetDebugInterface(IID_PPV_ARGS(&debugLayer));
-    if (result)
-    {
-        debugLayer->EnableDebugLayer();
-    }
+    ShaderCompileDesc compileDesc = {};
+    compileDesc.filePath = shader.filePath;
+    compileDesc.entryPoint = shader.entryPoint;
+    compileDesc.target = shader.target;
+    compileDesc.flags = SHADER_COMPILE_FLAG_DEBUG | SHADER_COMPILE_FLAG_SKIP_OPTIMIZATION; // デバッグ用 | 最適化なし
+    return compileDesc;
 }
 
 
-SampleApp::SampleApp(IApp* pApp)
+SampleApp::SampleApp(IApp* pApp, const AppStartupDesc& startupDesc)
     : m_pApp(pApp)
-    , m_BufferCount(2)
-    , m_BufferFormat(DXGI_FORMAT_R8G8B8A8_UNORM)
-    , m_FeatureLevel(D3D_FEATURE_LEVEL_11_1)
+    , m_Backend(startupDesc.graphicsBackend)
+    , m_EmulatedGpuMilliseconds(startupDesc.emulatedGpuMilliseconds)
+    , m_BufferCount(startupDesc.bufferCount)
+    , m_EmulatedUpdateMilliseconds(startupDesc.emulatedUpdateMilliseconds)
+    , m_BufferFormat(GRAPHICS_FORMAT_R8G8B8A8_UNORM)
+    , m_ShaderArchivePath(startupDesc.shaderArchivePath)
+    , m_ShaderArchiveHitCount(0)
+    , m_IsShaderSourceChanged(false)
+    , m_ShaderArchiveOpenMilliseconds(0.0)
+    , m_QuadCount(startupDesc.quadCount)
+    , m_RecordChunkSize(startupDesc.recordChunkSize)
+    , m_IsStateFilterEnabled(startupDesc.enableStateFilter)
+    , m_StateFilterStatistics()
+    , m_FrameIndex(0)
+    , m_FenceValue(0)
+    , m_FenceWaitCount(0)
+    , m_FenceWaitMilliseconds(0.0)
+    , m_VertexBufferAllocation()
+    , m_IndexBufferAllocation()
+    , m_VertexBufferView()
+    , m_IndexBufferView()
+    , m_pPipelineState(nullptr)
+    , m_pRootSignature(nullptr)
+    , m_IsThreadAffinityEnabled(startupDesc.enableThreadAffinity)
+    , m_MainProcessor(CpuTopology::InvalidIndex)
+    , m_RenderProcessor(CpuTopology::InvalidIndex)
+    , m_WorkerCount(startupDesc.workerCount)
+    , m_PipelineSetup()
+    , m_PipelineUpdate()
+    , m_IsPipelinePrewarmEnabled(startupDesc.enablePipelinePrewarm)
+    , m_ColorMode(startupDesc.colorMode)
+    , m_IsShaderHotReloadEnabled(startupDesc.enableShaderHotReload)
+    , m_HotReload()
+    , m_InitBeginTime()
+    , m_InitMilliseconds(0.0)
+    , m_IsGeometryReady(false)
+    , m_IsPipelineReady(false)
+    , m_IsContentReady(false)
+    , m_FirstFrameMilliseconds(0.0)
+    , m_ContentReadyMilliseconds(0.0)
+    , m_ContentFrameMilliseconds(0.0)
+    , m_RenderSnapshotCount(startupDesc.renderSnapshotCount)
+    , m_PushedSnapshotCount(0)
+    , m_RenderedSnapshotCount(0)
+    , m_IsRenderThreadQuitting(false)
+    , m_IsRenderThreadFailed(false)
+    , m_UpdateFrameNumber(0)
+    , m_UpdateBeginTime()
+    , m_FrameTiming()
 {
 
 }
@@ -60,254 +135,189 @@ SampleApp::~SampleApp()
 bool SampleApp::Init()
 {
     ResultUtil result;
-
-#ifdef _DEBUG
-    EnableDebugLayer();
-#endif
+    m_InitBeginTime = std::chrono::steady_clock::now();
 
     // ウィンドウハンドルを取得
-    HWND hWnd = reinterpret_cast<HWND>(m_pApp->GetWindowHandle());
+    void* hWnd = m_pApp->GetWindowHandle();
 
     // 描画領域のサイズを取得
     const Size2D& clientSize = m_pApp->GetClientSize();
 
-    // ファクトリーを生成
+    // デバイスを生成
+    {
 #ifdef _DEBUG
-    result = CreateDXGIFactory2(DXGI_CREATE_FACTORY_DEBUG, IID_PPV_ARGS(&m_Factory));
+        const bool enableDebugLayer = true;
 #else
-    result = CreateDXGIFactory1(IID_PPV_ARGS(&m_Factory));
+        const bool enableDebugLayer = false;
 #endif
+        GraphicsDeviceDesc deviceDesc = {};
+        deviceDesc.backend = m_Backend;
+        deviceDesc.enableDebugLayer = enableDebugLayer;
+        deviceDesc.emulatedGpuMilliseconds = m_EmulatedGpuMilliseconds;
+
+        result = CreateGraphicsDevice(deviceDesc, &m_Device);
+        if (!result)
+        {
+            ShowErrorMessage(result, "CreateGraphicsDevice");
+            return false;
+        }
+    }
+
+    // パイプラインキャッシュ (前回作ったパイプラインはコンパイルせずに作る)
+    result = m_PipelineStateCache.Init(m_Device.get(), "PipelineCache.bin");
     if (!result)
     {
-        ShowErrorMessage(result, "CreateDXGIFactory");
+        ShowErrorMessage(result, "PipelineStateCache::Init");
         return false;
     }
 
-    // アダプターを列挙
+    // コンパイル済みシェーダー (開けなければソースからコンパイルする)
+    if (!m_ShaderArchivePath.empty())
     {
-        std::vector<ComPtr<IDXGIAdapter>> adapters;
-        for (UINT i = 0; ; i++)
-        {
-            ComPtr<IDXGIAdapter> adapter;
-
-            if (m_Factory->EnumAdapters(i, &adapter) == DXGI_ERROR_NOT_FOUND)
-            {
-                break;
-            }
-
-            adapters.push_back(adapter);
-        }
-
-        SIZE_T largestVideoMemory = 0;
-        for (auto& adapter : adapters)
+        const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+        result = m_ShaderArchive.Open(m_ShaderArchivePath, GetShaderCompilerIdentifier(m_Backend));
+        m_ShaderArchiveOpenMilliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+        if (!result)
         {
-            DXGI_ADAPTER_DESC adapterDesc = {};
-
-            result = adapter->GetDesc(&adapterDesc);
-
-            if (!result) { continue; }
-
-            // とりあえず一番大きいビデオメモリを持つものを選択
-            if (largestVideoMemory > adapterDesc.DedicatedVideoMemory)
-            {
-                largestVideoMemory = adapterDesc.DedicatedVideoMemory;
-                m_Adapter = adapter;
-            }
+            DebugOutputFormatString("[ShaderArchive] %s を開けません (0x%08X)", m_ShaderArchivePath.c_str(), static_cast<u32>(result.GetHRESULT()));
         }
     }
 
-    // D3D12デバイスを生成
-    {
-        struct {
-            D3D_FEATURE_LEVEL featureLevel;
-            char featureName[16];
-        }
-        featureLevels[] = {
-            { D3D_FEATURE_LEVEL_12_1, "12.1" },
-            { D3D_FEATURE_LEVEL_12_0, "12.0" },
-            { D3D_FEATURE_LEVEL_11_1, "11.1" },
-            { D3D_FEATURE_LEVEL_11_0, "11.0" },
-        };
+    AddStartupStage("Device", 0.0, true);
 
-        for (int i = 0; i < _countof(featureLevels); i++)
+    // シェーダーとパイプラインはワーカーで作り、その間に残りの初期化を進める
+    // 最初のフレームに要るもの (スワップチェインまで) だけを作って戻り、残りは UpdateStartup で進める
+    // 描画の発行は性能の高いコアに、ワーカーはなるべく同じ L3 のコアに固定する
+    // 描画スレッドを使う場合は、メインスレッド (更新) にワーカーの最初の候補を使う
+    std::vector<u32> workerProcessors;
+    m_CpuTopology.Init(); // 取得できなければ固定しない
+    if (m_IsThreadAffinityEnabled)
+    {
+        const u32 mainThreadCount = (m_RenderSnapshotCount > 0) ? 1 : 0;
+        m_CpuTopology.MakePlacement(m_WorkerCount + mainThreadCount, &m_RenderProcessor, &workerProcessors);
+        m_MainProcessor = m_RenderProcessor;
+        if (mainThreadCount > 0)
         {
-            result = D3D12CreateDevice(
-                m_Adapter.Get(),
-                featureLevels[i].featureLevel,
-                IID_PPV_ARGS(&m_Device)
-            );
-            if (result)
-            {
-                DebugOutputFormatString("FeatureLevel[%s] is selected.", featureLevels[i].featureName);
-                break;
-            }
+            m_MainProcessor = workerProcessors.front();
+            workerProcessors.erase(workerProcessors.begin());
         }
-
-        if (!result)
+        if (m_MainProcessor != CpuTopology::InvalidIndex && !m_CpuTopology.SetCurrentThreadAffinity(m_MainProcessor))
         {
-            ShowErrorMessage(result, "D3D12CreateDevice");
-            return false;
+            m_MainProcessor = CpuTopology::InvalidIndex;
         }
-
-//#ifdef _DEBUG
-//        ID3D12DebugDevice* debugInterface = nullptr;
-//        result = m_Device->QueryInterface(&debugInterface);
-//        if (!result)
-//        {
-//            ShowErrorMessage(result, "ID3D12Device::QueryInterface<ID3D12DebugDevice>");
-//            return false;
-//        }
-//
-//        result = debugInterface->ReportLiveDeviceObjects(D3D12_RLDO_DETAIL | D3D12_RLDO_IGNORE_INTERNAL);
-//        if (!result)
-//        {
-//            ShowErrorMessage(result, "ID3D12DebugDevice::ReportLiveDeviceObjects");
-//            return false;
-//        }
-//        
-//        debugInterface->Release();
-//#endif
-    }
-
-    // コマンドリスト作成
-    {
-        result = m_Device->CreateCommandAllocator(
-            D3D12_COMMAND_LIST_TYPE_DIRECT,
-            IID_PPV_ARGS(&m_CommandAllocator)
-        );
-        if (!result)
+    }
+    m_TaskScheduler.Init(m_WorkerCount, &m_CpuTopology, workerProcessors.empty() ? nullptr : workerProcessors.data());
+    m_ShaderPermutations.Init(&m_TaskScheduler, [this](const ShaderCompileDesc& desc, ShaderBytecode* pOut, std::string* pErrorText)
+    {
+        return LoadShader(desc, pOut, pErrorText);
+    });
+    m_PipelinePrewarmer.Init(&m_TaskScheduler, &m_ShaderPermutations, [this](u32 vertexShaderIndex, ShaderVariantKey vertexShaderKey, u32 pixelShaderIndex, ShaderVariantKey pixelShaderKey, const GraphicsPipelineStateDesc& desc, std::string* pErrorText)
+    {
+        IGraphicsRootSignature* pRootSignature = nullptr;
+        IGraphicsPipelineState* pPipelineState = nullptr;
+        const HRESULT hr = CreateVariantPipelineState(vertexShaderIndex, vertexShaderKey, pixelShaderIndex, pixelShaderKey, desc, &pRootSignature, &pPipelineState, pErrorText);
+        if (FAILED(hr))
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateCommandAllocator");
-            return false;
+            DebugOutputFormatString("[Prewarm] パイプラインの作成に失敗しました (0x%08X)\n%s", static_cast<u32>(hr), pErrorText->c_str());
         }
+        return hr;
+    });
+    BeginPipelineSetup();
+    const f64 stageBeginMilliseconds = GetStartupMilliseconds();
 
-        result = m_Device->CreateCommandList(
-            0,
-            D3D12_COMMAND_LIST_TYPE_DIRECT,
-            m_CommandAllocator.Get(),
-            nullptr,
-            IID_PPV_ARGS(&m_GraphicsCommandList)
-        );
-        if (!result)
+    // コマンドリスト (必要になったときにアロケータと組で作る)
+    {
+        m_FrameContexts.resize(m_BufferCount);
+        for (FrameContext& frame : m_FrameContexts)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateCommandList");
-            return false;
+            frame.fenceValue = 0;
         }
+        m_FrameIndex = 0;
+
+        m_CommandListPool.Init(m_Device.get(), COMMAND_LIST_TYPE_DIRECT);
+        m_CommandRecorder.Init(&m_CommandListPool, &m_TaskScheduler);
+        m_DrawQueue.Init(&m_TaskScheduler);
     }
 
     // コマンドキュー作成
     {
-        D3D12_COMMAND_QUEUE_DESC commandQueueDesc = {};
-
-        // タイムアウトなし
-        commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-
-        // アダプターを一つしか使わない時は「0」で良い
-        commandQueueDesc.NodeMask = 0;
-
-        // プライオリティは特に指定なし
-        commandQueueDesc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
-
-        // コマンドリストと合わせる
-        commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-
-        result = m_Device->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&m_CommandQueue));
+        result = m_Device->CreateCommandQueue(COMMAND_LIST_TYPE_DIRECT, &m_CommandQueue);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateCommandQueue");
+            ShowErrorMessage(result, "IGraphicsDevice::CreateCommandQueue");
+            return false;
         }
     }
 
     // スワップチェインを生成
     {
-        DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-
-        swapChainDesc.Width = static_cast<UINT>(clientSize.width);
-        swapChainDesc.Height = static_cast<UINT>(clientSize.height);
-        swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        swapChainDesc.Stereo = FALSE;
-        swapChainDesc.SampleDesc.Count = 1;
-        swapChainDesc.SampleDesc.Quality = 0;
-        swapChainDesc.BufferUsage = DXGI_USAGE_BACK_BUFFER;
-        swapChainDesc.BufferCount = m_BufferCount;
-
-        // バックバッファは伸び縮み可能
-        swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-
-        // フリップ後は速やかに破棄
-        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-
-        // 特に指定なし
-        swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-
-        // ウィンドウ ⇔ フルスクリーン切り替え可能
-        swapChainDesc.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-
-        ComPtr<IDXGISwapChain1> swapChain;
-        result = m_Factory->CreateSwapChainForHwnd(
-            m_CommandQueue.Get(),
+        SwapChainDesc swapChainDesc = {};
+        swapChainDesc.width = clientSize.width;
+        swapChainDesc.height = clientSize.height;
+        swapChainDesc.format = m_BufferFormat;
+        swapChainDesc.bufferCount = m_BufferCount;
+
+        result = m_Device->CreateSwapChain(
+            m_CommandQueue.get(),
             hWnd,
-            &swapChainDesc,
-            nullptr,
-            nullptr,
-            &swapChain
+            swapChainDesc,
+            &m_SwapChain
         );
         if (!result)
         {
-            ShowErrorMessage(result, "IDXGIFactory6::CreateSwapChainForHwnd");
+            ShowErrorMessage(result, "IGraphicsDevice::CreateSwapChain");
             return false;
         }
-        swapChain.As(&m_SwapChain);
     }
 
-    // RTV用 ディスクリプタヒープ生成
+    // ディスクリプタ
     {
-        D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-
-        // アダプターを一つしか使わない時は「0」で良い
-        descriptorHeapDesc.NodeMask = 0;
-
-        // 特に指定なし
-        descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-
-        // レンダーターゲットビュー
-        descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-
-        // バックバッファの数分
-        descriptorHeapDesc.NumDescriptors = m_BufferCount;
+        // RTV 用 (CPU 専用、足りなければヒープを足す)
+        result = m_RTVAllocator.Init(m_Device.get(), DESCRIPTOR_HEAP_TYPE_RTV, 0);
+        if (!result)
+        {
+            ShowErrorMessage(result, "DescriptorHeapAllocator::Init");
+            return false;
+        }
 
-        result = m_Device->CreateDescriptorHeap(
-            &descriptorHeapDesc,
-            IID_PPV_ARGS(&m_RTVHeaps)
-        );
+        // フレームごとのテーブル用 (処理中のフレーム数分)
+        result = m_DescriptorRing.Init(m_Device.get(), DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, DescriptorRingSizePerFrame * m_BufferCount);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateDescriptorHeap");
+            ShowErrorMessage(result, "DescriptorRing::Init");
             return false;
         }
     }
 
+    // レンダーグラフ
+    m_RenderGraph.Init(m_Device.get());
+
     // バックバッファ生成
     {
         m_BackBuffers.resize(m_BufferCount);
-        D3D12_CPU_DESCRIPTOR_HANDLE descriptorHandle = m_RTVHeaps->GetCPUDescriptorHandleForHeapStart();
+        m_BackBufferRTVs.resize(m_BufferCount);
 
-        for (UINT i = 0; i < m_BufferCount; i++)
+        for (u32 i = 0; i < m_BufferCount; i++)
         {
-            result = m_SwapChain->GetBuffer(i, IID_PPV_ARGS(&m_BackBuffers[i]));
+            m_BackBuffers[i] = m_SwapChain->GetBuffer(i);
+            if (m_BackBuffers[i] == nullptr)
+            {
+                ShowErrorMessage(E_FAIL, "IGraphicsSwapChain::GetBuffer");
+                return false;
+            }
+            m_ResourceStates.Register(m_BackBuffers[i], RESOURCE_STATE_PRESENT);
+
+            result = m_RTVAllocator.Allocate(&m_BackBufferRTVs[i]);
             if (!result)
             {
-                ShowErrorMessage(result, "IDXGISwapChain4::GetBuffer");
+                ShowErrorMessage(result, "DescriptorHeapAllocator::Allocate");
                 return false;
             }
 
             m_Device->CreateRenderTargetView(
-                m_BackBuffers[i].Get(),
-                nullptr,
-                descriptorHandle
+                m_BackBuffers[i],
+                m_BackBufferRTVs[i].cpuHandle
             );
-
-            descriptorHandle.ptr += m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
         }
     }
 
@@ -316,487 +326,842 @@ bool SampleApp::Init()
         m_FenceValue = 0;
         result = m_Device->CreateFence(
             m_FenceValue,
-            D3D12_FENCE_FLAG_NONE,
-            IID_PPV_ARGS(&m_Fence)
+            &m_Fence
         );
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateFence");
+            ShowErrorMessage(result, "IGraphicsDevice::CreateFence");
             return false;
         }
     }
 
-    // 頂点バッファ & インデックスバッファ
+    // 静的なバッファ用のヒープと転送
     {
-        Vertex_Position vertices[] = {
-            { { -0.4f, -0.7f,  0.0f }, },
-            { { -0.4f,  0.7f,  0.0f }, },
-            { {  0.4f, -0.7f,  0.0f }, },
-            { {  0.4f,  0.7f,  0.0f }, },
-        };
-
-        USHORT indices[] = {
-            0, 1, 2,
-            2, 1, 3,
-        };
-
-        D3D12_HEAP_PROPERTIES heapProperties = {};
-        heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
-        heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN; // Type が D3D12_HEAP_TYPE_CUSTOM でないなら UNKNOWN でよい
-        heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN; // Type が D3D12_HEAP_TYPE_CUSTOM でないなら UNKNOWN でよい
-        heapProperties.CreationNodeMask = 0; // 単一アダプターの場合 0 でよい
-        heapProperties.VisibleNodeMask = 0; // 単一アダプターの場合 0 でよい
-
-        D3D12_RESOURCE_DESC resourceDesc = {};
-        resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER; // バッファ
-        resourceDesc.Alignment = 0;
-        resourceDesc.Width = sizeof(vertices); // 幅で全ての頂点分のバッファを表現
-        resourceDesc.Height = 1; // 幅で表現しているので 1 とする
-        resourceDesc.DepthOrArraySize = 1; // 1 でよい
-        resourceDesc.MipLevels = 1; // 1 でよい
-        resourceDesc.Format = DXGI_FORMAT_UNKNOWN; // 画像ではないので UNKNOWN でよい
-        resourceDesc.SampleDesc.Count = 1;
-        resourceDesc.SampleDesc.Quality = 0;
-        resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-        resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-        result = m_Device->CreateCommittedResource(
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_VertexBuffer)
-        );
+        GpuHeapAllocatorDesc heapDesc = {};
+        heapDesc.heapType = HEAP_TYPE_DEFAULT;
+        heapDesc.heapFlags = HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+        heapDesc.blockSize = BufferHeapBlockSize;
+        result = m_BufferHeap.Init(m_Device.get(), heapDesc);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateCommittedResource");
+            ShowErrorMessage(result, "GpuHeapAllocator::Init");
             return false;
         }
 
-        Vertex_Position* vertexBuffer = nullptr;
-        result = m_VertexBuffer->Map(
-            0,         // ミップマップなどではないため 0 でよい
-            nullptr,   // 範囲指定。全範囲なので nullptr でよい
-            (void**)&vertexBuffer // 受け取るためのポインター変数のアドレス
-        );
+        result = m_UploadManager.Init(m_Device.get(), UploadStagingSize);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Resource::Map");
+            ShowErrorMessage(result, "UploadManager::Init");
             return false;
         }
+    }
 
-        std::copy(
-            std::begin(vertices),
-            std::end(vertices),
-            vertexBuffer
-        );
+    AddStartupStage("SwapChain", stageBeginMilliseconds, true);
+
+    // ビューポート
+    {
+        m_Viewport = Viewport{};
+        m_Viewport.width = static_cast<f32>(clientSize.width);
+        m_Viewport.height = static_cast<f32>(clientSize.height);
+        m_Viewport.topLeftX = 0;
+        m_Viewport.topLeftY = 0;
+        m_Viewport.maxDepth = 1.0f;
+        m_Viewport.minDepth = 0.0f;
+    }
 
-        m_VertexBuffer->Unmap(0, nullptr);
+    // シザー矩形
+    {
+        m_ScissorRect.top = 0;
+        m_ScissorRect.left = 0;
+        m_ScissorRect.bottom = m_ScissorRect.top + static_cast<s32>(clientSize.height);
+        m_ScissorRect.right = m_ScissorRect.left + static_cast<s32>(clientSize.width);
+    }
 
-        m_VertexBufferView = D3D12_VERTEX_BUFFER_VIEW{};
+    m_InitMilliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - m_InitBeginTime).count();
+    return true;
+}
 
-        m_VertexBufferView.BufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
-        m_VertexBufferView.SizeInBytes = sizeof(vertices);
-        m_VertexBufferView.StrideInBytes = sizeof(vertices[0]);
+// 解放
+void SampleApp::Term()
+{
+    if (!m_Device)
+    {
+        return;
+    }
 
+    // 描画スレッドを最初に止める (渡した分は描画する)
+    EndRenderThread();
 
-        // インデックスバッファ
-        resourceDesc.Width = sizeof(indices); // 頂点バッファの設定からサイズのみ変更
-        result = m_Device->CreateCommittedResource(
-            &heapProperties,
-            D3D12_HEAP_FLAG_NONE,
-            &resourceDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_IndexBuffer)
-        );
+    // 初期化の途中で失敗した場合や読み込み中に終了した場合も、ワーカーのタスクを終わらせてから解放する
+    if (m_PipelineSetup.task.pState)
+    {
+        m_TaskScheduler.Wait(m_PipelineSetup.task);
+    }
+    m_ShaderHotReloader.Term();
+    if (m_PipelineUpdate.rebuildTask.pState)
+    {
+        m_TaskScheduler.Wait(m_PipelineUpdate.rebuildTask);
+    }
+    PipelinePrewarmerStatistics prewarmStatistics = {};
+    m_PipelinePrewarmer.GetStatistics(&prewarmStatistics);
+    m_PipelinePrewarmer.Term();
+    if (m_IsPipelinePrewarmEnabled && m_pPipelineState != nullptr)
+    {
+        // 事前作成しなかったとき、初期化に失敗したときは前回の記録を残す (今回の記録だけでは前回の分が消える)
+        ResultUtil result = m_PipelineTrace.Save(PipelineTracePath);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateCommittedResource");
-            return false;
+            DebugOutputFormatString("[Prewarm] %s に書き込めません (0x%08X)", PipelineTracePath, static_cast<u32>(result.GetHRESULT()));
         }
-
-        USHORT* indexBuffer = nullptr;
-        result = m_IndexBuffer->Map(
-            0,         // ミップマップなどではないため 0 でよい
-            nullptr,   // 範囲指定。全範囲なので nullptr でよい
-            (void**)&indexBuffer // 受け取るためのポインター変数のアドレス
-        );
+    }
+    {
+        // 書き出せなくても次回は使うときにコンパイルするだけ
+        ResultUtil result = m_ShaderPermutations.SaveUsage(ShaderVariantUsagePath);
         if (!result)
         {
-            ShowErrorMessage(result, "ID3D12Resource::Map");
-            return false;
+            DebugOutputFormatString("[ShaderVariant] %s に書き込めません (0x%08X)", ShaderVariantUsagePath, static_cast<u32>(result.GetHRESULT()));
         }
-
-        std::copy(
-            std::begin(indices),
-            std::end(indices),
-            indexBuffer
-        );
-
-        m_IndexBuffer->Unmap(0, nullptr);
-
-        m_IndexBufferView = D3D12_INDEX_BUFFER_VIEW{};
-        m_IndexBufferView.BufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
-        m_IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
-        m_IndexBufferView.SizeInBytes = sizeof(indices);
     }
+    ShaderPermutationStatistics variantStatistics = {};
+    m_ShaderPermutations.GetStatistics(&variantStatistics);
+    m_ShaderPermutations.Term();
+    m_TaskScheduler.Term();
 
+    // GPU の完了を待つ
+    if (m_Fence)
+    {
+        m_Fence->Wait(m_FenceValue);
+    }
 
-    ComPtr<ID3DBlob> vsBlob;
-    ComPtr<ID3DBlob> psBlob;
-
-    // 頂点シェーダー
+    // 統計情報
+    GraphicsStatistics statistics = {};
+    m_Device->GetStatistics(&statistics);
+    DebugOutputFormatString(
+        "[Graphics] executed command lists: %llu, recorded commands: %llu (%llu bytes), presents: %llu",
+        static_cast<unsigned long long>(statistics.executedCommandLists),
+        static_cast<unsigned long long>(statistics.recordedCommands),
+        static_cast<unsigned long long>(statistics.recordedBytes),
+        static_cast<unsigned long long>(statistics.presentCount)
+    );
     {
-        ComPtr<ID3DBlob> errorBlob;
-        result = D3DCompileFromFile(
-            _T("Shaders\\Basic_VS.hlsl"),
-            nullptr,
-            D3D_COMPILE_STANDARD_FILE_INCLUDE,
-            "main",
-            "vs_5_0",
-            D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, // デバッグ用 | 最適化なし
-            0,
-            &vsBlob,
-            &errorBlob
+        TaskSchedulerStatistics taskStatistics = {};
+        m_TaskScheduler.GetStatistics(&taskStatistics);
+        DebugOutputFormatString(
+            "[Startup] first frame: %.3f ms, content ready: %.3f ms, content frame: %.3f ms, init: %.3f ms, pipeline ready: %.3f ms (waited %.3f ms), workers: %u, tasks: %llu (workers %llu, main %llu, stolen %llu), task time: %.3f ms",
+            m_FirstFrameMilliseconds,
+            m_ContentReadyMilliseconds,
+            m_ContentFrameMilliseconds,
+            m_InitMilliseconds,
+            m_PipelineSetup.readyMilliseconds,
+            m_PipelineSetup.waitMilliseconds,
+            m_WorkerCount,
+            static_cast<unsigned long long>(taskStatistics.submittedCount),
+            static_cast<unsigned long long>(taskStatistics.workerExecutedCount),
+            static_cast<unsigned long long>(taskStatistics.waiterExecutedCount),
+            static_cast<unsigned long long>(taskStatistics.stolenCount),
+            taskStatistics.taskMilliseconds
         );
-        if (!result)
-        {
-            std::string errorText = "D3DCompileFromFile";
 
-            if (result.GetHRESULT() == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND))
+        // 段階ごとの時間 (始まった順)
+        std::stable_sort(m_StartupStages.begin(), m_StartupStages.end(), [](const StartupStage& a, const StartupStage& b) { return a.beginMilliseconds < b.beginMilliseconds; });
+        for (const StartupStage& stage : m_StartupStages)
+        {
+            DebugOutputFormatString(
+                "[Startup]   %-13s %9.3f - %9.3f ms (%s)",
+                stage.name,
+                stage.beginMilliseconds,
+                stage.endMilliseconds,
+                stage.isMainThread ? "main" : "worker"
+            );
+        }
+    }
+    {
+        char mainProcessor[64] = "not pinned";
+        if (m_MainProcessor != CpuTopology::InvalidIndex)
+        {
+            std::snprintf(mainProcessor, sizeof(mainProcessor), "cpu %u", m_CpuTopology.GetLogicalProcessor(m_MainProcessor).number);
+        }
+        char renderProcessor[64] = "not used";
+        if (m_RenderSnapshotCount > 0)
+        {
+            if (m_RenderProcessor != CpuTopology::InvalidIndex)
             {
-                errorText += "\nファイルが見つかりません。";
+                std::snprintf(renderProcessor, sizeof(renderProcessor), "cpu %u", m_CpuTopology.GetLogicalProcessor(m_RenderProcessor).number);
             }
             else
             {
-                std::string text;
-                text.resize(errorBlob->GetBufferSize());
-                std::copy_n(
-                    (char*)errorBlob->GetBufferPointer(),
-                    errorBlob->GetBufferSize(),
-                    text.begin()
-                );
-
-                errorText += "\n";
-                errorText += text;
+                std::snprintf(renderProcessor, sizeof(renderProcessor), "not pinned");
             }
+        }
+        DebugOutputFormatString(
+            "[Topology] logical processors: %u, cores: %u (performance %u), clusters: %u, probed: %s, main thread: %s, render thread: %s",
+            m_CpuTopology.GetLogicalProcessorCount(),
+            m_CpuTopology.GetCoreCount(),
+            m_CpuTopology.GetPerformanceCoreCount(),
+            m_CpuTopology.GetClusterCount(),
+            m_CpuTopology.IsAvailable() ? "yes" : "no",
+            mainProcessor,
+            renderProcessor
+        );
 
-            ShowErrorMessage(result, errorText);
-            return false;
+        // ワーカーごとの使用率
+        std::vector<TaskWorkerStatistics> workerStatistics;
+        m_TaskScheduler.GetWorkerStatistics(&workerStatistics);
+        for (size_t i = 0; i < workerStatistics.size(); i++)
+        {
+            const TaskWorkerStatistics& worker = workerStatistics[i];
+            char placement[96] = "not pinned";
+            if (worker.processor != CpuTopology::InvalidIndex)
+            {
+                const CpuLogicalProcessor& processor = m_CpuTopology.GetLogicalProcessor(worker.processor);
+                std::snprintf(placement, sizeof(placement), "cpu %u (core %u, cluster %u, class %u)", processor.number, processor.core, processor.cluster, processor.efficiencyClass);
+            }
+            DebugOutputFormatString(
+                "[Worker] #%u %s: tasks: %llu (stolen %llu), busy: %.3f / %.3f ms (%.1f%%)",
+                static_cast<u32>(i),
+                placement,
+                static_cast<unsigned long long>(worker.executedCount),
+                static_cast<unsigned long long>(worker.stolenCount),
+                worker.busyMilliseconds,
+                worker.elapsedMilliseconds,
+                (worker.elapsedMilliseconds > 0.0) ? worker.busyMilliseconds * 100.0 / worker.elapsedMilliseconds : 0.0
+            );
         }
     }
-
-    // ピクセルシェーダー
     {
-        ComPtr<ID3DBlob> errorBlob;
-        result = D3DCompileFromFile(
-            _T("Shaders\\Basic_PS.hlsl"),
-            nullptr,
-            D3D_COMPILE_STANDARD_FILE_INCLUDE,
-            "main",
-            "ps_5_0",
-            D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, // デバッグ用 | 最適化なし
-            0,
-            &psBlob,
-            &errorBlob
+        const UploadManagerStatistics& uploadStatistics = m_UploadManager.GetStatistics();
+        DebugOutputFormatString(
+            "[Upload] uploads: %llu (%llu bytes), copies: %llu, batches: %llu, stalls: %llu (%.3f ms), staging peak: %llu / %llu bytes",
+            static_cast<unsigned long long>(uploadStatistics.uploadCount),
+            static_cast<unsigned long long>(uploadStatistics.uploadedBytes),
+            static_cast<unsigned long long>(uploadStatistics.copyCount),
+            static_cast<unsigned long long>(uploadStatistics.batchCount),
+            static_cast<unsigned long long>(uploadStatistics.stallCount),
+            uploadStatistics.stallMilliseconds,
+            static_cast<unsigned long long>(m_UploadManager.GetStagingAllocator().GetStatistics().peakUsedBytes),
+            static_cast<unsigned long long>(m_UploadManager.GetStagingAllocator().GetCapacity())
         );
-        if (!result)
+    }
+    if (m_ShaderArchive.IsOpen())
+    {
+        DebugOutputFormatString(
+            "[ShaderArchive] entries: %u, hits: %u, open: %.3f ms",
+            m_ShaderArchive.GetEntryCount(),
+            m_ShaderArchiveHitCount.load(),
+            m_ShaderArchiveOpenMilliseconds
+        );
+    }
+    {
+        ShaderCacheStatistics shaderCacheStatistics = {};
+        m_ShaderCache.GetStatistics(&shaderCacheStatistics);
+        DebugOutputFormatString(
+            "[ShaderCache] hits: %llu (%.3f ms), misses: %llu (%.3f ms), hash: %.3f ms, errors: %llu, invalid: %llu, write errors: %llu",
+            static_cast<unsigned long long>(shaderCacheStatistics.hitCount),
+            shaderCacheStatistics.hitMilliseconds,
+            static_cast<unsigned long long>(shaderCacheStatistics.missCount),
+            shaderCacheStatistics.missMilliseconds,
+            shaderCacheStatistics.hashMilliseconds,
+            static_cast<unsigned long long>(shaderCacheStatistics.compileErrorCount),
+            static_cast<unsigned long long>(shaderCacheStatistics.invalidEntryCount),
+            static_cast<unsigned long long>(shaderCacheStatistics.writeErrorCount)
+        );
+    }
+    {
+        PipelineStateCacheStatistics pipelineStatistics = {};
+        m_PipelineStateCache.GetStatistics(&pipelineStatistics);
+        DebugOutputFormatString(
+            "[PipelineCache] root signatures: %u, requests: %llu (shared %llu), pipelines: %u, requests: %llu (shared %llu, library %llu, created %llu), store errors: %llu, loaded: %llu bytes%s, saved: %llu bytes, hash: %.3f ms, library: %.3f ms, create: %.3f ms",
+            pipelineStatistics.rootSignatureCount,
+            static_cast<unsigned long long>(pipelineStatistics.rootSignatureRequestCount),
+            static_cast<unsigned long long>(pipelineStatistics.rootSignatureSharedCount),
+            pipelineStatistics.pipelineCount,
+            static_cast<unsigned long long>(pipelineStatistics.requestCount),
+            static_cast<unsigned long long>(pipelineStatistics.sharedCount),
+            static_cast<unsigned long long>(pipelineStatistics.libraryHitCount),
+            static_cast<unsigned long long>(pipelineStatistics.createCount),
+            static_cast<unsigned long long>(pipelineStatistics.storeErrorCount),
+            static_cast<unsigned long long>(pipelineStatistics.loadedBytes),
+            pipelineStatistics.isLibraryRecreated ? " (recreated)" : "",
+            static_cast<unsigned long long>(pipelineStatistics.savedBytes),
+            pipelineStatistics.hashMilliseconds,
+            pipelineStatistics.libraryMilliseconds,
+            pipelineStatistics.createMilliseconds
+        );
+    }
+    if (m_IsShaderHotReloadEnabled)
+    {
+        const ShaderHotReloaderStatistics& reloadStatistics = m_ShaderHotReloader.GetStatistics();
+        DebugOutputFormatString(
+            "[HotReload] shaders: %u, watched files: %u, changes: %llu, compiles: %llu (errors %llu, %.3f ms)",
+            reloadStatistics.shaderCount,
+            reloadStatistics.watchedFileCount,
+            static_cast<unsigned long long>(reloadStatistics.changeCount),
+            static_cast<unsigned long long>(reloadStatistics.compileCount),
+            static_cast<unsigned long long>(reloadStatistics.compileErrorCount),
+            reloadStatistics.compileMilliseconds
+        );
+    }
+    DebugOutputFormatString(
+        "[ShaderVariant] shaders: %u, variants: %u, requests: %llu (fallback %llu), loads: %llu (errors %llu, %.3f ms), prebuilt: %u, pipeline swaps: %u",
+        variantStatistics.shaderCount,
+        variantStatistics.variantCount,
+        static_cast<unsigned long long>(variantStatistics.requestCount),
+        static_cast<unsigned long long>(variantStatistics.fallbackCount),
+        static_cast<unsigned long long>(variantStatistics.compileCount),
+        static_cast<unsigned long long>(variantStatistics.compileErrorCount),
+        variantStatistics.compileMilliseconds,
+        variantStatistics.prebuiltCount,
+        m_PipelineUpdate.swapCount
+    );
+    DebugOutputFormatString(
+        "[Prewarm] trace: %u (skipped %u), pipelines: %u / %u (failed %u), ready: %.3f ms, waited: %.3f ms, task time: %.3f ms, recorded: %u",
+        prewarmStatistics.entryCount,
+        prewarmStatistics.skippedCount,
+        prewarmStatistics.completedCount,
+        prewarmStatistics.submittedCount,
+        prewarmStatistics.failedCount,
+        prewarmStatistics.readyMilliseconds,
+        prewarmStatistics.waitMilliseconds,
+        prewarmStatistics.taskMilliseconds,
+        m_PipelineTrace.GetEntryCount()
+    );
+    {
+        const ResourceStateTrackerStatistics& stateStatistics = m_StateTracker.GetStatistics();
+        DebugOutputFormatString(
+            "[Barrier] transitions: %llu (skipped %llu, merged %llu, split %llu), barriers: %llu in %llu calls (device: %llu in %llu calls)",
+            static_cast<unsigned long long>(stateStatistics.requestedTransitions),
+            static_cast<unsigned long long>(stateStatistics.skippedTransitions),
+            static_cast<unsigned long long>(stateStatistics.mergedTransitions),
+            static_cast<unsigned long long>(stateStatistics.splitBarriers),
+            static_cast<unsigned long long>(stateStatistics.issuedBarriers),
+            static_cast<unsigned long long>(stateStatistics.resourceBarrierCalls),
+            static_cast<unsigned long long>(statistics.resourceBarriers),
+            static_cast<unsigned long long>(statistics.resourceBarrierCalls)
+        );
+    }
+    {
+        const RenderGraphStatistics& graphStatistics = m_RenderGraph.GetStatistics();
+        DebugOutputFormatString(
+            "[RenderGraph] passes: %u (culled %u), resources: %u, transient: %u (%llu bytes in %llu bytes heap), barriers: %u (aliasing %u), compile: %.3f ms",
+            graphStatistics.passCount,
+            graphStatistics.culledPassCount,
+            graphStatistics.resourceCount,
+            graphStatistics.transientCount,
+            static_cast<unsigned long long>(graphStatistics.transientBytes),
+            static_cast<unsigned long long>(graphStatistics.transientHeapBytes),
+            graphStatistics.plannedBarriers,
+            graphStatistics.aliasingBarriers,
+            graphStatistics.compileMilliseconds
+        );
+    }
+    {
+        // 記録は RecordParallel の時間 (分けなかったものも含む) のフレームあたりの平均
+        const ParallelCommandRecorderStatistics& recorderStatistics = m_CommandRecorder.GetStatistics();
+        CommandListPoolStatistics poolStatistics = {};
+        m_CommandListPool.GetStatistics(&poolStatistics);
+        const f64 frameCount = static_cast<f64>(std::max(recorderStatistics.frameCount, static_cast<u64>(1)));
+        DebugOutputFormatString(
+            "[CommandList] quads: %u, chunk: %u, frames: %llu, lists: %llu (%.2f / frame), parallel: %llu (chunks %llu), record: %.3f ms / frame, pool: %u lists (peak in use %u)",
+            m_QuadCount,
+            m_RecordChunkSize,
+            static_cast<unsigned long long>(recorderStatistics.frameCount),
+            static_cast<unsigned long long>(recorderStatistics.commandListCount),
+            static_cast<f64>(recorderStatistics.commandListCount) / frameCount,
+            static_cast<unsigned long long>(recorderStatistics.parallelCount),
+            static_cast<unsigned long long>(recorderStatistics.chunkCount),
+            recorderStatistics.recordMilliseconds / frameCount,
+            poolStatistics.commandListCount,
+            poolStatistics.peakInUseCount
+        );
+    }
+    {
+        // 種類ごとに 渡した数 / 捨てた数
+        const StateFilterStatistics& filterStatistics = m_StateFilterStatistics;
+        u64 issuedCalls = 0;
+        u64 filteredCalls = 0;
+        std::string calls;
+        for (u32 i = 0; i < STATE_FILTER_CALL_NUM; i++)
         {
-            std::string errorText = "D3DCompileFromFile";
-
-            if (result.GetHRESULT() == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND))
-            {
-                errorText += "\nファイルが見つかりません。";
-            }
-            else
+            if (filterStatistics.issuedCalls[i] == 0 && filterStatistics.filteredCalls[i] == 0)
             {
-                std::string text;
-                text.resize(errorBlob->GetBufferSize());
-                std::copy_n(
-                    (char*)errorBlob->GetBufferPointer(),
-                    errorBlob->GetBufferSize(),
-                    text.begin()
-                );
-
-                errorText += "\n";
-                errorText += text;
+                continue;
             }
-
-            ShowErrorMessage(result, errorText);
-            return false;
+            char text[96];
+            std::snprintf(text, sizeof(text), ", %s: %llu / %llu", StateFilterCommandList::GetCallName(static_cast<STATE_FILTER_CALL>(i)), static_cast<unsigned long long>(filterStatistics.issuedCalls[i]), static_cast<unsigned long long>(filterStatistics.filteredCalls[i]));
+            calls += text;
+            issuedCalls += filterStatistics.issuedCalls[i];
+            filteredCalls += filterStatistics.filteredCalls[i];
         }
+        DebugOutputFormatString(
+            "[StateFilter] %s, draws: %llu, state calls: %llu issued / %llu filtered (%.1f%%)%s",
+            m_IsStateFilterEnabled ? "enabled" : "disabled",
+            static_cast<unsigned long long>(filterStatistics.drawCalls),
+            static_cast<unsigned long long>(issuedCalls),
+            static_cast<unsigned long long>(filteredCalls),
+            100.0 * static_cast<f64>(filteredCalls) / static_cast<f64>(std::max(issuedCalls + filteredCalls, static_cast<u64>(1))),
+            calls.c_str()
+        );
     }
-
-    // ルートシグネチャ
     {
-        ComPtr<ID3DBlob> rootSignatureBlob;
-        ComPtr<ID3DBlob> errorBlob;
-
-        D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc = {};
-        rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT; // 入力レイアウト有り
-
-        result = D3D12SerializeRootSignature(
-            &rootSignatureDesc,
-            D3D_ROOT_SIGNATURE_VERSION_1_0,
-            &rootSignatureBlob,
-            &errorBlob
+        const RadixSorterStatistics& sortStatistics = m_DrawQueue.GetSortStatistics();
+        DebugOutputFormatString(
+            "[DrawQueue] sorts: %llu (parallel %llu), draws: %llu, passes: %llu (skipped %llu), sort: %.3f ms / frame",
+            static_cast<unsigned long long>(sortStatistics.sortCount),
+            static_cast<unsigned long long>(sortStatistics.parallelSortCount),
+            static_cast<unsigned long long>(sortStatistics.itemCount),
+            static_cast<unsigned long long>(sortStatistics.passCount),
+            static_cast<unsigned long long>(sortStatistics.skippedPassCount),
+            sortStatistics.sortMilliseconds / static_cast<f64>(std::max(sortStatistics.sortCount, static_cast<u64>(1)))
         );
-        if (!result)
-        {
-            std::string errorText = "D3D12SerializeRootSignature";
-            std::string text;
-            text.resize(errorBlob->GetBufferSize());
-            std::copy_n(
-                (char*)errorBlob->GetBufferPointer(),
-                errorBlob->GetBufferSize(),
-                text.begin()
-            );
-
-            errorText += "\n";
-            errorText += text;
-
-            ShowErrorMessage(result, errorText);
-            return false;
-        }
-
-        result = m_Device->CreateRootSignature(
-            0,
-            rootSignatureBlob->GetBufferPointer(),
-            rootSignatureBlob->GetBufferSize(),
-            IID_PPV_ARGS(&m_RootSignature)
+    }
+    {
+        DescriptorHeapAllocatorStatistics descriptorStatistics = {};
+        m_RTVAllocator.GetStatistics(&descriptorStatistics);
+        const LinearRingAllocatorStatistics& ringStatistics = m_DescriptorRing.GetAllocator().GetStatistics();
+        DebugOutputFormatString(
+            "[Descriptor] rtv heaps: %u, rtv allocated: %u (peak %u), table descriptors: %llu, failed: %llu, peak: %llu / %llu",
+            descriptorStatistics.heapCount,
+            descriptorStatistics.allocatedCount,
+            descriptorStatistics.peakAllocatedCount,
+            static_cast<unsigned long long>(ringStatistics.allocatedBytes),
+            static_cast<unsigned long long>(ringStatistics.failedCount),
+            static_cast<unsigned long long>(ringStatistics.peakUsedBytes),
+            static_cast<unsigned long long>(m_DescriptorRing.GetAllocator().GetCapacity())
         );
-        if (!result)
+    }
+    {
+        GpuHeapAllocatorStatistics heapStatistics = {};
+        m_BufferHeap.GetStatistics(&heapStatistics);
+        DebugOutputFormatString(
+            "[Heap] blocks: %u, allocations: %u, used: %llu / %llu bytes, fragmentation: %.3f",
+            heapStatistics.blockCount,
+            heapStatistics.allocationCount,
+            static_cast<unsigned long long>(heapStatistics.usedBytes),
+            static_cast<unsigned long long>(heapStatistics.reservedBytes),
+            heapStatistics.fragmentation
+        );
+    }
+    DebugOutputFormatString(
+        "[Frame] frames in flight: %u, fence waits: %llu (%.3f ms)",
+        m_BufferCount,
+        static_cast<unsigned long long>(m_FenceWaitCount),
+        m_FenceWaitMilliseconds
+    );
+    {
+        // 遅延は更新の開始から Present まで、間隔は Present の間隔
+        const FrameTiming& timing = m_FrameTiming;
+        const f64 presentMilliseconds = std::chrono::duration<f64, std::milli>(timing.lastPresentTime - timing.firstPresentTime).count();
+        const f64 frameCount = static_cast<f64>(std::max(timing.frameCount, static_cast<u64>(1)));
+        char mode[32] = "serial";
+        if (m_RenderSnapshotCount > 0)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateRootSignature");
-            return false;
+            std::snprintf(mode, sizeof(mode), "render thread (%u)", m_RenderSnapshotCount);
         }
-
+        DebugOutputFormatString(
+            "[FrameTiming] mode: %s, frames: %llu, interval: %.3f ms (%.1f fps), latency: %.3f ms (max %.3f ms), render: %.3f ms, main waited: %.3f ms, render idle: %.3f ms",
+            mode,
+            static_cast<unsigned long long>(timing.frameCount),
+            (timing.frameCount > 1) ? presentMilliseconds / static_cast<f64>(timing.frameCount - 1) : 0.0,
+            (presentMilliseconds > 0.0) ? static_cast<f64>(timing.frameCount - 1) * 1000.0 / presentMilliseconds : 0.0,
+            timing.latencyMilliseconds / frameCount,
+            timing.maxLatencyMilliseconds,
+            timing.renderMilliseconds / frameCount,
+            timing.mainWaitMilliseconds,
+            timing.renderIdleMilliseconds
+        );
     }
-
-    // パイプラインステート
+    if (statistics.triangleCount > 0)
     {
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc = {};
-        
-        // ルートシグネチャ
-        pipelineStateDesc.pRootSignature = m_RootSignature.Get();
-
-        // シェーダー
-        pipelineStateDesc.VS.BytecodeLength = vsBlob->GetBufferSize();
-        pipelineStateDesc.VS.pShaderBytecode = vsBlob->GetBufferPointer();
-        pipelineStateDesc.PS.BytecodeLength = psBlob->GetBufferSize();
-        pipelineStateDesc.PS.pShaderBytecode = psBlob->GetBufferPointer();
-
-        // ラスタライザステート
-        pipelineStateDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
-        pipelineStateDesc.RasterizerState.MultisampleEnable = FALSE;
-        pipelineStateDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-        pipelineStateDesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
-        pipelineStateDesc.RasterizerState.DepthClipEnable = TRUE;
-
-        // ブレンドステート
-        pipelineStateDesc.BlendState.AlphaToCoverageEnable = FALSE;
-        pipelineStateDesc.BlendState.IndependentBlendEnable = FALSE;
-        pipelineStateDesc.BlendState.RenderTarget[0].BlendEnable = FALSE;
-        pipelineStateDesc.BlendState.RenderTarget[0].LogicOpEnable = FALSE;
-        pipelineStateDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+        DebugOutputFormatString(
+            "[Graphics] draws: %llu, triangles: %llu, pixels: %llu, rasterize: %.3f ms",
+            static_cast<unsigned long long>(statistics.drawCount),
+            static_cast<unsigned long long>(statistics.triangleCount),
+            static_cast<unsigned long long>(statistics.pixelCount),
+            statistics.rasterizeMilliseconds
+        );
+    }
 
-        // 入力レイアウト
-        pipelineStateDesc.InputLayout.NumElements = Vertex_Position::NumElements;
-        pipelineStateDesc.InputLayout.pInputElementDescs = Vertex_Position::pInputElementDescs;
+    for (IGraphicsResource* pBackBuffer : m_BackBuffers)
+    {
+        m_ResourceStates.Unregister(pBackBuffer);
+    }
+    m_BackBuffers.clear();
+    m_RenderGraph.Term();
+    m_PipelineStateCache.Save();
+    m_PipelineStateCache.Term();
+    m_pPipelineState = nullptr;
+    m_pRootSignature = nullptr;
+    if (m_VertexBuffer)
+    {
+        m_VertexBuffer.reset();
+        m_BufferHeap.Free(m_VertexBufferAllocation);
+    }
+    if (m_IndexBuffer)
+    {
+        m_IndexBuffer.reset();
+        m_BufferHeap.Free(m_IndexBufferAllocation);
+    }
+    m_UploadManager.Term();
+    m_BufferHeap.Term();
+    m_Fence.reset();
+    for (const DescriptorAllocation& rtv : m_BackBufferRTVs)
+    {
+        m_RTVAllocator.Free(rtv);
+    }
+    m_BackBufferRTVs.clear();
+    m_RTVAllocator.Term();
+    m_DescriptorRing.Term();
+    m_DrawQueue.Term();
+    m_CommandRecorder.Term();
+    m_CommandListPool.Term();
+    m_FrameContexts.clear();
+    m_SwapChain.reset();
+    m_CommandQueue.reset();
+    m_ShaderArchive.Close();
+    m_CompiledShaders.clear();
+    m_ShaderCache.Term();
+    m_ShaderCompiler.reset();
+    m_Device.reset();
+}
 
-        // プリミティブトポロジータイプ
-        pipelineStateDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE; // 三角形
+// 更新処理
+void SampleApp::Update()
+{
+    m_UpdateBeginTime = std::chrono::steady_clock::now();
+    m_UpdateFrameNumber++;
 
-        // レンダーターゲット
-        pipelineStateDesc.NumRenderTargets = 1;
-        pipelineStateDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    // 更新処理の代わりに CPU 時間を使う (描画スレッドと重なる分を計測するため)
+    while (m_EmulatedUpdateMilliseconds > 0.0 && std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - m_UpdateBeginTime).count() < m_EmulatedUpdateMilliseconds)
+    {
 
-        // アンチエイリアス マルチサンプル
-        pipelineStateDesc.SampleDesc.Count = 1;
-        pipelineStateDesc.SampleDesc.Quality = 0;
+    }
 
-        result = m_Device->CreateGraphicsPipelineState(
-            &pipelineStateDesc,
-            IID_PPV_ARGS(&m_PipelineState)
-        );
-        if (!result)
+    // 読み込みが終わるまでは起動の段階を進めるだけ
+    if (!m_IsContentReady)
+    {
+        UpdateStartup();
+        if (!m_IsContentReady)
         {
-            ShowErrorMessage(result, "ID3D12Device::CreateGraphicsPipelineState");
-            return false;
+            return;
         }
     }
 
-    // ビューポート
+    if (m_IsShaderHotReloadEnabled)
     {
-        m_Viewport = D3D12_VIEWPORT{};
-        m_Viewport.Width = static_cast<FLOAT>(clientSize.width);
-        m_Viewport.Height = static_cast<FLOAT>(clientSize.height);
-        m_Viewport.TopLeftX = 0;
-        m_Viewport.TopLeftY = 0;
-        m_Viewport.MaxDepth = 1.0f;
-        m_Viewport.MinDepth = 0.0f;
+        UpdateShaderHotReload();
     }
+    UpdatePipeline();
+}
 
-    // シザー矩形
+// 描画処理
+void SampleApp::Render()
+{
+    RenderSnapshot snapshot;
+    MakeRenderSnapshot(&snapshot);
+
+    // 描画スレッドを使わない場合と読み込み中は、ここで描画する
+    if (m_RenderSnapshotCount == 0 || !snapshot.isContentReady)
     {
-        m_ScissorRect.top = 0;
-        m_ScissorRect.left = 0;
-        m_ScissorRect.bottom = m_ScissorRect.top + static_cast<LONG>(clientSize.height);
-        m_ScissorRect.right = m_ScissorRect.left + static_cast<LONG>(clientSize.width);
+        RenderFrame(snapshot);
+        return;
     }
 
-    return true;
-}
-
-// 解放
-void SampleApp::Term()
-{
-
+    if (!m_RenderThread.joinable())
+    {
+        BeginRenderThread();
+    }
+    if (!PushRenderSnapshot(snapshot))
+    {
+        m_pApp->PostQuit();
+    }
 }
 
-// 更新処理
-void SampleApp::Update()
+// 1 フレームを記録して実行し、Present する (描画スレッドを使う場合は描画スレッドで呼ぶ)
+bool SampleApp::RenderFrame(const RenderSnapshot& snapshot)
 {
+    ResultUtil result;
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
 
-}
+    FrameContext& frame = m_FrameContexts[m_FrameIndex];
 
-// 描画処理
-void SampleApp::Render()
-{
-    ResultUtil result;
+    // このフレームのアロケータを GPU が使い終わるまで待つ
+    // (バックバッファの数だけ前のフレームなので、通常は待たずに済む)
+    if (!WaitForFrame(frame))
+    {
+        return false;
+    }
 
-    UINT backBufferIndex = m_SwapChain->GetCurrentBackBufferIndex();
+    // 転送が終わった分のステージングと、GPU が使い終わったテーブルを再利用する
+    m_UploadManager.Reclaim();
+    m_DescriptorRing.Reclaim(m_Fence->GetCompletedValue());
+    m_RenderGraph.Reclaim(m_Fence->GetCompletedValue());
+    m_CommandListPool.Reclaim(m_Fence->GetCompletedValue());
 
-    // リソースバリア
+    // コマンドリストを借りて記録を始める
+    result = m_CommandRecorder.Begin();
+    if (!result)
     {
-        D3D12_RESOURCE_BARRIER resourceBarrier = {};
-        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION; // 状態遷移
-        resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE; // 特別なことはしないので特に指定しない
-        resourceBarrier.Transition.pResource = m_BackBuffers[backBufferIndex].Get();
-        resourceBarrier.Transition.Subresource = 0;
-        resourceBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT; // 直前は Present 状態
-        resourceBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET; // 今から RenderTarget 状態
-        m_GraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+        ShowErrorMessage(result, "ParallelCommandRecorder::Begin");
+        return false;
     }
 
-    
-    // レンダーターゲットの設定
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_RTVHeaps->GetCPUDescriptorHandleForHeapStart();
-    rtvHandle.ptr += backBufferIndex * m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    m_GraphicsCommandList->OMSetRenderTargets(1, &rtvHandle, TRUE, nullptr);
+    u32 backBufferIndex = m_SwapChain->GetCurrentBackBufferIndex();
+
+    // 状態の追跡 (遷移は溜めておき、使う直前にまとめて発行する)
+    m_StateTracker.Begin(&m_ResourceStates);
+
+    // パスの構成 (遷移はグラフがパスの前にまとめて発行する)
+    m_RenderGraph.Reset();
+    const RenderGraphResource backBuffer = m_RenderGraph.ImportResource("BackBuffer", m_BackBuffers[backBufferIndex], RESOURCE_STATE_PRESENT, true);
+    const CpuDescriptorHandle rtvHandle = m_BackBufferRTVs[backBufferIndex].cpuHandle;
 
     // 画面クリア
+    const u32 clearPass = m_RenderGraph.AddPass("Clear", [rtvHandle](IGraphicsCommandList* pCommandList)
     {
-        FLOAT clearColor[4] = { 0.0f, 0.125f, 0.3f, 1.0f }; // red, green, blue, alpha
-        m_GraphicsCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    }
+        f32 clearColor[4] = { 0.0f, 0.125f, 0.3f, 1.0f }; // red, green, blue, alpha
+        pCommandList->ClearRenderTargetView(rtvHandle, clearColor);
+    });
+    m_RenderGraph.Write(clearPass, backBuffer, RESOURCE_STATE_RENDER_TARGET);
+
+    // ポリゴン (読み込みが終わるまではクリアだけ)
+    // 画面を格子に分けて 1 マスに 1 つ描き、m_RecordChunkSize 個ごとに別のコマンドリストへワーカーで記録する
+    if (snapshot.isContentReady)
+    {
+        const RenderSnapshot* pSnapshot = &snapshot;
+        const u32 columnCount = static_cast<u32>(std::ceil(std::sqrt(static_cast<f64>(m_QuadCount))));
+        const u32 rowCount = (m_QuadCount + columnCount - 1) / columnCount;
 
-    // パイプラインステート
-    m_GraphicsCommandList->SetPipelineState(m_PipelineState.Get());
+        // 発行キューに積んでキーで並べる (パイプラインとマテリアルは 1 つなので、画面の中心に近いものから)
+        m_DrawQueue.Reset();
+        for (u32 i = 0; i < m_QuadCount; i++)
+        {
+            const f32 x = (static_cast<f32>(i % columnCount) + 0.5f) / static_cast<f32>(columnCount) - 0.5f;
+            const f32 y = (static_cast<f32>(i / columnCount) + 0.5f) / static_cast<f32>(rowCount) - 0.5f;
+            const u32 depth = DrawQueue::QuantizeDepth(std::sqrt((x * x + y * y) * 2.0f));
+            m_DrawQueue.Push(DrawQueue::MakeKey(0, 0, 0, depth), i);
+        }
+        m_DrawQueue.Sort();
+        const u32* pQuads = m_DrawQueue.GetPayloads();
 
-    // ルートシグネチャ
-    m_GraphicsCommandList->SetGraphicsRootSignature(m_RootSignature.Get());
+        const u32 quadPass = m_RenderGraph.AddParallelPass("Quad", m_DrawQueue.GetCount(), m_RecordChunkSize, [this, pSnapshot, rtvHandle, columnCount, rowCount, pQuads](IGraphicsCommandList* pCommandList, u32 begin, u32 end)
+        {
+            // 四角形ごとに全ての状態を設定し、前の四角形と同じものはフィルタで捨てる
+            StateFilterCommandList commandList(pCommandList, m_IsStateFilterEnabled);
+            for (u32 i = begin; i < end; i++)
+            {
+                const u32 quad = pQuads[i];
 
-    // ビューポート
-    m_GraphicsCommandList->RSSetViewports(1, &m_Viewport);
+                // レンダーターゲットの設定
+                commandList.OMSetRenderTargets(1, &rtvHandle, nullptr);
 
-    // シザー矩形
-    m_GraphicsCommandList->RSSetScissorRects(1, &m_ScissorRect);
+                // パイプラインステート
+                commandList.SetPipelineState(pSnapshot->pPipelineState);
 
-    // プリミティブトポロジー
-    m_GraphicsCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                // ルートシグネチャ
+                commandList.SetGraphicsRootSignature(pSnapshot->pRootSignature);
 
-    // 頂点バッファ
-    m_GraphicsCommandList->IASetVertexBuffers(0, 1, &m_VertexBufferView);
+                // ビューポート (格子のマス)
+                Viewport viewport = pSnapshot->viewport;
+                viewport.width /= columnCount;
+                viewport.height /= rowCount;
+                viewport.topLeftX += viewport.width * (quad % columnCount);
+                viewport.topLeftY += viewport.height * (quad / columnCount);
+                commandList.RSSetViewports(1, &viewport);
 
-    // インデックスバッファ
-    m_GraphicsCommandList->IASetIndexBuffer(&m_IndexBufferView);
+                // シザー矩形
+                commandList.RSSetScissorRects(1, &pSnapshot->scissorRect);
 
-    // 描画命令
-    m_GraphicsCommandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
+                // プリミティブトポロジー
+                commandList.IASetPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    // リソースバリア
-    {
-        D3D12_RESOURCE_BARRIER resourceBarrier = {};
-        resourceBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION; // 状態遷移
-        resourceBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE; // 特別なことはしないので特に指定しない
-        resourceBarrier.Transition.pResource = m_BackBuffers[backBufferIndex].Get();
-        resourceBarrier.Transition.Subresource = 0;
-        resourceBarrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET; // 直前は RenderTarget 状態
-        resourceBarrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT; // 今から Present 状態
-        m_GraphicsCommandList->ResourceBarrier(1, &resourceBarrier);
+                // 頂点バッファ
+                commandList.IASetVertexBuffers(0, 1, &pSnapshot->vertexBufferView);
+
+                // インデックスバッファ
+                commandList.IASetIndexBuffer(&pSnapshot->indexBufferView);
+
+                // 描画命令
+                commandList.DrawIndexedInstanced(6, 1, 0, 0, 0);
+            }
+
+            std::lock_guard<std::mutex> lock(m_StateFilterMutex);
+            StateFilterCommandList::AddStatistics(commandList.GetStatistics(), &m_StateFilterStatistics);
+        });
+        m_RenderGraph.Write(quadPass, backBuffer, RESOURCE_STATE_RENDER_TARGET);
     }
 
-    // 命令のクローズ
-    result = m_GraphicsCommandList->Close();
+    m_RenderGraph.Compile();
+    result = m_RenderGraph.Execute(&m_CommandRecorder, &m_StateTracker);
     if (!result)
     {
-        ShowErrorMessage(result, "ID3D12GraphicsCommandList::Close");
-        return;
+        ShowErrorMessage(result, "RenderGraph::Execute");
+        return false;
     }
 
-    // コマンドリストの実行
+    // バックバッファを Present 状態へ
+    m_StateTracker.Transition(m_BackBuffers[backBufferIndex], RESOURCE_STATE_PRESENT);
+    m_StateTracker.FlushBarriers(m_CommandRecorder.GetCommandList());
+
+    // 命令をクローズし、記録した順に 1 回で実行する
+    result = m_CommandRecorder.Submit(m_CommandQueue.get());
+    if (!result)
     {
-        ID3D12CommandList* commandLists[] = { m_GraphicsCommandList.Get() };
-        m_CommandQueue->ExecuteCommandLists(
-            _countof(commandLists),
-            commandLists
-        );
+        ShowErrorMessage(result, "ParallelCommandRecorder::Submit");
+        return false;
     }
 
-    // 待ち
-    m_CommandQueue->Signal(m_Fence.Get(), ++m_FenceValue);
+    // このフレームの完了を示すフェンス値 (待つのは次にこのフレームを使うとき)
+    m_CommandQueue->Signal(m_Fence.get(), ++m_FenceValue);
+    frame.fenceValue = m_FenceValue;
+    m_DescriptorRing.FinishFrame(m_FenceValue);
+    m_RenderGraph.FinishFrame(m_FenceValue);
+    m_CommandListPool.FinishFrame(m_FenceValue);
 
     // 画面フリップ
-    result = m_SwapChain->Present(1, 0);
+    result = m_SwapChain->Present(1);
     if (!result)
     {
-        ShowErrorMessage(result, "IDXGISwapChain4::Present");
+        ShowErrorMessage(result, "IGraphicsSwapChain::Present");
+        return false;
+    }
+
+    m_FrameIndex = (m_FrameIndex + 1) % m_BufferCount;
+
+    // 起動から画面が出るまで、描画できるようになるまでの時間
+    if (m_FirstFrameMilliseconds == 0.0)
+    {
+        m_FirstFrameMilliseconds = GetStartupMilliseconds();
+        AddStartupStage("FirstFrame", m_InitMilliseconds, true);
+    }
+    if (snapshot.isContentReady && m_ContentFrameMilliseconds == 0.0)
+    {
+        m_ContentFrameMilliseconds = GetStartupMilliseconds();
+        AddStartupStage("ContentFrame", m_ContentReadyMilliseconds, std::this_thread::get_id() != m_RenderThread.get_id());
+    }
+
+    // 更新の開始から画面に出すまでの遅延と、Present の間隔
+    const std::chrono::steady_clock::time_point presentTime = std::chrono::steady_clock::now();
+    const f64 latencyMilliseconds = std::chrono::duration<f64, std::milli>(presentTime - snapshot.updateBeginTime).count();
+    FrameTiming& timing = m_FrameTiming;
+    if (timing.frameCount == 0)
+    {
+        timing.firstPresentTime = presentTime;
+    }
+    timing.lastPresentTime = presentTime;
+    timing.frameCount++;
+    timing.latencyMilliseconds += latencyMilliseconds;
+    timing.maxLatencyMilliseconds = std::max(timing.maxLatencyMilliseconds, latencyMilliseconds);
+    timing.renderMilliseconds += std::chrono::duration<f64, std::milli>(presentTime - beginTime).count();
+    return true;
+}
+
+
+// 今の描画の状態を取り出す
+void SampleApp::MakeRenderSnapshot(RenderSnapshot* pOut)
+{
+    pOut->frameNumber = m_UpdateFrameNumber;
+    pOut->isContentReady = m_IsContentReady;
+    pOut->pPipelineState = m_pPipelineState;
+    pOut->pRootSignature = m_pRootSignature;
+    pOut->vertexBufferView = m_VertexBufferView;
+    pOut->indexBufferView = m_IndexBufferView;
+    pOut->viewport = m_Viewport;
+    pOut->scissorRect = m_ScissorRect;
+    pOut->updateBeginTime = m_UpdateBeginTime;
+}
+
+
+// 描画スレッドを始める (読み込みが終わってから)
+void SampleApp::BeginRenderThread()
+{
+    m_RenderSnapshots.assign(m_RenderSnapshotCount, RenderSnapshot());
+    m_PushedSnapshotCount = 0;
+    m_RenderedSnapshotCount = 0;
+    m_IsRenderThreadQuitting = false;
+    m_IsRenderThreadFailed = false;
+    m_RenderThread = std::thread(&SampleApp::RenderThreadMain, this);
+}
+
+
+// 渡した状態を全て描画してから止める
+void SampleApp::EndRenderThread()
+{
+    if (!m_RenderThread.joinable())
+    {
         return;
     }
 
-    if (m_Fence->GetCompletedValue() != m_FenceValue)
     {
-        HANDLE eventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        std::lock_guard<std::mutex> lock(m_RenderMutex);
+        m_IsRenderThreadQuitting = true;
+    }
+    m_RenderCondition.notify_all();
+    m_RenderThread.join();
+}
+
+
+void SampleApp::RenderThreadMain()
+{
+    // 描画の発行は性能の高いコアで行う
+    if (m_RenderProcessor != CpuTopology::InvalidIndex && !m_CpuTopology.SetCurrentThreadAffinity(m_RenderProcessor))
+    {
+        m_RenderProcessor = CpuTopology::InvalidIndex;
+    }
 
-        result = m_Fence->SetEventOnCompletion(m_FenceValue, eventHandle);
-        if (!result)
+    std::unique_lock<std::mutex> lock(m_RenderMutex);
+    for (;;)
+    {
+        const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+        m_RenderCondition.wait(lock, [this]() { return m_RenderedSnapshotCount < m_PushedSnapshotCount || m_IsRenderThreadQuitting; });
+        m_FrameTiming.renderIdleMilliseconds += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+        if (m_RenderedSnapshotCount == m_PushedSnapshotCount)
         {
-            ShowErrorMessage(result, "ID3D12Fence::SetEventOnCompletion");
-            return;
+            break; // 終了時は渡された分を描画し終わってから
         }
 
-        WaitForSingleObject(eventHandle, INFINITE);
+        // この状態はメインスレッドが書き換えない (描画し終わるまで空きにならない)
+        const RenderSnapshot& snapshot = m_RenderSnapshots[m_RenderedSnapshotCount % m_RenderSnapshots.size()];
+        lock.unlock();
+        const bool isSucceeded = RenderFrame(snapshot);
+        lock.lock();
 
-        CloseHandle(eventHandle);
+        m_RenderedSnapshotCount++;
+        m_IsRenderThreadFailed = !isSucceeded;
+        m_RenderCondition.notify_all();
+        if (m_IsRenderThreadFailed)
+        {
+            break;
+        }
     }
+}
+
 
-    // コマンドリストクリア
+// 空きができるまで待ってから描画スレッドに渡す
+bool SampleApp::PushRenderSnapshot(const RenderSnapshot& snapshot)
+{
     {
-        //キューをクリア
-        result = m_CommandAllocator->Reset();
-        if (!result)
+        std::unique_lock<std::mutex> lock(m_RenderMutex);
+        const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+        m_RenderCondition.wait(lock, [this]() { return m_PushedSnapshotCount - m_RenderedSnapshotCount < m_RenderSnapshots.size() || m_IsRenderThreadFailed; });
+        m_FrameTiming.mainWaitMilliseconds += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+        if (m_IsRenderThreadFailed)
         {
-            ShowErrorMessage(result, "ID3D12CommandAllocator::Reset");
-            return;
+            return false;
         }
 
-        //再びコマンドリストをためる準備
-        result = m_GraphicsCommandList->Reset(m_CommandAllocator.Get(), nullptr);
-        if (!result)
-        {
-            ShowErrorMessage(result, "ID3D12GraphicsCommandList::Reset");
-            return;
-        }
+        m_RenderSnapshots[m_PushedSnapshotCount % m_RenderSnapshots.size()] = snapshot;
+        m_PushedSnapshotCount++;
     }
+    m_RenderCondition.notify_all();
+    return true;
 }
 
+
 // リサイズ
 void SampleApp::OnResize(const Size2D& newSize)
 {
-    // バックバッファを再生成
+    // バックバッファを再生成 (描画スレッドは止めておき、次の Render で始め直す)
+    EndRenderThread();
     CreateBackBuffer(newSize);
 }
 
@@ -807,6 +1172,14 @@ void SampleApp::OnKey(KEY_CODE key, bool isDown)
     {
         m_pApp->PostQuit();
     }
+
+    // 四角形の色を切り替える (初めて使う色はコンパイルが終わるまで前の色のまま)
+    if (key == KEY_CODE_C && isDown && m_IsContentReady)
+    {
+        PipelineUpdate& update = m_PipelineUpdate;
+        const u32 colorMode = m_ShaderPermutations.GetFeature(update.pixelShaderIndex, update.pixelShaderKey, update.colorModeFeature);
+        update.pixelShaderKey = m_ShaderPermutations.SetFeature(update.pixelShaderIndex, update.pixelShaderKey, update.colorModeFeature, (colorMode + 1) % 4);
+    }
 }
 
 // マウスボタン
@@ -822,6 +1195,214 @@ void SampleApp::OnMouseWheel(const Position2D& position, s32 wheelDelta)
 }
 
 
+// 使う全てのシェーダーをコンパイルしてアーカイブにまとめる
+bool SampleApp::BuildShaderArchive(GRAPHICS_BACKEND backend, const std::string& path)
+{
+    std::unique_ptr<IShaderCompiler> compiler;
+    HRESULT hr = CreateShaderCompiler(backend, &compiler);
+    if (FAILED(hr))
+    {
+        DebugOutputFormatString("[ShaderArchive] CreateShaderCompiler に失敗しました (0x%08X)", static_cast<u32>(hr));
+        return false;
+    }
+
+    // 既定のバリアントと、記録にあるバリアント (機能の宣言が変わっていないもの)
+    std::vector<ShaderVariantUsage> usages;
+    ShaderPermutationManager::LoadUsage(ShaderVariantUsagePath, &usages);
+
+    std::vector<ShaderCompileDesc> descs;
+    for (const SampleShader* pShader : SampleShaders)
+    {
+        const ShaderCompileDesc baseDesc = MakeShaderCompileDesc(*pShader);
+        const std::string name = ShaderArchive::MakeName(baseDesc);
+        const u64 featureHash = ShaderPermutationManager::ComputeFeatureHash(pShader->pFeatures, pShader->featureCount);
+
+        std::vector<ShaderVariantKey> keys(1, 0);
+        for (const ShaderVariantUsage& usage : usages)
+        {
+            if (usage.shaderName == name && usage.featureHash == featureHash && std::find(keys.begin(), keys.end(), usage.key) == keys.end())
+            {
+                keys.push_back(usage.key);
+            }
+        }
+
+        for (ShaderVariantKey key : keys)
+        {
+            ShaderCompileDesc desc;
+            if (ShaderPermutationManager::MakeVariantDesc(baseDesc, pShader->pFeatures, pShader->featureCount, key, &desc))
+            {
+                descs.push_back(std::move(desc));
+            }
+        }
+    }
+
+    // 互いに独立しているので並列にコンパイルし、追加は上の順に行う
+    struct CompileResult
+    {
+        ShaderCompileDesc desc;
+        std::vector<u8>   bytecode;
+        std::string       text;
+        HRESULT           result;
+    };
+    std::vector<CompileResult> results(descs.size());
+    {
+        TaskScheduler taskScheduler;
+        taskScheduler.Init(TaskScheduler::GetDefaultWorkerCount());
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            CompileResult* pResult = &results[i];
+            pResult->desc = descs[i];
+            taskScheduler.Submit("CompileShader", [&compiler, pResult]()
+            {
+                pResult->result = compiler->CompileFromFile(pResult->desc, &pResult->bytecode, &pResult->text);
+            });
+        }
+        taskScheduler.Term();
+    }
+
+    ShaderArchiveWriter writer;
+    for (const CompileResult& result : results)
+    {
+        if (FAILED(result.result))
+        {
+            DebugOutputFormatString("[ShaderArchive] %s のコンパイルに失敗しました (0x%08X)\n%s", ShaderArchive::MakeName(result.desc).c_str(), static_cast<u32>(result.result), result.text.c_str());
+            return false;
+        }
+        writer.Add(result.desc, result.bytecode);
+    }
+
+    hr = writer.Write(path, compiler->GetIdentifier());
+    if (FAILED(hr))
+    {
+        DebugOutputFormatString("[ShaderArchive] %s に書き込めません (0x%08X)", path.c_str(), static_cast<u32>(hr));
+        return false;
+    }
+
+    DebugOutputFormatString("[ShaderArchive] %s: %u shaders (%s)", path.c_str(), writer.GetEntryCount(), compiler->GetIdentifier());
+    return true;
+}
+
+
+// 計測用の乱数 (splitmix64)
+static u64 NextBenchmarkRandom(u64* pState)
+{
+    u64 value = (*pState += 0x9E3779B97F4A7C15ull);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+
+void SampleApp::RunSortBenchmark(u32 workerCount, u32 count)
+{
+    static const u32 RepeatCount = 5;
+
+    struct Entry
+    {
+        u64 key;
+        u32 payload;
+    };
+
+    // ワーカーは計測の間だけ動かす
+    TaskScheduler taskScheduler;
+    taskScheduler.Init(workerCount);
+
+    // 描画のキーらしいもの (パスとパイプラインは少なく、深度はばらばら) と、全てのビットがばらばらのもの
+    for (u32 pattern = 0; pattern < 2; pattern++)
+    {
+        std::vector<u64> keys(count);
+        u64 randomState = 1;
+        for (u64& key : keys)
+        {
+            const u64 random = NextBenchmarkRandom(&randomState);
+            key = (pattern == 0)
+                ? DrawQueue::MakeKey(static_cast<u32>(random % 4), static_cast<u32>((random >> 8) % 64), static_cast<u32>((random >> 16) % 1024), static_cast<u32>(random >> 40))
+                : random;
+        }
+
+        // 同じ入力を RepeatCount 回並べ、一番速かったものを使う
+        const auto measure = [count](const std::function<void()>& prepare, const std::function<void()>& sort)
+        {
+            f64 bestMilliseconds = 0.0;
+            for (u32 i = 0; i < RepeatCount; i++)
+            {
+                prepare();
+                const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+                sort();
+                const f64 milliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+                bestMilliseconds = (i == 0) ? milliseconds : std::min(bestMilliseconds, milliseconds);
+            }
+            return bestMilliseconds;
+        };
+
+        std::vector<Entry> entries(count);
+        const auto prepareEntries = [&]()
+        {
+            for (u32 i = 0; i < count; i++)
+            {
+                entries[i].key = keys[i];
+                entries[i].payload = i;
+            }
+        };
+        const auto compareEntries = [](const Entry& a, const Entry& b) { return a.key < b.key; };
+        const f64 sortMilliseconds = measure(prepareEntries, [&]() { std::sort(entries.begin(), entries.end(), compareEntries); });
+        const f64 stableSortMilliseconds = measure(prepareEntries, [&]() { std::stable_sort(entries.begin(), entries.end(), compareEntries); });
+
+        // 基数ソートは安定なので、std::stable_sort と同じ並びになる
+        std::vector<u64> sortedKeys(count);
+        std::vector<u32> payloads(count);
+        const auto prepareKeys = [&]()
+        {
+            sortedKeys = keys;
+            for (u32 i = 0; i < count; i++)
+            {
+                payloads[i] = i;
+            }
+        };
+        const auto isSameAsStableSort = [&]()
+        {
+            for (u32 i = 0; i < count; i++)
+            {
+                if (sortedKeys[i] != entries[i].key || payloads[i] != entries[i].payload)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        RadixSorter serialSorter;
+        serialSorter.Init(nullptr);
+        const f64 serialMilliseconds = measure(prepareKeys, [&]() { serialSorter.Sort(sortedKeys.data(), payloads.data(), count); });
+        const bool isSerialCorrect = isSameAsStableSort();
+
+        RadixSorter parallelSorter;
+        parallelSorter.Init(&taskScheduler);
+        const f64 parallelMilliseconds = measure(prepareKeys, [&]() { parallelSorter.Sort(sortedKeys.data(), payloads.data(), count); });
+        const bool isParallelCorrect = isSameAsStableSort();
+
+        const RadixSorterStatistics& statistics = serialSorter.GetStatistics();
+        DebugOutputFormatString(
+            "[SortBenchmark] %s keys: %u, std::sort: %.3f ms, std::stable_sort: %.3f ms, radix: %.3f ms (%.2fx), radix %u threads: %.3f ms (%.2fx), passes: %llu / %u, result: %s",
+            (pattern == 0) ? "draw" : "random",
+            count,
+            sortMilliseconds,
+            stableSortMilliseconds,
+            serialMilliseconds,
+            sortMilliseconds / std::max(serialMilliseconds, 1e-6),
+            taskScheduler.GetWorkerCount() + 1,
+            parallelMilliseconds,
+            sortMilliseconds / std::max(parallelMilliseconds, 1e-6),
+            static_cast<unsigned long long>(statistics.passCount / std::max(statistics.sortCount, static_cast<u64>(1))),
+            static_cast<u32>(RadixSorter::DigitCount),
+            (isSerialCorrect && isParallelCorrect) ? "ok" : "MISMATCH"
+        );
+    }
+
+    taskScheduler.Term();
+}
+
+
 // バックバッファを作成
 bool SampleApp::CreateBackBuffer(const Size2D& newSize)
 {
@@ -830,6 +1411,672 @@ bool SampleApp::CreateBackBuffer(const Size2D& newSize)
 }
 
 
+// 頂点とインデックスのバッファを作って転送を始める
+bool SampleApp::CreateGeometry()
+{
+    ResultUtil result;
+
+    // 頂点バッファ
+    {
+        // COMMON で作れば COPY キューでもそのまま書き込める
+        result = m_BufferHeap.CreateResource(
+            MakeBufferResourceDesc(sizeof(QuadVertices)),
+            RESOURCE_STATE_COMMON,
+            &m_VertexBuffer,
+            &m_VertexBufferAllocation
+        );
+        if (!result)
+        {
+            ShowErrorMessage(result, "GpuHeapAllocator::CreateResource");
+            return false;
+        }
+
+        result = m_UploadManager.UploadBuffer(m_VertexBuffer.get(), 0, QuadVertices, sizeof(QuadVertices));
+        if (!result)
+        {
+            ShowErrorMessage(result, "UploadManager::UploadBuffer");
+            return false;
+        }
+
+        m_VertexBufferView.bufferLocation = m_VertexBuffer->GetGPUVirtualAddress();
+        m_VertexBufferView.sizeInBytes = sizeof(QuadVertices);
+        m_VertexBufferView.strideInBytes = sizeof(QuadVertices[0]);
+    }
+
+    // インデックスバッファ
+    {
+        result = m_BufferHeap.CreateResource(
+            MakeBufferResourceDesc(sizeof(QuadIndices)),
+            RESOURCE_STATE_COMMON,
+            &m_IndexBuffer,
+            &m_IndexBufferAllocation
+        );
+        if (!result)
+        {
+            ShowErrorMessage(result, "GpuHeapAllocator::CreateResource");
+            return false;
+        }
+
+        result = m_UploadManager.UploadBuffer(m_IndexBuffer.get(), 0, QuadIndices, sizeof(QuadIndices));
+        if (!result)
+        {
+            ShowErrorMessage(result, "UploadManager::UploadBuffer");
+            return false;
+        }
+
+        m_IndexBufferView.bufferLocation = m_IndexBuffer->GetGPUVirtualAddress();
+        m_IndexBufferView.format = GRAPHICS_FORMAT_R16_UINT;
+        m_IndexBufferView.sizeInBytes = sizeof(QuadIndices);
+    }
+
+    // 転送をまとめて COPY キューに積み、描画側のキューはその完了を GPU 上で待つ
+    {
+        u64 uploadFenceValue = 0;
+        result = m_UploadManager.Flush(&uploadFenceValue);
+        if (!result)
+        {
+            ShowErrorMessage(result, "UploadManager::Flush");
+            return false;
+        }
+
+        result = m_UploadManager.WaitOnQueue(m_CommandQueue.get(), uploadFenceValue);
+        if (!result)
+        {
+            ShowErrorMessage(result, "UploadManager::WaitOnQueue");
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// 起動の残りの段階を進める
+void SampleApp::UpdateStartup()
+{
+    // 最初のフレームを出すまでは何もしない (ワーカーは読み込みを続ける)
+    if (m_FirstFrameMilliseconds == 0.0)
+    {
+        return;
+    }
+
+    // 転送は COPY キューで行い、描画側のキューは GPU 上で完了を待つので、ここでは待たない
+    if (!m_IsGeometryReady)
+    {
+        const f64 beginMilliseconds = GetStartupMilliseconds();
+        if (!CreateGeometry())
+        {
+            m_pApp->PostQuit();
+            return;
+        }
+        m_IsGeometryReady = true;
+        AddStartupStage("Geometry", beginMilliseconds, true);
+    }
+
+    // ワーカーが無ければここでまとめて実行する
+    if (!m_IsPipelineReady)
+    {
+        if (m_WorkerCount > 0 && !m_TaskScheduler.IsCompleted(m_PipelineSetup.task))
+        {
+            return;
+        }
+        if (!EndPipelineSetup())
+        {
+            m_pApp->PostQuit();
+            return;
+        }
+        m_IsPipelineReady = true;
+    }
+
+    // 事前作成が終わるまでは色の切り替えなどでパイプラインを作らない (同じものを同時にコンパイルしない)
+    if (m_WorkerCount > 0 && !m_PipelinePrewarmer.IsCompleted())
+    {
+        return;
+    }
+    m_PipelinePrewarmer.Wait();
+
+    PipelinePrewarmerStatistics prewarmStatistics = {};
+    m_PipelinePrewarmer.GetStatistics(&prewarmStatistics);
+    if (prewarmStatistics.submittedCount > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_StartupMutex);
+        StartupStage stage = { "Prewarm", m_PipelineSetup.prewarmBeginMilliseconds, m_PipelineSetup.prewarmBeginMilliseconds + prewarmStatistics.readyMilliseconds, false };
+        m_StartupStages.push_back(stage);
+    }
+
+    m_IsContentReady = true;
+    m_ContentReadyMilliseconds = GetStartupMilliseconds();
+}
+
+
+// Init の開始からの時間
+f64 SampleApp::GetStartupMilliseconds() const
+{
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - m_InitBeginTime).count();
+}
+
+
+// 起動の段階を記録する (ワーカーから呼んでよい)
+void SampleApp::AddStartupStage(const char* name, f64 beginMilliseconds, bool isMainThread)
+{
+    StartupStage stage = { name, beginMilliseconds, GetStartupMilliseconds(), isMainThread };
+
+    std::lock_guard<std::mutex> lock(m_StartupMutex);
+    m_StartupStages.push_back(stage);
+}
+
+
+// パイプラインの準備をワーカーで始める
+void SampleApp::BeginPipelineSetup()
+{
+    m_PipelineSetup.beginMilliseconds = GetStartupMilliseconds();
+
+    PipelineUpdate& update = m_PipelineUpdate;
+    update.vertexShaderIndex = m_ShaderPermutations.AddShader(MakeShaderCompileDesc(BasicVertexShader), BasicVertexShader.pFeatures, BasicVertexShader.featureCount);
+    update.pixelShaderIndex = m_ShaderPermutations.AddShader(MakeShaderCompileDesc(BasicPixelShader), BasicPixelShader.pFeatures, BasicPixelShader.featureCount);
+    update.colorModeFeature = m_ShaderPermutations.FindFeature(update.pixelShaderIndex, "COLOR_MODE");
+    update.pixelShaderKey = m_ShaderPermutations.SetFeature(update.pixelShaderIndex, 0, update.colorModeFeature, m_ColorMode);
+
+    // 初期化では既定のバリアント (フォールバック) で作り、要求された色は UpdatePipeline で差し替える
+    // シェーダーは互いに依存しないので同時に読み込み、ルートシグネチャは両方のリフレクションから作る
+    m_PipelineSetup.vertexShader.desc = m_ShaderPermutations.MakeDesc(update.vertexShaderIndex, 0);
+    m_PipelineSetup.pixelShader.desc = m_ShaderPermutations.MakeDesc(update.pixelShaderIndex, 0);
+
+    // 各段階は始めてから終わるまでを記録する (シェーダーは読み込みを含めて準備の開始から)
+    TaskHandle shaderTasks[2];
+    for (u32 i = 0; i < 2; i++)
+    {
+        ShaderLoad* pLoad = (i == 0) ? &m_PipelineSetup.vertexShader : &m_PipelineSetup.pixelShader;
+        const u32 shaderIndex = (i == 0) ? update.vertexShaderIndex : update.pixelShaderIndex;
+        const char* stageName = (i == 0) ? "VertexShader" : "PixelShader";
+        const TaskHandle loadTask = m_ShaderPermutations.Prepare(shaderIndex, 0);
+
+        pLoad->result = E_FAIL; // 実行されなければ失敗のまま
+        shaderTasks[i] = m_TaskScheduler.Submit("ReflectShader", [this, pLoad, shaderIndex, stageName]()
+        {
+            pLoad->result = m_ShaderPermutations.Wait(shaderIndex, 0, &pLoad->bytecode, &pLoad->errorText);
+            if (SUCCEEDED(pLoad->result))
+            {
+                pLoad->result = ReflectShader(m_Backend, pLoad->desc, pLoad->bytecode, &pLoad->reflection);
+                if (FAILED(pLoad->result))
+                {
+                    pLoad->errorText = "ReflectShader\n" + ShaderArchive::MakeName(pLoad->desc);
+                }
+            }
+            AddStartupStage(stageName, m_PipelineSetup.beginMilliseconds, false);
+        }, &loadTask, 1);
+    }
+
+    // 前回使ったバリアントは、描画で要求される前にコンパイルしておく
+    std::vector<ShaderVariantUsage> usages;
+    if (SUCCEEDED(ShaderPermutationManager::LoadUsage(ShaderVariantUsagePath, &usages)))
+    {
+        m_ShaderPermutations.PrebuildUsedVariants(usages);
+    }
+
+    // ルートシグネチャ
+    m_PipelineSetup.rootSignatureResult = E_FAIL;
+    const TaskHandle rootSignatureTask = m_TaskScheduler.Submit("CreateRootSignature", [this]()
+    {
+        if (FAILED(m_PipelineSetup.vertexShader.result) || FAILED(m_PipelineSetup.pixelShader.result))
+        {
+            return;
+        }
+
+        const f64 beginMilliseconds = GetStartupMilliseconds();
+        m_PipelineSetup.rootSignatureResult = CreateReflectedRootSignature(
+            m_PipelineSetup.vertexShader.reflection,
+            m_PipelineSetup.pixelShader.reflection,
+            &m_pRootSignature,
+            &m_PipelineSetup.rootSignatureErrorText
+        );
+        AddStartupStage("RootSignature", beginMilliseconds, false);
+    }, shaderTasks, _countof(shaderTasks));
+
+    // パイプラインステート
+    m_PipelineSetup.pipelineStateResult = E_FAIL;
+    m_PipelineSetup.task = m_TaskScheduler.Submit("CreatePipelineState", [this]()
+    {
+        if (FAILED(m_PipelineSetup.rootSignatureResult))
+        {
+            return;
+        }
+
+        const f64 beginMilliseconds = GetStartupMilliseconds();
+        GraphicsPipelineStateDesc pipelineStateDesc = {};
+
+        // ルートシグネチャ
+        pipelineStateDesc.pRootSignature = m_pRootSignature;
+
+        // シェーダー
+        pipelineStateDesc.VS = m_PipelineSetup.vertexShader.bytecode;
+        pipelineStateDesc.PS = m_PipelineSetup.pixelShader.bytecode;
+
+        // ラスタライザステート
+        pipelineStateDesc.sampleMask = 0xFFFFFFFF;
+        pipelineStateDesc.rasterizerState.multisampleEnable = false;
+        pipelineStateDesc.rasterizerState.cullMode = CULL_MODE_NONE;
+        pipelineStateDesc.rasterizerState.fillMode = FILL_MODE_SOLID;
+        pipelineStateDesc.rasterizerState.depthClipEnable = true;
+
+        // ブレンドステート
+        pipelineStateDesc.blendState.blendEnable = false;
+        pipelineStateDesc.blendState.renderTargetWriteMask = COLOR_WRITE_ENABLE_ALL;
+
+        // 入力レイアウト
+        pipelineStateDesc.inputLayout.numElements = Vertex_Position::NumElements;
+        pipelineStateDesc.inputLayout.pInputElementDescs = Vertex_Position::pInputElementDescs;
+
+        // プリミティブトポロジータイプ
+        pipelineStateDesc.primitiveTopologyType = PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE; // 三角形
+
+        // レンダーターゲット
+        pipelineStateDesc.numRenderTargets = 1;
+        pipelineStateDesc.rtvFormats[0] = m_BufferFormat;
+
+        // アンチエイリアス マルチサンプル
+        pipelineStateDesc.sampleCount = 1;
+
+        // 頂点の構造体とシェーダーの入力が合っているか
+        m_PipelineSetup.pipelineStateResult = ValidateInputLayout(
+            m_PipelineSetup.vertexShader.reflection,
+            pipelineStateDesc.inputLayout,
+            &m_PipelineSetup.pipelineStateErrorText
+        );
+        if (FAILED(m_PipelineSetup.pipelineStateResult))
+        {
+            m_PipelineSetup.pipelineStateErrorText = "ValidateInputLayout\n" + m_PipelineSetup.pipelineStateErrorText;
+            return;
+        }
+
+        m_PipelineSetup.pipelineStateResult = m_PipelineStateCache.GetOrCreate(
+            pipelineStateDesc,
+            &m_pPipelineState
+        );
+        m_PipelineSetup.pipelineStateErrorText = "PipelineStateCache::GetOrCreate";
+        m_PipelineUpdate.pipelineStateDesc = pipelineStateDesc;
+        m_PipelineSetup.readyMilliseconds = GetStartupMilliseconds();
+        AddStartupStage("PipelineState", beginMilliseconds, false);
+        if (SUCCEEDED(m_PipelineSetup.pipelineStateResult))
+        {
+            m_PipelineTrace.Record(
+                m_ShaderPermutations.MakeUsage(m_PipelineUpdate.vertexShaderIndex, 0),
+                m_ShaderPermutations.MakeUsage(m_PipelineUpdate.pixelShaderIndex, 0),
+                pipelineStateDesc
+            );
+        }
+    }, &rootSignatureTask, 1);
+
+    // 前回作ったパイプラインを、描画で要求される前に作っておく
+    // 起動に必要なパイプラインを先に作り、同じものを同時にコンパイルしないようにする
+    if (m_IsPipelinePrewarmEnabled)
+    {
+        std::vector<PipelineTraceEntry> entries;
+        ResultUtil result = PipelineTrace::Load(PipelineTracePath, &entries);
+        if (result)
+        {
+            m_PipelineSetup.prewarmBeginMilliseconds = GetStartupMilliseconds();
+            m_PipelinePrewarmer.Begin(entries, &m_PipelineSetup.task, 1);
+        }
+        else if (result.GetHRESULT() != HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND))
+        {
+            DebugOutputFormatString("[Prewarm] %s を読めません (0x%08X)", PipelineTracePath, static_cast<u32>(result.GetHRESULT()));
+        }
+    }
+}
+
+
+// パイプラインの準備が終わるのを待つ
+bool SampleApp::EndPipelineSetup()
+{
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    m_TaskScheduler.Wait(m_PipelineSetup.task);
+    m_PipelineSetup.waitMilliseconds = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+
+    // エラーは依存関係の順に表示する
+    ResultUtil result;
+    for (const ShaderLoad* pLoad : { &m_PipelineSetup.vertexShader, &m_PipelineSetup.pixelShader })
+    {
+        result = pLoad->result;
+        if (!result)
+        {
+            ShowErrorMessage(result, pLoad->errorText);
+            return false;
+        }
+    }
+
+    result = m_PipelineSetup.rootSignatureResult;
+    if (!result)
+    {
+        ShowErrorMessage(result, m_PipelineSetup.rootSignatureErrorText);
+        return false;
+    }
+
+    result = m_PipelineSetup.pipelineStateResult;
+    if (!result)
+    {
+        ShowErrorMessage(result, m_PipelineSetup.pipelineStateErrorText);
+        return false;
+    }
+
+    // 書き出せなくても次回コンパイルするだけなので続ける
+    result = m_PipelineStateCache.Save();
+    if (!result)
+    {
+        DebugOutputFormatString("[PipelineCache] 書き出しに失敗しました (0x%08X)", static_cast<u32>(result.GetHRESULT()));
+    }
+
+    if (m_IsShaderHotReloadEnabled)
+    {
+        BeginShaderHotReload();
+    }
+    return true;
+}
+
+
+// ホットリロードを始める
+void SampleApp::BeginShaderHotReload()
+{
+    // コンパイルはワーカーで行うので、ワーカーが無ければ使えない
+    if (m_WorkerCount == 0)
+    {
+        DebugOutputFormatString("[HotReload] ワーカーが無いので無効にします");
+        m_IsShaderHotReloadEnabled = false;
+        return;
+    }
+
+    // アーカイブから読んだ場合もコンパイラを用意する
+    std::string errorText;
+    HRESULT hr = PrepareShaderCompiler(&errorText);
+    if (FAILED(hr) || !m_ShaderHotReloader.Init(&m_ShaderCache, &m_TaskScheduler))
+    {
+        DebugOutputFormatString("[HotReload] 開始できないので無効にします (0x%08X)", static_cast<u32>(hr));
+        m_IsShaderHotReloadEnabled = false;
+        return;
+    }
+
+    m_HotReload.vertexShaderIndex = m_ShaderHotReloader.AddShader(m_PipelineSetup.vertexShader.desc);
+    m_HotReload.pixelShaderIndex = m_ShaderHotReloader.AddShader(m_PipelineSetup.pixelShader.desc);
+}
+
+
+// 変更されたシェーダーを受け取り、そのバリアントを捨てる
+void SampleApp::UpdateShaderHotReload()
+{
+    m_ShaderHotReloader.Update(&m_ShaderReloadResults);
+    for (ShaderReloadResult& reload : m_ShaderReloadResults)
+    {
+        const std::string name = ShaderArchive::MakeName(m_ShaderHotReloader.GetDesc(reload.shaderIndex));
+
+        // 失敗したら前のパイプラインのまま続ける
+        if (FAILED(reload.result))
+        {
+            DebugOutputFormatString("[HotReload] %s のコンパイルに失敗しました (0x%08X)\n%s", name.c_str(), static_cast<u32>(reload.result), reload.errorText.c_str());
+            continue;
+        }
+
+        // 使っているバリアントは UpdatePipeline で要求し直す (既定のバリアントはキャッシュに入ったものを読む)
+        // アーカイブの内容は古くなったので以降は使わない
+        m_IsShaderSourceChanged = true;
+        m_ShaderPermutations.Invalidate((reload.shaderIndex == m_HotReload.vertexShaderIndex) ? m_PipelineUpdate.vertexShaderIndex : m_PipelineUpdate.pixelShaderIndex);
+        DebugOutputFormatString("[HotReload] %s をコンパイルしました", name.c_str());
+    }
+}
+
+
+// 要求するバリアントでパイプラインを作り直し、できたものに差し替える
+void SampleApp::UpdatePipeline()
+{
+    PipelineUpdate& update = m_PipelineUpdate;
+
+    // 作り直しが終わっていれば差し替える (ワーカーが無ければここで作る)
+    // 前のパイプラインはキャッシュが持ったままなので、GPU が使用中でも解放されない
+    if (update.rebuildTask.pState && m_WorkerCount == 0)
+    {
+        m_TaskScheduler.Wait(update.rebuildTask);
+    }
+    if (update.rebuildTask.pState && m_TaskScheduler.IsCompleted(update.rebuildTask))
+    {
+        if (SUCCEEDED(update.rebuildResult))
+        {
+            m_pRootSignature = update.pRebuiltRootSignature;
+            m_pPipelineState = update.pRebuiltPipelineState;
+            update.swapCount++;
+        }
+        else
+        {
+            DebugOutputFormatString("[ShaderVariant] パイプラインの作成に失敗しました (0x%08X)\n%s", static_cast<u32>(update.rebuildResult), update.rebuildErrorText.c_str());
+        }
+        update.rebuildTask = TaskHandle();
+    }
+
+    // コンパイル中はフォールバックが返るので、できたときにもう一度作り直す
+    ShaderVariantKey vertexShaderKey = 0;
+    ShaderVariantKey pixelShaderKey = update.pixelShaderKey;
+    ShaderBytecode vertexShader = {};
+    ShaderBytecode pixelShader = {};
+    const SHADER_VARIANT_STATUS vertexShaderStatus = m_ShaderPermutations.Request(update.vertexShaderIndex, vertexShaderKey, &vertexShader);
+    const SHADER_VARIANT_STATUS pixelShaderStatus = m_ShaderPermutations.Request(update.pixelShaderIndex, pixelShaderKey, &pixelShader);
+    if (pixelShaderStatus == SHADER_VARIANT_STATUS_FAILED)
+    {
+        DebugOutputFormatString("[ShaderVariant] %s を使えないので既定のバリアントにします", ShaderArchive::MakeName(m_ShaderPermutations.MakeDesc(update.pixelShaderIndex, pixelShaderKey)).c_str());
+        update.pixelShaderKey = 0;
+    }
+    if (vertexShaderStatus == SHADER_VARIANT_STATUS_UNAVAILABLE || pixelShaderStatus == SHADER_VARIANT_STATUS_UNAVAILABLE)
+    {
+        return;
+    }
+    if (pixelShaderStatus != SHADER_VARIANT_STATUS_READY)
+    {
+        pixelShaderKey = 0;
+    }
+
+    if (vertexShader.pShaderBytecode != update.pipelineStateDesc.VS.pShaderBytecode || pixelShader.pShaderBytecode != update.pipelineStateDesc.PS.pShaderBytecode)
+    {
+        update.pipelineStateDesc.VS = vertexShader;
+        update.pipelineStateDesc.PS = pixelShader;
+        update.isRebuildNeeded = true;
+    }
+
+    // 作り直している間に変わったものは、終わってから作り直す
+    if (!update.isRebuildNeeded || update.rebuildTask.pState)
+    {
+        return;
+    }
+    update.isRebuildNeeded = false;
+
+    // 事前作成したものならキャッシュにあるので、ここではコンパイルしない
+    const GraphicsPipelineStateDesc pipelineStateDesc = update.pipelineStateDesc;
+    update.rebuildTask = m_TaskScheduler.Submit("RebuildPipelineState", [this, vertexShaderKey, pixelShaderKey, pipelineStateDesc]()
+    {
+        PipelineUpdate& update = m_PipelineUpdate;
+        update.rebuildErrorText.clear();
+        update.rebuildResult = CreateVariantPipelineState(
+            update.vertexShaderIndex,
+            vertexShaderKey,
+            update.pixelShaderIndex,
+            pixelShaderKey,
+            pipelineStateDesc,
+            &update.pRebuiltRootSignature,
+            &update.pRebuiltPipelineState,
+            &update.rebuildErrorText
+        );
+    });
+}
+
+
+// リフレクションからルートシグネチャを作る (ワーカーから呼ぶ)
+HRESULT SampleApp::CreateReflectedRootSignature(const ShaderReflection& vertexShader, const ShaderReflection& pixelShader, IGraphicsRootSignature** ppOut, std::string* pErrorText)
+{
+    const ShaderReflection* stages[] = { &vertexShader, &pixelShader };
+
+    ReflectedRootSignature rootSignature;
+    HRESULT hr = rootSignature.Build(stages, _countof(stages));
+    if (FAILED(hr))
+    {
+        *pErrorText = "ReflectedRootSignature::Build";
+        return hr;
+    }
+
+    std::string text;
+    hr = m_PipelineStateCache.GetOrCreateRootSignature(rootSignature.GetDesc(), ppOut, &text);
+    if (FAILED(hr))
+    {
+        *pErrorText = "PipelineStateCache::GetOrCreateRootSignature\n" + text;
+        return hr;
+    }
+    return S_OK;
+}
+
+
+// バリアントからパイプラインを作る (ワーカーから呼ぶ)
+HRESULT SampleApp::CreateVariantPipelineState(u32 vertexShaderIndex, ShaderVariantKey vertexShaderKey, u32 pixelShaderIndex, ShaderVariantKey pixelShaderKey, const GraphicsPipelineStateDesc& desc, IGraphicsRootSignature** ppRootSignature, IGraphicsPipelineState** ppPipelineState, std::string* pErrorText)
+{
+    // バインドや入力が変わっていることがあるので、ルートシグネチャから作り直す
+    ShaderReflection vertexShader;
+    ShaderReflection pixelShader;
+    HRESULT hr = ReflectShader(m_Backend, m_ShaderPermutations.MakeDesc(vertexShaderIndex, vertexShaderKey), desc.VS, &vertexShader);
+    if (SUCCEEDED(hr))
+    {
+        hr = ReflectShader(m_Backend, m_ShaderPermutations.MakeDesc(pixelShaderIndex, pixelShaderKey), desc.PS, &pixelShader);
+    }
+    if (FAILED(hr))
+    {
+        *pErrorText = "ReflectShader";
+        return hr;
+    }
+
+    GraphicsPipelineStateDesc pipelineStateDesc = desc;
+    hr = CreateReflectedRootSignature(vertexShader, pixelShader, ppRootSignature, pErrorText);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    pipelineStateDesc.pRootSignature = *ppRootSignature;
+
+    hr = ValidateInputLayout(vertexShader, pipelineStateDesc.inputLayout, pErrorText);
+    if (FAILED(hr))
+    {
+        *pErrorText = "ValidateInputLayout\n" + *pErrorText;
+        return hr;
+    }
+
+    hr = m_PipelineStateCache.GetOrCreate(pipelineStateDesc, ppPipelineState);
+    if (FAILED(hr))
+    {
+        *pErrorText = "PipelineStateCache::GetOrCreate";
+        return hr;
+    }
+
+    m_PipelineTrace.Record(
+        m_ShaderPermutations.MakeUsage(vertexShaderIndex, vertexShaderKey),
+        m_ShaderPermutations.MakeUsage(pixelShaderIndex, pixelShaderKey),
+        pipelineStateDesc
+    );
+    return S_OK;
+}
+
+
+// シェーダーのバイトコードを取得 (ワーカーから呼ぶ)
+HRESULT SampleApp::LoadShader(const ShaderCompileDesc& desc, ShaderBytecode* pOut, std::string* pErrorText)
+{
+    // アーカイブにあれば、マップしたものをコピーせずに使う
+    if (m_ShaderArchive.IsOpen() && !m_IsShaderSourceChanged && m_ShaderArchive.Find(desc, pOut))
+    {
+        m_ShaderArchiveHitCount++;
+        return S_OK;
+    }
+
+    // コンパイラはアーカイブに無いものがあったときに初めて作る
+    HRESULT hr = PrepareShaderCompiler(pErrorText);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::vector<u8> bytecode;
+    std::string text;
+    hr = m_ShaderCache.CompileFromFile(desc, &bytecode, &text);
+    if (FAILED(hr))
+    {
+        *pErrorText = "IShaderCompiler::CompileFromFile";
+
+        if (hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND))
+        {
+            *pErrorText += "\nファイルが見つかりません。";
+        }
+        else
+        {
+            *pErrorText += "\n";
+            *pErrorText += text;
+        }
+        return hr;
+    }
+
+    *pOut = StoreCompiledShader(&bytecode);
+    return S_OK;
+}
+
+
+// コンパイラとキャッシュを作る
+HRESULT SampleApp::PrepareShaderCompiler(std::string* pErrorText)
+{
+    std::lock_guard<std::mutex> lock(m_ShaderCompilerMutex);
+    if (m_ShaderCompiler)
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = CreateShaderCompiler(m_Backend, &m_ShaderCompiler);
+    if (FAILED(hr))
+    {
+        *pErrorText = "CreateShaderCompiler";
+        return hr;
+    }
+
+    // 内容が変わっていなければ前回のバイトコードを使う
+    m_ShaderCache.Init(m_ShaderCompiler.get(), "ShaderCache");
+    return S_OK;
+}
+
+
+// コンパイルしたバイトコードを解放時まで持つ
+ShaderBytecode SampleApp::StoreCompiledShader(std::vector<u8>* pBytecode)
+{
+    // 要素の移動ではバッファの位置は変わらない
+    std::lock_guard<std::mutex> lock(m_ShaderCompilerMutex);
+    m_CompiledShaders.push_back(std::move(*pBytecode));
+
+    ShaderBytecode bytecode = {};
+    bytecode.pShaderBytecode = m_CompiledShaders.back().data();
+    bytecode.bytecodeLength = m_CompiledShaders.back().size();
+    return bytecode;
+}
+
+
+// GPU がフレームを使い終わるまで待つ
+bool SampleApp::WaitForFrame(const FrameContext& frame)
+{
+    if (m_Fence->GetCompletedValue() >= frame.fenceValue)
+    {
+        return true;
+    }
+
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+
+    ResultUtil result = m_Fence->Wait(frame.fenceValue);
+    if (!result)
+    {
+        ShowErrorMessage(result, "IGraphicsFence::Wait");
+        return false;
+    }
+
+    const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+    m_FenceWaitCount++;
+    m_FenceWaitMilliseconds += std::chrono::duration<f64, std::milli>(endTime - beginTime).count();
+    return true;
+}
+
+
 // エラーメッセージ表示
 void SampleApp::ShowErrorMessage(const ResultUtil& result, const std::string& text)
 {
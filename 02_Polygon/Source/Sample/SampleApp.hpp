@@ -4,7 +4,7 @@
 class SampleApp
 {
 public:
-    SampleApp(IApp* pApp);
+    SampleApp(IApp* pApp, const AppStartupDesc& startupDesc);
 
     ~SampleApp();
 
@@ -32,48 +32,301 @@ public:
     // マウスホイール
     void OnMouseWheel(const Position2D& position, s32 wheelDelta);
 
+    // 使う全てのシェーダーをコンパイルしてアーカイブにまとめる
+    static bool BuildShaderArchive(GRAPHICS_BACKEND backend, const std::string& path);
+
+    // 描画のキーを基数ソート (1 スレッドとワーカー) と std::sort で並べて時間を比べる
+    static void RunSortBenchmark(u32 workerCount, u32 count);
+
+
+private:
+    // フレームごとに持つもの (GPU が使い終わるまで再利用できない)
+    // (コマンドアロケータは CommandListPool がフェンスで回収する)
+    struct FrameContext
+    {
+        u64 fenceValue; // このフレームの完了を示すフェンス値
+    };
+
+    // ワーカーで読み込むシェーダー
+    struct ShaderLoad
+    {
+        ShaderCompileDesc desc;
+        ShaderBytecode    bytecode;
+        ShaderReflection  reflection;
+        HRESULT           result;
+        std::string       errorText;
+    };
+
+    // シェーダーのホットリロード (変更されたシェーダーのバリアントを捨て、UpdatePipeline で作り直す)
+    struct HotReload
+    {
+        u32 vertexShaderIndex; // m_ShaderHotReloader
+        u32 pixelShaderIndex;
+    };
+
+    // 描画に使うバリアントとパイプラインの作り直し
+    // 要求したバリアントができるまではフォールバックで作ったパイプラインで描画する
+    // パイプラインはワーカーで作り、終わってから Update で差し替える
+    struct PipelineUpdate
+    {
+        u32                       vertexShaderIndex;    // m_ShaderPermutations
+        u32                       pixelShaderIndex;
+        u32                       colorModeFeature;
+        ShaderVariantKey          pixelShaderKey;       // 要求するバリアント
+        GraphicsPipelineStateDesc pipelineStateDesc;    // 最後に作り始めたパイプラインの設定
+        bool                      isRebuildNeeded;
+        TaskHandle                rebuildTask;
+        HRESULT                   rebuildResult;
+        std::string               rebuildErrorText;
+        IGraphicsRootSignature*   pRebuiltRootSignature;
+        IGraphicsPipelineState*   pRebuiltPipelineState;
+        u32                       swapCount;
+    };
+
+    // 初期化時にワーカーで行うパイプラインの準備 (結果は EndPipelineSetup で確認する)
+    struct PipelineSetup
+    {
+        ShaderLoad  vertexShader;
+        ShaderLoad  pixelShader;
+        HRESULT     rootSignatureResult;
+        std::string rootSignatureErrorText;
+        HRESULT     pipelineStateResult;
+        std::string pipelineStateErrorText;
+        TaskHandle  task;                // パイプラインステートの作成 (他の全てに依存する)
+        f64         beginMilliseconds;   // Init の開始からの時間
+        f64         prewarmBeginMilliseconds;
+        f64         readyMilliseconds;   // Init の開始からパイプラインができるまで
+        f64         waitMilliseconds;    // メインスレッドがパイプラインを待った時間
+    };
+
+    // 描画に使う状態 (Update の後に作り、描画はこれだけを読む)
+    // 描画スレッドを使う場合は、描画スレッドがフレーム N を描画する間にメインスレッドがフレーム N + 1 を更新する
+    struct RenderSnapshot
+    {
+        u64                                   frameNumber;
+        bool                                  isContentReady;
+        IGraphicsPipelineState*               pPipelineState; // キャッシュが解放時まで持つ
+        IGraphicsRootSignature*               pRootSignature;
+        VertexBufferView                      vertexBufferView;
+        IndexBufferView                       indexBufferView;
+        Viewport                              viewport;
+        Rect                                  scissorRect;
+        std::chrono::steady_clock::time_point updateBeginTime; // 遅延の計測用
+    };
+
+    // フレームの遅延と間隔の統計 (描画したスレッドが書く)
+    struct FrameTiming
+    {
+        u64                                   frameCount;
+        f64                                   latencyMilliseconds;    // 更新の開始から Present までの合計
+        f64                                   maxLatencyMilliseconds;
+        f64                                   renderMilliseconds;     // 記録から Present までの合計
+        f64                                   mainWaitMilliseconds;   // メインスレッドが描画の状態の空きを待った時間
+        f64                                   renderIdleMilliseconds; // 描画スレッドが描画の状態を待った時間
+        std::chrono::steady_clock::time_point firstPresentTime;
+        std::chrono::steady_clock::time_point lastPresentTime;
+    };
+
+    // 起動の段階 (時間は Init の開始から)
+    struct StartupStage
+    {
+        const char* name;
+        f64         beginMilliseconds;
+        f64         endMilliseconds;
+        bool        isMainThread;
+    };
 
 private:
     // バックバッファを作成
     bool CreateBackBuffer(const Size2D& newSize);
 
+    // 頂点とインデックスのバッファを作って転送を始める
+    bool CreateGeometry();
+
+    // 最初のフレームの後に、ジオメトリの転送、パイプラインの確認、事前作成の完了を順に進める
+    // 全て終わるまでは Render はクリアだけ行う
+    void UpdateStartup();
+
+    f64 GetStartupMilliseconds() const;
+
+    // beginMilliseconds から今までを記録する (複数のスレッドから呼んでよい)
+    void AddStartupStage(const char* name, f64 beginMilliseconds, bool isMainThread);
+
+    // シェーダーとパイプラインの作成をワーカーで始める
+    void BeginPipelineSetup();
+
+    // 終わるのを待ち、失敗していればエラーを表示する
+    bool EndPipelineSetup();
+
+    // シェーダーのバイトコードを取得 (アーカイブになければコンパイルする、複数のスレッドから呼んでよい)
+    HRESULT LoadShader(const ShaderCompileDesc& desc, ShaderBytecode* pOut, std::string* pErrorText);
+
+    // コンパイラとキャッシュを作る (作成済みなら何もしない)
+    HRESULT PrepareShaderCompiler(std::string* pErrorText);
+
+    // コンパイルしたバイトコードを解放時まで持つ
+    ShaderBytecode StoreCompiledShader(std::vector<u8>* pBytecode);
+
+    // シェーダーのリフレクションからルートシグネチャを作る (同じものはキャッシュが共有する、複数のスレッドから呼んでよい)
+    HRESULT CreateReflectedRootSignature(const ShaderReflection& vertexShader, const ShaderReflection& pixelShader, IGraphicsRootSignature** ppOut, std::string* pErrorText);
+
+    // バリアントのバイトコードを入れた設定から、ルートシグネチャとパイプラインを作って使用記録に加える (複数のスレッドから呼んでよい)
+    HRESULT CreateVariantPipelineState(u32 vertexShaderIndex, ShaderVariantKey vertexShaderKey, u32 pixelShaderIndex, ShaderVariantKey pixelShaderKey, const GraphicsPipelineStateDesc& desc, IGraphicsRootSignature** ppRootSignature, IGraphicsPipelineState** ppPipelineState, std::string* pErrorText);
+
+    // ホットリロードを始める (失敗しても描画は続ける)
+    void BeginShaderHotReload();
+
+    // 変更されたシェーダーを受け取り、そのバリアントを捨てる
+    void UpdateShaderHotReload();
+
+    // 要求するバリアントでパイプラインを作り直し、できたものに差し替える
+    void UpdatePipeline();
+
+    // 今の描画の状態を取り出す
+    void MakeRenderSnapshot(RenderSnapshot* pOut);
+
+    // 1 フレームを記録して実行し、Present する
+    bool RenderFrame(const RenderSnapshot& snapshot);
+
+    // 描画スレッド
+    void BeginRenderThread();
+
+    // 渡した状態を全て描画してから止める
+    void EndRenderThread();
+
+    void RenderThreadMain();
+
+    // 空きができるまで待ってから描画スレッドに渡す (描画スレッドが失敗して止まっていれば false)
+    bool PushRenderSnapshot(const RenderSnapshot& snapshot);
+
+    // GPU がフレームを使い終わるまで待つ
+    bool WaitForFrame(const FrameContext& frame);
+
     // エラーメッセージ表示
     void ShowErrorMessage(const ResultUtil& result, const std::string& text);
 
 
 private:
     IApp * m_pApp;
-    UINT m_BufferCount;
+    GRAPHICS_BACKEND m_Backend;
+    f64 m_EmulatedGpuMilliseconds;
+    u32 m_BufferCount;
+    f64 m_EmulatedUpdateMilliseconds;
+
+    GRAPHICS_FORMAT m_BufferFormat;
+
+    std::unique_ptr<IGraphicsDevice>    m_Device;
+    std::mutex                          m_ShaderCompilerMutex; // m_ShaderCompiler の作成と m_CompiledShaders
+    std::unique_ptr<IShaderCompiler>    m_ShaderCompiler;
+    ShaderCache                         m_ShaderCache; // m_ShaderCompiler の前段
+
+    // シェーダー (アーカイブのものはマップしたまま、コンパイルしたものはここに持つ)
+    std::string                  m_ShaderArchivePath;
+    ShaderArchive                m_ShaderArchive;
+    std::vector<std::vector<u8>> m_CompiledShaders;
+    std::atomic<u32>             m_ShaderArchiveHitCount;
+    std::atomic<bool>            m_IsShaderSourceChanged; // ホットリロード後はアーカイブを使わない
+    f64                          m_ShaderArchiveOpenMilliseconds;
+    std::unique_ptr<IGraphicsSwapChain> m_SwapChain;
+
+    std::unique_ptr<IGraphicsCommandQueue> m_CommandQueue;
+
+    // コマンドリスト (アロケータと組でプールから借り、四角形はワーカーで分けて記録する)
+    CommandListPool         m_CommandListPool;
+    ParallelCommandRecorder m_CommandRecorder;
+    u32                     m_QuadCount;
+    u32                     m_RecordChunkSize;
+    bool                    m_IsStateFilterEnabled;
+    std::mutex              m_StateFilterMutex;      // 記録するワーカーから足す
+    StateFilterStatistics   m_StateFilterStatistics;
+    DrawQueue               m_DrawQueue;             // 四角形をキーで並べてから記録する
+
+    // フレームコンテキストのリング (バックバッファの数だけ同時に処理中にできる)
+    std::vector<FrameContext> m_FrameContexts;
+    u32                       m_FrameIndex;
+
+    // ディスクリプタ
+    DescriptorHeapAllocator           m_RTVAllocator;
+    std::vector<DescriptorAllocation> m_BackBufferRTVs;
+    DescriptorRing                    m_DescriptorRing; // フレームごとのテーブル用
+    std::vector<IGraphicsResource*>          m_BackBuffers; // スワップチェインが所有
+
+    // リソースの状態の追跡
+    ResourceStateTable   m_ResourceStates;
+    ResourceStateTracker m_StateTracker;
 
-    DXGI_FORMAT       m_BufferFormat;
-    D3D_FEATURE_LEVEL m_FeatureLevel;
+    // フレームのパスの構成
+    RenderGraph m_RenderGraph;
 
-    ComPtr<IDXGIFactory6>   m_Factory;
-    ComPtr<IDXGIAdapter>    m_Adapter;
-    ComPtr<IDXGISwapChain4> m_SwapChain;
+    u64 m_FenceValue;
+    std::unique_ptr<IGraphicsFence> m_Fence;
 
-    ComPtr<ID3D12Device>              m_Device;
-    ComPtr<ID3D12CommandAllocator>    m_CommandAllocator;
-    ComPtr<ID3D12GraphicsCommandList> m_GraphicsCommandList;
-    ComPtr<ID3D12CommandQueue>        m_CommandQueue;
+    // フレームの完了待ちの統計
+    u64 m_FenceWaitCount;
+    f64 m_FenceWaitMilliseconds;
 
-    ComPtr<ID3D12DescriptorHeap>         m_RTVHeaps;
-    std::vector<ComPtr<ID3D12Resource1>> m_BackBuffers;
+    // 静的なジオメトリ (DEFAULT ヒープに置き、COPY キューで転送する)
+    GpuHeapAllocator                   m_BufferHeap;
+    UploadManager                      m_UploadManager;
+    std::unique_ptr<IGraphicsResource> m_VertexBuffer;
+    std::unique_ptr<IGraphicsResource> m_IndexBuffer;
+    GpuHeapAllocation                  m_VertexBufferAllocation;
+    GpuHeapAllocation                  m_IndexBufferAllocation;
+    VertexBufferView                   m_VertexBufferView;
+    IndexBufferView                    m_IndexBufferView;
 
-    UINT64 m_FenceValue;
-    ComPtr<ID3D12Fence1> m_Fence;
+    // パイプラインステートとルートシグネチャはキャッシュが持つ
+    PipelineStateCache      m_PipelineStateCache;
+    IGraphicsPipelineState* m_pPipelineState;
+    IGraphicsRootSignature* m_pRootSignature;
 
-    ComPtr<ID3D12Resource1> m_VertexBuffer;
-    ComPtr<ID3D12Resource1> m_IndexBuffer;
-    D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;
-    D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
+    Viewport m_Viewport;
+    Rect m_ScissorRect;
 
-    ComPtr<ID3D12PipelineState> m_PipelineState;
+    // 初期化のタスク (解放時は最初に止める)
+    CpuTopology                           m_CpuTopology;
+    bool                                  m_IsThreadAffinityEnabled;
+    u32                                   m_MainProcessor;     // メインスレッドを固定した論理プロセッサ
+    u32                                   m_RenderProcessor;   // 描画スレッドを固定する論理プロセッサ
+    TaskScheduler                         m_TaskScheduler;
+    u32                                   m_WorkerCount;
+    PipelineSetup                         m_PipelineSetup;
+    ShaderPermutationManager              m_ShaderPermutations;
+    PipelineUpdate                        m_PipelineUpdate;
+    PipelineTrace                         m_PipelineTrace;     // 今回作ったパイプライン (次回の事前作成に使う)
+    PipelinePrewarmer                     m_PipelinePrewarmer; // 前回の記録からの事前作成
+    bool                                  m_IsPipelinePrewarmEnabled;
+    u32                                   m_ColorMode;
+    bool                                  m_IsShaderHotReloadEnabled;
+    ShaderHotReloader                     m_ShaderHotReloader;
+    HotReload                             m_HotReload;
+    std::vector<ShaderReloadResult>       m_ShaderReloadResults;
+    std::chrono::steady_clock::time_point m_InitBeginTime;
+    f64                                   m_InitMilliseconds;
 
-    ComPtr<ID3D12RootSignature> m_RootSignature;
+    // 段階的な起動 (Init は最初のフレームに要るものだけを作り、残りは UpdateStartup で進める)
+    bool                      m_IsGeometryReady;
+    bool                      m_IsPipelineReady;
+    bool                      m_IsContentReady;          // 四角形を描画できる
+    f64                       m_FirstFrameMilliseconds;  // 最初のフレームを出すまで
+    f64                       m_ContentReadyMilliseconds;
+    f64                       m_ContentFrameMilliseconds; // 四角形を描画した最初のフレームを出すまで
+    std::mutex                m_StartupMutex;
+    std::vector<StartupStage> m_StartupStages;
 
-    D3D12_VIEWPORT m_Viewport;
-    D3D12_RECT m_ScissorRect;
+    // 描画スレッド (読み込みが終わるまではメインスレッドで描画する)
+    u32                                   m_RenderSnapshotCount;  // 0 なら使わない
+    std::thread                           m_RenderThread;
+    std::mutex                            m_RenderMutex;
+    std::condition_variable               m_RenderCondition;      // 状態が渡された、または描画し終わった
+    std::vector<RenderSnapshot>           m_RenderSnapshots;      // リング (m_PushedSnapshotCount % 数 に書く)
+    u64                                   m_PushedSnapshotCount;
+    u64                                   m_RenderedSnapshotCount;
+    bool                                  m_IsRenderThreadQuitting;
+    bool                                  m_IsRenderThreadFailed;
+    u64                                   m_UpdateFrameNumber;
+    std::chrono::steady_clock::time_point m_UpdateBeginTime;
+    FrameTiming                           m_FrameTiming;
 };
 
 
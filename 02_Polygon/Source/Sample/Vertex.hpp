@@ -1,13 +1,14 @@
-#pragma once
+﻿#pragma once
 
 
+// 入力レイアウトは頂点シェーダーのリフレクションと照合する (合わなければ初期化に失敗する)
 struct Vertex_Position
 {
-    DirectX::XMFLOAT3 position;
+    Float3 position;
 
-    static constexpr D3D12_INPUT_ELEMENT_DESC pInputElementDescs[] = {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    static constexpr InputElementDesc pInputElementDescs[] = {
+        { "POSITION", 0, GRAPHICS_FORMAT_R32G32B32_FLOAT, 0, APPEND_ALIGNED_ELEMENT },
     };
 
-    static constexpr UINT NumElements = _countof(pInputElementDescs);
+    static constexpr u32 NumElements = _countof(pInputElementDescs);
 };
@@ -0,0 +1,490 @@
+﻿
+
+// OS から取得したままの論理プロセッサの情報 (番号を振る前)
+struct CpuRawProcessor
+{
+    u32 group;
+    u32 number;
+    u64 coreKey;      // 同じ物理コアなら同じ値
+    u64 clusterKey;   // L3 を共有するなら同じ値
+    u64 performance;  // 大きいほど性能が高い (種類を分けるための目安)
+};
+
+
+// 性能の目安がこの比率以内なら同じ種類とみなす (最大クロックのわずかな違いで分けない)
+static const f64 EfficiencyClassTolerance = 1.1;
+
+
+// コアとクラスターに番号を振り、性能の目安を種類に分ける
+static void BuildLogicalProcessors(const std::vector<CpuRawProcessor>& rawProcessors, std::vector<CpuLogicalProcessor>* pOut, u32* pCoreCount, u32* pClusterCount)
+{
+    std::vector<u64> performances;
+    for (const CpuRawProcessor& raw : rawProcessors)
+    {
+        performances.push_back(raw.performance);
+    }
+    std::sort(performances.begin(), performances.end());
+    performances.erase(std::unique(performances.begin(), performances.end()), performances.end());
+
+    // 種類の境目 (それぞれの種類の最小の値)
+    std::vector<u64> classBases;
+    for (u64 performance : performances)
+    {
+        if (classBases.empty() || static_cast<f64>(performance) > static_cast<f64>(classBases.back()) * EfficiencyClassTolerance)
+        {
+            classBases.push_back(performance);
+        }
+    }
+
+    std::unordered_map<u64, u32> coreIndices;
+    std::unordered_map<u64, u32> clusterIndices;
+    std::unordered_map<u64, u32> coreThreadCounts;
+
+    pOut->clear();
+    pOut->reserve(rawProcessors.size());
+    for (const CpuRawProcessor& raw : rawProcessors)
+    {
+        CpuLogicalProcessor processor = {};
+        processor.group = raw.group;
+        processor.number = raw.number;
+        processor.core = coreIndices.emplace(raw.coreKey, static_cast<u32>(coreIndices.size())).first->second;
+        processor.cluster = clusterIndices.emplace(raw.clusterKey, static_cast<u32>(clusterIndices.size())).first->second;
+        processor.efficiencyClass = static_cast<u32>(std::upper_bound(classBases.begin(), classBases.end(), raw.performance) - classBases.begin()) - 1;
+        processor.smtIndex = coreThreadCounts[raw.coreKey]++;
+        pOut->push_back(processor);
+    }
+    *pCoreCount = static_cast<u32>(coreIndices.size());
+    *pClusterCount = static_cast<u32>(clusterIndices.size());
+}
+
+
+#if defined(_WIN32)
+
+static bool ProbeProcessors(std::vector<CpuRawProcessor>* pOut)
+{
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    if (length == 0)
+    {
+        return false;
+    }
+    std::vector<u8> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+    {
+        return false;
+    }
+
+    // L3 とパッケージのマスク (L3 が無ければパッケージでまとめる)
+    std::vector<GROUP_AFFINITY> caches;
+    std::vector<GROUP_AFFINITY> packages;
+    for (DWORD offset = 0; offset < length;)
+    {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* pInfo = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        if (pInfo->Relationship == RelationCache && pInfo->Cache.Level == 3)
+        {
+            caches.push_back(pInfo->Cache.GroupMask);
+        }
+        else if (pInfo->Relationship == RelationProcessorPackage)
+        {
+            for (WORD i = 0; i < pInfo->Processor.GroupCount; i++)
+            {
+                packages.push_back(pInfo->Processor.GroupMask[i]);
+            }
+        }
+        offset += pInfo->Size;
+    }
+
+    const auto findMask = [](const std::vector<GROUP_AFFINITY>& masks, u32 group, u32 number) -> u64
+    {
+        for (size_t i = 0; i < masks.size(); i++)
+        {
+            if (masks[i].Group == group && (masks[i].Mask & (static_cast<KAFFINITY>(1) << number)) != 0)
+            {
+                return i;
+            }
+        }
+        return ~0ull;
+    };
+
+    u64 coreKey = 0;
+    pOut->clear();
+    for (DWORD offset = 0; offset < length;)
+    {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* pInfo = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+        if (pInfo->Relationship == RelationProcessorCore)
+        {
+            for (WORD i = 0; i < pInfo->Processor.GroupCount; i++)
+            {
+                const GROUP_AFFINITY& mask = pInfo->Processor.GroupMask[i];
+                for (u32 number = 0; number < sizeof(KAFFINITY) * 8; number++)
+                {
+                    if ((mask.Mask & (static_cast<KAFFINITY>(1) << number)) == 0)
+                    {
+                        continue;
+                    }
+
+                    CpuRawProcessor raw = {};
+                    raw.group = mask.Group;
+                    raw.number = number;
+                    raw.coreKey = coreKey;
+                    raw.clusterKey = findMask(caches, mask.Group, number);
+                    if (raw.clusterKey == ~0ull)
+                    {
+                        raw.clusterKey = (1ull << 32) | findMask(packages, mask.Group, number);
+                    }
+                    raw.performance = pInfo->Processor.EfficiencyClass;
+                    pOut->push_back(raw);
+                }
+            }
+            coreKey++;
+        }
+        offset += pInfo->Size;
+    }
+    return !pOut->empty();
+}
+
+#else
+
+static bool ReadTextFile(const std::string& path, std::string* pOut)
+{
+    FILE* pFile = fopen(path.c_str(), "rb");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    pOut->clear();
+    char buffer[256];
+    size_t size = 0;
+    while ((size = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        pOut->append(buffer, size);
+    }
+    fclose(pFile);
+    return true;
+}
+
+
+static bool ReadNumber(const std::string& path, u64* pOut)
+{
+    std::string text;
+    if (!ReadTextFile(path, &text) || text.empty() || !std::isdigit(static_cast<unsigned char>(text[0])))
+    {
+        return false;
+    }
+    *pOut = std::strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+
+// "0-3,8,10-11" の形式
+static bool ParseCpuList(const std::string& text, std::vector<u32>* pOut)
+{
+    pOut->clear();
+    const char* p = text.c_str();
+    while (*p != '\0' && *p != '\n')
+    {
+        char* pEnd = nullptr;
+        const u32 first = static_cast<u32>(std::strtoul(p, &pEnd, 10));
+        if (pEnd == p)
+        {
+            return false;
+        }
+        u32 last = first;
+        p = pEnd;
+        if (*p == '-')
+        {
+            p++;
+            last = static_cast<u32>(std::strtoul(p, &pEnd, 10));
+            if (pEnd == p || last < first)
+            {
+                return false;
+            }
+            p = pEnd;
+        }
+        for (u32 cpu = first; cpu <= last; cpu++)
+        {
+            pOut->push_back(cpu);
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+    }
+    return !pOut->empty();
+}
+
+
+// cpuDirectory は /sys/devices/system/cpu
+static bool ProbeSysfs(const std::string& cpuDirectory, std::vector<CpuRawProcessor>* pOut)
+{
+    std::string text;
+    std::vector<u32> cpus;
+    if (!ReadTextFile(cpuDirectory + "/online", &text) || !ParseCpuList(text, &cpus))
+    {
+        return false;
+    }
+
+    // Intel のハイブリッド構成は種類ごとの一覧がある (最大クロックは P コアの間でも違うので、こちらを優先する)
+    std::vector<u32> atomCpus;
+    if (ReadTextFile(cpuDirectory + "/../../cpu_atom/cpus", &text))
+    {
+        ParseCpuList(text, &atomCpus);
+    }
+
+    pOut->clear();
+    for (u32 cpu : cpus)
+    {
+        const std::string directory = cpuDirectory + "/cpu" + std::to_string(cpu);
+
+        u64 package = 0;
+        u64 coreId = cpu;
+        ReadNumber(directory + "/topology/physical_package_id", &package);
+        ReadNumber(directory + "/topology/core_id", &coreId);
+
+        // L3 を共有する CPU の最小の番号でまとめる (L3 が無ければクラスター、それも無ければパッケージ)
+        u64 clusterKey = (1ull << 32) | package;
+        bool isClusterFound = false;
+        for (u32 index = 0; !isClusterFound; index++)
+        {
+            const std::string cacheDirectory = directory + "/cache/index" + std::to_string(index);
+            u64 level = 0;
+            if (!ReadNumber(cacheDirectory + "/level", &level))
+            {
+                break;
+            }
+            std::vector<u32> sharedCpus;
+            if (level == 3 && ReadTextFile(cacheDirectory + "/shared_cpu_list", &text) && ParseCpuList(text, &sharedCpus))
+            {
+                clusterKey = *std::min_element(sharedCpus.begin(), sharedCpus.end());
+                isClusterFound = true;
+            }
+        }
+        std::vector<u32> clusterCpus;
+        if (!isClusterFound && ReadTextFile(directory + "/topology/cluster_cpus_list", &text) && ParseCpuList(text, &clusterCpus))
+        {
+            clusterKey = (2ull << 32) | *std::min_element(clusterCpus.begin(), clusterCpus.end());
+        }
+
+        // 性能の目安 : 種類ごとの一覧、cpu_capacity (ARM など)、最大クロックの順に使う
+        u64 performance = 0;
+        if (!atomCpus.empty())
+        {
+            performance = std::find(atomCpus.begin(), atomCpus.end(), cpu) != atomCpus.end() ? 1 : 2;
+        }
+        else if (!ReadNumber(directory + "/cpu_capacity", &performance))
+        {
+            ReadNumber(directory + "/cpufreq/cpuinfo_max_freq", &performance);
+        }
+
+        CpuRawProcessor raw = {};
+        raw.group = 0;
+        raw.number = cpu;
+        raw.coreKey = (package << 32) | coreId;
+        raw.clusterKey = clusterKey;
+        raw.performance = performance;
+        pOut->push_back(raw);
+    }
+
+    // プロセスに許されていない CPU (taskset、cgroup など) は使わない
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        pOut->erase(std::remove_if(pOut->begin(), pOut->end(), [&allowed](const CpuRawProcessor& raw)
+        {
+            return raw.number >= CPU_SETSIZE || !CPU_ISSET(raw.number, &allowed);
+        }), pOut->end());
+    }
+    return !pOut->empty();
+}
+
+
+static bool ProbeProcessors(std::vector<CpuRawProcessor>* pOut)
+{
+    return ProbeSysfs("/sys/devices/system/cpu", pOut);
+}
+
+#endif // defined(_WIN32)
+
+
+CpuTopology::CpuTopology()
+    : m_CoreCount(0)
+    , m_ClusterCount(0)
+    , m_IsAvailable(false)
+{
+
+}
+
+
+CpuTopology::~CpuTopology()
+{
+
+}
+
+
+HRESULT CpuTopology::Init()
+{
+    std::vector<CpuRawProcessor> rawProcessors;
+    m_IsAvailable = ProbeProcessors(&rawProcessors);
+    if (!m_IsAvailable)
+    {
+        // 論理プロセッサごとに別のコアとして扱う
+        rawProcessors.clear();
+        const u32 threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        for (u32 i = 0; i < threadCount; i++)
+        {
+            CpuRawProcessor raw = {};
+            raw.number = i;
+            raw.coreKey = i;
+            rawProcessors.push_back(raw);
+        }
+    }
+
+    BuildLogicalProcessors(rawProcessors, &m_LogicalProcessors, &m_CoreCount, &m_ClusterCount);
+    return m_IsAvailable ? S_OK : E_FAIL;
+}
+
+
+bool CpuTopology::IsAvailable() const
+{
+    return m_IsAvailable;
+}
+
+
+u32 CpuTopology::GetLogicalProcessorCount() const
+{
+    return static_cast<u32>(m_LogicalProcessors.size());
+}
+
+
+const CpuLogicalProcessor& CpuTopology::GetLogicalProcessor(u32 index) const
+{
+    return m_LogicalProcessors[index];
+}
+
+
+u32 CpuTopology::GetCoreCount() const
+{
+    return m_CoreCount;
+}
+
+
+u32 CpuTopology::GetClusterCount() const
+{
+    return m_ClusterCount;
+}
+
+
+u32 CpuTopology::GetPerformanceCoreCount() const
+{
+    u32 topClass = 0;
+    for (const CpuLogicalProcessor& processor : m_LogicalProcessors)
+    {
+        topClass = std::max(topClass, processor.efficiencyClass);
+    }
+
+    u32 count = 0;
+    for (const CpuLogicalProcessor& processor : m_LogicalProcessors)
+    {
+        if (processor.efficiencyClass == topClass && processor.smtIndex == 0)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+void CpuTopology::MakePlacement(u32 workerCount, u32* pMainProcessor, std::vector<u32>* pWorkerProcessors) const
+{
+    pWorkerProcessors->assign(workerCount, static_cast<u32>(InvalidIndex));
+    *pMainProcessor = InvalidIndex;
+    if (!m_IsAvailable || m_LogicalProcessors.empty())
+    {
+        return;
+    }
+
+    const u32 processorCount = GetLogicalProcessorCount();
+    u32 topClass = 0;
+    for (const CpuLogicalProcessor& processor : m_LogicalProcessors)
+    {
+        topClass = std::max(topClass, processor.efficiencyClass);
+    }
+
+    // メインスレッドは一番性能の高い種類のコアが最も多いクラスターに置く (ワーカーも同じ L3 に集められる)
+    std::vector<u32> topCoreCounts(m_ClusterCount, 0);
+    for (const CpuLogicalProcessor& processor : m_LogicalProcessors)
+    {
+        if (processor.efficiencyClass == topClass && processor.smtIndex == 0)
+        {
+            topCoreCounts[processor.cluster]++;
+        }
+    }
+    const u32 mainCluster = static_cast<u32>(std::max_element(topCoreCounts.begin(), topCoreCounts.end()) - topCoreCounts.begin());
+    for (u32 i = 0; i < processorCount; i++)
+    {
+        const CpuLogicalProcessor& processor = m_LogicalProcessors[i];
+        if (processor.efficiencyClass == topClass && processor.smtIndex == 0 && processor.cluster == mainCluster)
+        {
+            *pMainProcessor = i;
+            break;
+        }
+    }
+
+    // ワーカーは SMT の兄弟を後に、性能の高い種類を先に、メインスレッドのクラスターを先に使う
+    std::vector<u32> order;
+    for (u32 i = 0; i < processorCount; i++)
+    {
+        if (i != *pMainProcessor)
+        {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this, mainCluster](u32 a, u32 b)
+    {
+        const CpuLogicalProcessor& pa = m_LogicalProcessors[a];
+        const CpuLogicalProcessor& pb = m_LogicalProcessors[b];
+        if ((pa.smtIndex > 0) != (pb.smtIndex > 0))
+        {
+            return pa.smtIndex == 0;
+        }
+        if (pa.efficiencyClass != pb.efficiencyClass)
+        {
+            return pa.efficiencyClass > pb.efficiencyClass;
+        }
+        if ((pa.cluster == mainCluster) != (pb.cluster == mainCluster))
+        {
+            return pa.cluster == mainCluster;
+        }
+        return pa.cluster < pb.cluster;
+    });
+    order.push_back(*pMainProcessor);
+
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        (*pWorkerProcessors)[i] = order[i % order.size()];
+    }
+}
+
+
+bool CpuTopology::SetCurrentThreadAffinity(u32 index) const
+{
+    if (!m_IsAvailable || index >= m_LogicalProcessors.size())
+    {
+        return false;
+    }
+
+    const CpuLogicalProcessor& processor = m_LogicalProcessors[index];
+#if defined(_WIN32)
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = static_cast<WORD>(processor.group);
+    affinity.Mask = static_cast<KAFFINITY>(1) << processor.number;
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != FALSE;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor.number, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0; // 0 は呼んだスレッド
+#endif
+}
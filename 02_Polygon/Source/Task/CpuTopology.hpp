@@ -0,0 +1,64 @@
+﻿#pragma once
+
+
+// CPU の構成
+// 論理プロセッサを物理コア、L3 を共有するまとまり (クラスター)、コアの種類 (性能) で分類し、
+// スレッドをどの論理プロセッサで動かすかを決める
+// (Linux は /sys/devices/system/cpu、Windows は GetLogicalProcessorInformationEx)
+//
+// 配置の方針
+//   メインスレッド (描画の発行) : 一番性能の高い種類のコア
+//   ワーカー : 性能の高い種類から、メインスレッドと L3 を共有するものを先に、SMT の兄弟は後に使う
+//
+// 取得できない環境では論理プロセッサごとに別のコアとして扱い、スレッドは固定しない
+
+
+// 論理プロセッサ
+struct CpuLogicalProcessor
+{
+    u32 group;            // Windows のプロセッサ グループ (Linux は 0)
+    u32 number;           // グループ内の番号 (Linux は CPU 番号)
+    u32 core;             // 物理コア (CpuTopology 内の番号)
+    u32 cluster;          // L3 を共有するまとまり (CpuTopology 内の番号)
+    u32 efficiencyClass;  // コアの種類 (大きいほど性能が高い、全て同じなら 0)
+    u32 smtIndex;         // 同じコアの中での順番 (0 が最初のスレッド)
+};
+
+
+class CpuTopology
+{
+public:
+    static const u32 InvalidIndex = 0xFFFFFFFF;
+
+    CpuTopology();
+
+    ~CpuTopology();
+
+    // 取得できなければ E_FAIL (その場合も論理プロセッサの数だけは分かる)
+    HRESULT Init();
+
+    bool IsAvailable() const;
+
+    u32 GetLogicalProcessorCount() const;
+
+    const CpuLogicalProcessor& GetLogicalProcessor(u32 index) const;
+
+    u32 GetCoreCount() const;
+
+    u32 GetClusterCount() const;
+
+    // 一番性能の高い種類のコアの数
+    u32 GetPerformanceCoreCount() const;
+
+    // メインスレッドとワーカーを動かす論理プロセッサを決める (足りなければ同じものを繰り返す)
+    void MakePlacement(u32 workerCount, u32* pMainProcessor, std::vector<u32>* pWorkerProcessors) const;
+
+    // 今のスレッドを論理プロセッサ index だけで動かす
+    bool SetCurrentThreadAffinity(u32 index) const;
+
+private:
+    std::vector<CpuLogicalProcessor> m_LogicalProcessors;
+    u32                              m_CoreCount;
+    u32                              m_ClusterCount;
+    bool                             m_IsAvailable;
+};
@@ -0,0 +1,204 @@
+﻿
+
+RadixSorter::RadixSorter()
+    : m_pTaskScheduler(nullptr)
+    , m_Statistics()
+{
+
+}
+
+
+RadixSorter::~RadixSorter()
+{
+    Term();
+}
+
+
+void RadixSorter::Init(TaskScheduler* pTaskScheduler)
+{
+    m_pTaskScheduler = pTaskScheduler;
+}
+
+
+void RadixSorter::Term()
+{
+    m_TempKeys.clear();
+    m_TempKeys.shrink_to_fit();
+    m_TempValues.clear();
+    m_TempValues.shrink_to_fit();
+    m_Histograms.clear();
+    m_pTaskScheduler = nullptr;
+}
+
+
+void RadixSorter::Sort(u64* pKeys, u32* pValues, u32 count)
+{
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    m_Statistics.sortCount++;
+    m_Statistics.itemCount += count;
+    if (count <= 1)
+    {
+        return;
+    }
+
+    // ブロックはスレッドの数まで (少ないものは分けない)
+    const u32 threadCount = (m_pTaskScheduler != nullptr) ? m_pTaskScheduler->GetWorkerCount() + 1 : 1;
+    const u32 blockCount = std::max(std::min(threadCount, count / MinBlockSize), 1u);
+    m_Statistics.parallelSortCount += (blockCount > 1) ? 1 : 0;
+
+    if (m_TempKeys.size() < count)
+    {
+        m_TempKeys.resize(count);
+    }
+    if (pValues != nullptr && m_TempValues.size() < count)
+    {
+        m_TempValues.resize(count);
+    }
+    m_Histograms.assign(static_cast<size_t>(blockCount) * DigitCount * BucketCount, 0);
+
+    // ブロックごとに処理する (ブロックが 1 つならこのスレッドで)
+    const auto forEachBlock = [this, blockCount](const char* name, const std::function<void(u32 block)>& function)
+    {
+        if (blockCount == 1)
+        {
+            function(0);
+            return;
+        }
+        m_pTaskScheduler->ParallelFor(name, blockCount, 1, [&function](u32 begin, u32 end)
+        {
+            for (u32 block = begin; block < end; block++)
+            {
+                function(block);
+            }
+        });
+    };
+    const auto getBlockBegin = [count, blockCount](u32 block)
+    {
+        return static_cast<u32>(static_cast<u64>(count) * block / blockCount);
+    };
+
+    // 全ての桁を 1 回で数える (最初に振り分ける桁はこれをそのまま使う)
+    u32* pHistograms = m_Histograms.data();
+    forEachBlock("RadixSort.Count", [&](u32 block)
+    {
+        u32* pBlockHistograms = pHistograms + static_cast<size_t>(block) * DigitCount * BucketCount;
+        const u32 end = getBlockBegin(block + 1);
+        for (u32 i = getBlockBegin(block); i < end; i++)
+        {
+            const u64 key = pKeys[i];
+            for (u32 digit = 0; digit < DigitCount; digit++)
+            {
+                pBlockHistograms[digit * BucketCount + ((key >> (digit * DigitBits)) & (BucketCount - 1))]++;
+            }
+        }
+    });
+
+    u64* pSrcKeys = pKeys;
+    u64* pDstKeys = m_TempKeys.data();
+    u32* pSrcValues = pValues;
+    u32* pDstValues = (pValues != nullptr) ? m_TempValues.data() : nullptr;
+    bool isCounted = true;
+    for (u32 digit = 0; digit < DigitCount; digit++)
+    {
+        const u32 shift = digit * DigitBits;
+
+        // 全て同じ値の桁は並びが変わらない (どのブロックでも数は変わらないので、最初の数え上げで分かる)
+        bool isSkipped = false;
+        for (u32 bucket = 0; bucket < BucketCount && !isSkipped; bucket++)
+        {
+            u32 total = 0;
+            for (u32 block = 0; block < blockCount; block++)
+            {
+                total += pHistograms[(static_cast<size_t>(block) * DigitCount + digit) * BucketCount + bucket];
+            }
+            isSkipped = (total == count);
+            if (total != 0)
+            {
+                break;
+            }
+        }
+        if (isSkipped)
+        {
+            m_Statistics.skippedPassCount++;
+            continue;
+        }
+        m_Statistics.passCount++;
+
+        // 前の桁で並びが変わったので、ブロックごとの数を数え直す
+        if (!isCounted)
+        {
+            forEachBlock("RadixSort.Count", [&](u32 block)
+            {
+                u32* pBucketCounts = pHistograms + (static_cast<size_t>(block) * DigitCount + digit) * BucketCount;
+                std::fill_n(pBucketCounts, BucketCount, 0u);
+                const u32 end = getBlockBegin(block + 1);
+                for (u32 i = getBlockBegin(block); i < end; i++)
+                {
+                    pBucketCounts[(pSrcKeys[i] >> shift) & (BucketCount - 1)]++;
+                }
+            });
+        }
+        isCounted = false;
+
+        // 値ごとに、前のブロックの後ろから書く
+        u32 offset = 0;
+        for (u32 bucket = 0; bucket < BucketCount; bucket++)
+        {
+            for (u32 block = 0; block < blockCount; block++)
+            {
+                u32& bucketCount = pHistograms[(static_cast<size_t>(block) * DigitCount + digit) * BucketCount + bucket];
+                const u32 bucketOffset = offset;
+                offset += bucketCount;
+                bucketCount = bucketOffset;
+            }
+        }
+
+        forEachBlock("RadixSort.Scatter", [&](u32 block)
+        {
+            u32* pOffsets = pHistograms + (static_cast<size_t>(block) * DigitCount + digit) * BucketCount;
+            const u32 end = getBlockBegin(block + 1);
+            if (pSrcValues != nullptr)
+            {
+                for (u32 i = getBlockBegin(block); i < end; i++)
+                {
+                    const u32 index = pOffsets[(pSrcKeys[i] >> shift) & (BucketCount - 1)]++;
+                    pDstKeys[index] = pSrcKeys[i];
+                    pDstValues[index] = pSrcValues[i];
+                }
+            }
+            else
+            {
+                for (u32 i = getBlockBegin(block); i < end; i++)
+                {
+                    const u32 index = pOffsets[(pSrcKeys[i] >> shift) & (BucketCount - 1)]++;
+                    pDstKeys[index] = pSrcKeys[i];
+                }
+            }
+        });
+        std::swap(pSrcKeys, pDstKeys);
+        std::swap(pSrcValues, pDstValues);
+    }
+
+    // 振り分けた回数が奇数なら作業用の方に入っている
+    if (pSrcKeys != pKeys)
+    {
+        forEachBlock("RadixSort.Copy", [&](u32 block)
+        {
+            const u32 begin = getBlockBegin(block);
+            const u32 end = getBlockBegin(block + 1);
+            std::copy(pSrcKeys + begin, pSrcKeys + end, pKeys + begin);
+            if (pValues != nullptr)
+            {
+                std::copy(pSrcValues + begin, pSrcValues + end, pValues + begin);
+            }
+        });
+    }
+
+    m_Statistics.sortMilliseconds += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - beginTime).count();
+}
+
+
+const RadixSorterStatistics& RadixSorter::GetStatistics() const
+{
+    return m_Statistics;
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+
+
+// 64 ビットのキーの基数ソート
+// キーの下位から 8 ビットずつ、8 回の安定な振り分けで昇順に並べる (LSD)
+// 全ての要素で同じ値の桁は振り分けを飛ばす (描画のキーのように一部の桁しか変わらないものは速い)
+//
+// ワーカーがあれば配列をブロックに分け、ブロックごとの数え上げと振り分けを ParallelFor で行う
+// (ブロックごとの書き込み先は、前のブロックの同じ桁の後ろになるので安定のまま)
+
+
+// 統計情報 (累計)
+struct RadixSorterStatistics
+{
+    u64 sortCount;
+    u64 parallelSortCount;  // ブロックに分けて並べたもの
+    u64 itemCount;
+    u64 passCount;          // 振り分けた桁
+    u64 skippedPassCount;   // 全て同じ値なので飛ばした桁
+    f64 sortMilliseconds;
+};
+
+
+class RadixSorter
+{
+public:
+    static const u32 DigitBits = 8;
+    static const u32 DigitCount = 64 / DigitBits;
+    static const u32 BucketCount = 1 << DigitBits;
+
+    // 1 ブロックの最小の要素数 (これより少なければ分けない)
+    static const u32 MinBlockSize = 16 * 1024;
+
+    RadixSorter();
+
+    ~RadixSorter();
+
+    // pTaskScheduler が nullptr なら呼んだスレッドだけで並べる
+    void Init(TaskScheduler* pTaskScheduler);
+
+    void Term();
+
+    // pKeys を昇順に並べ、pValues (nullptr 可) も同じように並べ替える
+    // 作業用のメモリは次の Sort でも使い回す (複数のスレッドから同時に呼ばないこと)
+    void Sort(u64* pKeys, u32* pValues, u32 count);
+
+    const RadixSorterStatistics& GetStatistics() const;
+
+private:
+    TaskScheduler*   m_pTaskScheduler;
+    std::vector<u64> m_TempKeys;
+    std::vector<u32> m_TempValues;
+    std::vector<u32> m_Histograms; // [ブロック][桁][値] (振り分けの前はブロックごとの書き込み先)
+
+    RadixSorterStatistics m_Statistics;
+};
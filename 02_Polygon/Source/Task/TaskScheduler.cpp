@@ -0,0 +1,735 @@
+﻿
+
+// 投入したタスクの状態
+struct TaskState
+{
+    const char*                             name;
+    TaskFunction                            function;
+    std::shared_ptr<TaskState>              pParent;
+    std::shared_ptr<TaskState>              pSelf;                  // キューに入っている間、自身を保持する
+    std::atomic<u32>                        pendingDependencyCount; // 終わっていない依存するタスク (+ 投入中の 1)
+    std::atomic<u32>                        unfinishedCount;        // 終わっていない処理 (1) と子
+    std::atomic<bool>                       isCompleted;
+    std::mutex                              mutex;                  // successors を守る
+    std::vector<std::shared_ptr<TaskState>> successors;             // これが終わるのを待っているタスク
+};
+
+
+//-----------------------------------------------------------------
+// TaskDeque
+//-----------------------------------------------------------------
+// タスクの両端キュー (Chase-Lev)
+// 持ち主のワーカーだけが Push / Pop (後ろ) し、他のスレッドは Steal (前) する
+// 足りなくなったら 2 倍の配列に移す (古い配列は盗む側が読んでいるかもしれないので破棄まで残す)
+class TaskDeque
+{
+public:
+    TaskDeque()
+        : m_Top(0)
+        , m_Bottom(0)
+        , m_pArray(nullptr)
+    {
+        m_Arrays.emplace_back(new Array(InitialCapacity));
+        m_pArray.store(m_Arrays.back().get(), std::memory_order_relaxed);
+    }
+
+    void Push(TaskState* pTask)
+    {
+        const s64 bottom = m_Bottom.load(std::memory_order_relaxed);
+        const s64 top = m_Top.load(std::memory_order_acquire);
+        Array* pArray = m_pArray.load(std::memory_order_relaxed);
+        if (bottom - top >= pArray->capacity)
+        {
+            pArray = Grow(pArray, top, bottom);
+        }
+        pArray->Put(bottom, pTask);
+        m_Bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    TaskState* Pop()
+    {
+        const s64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+        Array* pArray = m_pArray.load(std::memory_order_relaxed);
+        m_Bottom.store(bottom, std::memory_order_seq_cst);
+        s64 top = m_Top.load(std::memory_order_seq_cst);
+        if (top > bottom)
+        {
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        TaskState* pTask = pArray->Get(bottom);
+        if (top == bottom)
+        {
+            // 最後の 1 つは盗む側と取り合う
+            if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                pTask = nullptr;
+            }
+            m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return pTask;
+    }
+
+    // 他のスレッドと取り合って負けたら *pIsContended を true にする
+    TaskState* Steal(bool* pIsContended)
+    {
+        s64 top = m_Top.load(std::memory_order_seq_cst);
+        const s64 bottom = m_Bottom.load(std::memory_order_seq_cst);
+        if (top >= bottom)
+        {
+            return nullptr;
+        }
+
+        Array* pArray = m_pArray.load(std::memory_order_acquire);
+        TaskState* pTask = pArray->Get(top);
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            *pIsContended = true;
+            return nullptr;
+        }
+        return pTask;
+    }
+
+private:
+    static const s64 InitialCapacity = 256;
+
+    struct Array
+    {
+        explicit Array(s64 capacity)
+            : capacity(capacity)
+            , tasks(new std::atomic<TaskState*>[capacity])
+        {
+
+        }
+
+        TaskState* Get(s64 index) const
+        {
+            return tasks[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void Put(s64 index, TaskState* pTask)
+        {
+            tasks[index & (capacity - 1)].store(pTask, std::memory_order_relaxed);
+        }
+
+        s64                                        capacity; // 2 の累乗
+        std::unique_ptr<std::atomic<TaskState*>[]> tasks;
+    };
+
+    Array* Grow(Array* pArray, s64 top, s64 bottom)
+    {
+        m_Arrays.emplace_back(new Array(pArray->capacity * 2));
+        Array* pNewArray = m_Arrays.back().get();
+        for (s64 i = top; i < bottom; i++)
+        {
+            pNewArray->Put(i, pArray->Get(i));
+        }
+        m_pArray.store(pNewArray, std::memory_order_release);
+        return pNewArray;
+    }
+
+private:
+    std::atomic<s64>                    m_Top;
+    std::atomic<s64>                    m_Bottom;
+    std::atomic<Array*>                 m_pArray;
+    std::vector<std::unique_ptr<Array>> m_Arrays; // 持ち主だけが触る
+};
+
+
+//-----------------------------------------------------------------
+// TaskWorker
+//-----------------------------------------------------------------
+struct TaskWorker
+{
+    TaskDeque         deque;
+    std::thread       thread;
+    u32               randomState;      // 盗む相手を選ぶ
+    u32               processor;        // 固定する論理プロセッサ
+    std::atomic<bool> isPinned;         // 固定できた
+    std::atomic<u64>  executedCount;    // 統計 (ワーカーだけが書く)
+    std::atomic<u64>  stolenCount;
+    std::atomic<u64>  taskNanoseconds;
+    std::atomic<u64>  busyNanoseconds;  // 最も外側のタスクの実行時間
+};
+
+
+// 今のスレッドのスケジューラーとワーカーの番号 (ワーカー以外は InvalidWorkerIndex)
+static const u32 InvalidWorkerIndex = 0xFFFFFFFF;
+static thread_local TaskScheduler*                     t_pScheduler = nullptr;
+static thread_local u32                                t_WorkerIndex = InvalidWorkerIndex;
+static thread_local const std::shared_ptr<TaskState>* t_pCurrentTask = nullptr;
+
+// 眠る前に探し直す回数
+static const u32 SpinCount = 64;
+
+
+static u64 GetElapsedNanoseconds(const std::chrono::steady_clock::time_point& beginTime)
+{
+    return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - beginTime).count());
+}
+
+
+static u32 NextRandom(u32* pState)
+{
+    // xorshift32
+    u32 x = *pState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *pState = x;
+    return x;
+}
+
+
+//-----------------------------------------------------------------
+// TaskScheduler
+//-----------------------------------------------------------------
+TaskScheduler::TaskScheduler()
+    : m_pTopology(nullptr)
+    , m_InitTime()
+    , m_InjectedCount(0)
+    , m_WakeCount(0)
+    , m_SleepingCount(0)
+    , m_WaitingCount(0)
+    , m_IsQuitting(false)
+    , m_SubmittedCount(0)
+    , m_WaiterExecutedCount(0)
+    , m_WaiterStolenCount(0)
+    , m_WaiterTaskNanoseconds(0)
+    , m_WaitNanoseconds(0)
+    , m_TermTaskNanoseconds(0)
+{
+
+}
+
+
+TaskScheduler::~TaskScheduler()
+{
+    Term();
+}
+
+
+void TaskScheduler::Init(u32 workerCount, const CpuTopology* pTopology, const u32* pWorkerProcessors)
+{
+    m_pTopology = pTopology;
+    m_InitTime = std::chrono::steady_clock::now();
+    m_IsQuitting = false;
+    m_SubmittedCount = 0;
+    m_WaiterExecutedCount = 0;
+    m_WaiterStolenCount = 0;
+    m_WaiterTaskNanoseconds = 0;
+    m_WaitNanoseconds = 0;
+    m_TermWorkerStatistics.clear();
+    m_TermTaskNanoseconds = 0;
+
+    // 全てのワーカーを作ってから動かす (動き出したワーカーは他のワーカーのキューを見る)
+    m_Workers.reserve(workerCount);
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        std::unique_ptr<TaskWorker> pWorker(new TaskWorker());
+        pWorker->randomState = 0x9E3779B9u * (i + 1);
+        pWorker->processor = (pTopology && pWorkerProcessors) ? pWorkerProcessors[i] : static_cast<u32>(CpuTopology::InvalidIndex);
+        pWorker->executedCount = 0;
+        pWorker->stolenCount = 0;
+        pWorker->taskNanoseconds = 0;
+        pWorker->busyNanoseconds = 0;
+        pWorker->isPinned = false;
+        m_Workers.push_back(std::move(pWorker));
+    }
+    for (u32 i = 0; i < workerCount; i++)
+    {
+        m_Workers[i]->thread = std::thread(&TaskScheduler::WorkerMain, this, i);
+    }
+}
+
+
+void TaskScheduler::Term()
+{
+    // ワーカーは残っているタスクが無くなってから終わる
+    m_IsQuitting = true;
+    Notify(true);
+    for (std::unique_ptr<TaskWorker>& pWorker : m_Workers)
+    {
+        if (pWorker->thread.joinable())
+        {
+            pWorker->thread.join();
+        }
+    }
+
+    // ワーカーが無い場合や、ワーカーが終わった後に投入されたものはここで実行する
+    bool isStolen = false;
+    while (TaskState* pTask = FindTask(&isStolen))
+    {
+        Execute(pTask, isStolen);
+    }
+
+    // 統計は Term の後も取れるように残す
+    if (!m_Workers.empty())
+    {
+        const u64 elapsedNanoseconds = GetElapsedNanoseconds(m_InitTime);
+        m_TermWorkerStatistics.resize(m_Workers.size());
+        for (size_t i = 0; i < m_Workers.size(); i++)
+        {
+            GetWorkerStatistics(*m_Workers[i], elapsedNanoseconds, &m_TermWorkerStatistics[i]);
+            m_TermTaskNanoseconds += m_Workers[i]->taskNanoseconds.load(std::memory_order_relaxed);
+        }
+    }
+    m_Workers.clear();
+}
+
+
+TaskHandle TaskScheduler::Submit(const char* name, const TaskFunction& function, const TaskHandle* pDependencies, u32 dependencyCount)
+{
+    std::shared_ptr<TaskState> pState = CreateState(name, function);
+    m_SubmittedCount.fetch_add(1, std::memory_order_relaxed);
+
+    // 登録の途中で依存するタスクが終わっても実行されないように、投入中の分を足しておく
+    pState->pendingDependencyCount.store(1, std::memory_order_relaxed);
+    for (u32 i = 0; i < dependencyCount; i++)
+    {
+        const std::shared_ptr<TaskState>& pDependency = pDependencies[i].pState;
+        if (!pDependency)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(pDependency->mutex);
+        if (!pDependency->isCompleted.load(std::memory_order_relaxed))
+        {
+            pDependency->successors.push_back(pState);
+            pState->pendingDependencyCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (pState->pendingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Schedule(pState);
+    }
+
+    TaskHandle handle = { pState };
+    return handle;
+}
+
+
+TaskHandle TaskScheduler::SubmitChild(const TaskHandle& parent, const char* name, const TaskFunction& function)
+{
+    std::shared_ptr<TaskState> pState = CreateState(name, function);
+    m_SubmittedCount.fetch_add(1, std::memory_order_relaxed);
+    pState->pendingDependencyCount.store(0, std::memory_order_relaxed);
+    if (parent.pState)
+    {
+        parent.pState->unfinishedCount.fetch_add(1, std::memory_order_relaxed);
+        pState->pParent = parent.pState;
+    }
+    Schedule(pState);
+
+    TaskHandle handle = { pState };
+    return handle;
+}
+
+
+void TaskScheduler::ParallelFor(const char* name, u32 count, u32 grainSize, const ParallelForFunction& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // 盗まれる単位が細かくなりすぎない程度に、スレッド数より十分多く分ける
+    const u32 threadCount = GetWorkerCount() + 1;
+    if (grainSize == 0)
+    {
+        grainSize = std::max(count / (threadCount * 8), 1u);
+    }
+    if (count <= grainSize || m_Workers.empty())
+    {
+        function(0, count);
+        return;
+    }
+
+    // 分けたものは全て root の子にして、root を待つ
+    std::shared_ptr<TaskState> pRoot = CreateState(name, TaskFunction());
+    ParallelForRange(this, pRoot, name, 0, count, grainSize, &function);
+    Finish(pRoot.get());
+
+    TaskHandle root = { pRoot };
+    Wait(root);
+}
+
+
+void TaskScheduler::Wait(const TaskHandle& task)
+{
+    if (!task.pState)
+    {
+        return;
+    }
+
+    m_WaitingCount.fetch_add(1, std::memory_order_seq_cst);
+    for (;;)
+    {
+        // 先に数を取ってから確かめる (確かめた後に増えたタスクや終わったタスクは数が変わるので見逃さない)
+        const u64 wakeCount = m_WakeCount.load(std::memory_order_seq_cst);
+        if (task.pState->isCompleted.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        // 待つ間に実行できるものを実行する (関係の無いタスクでも、ワーカーの空きを待つよりよい)
+        bool isStolen = false;
+        if (TaskState* pTask = FindTask(&isStolen))
+        {
+            Execute(pTask, isStolen);
+            continue;
+        }
+
+        const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+        Sleep(wakeCount);
+        m_WaitNanoseconds.fetch_add(GetElapsedNanoseconds(beginTime), std::memory_order_relaxed);
+    }
+    m_WaitingCount.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+
+bool TaskScheduler::IsCompleted(const TaskHandle& task) const
+{
+    return !task.pState || task.pState->isCompleted.load(std::memory_order_acquire);
+}
+
+
+u32 TaskScheduler::GetWorkerCount() const
+{
+    return static_cast<u32>(m_Workers.size());
+}
+
+
+TaskHandle TaskScheduler::GetCurrentTask()
+{
+    TaskHandle handle;
+    if (t_pCurrentTask)
+    {
+        handle.pState = *t_pCurrentTask;
+    }
+    return handle;
+}
+
+
+void TaskScheduler::GetStatistics(TaskSchedulerStatistics* pOut) const
+{
+    TaskSchedulerStatistics statistics = {};
+    statistics.submittedCount = m_SubmittedCount.load(std::memory_order_relaxed);
+    statistics.waiterExecutedCount = m_WaiterExecutedCount.load(std::memory_order_relaxed);
+    statistics.stolenCount = m_WaiterStolenCount.load(std::memory_order_relaxed);
+    for (const TaskWorkerStatistics& workerStatistics : m_TermWorkerStatistics)
+    {
+        statistics.workerExecutedCount += workerStatistics.executedCount;
+        statistics.stolenCount += workerStatistics.stolenCount;
+    }
+
+    u64 taskNanoseconds = m_WaiterTaskNanoseconds.load(std::memory_order_relaxed) + m_TermTaskNanoseconds;
+    for (const std::unique_ptr<TaskWorker>& pWorker : m_Workers)
+    {
+        statistics.workerExecutedCount += pWorker->executedCount.load(std::memory_order_relaxed);
+        statistics.stolenCount += pWorker->stolenCount.load(std::memory_order_relaxed);
+        taskNanoseconds += pWorker->taskNanoseconds.load(std::memory_order_relaxed);
+    }
+    statistics.taskMilliseconds = static_cast<f64>(taskNanoseconds) / 1000000.0;
+    statistics.waitMilliseconds = static_cast<f64>(m_WaitNanoseconds.load(std::memory_order_relaxed)) / 1000000.0;
+    *pOut = statistics;
+}
+
+
+void TaskScheduler::GetWorkerStatistics(std::vector<TaskWorkerStatistics>* pOut) const
+{
+    if (m_Workers.empty())
+    {
+        *pOut = m_TermWorkerStatistics;
+        return;
+    }
+
+    const u64 elapsedNanoseconds = GetElapsedNanoseconds(m_InitTime);
+    pOut->resize(m_Workers.size());
+    for (size_t i = 0; i < m_Workers.size(); i++)
+    {
+        GetWorkerStatistics(*m_Workers[i], elapsedNanoseconds, &(*pOut)[i]);
+    }
+}
+
+
+u32 TaskScheduler::GetDefaultWorkerCount()
+{
+    // 0 は不明
+    const u32 threadCount = std::thread::hardware_concurrency();
+    return (threadCount > 1) ? threadCount - 1 : 1;
+}
+
+
+void TaskScheduler::WorkerMain(u32 workerIndex)
+{
+    t_pScheduler = this;
+    t_WorkerIndex = workerIndex;
+
+    TaskWorker* pWorker = m_Workers[workerIndex].get();
+    if (pWorker->processor != CpuTopology::InvalidIndex)
+    {
+        pWorker->isPinned = m_pTopology->SetCurrentThreadAffinity(pWorker->processor);
+    }
+
+    u32 spinCount = 0;
+    for (;;)
+    {
+        const u64 wakeCount = m_WakeCount.load(std::memory_order_seq_cst);
+
+        bool isStolen = false;
+        if (TaskState* pTask = FindTask(&isStolen))
+        {
+            const u64 nanoseconds = Execute(pTask, isStolen);
+            pWorker->busyNanoseconds.store(pWorker->busyNanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+            spinCount = 0;
+            continue;
+        }
+
+        // 終了時も残っているものは実行する
+        if (m_IsQuitting.load(std::memory_order_acquire))
+        {
+            break;
+        }
+
+        // すぐに次が来ることが多いので、少し探し直してから眠る
+        if (spinCount < SpinCount)
+        {
+            spinCount++;
+            std::this_thread::yield();
+            continue;
+        }
+        spinCount = 0;
+        Sleep(wakeCount);
+    }
+
+    t_pScheduler = nullptr;
+    t_WorkerIndex = InvalidWorkerIndex;
+}
+
+
+std::shared_ptr<TaskState> TaskScheduler::CreateState(const char* name, const TaskFunction& function)
+{
+    std::shared_ptr<TaskState> pState = std::make_shared<TaskState>();
+    pState->name = name;
+    pState->function = function;
+    pState->unfinishedCount.store(1, std::memory_order_relaxed);
+    pState->isCompleted.store(false, std::memory_order_relaxed);
+    return pState;
+}
+
+
+void TaskScheduler::Schedule(const std::shared_ptr<TaskState>& pState)
+{
+    pState->pSelf = pState;
+
+    // ワーカーは自分のキューに、それ以外は共有のキューに入れる
+    if (t_pScheduler == this && t_WorkerIndex != InvalidWorkerIndex)
+    {
+        m_Workers[t_WorkerIndex]->deque.Push(pState.get());
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedMutex);
+        m_InjectedTasks.push_back(pState.get());
+        m_InjectedCount.fetch_add(1, std::memory_order_seq_cst);
+    }
+    Notify(false);
+}
+
+
+TaskState* TaskScheduler::FindTask(bool* pIsStolen)
+{
+    *pIsStolen = false;
+
+    const bool isWorker = (t_pScheduler == this && t_WorkerIndex != InvalidWorkerIndex);
+    if (isWorker)
+    {
+        if (TaskState* pTask = m_Workers[t_WorkerIndex]->deque.Pop())
+        {
+            return pTask;
+        }
+    }
+
+    if (m_InjectedCount.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_InjectedMutex);
+        if (!m_InjectedTasks.empty())
+        {
+            TaskState* pTask = m_InjectedTasks.front();
+            m_InjectedTasks.pop_front();
+            m_InjectedCount.fetch_sub(1, std::memory_order_relaxed);
+            return pTask;
+        }
+    }
+
+    // 相手は乱数で選んだところから順に見る (取り合いに負けたら残っているかもしれないので見直す)
+    const u32 workerCount = static_cast<u32>(m_Workers.size());
+    if (workerCount == 0)
+    {
+        return nullptr;
+    }
+    u32 randomState = 0;
+    u32 first = 0;
+    if (isWorker)
+    {
+        first = NextRandom(&m_Workers[t_WorkerIndex]->randomState) % workerCount;
+    }
+    else
+    {
+        randomState = static_cast<u32>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+        first = NextRandom(&randomState) % workerCount;
+    }
+
+    bool isContended = true;
+    while (isContended)
+    {
+        isContended = false;
+        for (u32 i = 0; i < workerCount; i++)
+        {
+            const u32 victim = (first + i) % workerCount;
+            if (isWorker && victim == t_WorkerIndex)
+            {
+                continue;
+            }
+            if (TaskState* pTask = m_Workers[victim]->deque.Steal(&isContended))
+            {
+                *pIsStolen = true;
+                return pTask;
+            }
+        }
+    }
+    return nullptr;
+}
+
+
+u64 TaskScheduler::Execute(TaskState* pTask, bool isStolen)
+{
+    // キューが持っていた参照を引き取る
+    const std::shared_ptr<TaskState> pState = std::move(pTask->pSelf);
+
+    const std::shared_ptr<TaskState>* pPreviousTask = t_pCurrentTask;
+    t_pCurrentTask = &pState;
+    const std::chrono::steady_clock::time_point beginTime = std::chrono::steady_clock::now();
+    if (pState->function)
+    {
+        pState->function();
+    }
+    const u64 nanoseconds = GetElapsedNanoseconds(beginTime);
+    t_pCurrentTask = pPreviousTask;
+    pState->function = TaskFunction(); // キャプチャしたものをすぐに解放する
+
+    if (t_pScheduler == this && t_WorkerIndex != InvalidWorkerIndex)
+    {
+        TaskWorker* pWorker = m_Workers[t_WorkerIndex].get();
+        pWorker->executedCount.store(pWorker->executedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        pWorker->stolenCount.store(pWorker->stolenCount.load(std::memory_order_relaxed) + (isStolen ? 1 : 0), std::memory_order_relaxed);
+        pWorker->taskNanoseconds.store(pWorker->taskNanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_WaiterExecutedCount.fetch_add(1, std::memory_order_relaxed);
+        m_WaiterStolenCount.fetch_add(isStolen ? 1 : 0, std::memory_order_relaxed);
+        m_WaiterTaskNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    Finish(pState.get());
+    return nanoseconds;
+}
+
+
+void TaskScheduler::GetWorkerStatistics(const TaskWorker& worker, u64 elapsedNanoseconds, TaskWorkerStatistics* pOut) const
+{
+    pOut->processor = worker.isPinned.load(std::memory_order_relaxed) ? worker.processor : static_cast<u32>(CpuTopology::InvalidIndex);
+    pOut->executedCount = worker.executedCount.load(std::memory_order_relaxed);
+    pOut->stolenCount = worker.stolenCount.load(std::memory_order_relaxed);
+    pOut->busyMilliseconds = static_cast<f64>(worker.busyNanoseconds.load(std::memory_order_relaxed)) / 1000000.0;
+    pOut->elapsedMilliseconds = static_cast<f64>(elapsedNanoseconds) / 1000000.0;
+}
+
+
+void TaskScheduler::Finish(TaskState* pTask)
+{
+    // 処理と子が全て終わったら完了
+    if (pTask->unfinishedCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+
+    std::vector<std::shared_ptr<TaskState>> successors;
+    {
+        std::lock_guard<std::mutex> lock(pTask->mutex);
+        pTask->isCompleted.store(true, std::memory_order_seq_cst);
+        successors.swap(pTask->successors);
+    }
+    for (const std::shared_ptr<TaskState>& pSuccessor : successors)
+    {
+        if (pSuccessor->pendingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            Schedule(pSuccessor);
+        }
+    }
+
+    // 親は子が保持しているので、ここで手放してから親を終わらせる
+    const std::shared_ptr<TaskState> pParent = std::move(pTask->pParent);
+    if (m_WaitingCount.load(std::memory_order_seq_cst) > 0)
+    {
+        Notify(true);
+    }
+    if (pParent)
+    {
+        Finish(pParent.get());
+    }
+}
+
+
+void TaskScheduler::Notify(bool isAll)
+{
+    m_WakeCount.fetch_add(1, std::memory_order_seq_cst);
+    if (m_SleepingCount.load(std::memory_order_seq_cst) == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (isAll)
+    {
+        m_Condition.notify_all();
+    }
+    else
+    {
+        m_Condition.notify_one();
+    }
+}
+
+
+void TaskScheduler::Sleep(u64 wakeCount)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_SleepingCount.fetch_add(1, std::memory_order_seq_cst);
+    m_Condition.wait(lock, [this, wakeCount]()
+    {
+        return m_WakeCount.load(std::memory_order_seq_cst) != wakeCount || m_IsQuitting.load(std::memory_order_seq_cst);
+    });
+    m_SleepingCount.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+
+void TaskScheduler::ParallelForRange(TaskScheduler* pScheduler, const std::shared_ptr<TaskState>& pRoot, const char* name, u32 begin, u32 end, u32 grainSize, const ParallelForFunction* pFunction)
+{
+    // 後半を子として投入し、前半を自分で処理する (盗む側は大きな塊を先から取る)
+    const TaskHandle root = { pRoot };
+    while (end - begin > grainSize)
+    {
+        const u32 middle = begin + (end - begin) / 2;
+        const u32 childEnd = end;
+        pScheduler->SubmitChild(root, name, [pScheduler, pRoot, name, middle, childEnd, grainSize, pFunction]()
+        {
+            ParallelForRange(pScheduler, pRoot, name, middle, childEnd, grainSize, pFunction);
+        });
+        end = middle;
+    }
+    (*pFunction)(begin, end);
+}
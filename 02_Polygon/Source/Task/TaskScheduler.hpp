@@ -0,0 +1,151 @@
+﻿#pragma once
+
+
+// タスクの実行
+// ワーカースレッドでタスクを実行する。タスクは依存するタスクが全て終わってから実行される
+// Wait で待つスレッドも、待つ間は実行できるタスクを実行する (ワーカーが 0 ならそのスレッドだけで実行する)
+//
+// ワーカーはそれぞれタスクの両端キュー (Chase-Lev) を持ち、自分で投入したものは後から、
+// 他のワーカーのものは先から取る (盗む)。ワーカー以外のスレッドが投入したものは共有のキューに入る
+//
+// 子タスク : 親の処理と全ての子が終わったときに親が完了する (親を待つもの、親に依存するものは子も待つ)
+//
+// タスクは失敗を返さない。結果は関数が書き込む先 (キャプチャした変数) で受け取ること
+
+
+// タスクの処理
+typedef std::function<void()> TaskFunction;
+
+// ParallelFor の処理 ([begin, end) を処理する)
+typedef std::function<void(u32 begin, u32 end)> ParallelForFunction;
+
+
+// 投入したタスク (空なら何も指さない)
+struct TaskState;
+struct TaskWorker;
+
+struct TaskHandle
+{
+    std::shared_ptr<TaskState> pState;
+};
+
+
+// 統計情報
+struct TaskSchedulerStatistics
+{
+    u64 submittedCount;
+    u64 workerExecutedCount;  // ワーカーが実行した
+    u64 waiterExecutedCount;  // Wait で待つスレッドが実行した
+    u64 stolenCount;          // 他のワーカーのキューから取った
+    f64 taskMilliseconds;     // 実行時間の合計 (1 スレッドで順に実行した場合の時間)
+    f64 waitMilliseconds;     // Wait で何もできずに止まった時間
+};
+
+
+// ワーカーごとの統計情報 (busyMilliseconds / elapsedMilliseconds が使用率)
+struct TaskWorkerStatistics
+{
+    u32 processor;            // 固定した論理プロセッサ (CpuTopology の番号、固定していなければ CpuTopology::InvalidIndex)
+    u64 executedCount;
+    u64 stolenCount;
+    f64 busyMilliseconds;     // タスクを実行していた時間 (中で Wait して実行したものは重ねて数えない)
+    f64 elapsedMilliseconds;  // Init から (Term の後は Term まで)
+};
+
+
+class TaskScheduler
+{
+public:
+    TaskScheduler();
+
+    ~TaskScheduler();
+
+    // pTopology と pWorkerProcessors (workerCount 個) があれば、ワーカーをその論理プロセッサに固定する
+    void Init(u32 workerCount, const CpuTopology* pTopology = nullptr, const u32* pWorkerProcessors = nullptr);
+
+    // 残っているタスクを全て実行してからワーカーを止める
+    void Term();
+
+    // pDependencies は全て投入済みのもの (空のハンドルは無視する)
+    TaskHandle Submit(const char* name, const TaskFunction& function, const TaskHandle* pDependencies = nullptr, u32 dependencyCount = 0);
+
+    // parent の子として投入する (parent が完了する前、普通は parent の処理の中から呼ぶこと)
+    TaskHandle SubmitChild(const TaskHandle& parent, const char* name, const TaskFunction& function);
+
+    // [0, count) を grainSize ずつ以上に分けて並列に処理し、全て終わるまで待つ (待つ間は他のタスクも実行する)
+    // grainSize が 0 ならスレッド数から決める
+    void ParallelFor(const char* name, u32 count, u32 grainSize, const ParallelForFunction& function);
+
+    void Wait(const TaskHandle& task);
+
+    bool IsCompleted(const TaskHandle& task) const;
+
+    u32 GetWorkerCount() const;
+
+    // 実行中のタスク (タスクの外なら空)
+    static TaskHandle GetCurrentTask();
+
+    void GetStatistics(TaskSchedulerStatistics* pOut) const;
+
+    // Term の後は Term までのもの
+    void GetWorkerStatistics(std::vector<TaskWorkerStatistics>* pOut) const;
+
+    // ワーカーの既定の数 (論理コア数 - 1、最低 1)
+    static u32 GetDefaultWorkerCount();
+
+private:
+    void WorkerMain(u32 workerIndex);
+
+    std::shared_ptr<TaskState> CreateState(const char* name, const TaskFunction& function);
+
+    // 実行できるようになったタスクをキューに入れる
+    void Schedule(const std::shared_ptr<TaskState>& pState);
+
+    // 実行できるタスクを 1 つ取る (無ければ nullptr)
+    TaskState* FindTask(bool* pIsStolen);
+
+    // 実行にかかった時間を返す
+    u64 Execute(TaskState* pTask, bool isStolen);
+
+    void GetWorkerStatistics(const TaskWorker& worker, u64 elapsedNanoseconds, TaskWorkerStatistics* pOut) const;
+
+    // 処理か子が 1 つ終わった
+    void Finish(TaskState* pTask);
+
+    // 眠っているスレッドを起こす
+    void Notify(bool isAll);
+
+    // m_WakeCount が wakeCount から変わるまで眠る
+    void Sleep(u64 wakeCount);
+
+    static void ParallelForRange(TaskScheduler* pScheduler, const std::shared_ptr<TaskState>& pRoot, const char* name, u32 begin, u32 end, u32 grainSize, const ParallelForFunction* pFunction);
+
+private:
+    std::vector<std::unique_ptr<TaskWorker>> m_Workers;
+    const CpuTopology*                       m_pTopology;
+    std::chrono::steady_clock::time_point    m_InitTime;
+
+    // ワーカー以外のスレッドが投入したもの
+    std::mutex             m_InjectedMutex;
+    std::deque<TaskState*> m_InjectedTasks;
+    std::atomic<u32>       m_InjectedCount;
+
+    // 眠る、起こす
+    std::mutex              m_Mutex;
+    std::condition_variable m_Condition;
+    std::atomic<u64>        m_WakeCount;     // タスクが増える、または待たれているタスクが終わるたびに増やす
+    std::atomic<u32>        m_SleepingCount;
+    std::atomic<u32>        m_WaitingCount;  // Wait しているスレッド
+    std::atomic<bool>       m_IsQuitting;
+
+    // ワーカー以外のスレッドでの統計 (ワーカーのものは TaskWorker が持つ)
+    std::atomic<u64> m_SubmittedCount;
+    std::atomic<u64> m_WaiterExecutedCount;
+    std::atomic<u64> m_WaiterStolenCount;
+    std::atomic<u64> m_WaiterTaskNanoseconds;
+    std::atomic<u64> m_WaitNanoseconds;
+
+    // Term で止めたワーカーの統計
+    std::vector<TaskWorkerStatistics> m_TermWorkerStatistics;
+    u64                               m_TermTaskNanoseconds;
+};
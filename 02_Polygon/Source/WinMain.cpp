@@ -1,4 +1,8 @@
 ﻿
+#if defined(_WIN32)
+
+#include <shellapi.h>
+
 
 #if defined(DEBUG) || defined(_DEBUG)
 #include <crtdbg.h>
@@ -21,10 +25,38 @@ int APIENTRY _tWinMain(_In_ HINSTANCE hInstance,
 
     EnableMemoryLeakCheck();
 
-    AppMain();
+    // コマンドライン引数を UTF-8 に変換
+    int argc = 0;
+    LPWSTR* argvW = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+    std::vector<std::string> arguments;
+    for (int i = 0; i < argc; i++)
+    {
+        int length = WideCharToMultiByte(CP_UTF8, 0, argvW[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string argument;
+        if (length > 0)
+        {
+            argument.resize(static_cast<size_t>(length));
+            WideCharToMultiByte(CP_UTF8, 0, argvW[i], -1, &argument[0], length, nullptr, nullptr);
+            argument.resize(static_cast<size_t>(length - 1));
+        }
+        arguments.push_back(argument);
+    }
+    LocalFree(argvW);
+
+    std::vector<const char*> argv;
+    for (auto& argument : arguments)
+    {
+        argv.push_back(argument.c_str());
+    }
+
+    AppMain(argc, argv.data());
 
     return 0;
 }
 
+#endif
+
+
 
 